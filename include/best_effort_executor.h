@@ -0,0 +1,236 @@
+#ifndef BEST_EFFORT_EXECUTOR_H
+#define BEST_EFFORT_EXECUTOR_H
+
+#include "change_signal.h"
+#include "performance_monitor.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr size_t BEST_EFFORT_LANE_COUNT = 3;
+constexpr size_t BEST_EFFORT_DEFAULT_MAX_JOBS = 64;
+constexpr int BEST_EFFORT_IDLE_WAIT_MS = 1000;     // Longest sleep with no release pending
+
+/**
+ * @brief Priority lane of best-effort work (lower index runs first)
+ */
+enum class WorkLane {
+    HIGH = 0,       // Feeds a control loop (fault delivery, bridge inputs)
+    NORMAL = 1,     // Output and persistence (log commits)
+    LOW = 2         // Presentation (operator display, reports)
+};
+
+/**
+ * @file best_effort_executor.h
+ * @brief Work-stealing thread pool for the soft (non-real-time) work
+ *
+ * Log commits, fault event delivery, the operator display, bridge file
+ * reads and writes with their JSON encoding, and planner requests do not
+ * need a thread each. They run as tasks on a few SCHED_OTHER workers,
+ * optionally pinned to CPUs the SCHED_FIFO tasks do not use.
+ *
+ * Each worker owns one deque per lane. A task submitted from a worker
+ * goes to that worker's deques, any other to the next worker in turn. A
+ * worker takes the oldest task of the highest lane that has one, from its
+ * own deques first and otherwise stolen from another worker's. Two tasks
+ * may therefore run in either order or at once: work that must stay in
+ * order (one truck's bridge writes) belongs in one task or one job.
+ *
+ * Periodic jobs are released once per period, like RtWorkerPool's, and
+ * never run on two workers at once. wake() releases a job now; it is
+ * lock-free and safe to call from an RT thread. A job woken while it runs
+ * runs again as soon as it ends.
+ *
+ * Every task's queue wait (submit or release to start) and run time are
+ * recorded as "BestEffortWait.<name>" and "BestEffortRun.<name>".
+ */
+class BestEffortExecutor {
+public:
+    using JobId = int;
+
+    struct Stats {
+        size_t workers;
+        size_t jobs;
+        std::array<long, BEST_EFFORT_LANE_COUNT> runs;          // Per lane
+        std::array<long, BEST_EFFORT_LANE_COUNT> max_wait_us;   // Per lane
+        long steals;
+        long rejected;                                          // submit() while stopped
+    };
+
+    /**
+     * @brief Construct the executor (workers are started by start())
+     *
+     * @param workers Number of worker threads
+     * @param max_jobs Most periodic jobs added at once
+     * @param perf_monitor Receives per-task wait and run times (optional)
+     */
+    explicit BestEffortExecutor(size_t workers, size_t max_jobs = BEST_EFFORT_DEFAULT_MAX_JOBS,
+                                PerformanceMonitor* perf_monitor = nullptr);
+
+    ~BestEffortExecutor();
+
+    /**
+     * @brief Pin the workers to a CPU set
+     *
+     * Must be called before start(). An empty set leaves them unpinned.
+     *
+     * @param cpus CPU numbers (see RtProfile::parse_cpu_list())
+     */
+    void set_cpu_affinity(const std::vector<int>& cpus);
+
+    void start();
+
+    /**
+     * @brief Stop the workers once every submitted task has run
+     *
+     * Periodic jobs are not released again; they stay added.
+     */
+    void stop();
+
+    /**
+     * @brief Queue a one-shot task (any thread)
+     *
+     * @param lane Priority lane
+     * @param name Task name for latency accounting (string literal)
+     * @param task Work to run
+     * @return false if the executor is stopped and the task was dropped
+     */
+    bool submit(WorkLane lane, const char* name, std::function<void()> task);
+
+    /**
+     * @brief Run body(0) .. body(count - 1) as tasks and wait for all of them
+     *
+     * Runs inline when the executor is stopped. Must not be called from a
+     * worker.
+     */
+    void parallel_for(WorkLane lane, const char* name, size_t count, const std::function<void(size_t)>& body);
+
+    /**
+     * @brief Add a periodic job, first released now
+     *
+     * @param lane Priority lane
+     * @param name Job name for latency accounting (string literal)
+     * @param period_ms Release period in milliseconds
+     * @param cycle One job cycle
+     * @return ID for wake() and remove(), -1 if max_jobs are already added
+     */
+    JobId add_periodic(WorkLane lane, const char* name, int period_ms, std::function<void()> cycle);
+
+    /**
+     * @brief Release a periodic job now (lock-free, any thread)
+     */
+    void wake(JobId id);
+
+    /**
+     * @brief Remove a job, waiting for a cycle in progress to end
+     *
+     * Must not be called from the job's own cycle.
+     */
+    void remove(JobId id);
+
+    /**
+     * @brief Run one queued task on the calling worker, if there is one
+     *
+     * For a task that must wait on another task (a DURABLE log record
+     * waiting for the log writer's job): helping instead of sleeping keeps
+     * the waited-on task from starving when every worker is waiting.
+     *
+     * @return false if the caller is not a worker or nothing was runnable
+     */
+    bool help();
+
+    Stats get_stats() const;
+
+private:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    struct Task {
+        JobId job;                      // -1: one-shot task
+        long generation;                // Job generation the release belongs to
+        WorkLane lane;
+        const char* name;
+        std::function<void()> run;      // One-shot tasks only
+        time_point queued;              // Submit or release time
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::array<std::deque<Task>, BEST_EFFORT_LANE_COUNT> lanes;
+        std::thread thread;
+    };
+
+    struct Job {
+        const char* name;
+        WorkLane lane;
+        std::chrono::nanoseconds period;
+        std::function<void()> cycle;
+        time_point release;
+        long generation;                // Changes when a wake() replaces the pending release
+        bool queued = false;
+        bool running = false;
+        bool rerun = false;             // Woken while running
+        long runs = 0;
+    };
+
+    struct Release {
+        time_point time;
+        JobId id;
+        long generation;
+        bool operator>(const Release& other) const {
+            return time != other.time ? time > other.time : id > other.id;
+        }
+    };
+
+    void worker_loop(size_t index);
+
+    /**
+     * @brief Apply wakes and queue due job releases on worker index
+     *
+     * @return Time of the next pending release
+     */
+    time_point release_jobs(size_t index);
+
+    bool take_task(size_t index, Task& task);
+
+    /**
+     * @brief Run a task and record its wait and run times
+     *
+     * @param notify_release Wake the other workers for the job's next release
+     */
+    void run_task(Task& task, bool notify_release);
+    void push_task(size_t index, Task task);
+
+    size_t worker_count_;
+    size_t max_jobs_;
+    PerformanceMonitor* perf_monitor_;
+    std::vector<int> cpus_;
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<bool> running_;
+    std::atomic<size_t> next_worker_;           // Round robin for outside submitters
+    ChangeSignal work_signal_;                  // New task, wake() or stop
+
+    mutable std::mutex jobs_mutex_;
+    std::condition_variable cycle_done_;        // remove(): a cycle ended
+    std::vector<std::unique_ptr<Job>> jobs_;    // Indexed by JobId, nullptr when free
+    std::priority_queue<Release, std::vector<Release>, std::greater<Release>> releases_;
+    long next_generation_;
+    std::unique_ptr<std::atomic<bool>[]> wake_requests_;   // Indexed by JobId
+    std::atomic<bool> wake_pending_;
+
+    std::array<std::atomic<long>, BEST_EFFORT_LANE_COUNT> lane_runs_;
+    std::array<std::atomic<long>, BEST_EFFORT_LANE_COUNT> lane_max_wait_us_;
+    std::atomic<long> steals_;
+    std::atomic<long> rejected_;
+};
+
+#endif // BEST_EFFORT_EXECUTOR_H
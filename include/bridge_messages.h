@@ -0,0 +1,85 @@
+#ifndef BRIDGE_MESSAGES_H
+#define BRIDGE_MESSAGES_H
+
+#include "common_types.h"
+#include "route_planning.h"
+#include "sensor_processing.h"
+#include "json.hpp"
+#include <string>
+#include <vector>
+
+/**
+ * @file bridge_messages.h
+ * @brief JSON messages exchanged with the MQTT bridge through bridge/ files
+ *
+ * The bridge writes each MQTT message it receives as
+ * bridge/from_mqtt/<ms>_truck_<id>_<topic>.json holding
+ * {"topic", "payload"[, "timestamp"]}, and publishes the files written
+ * into bridge/to_mqtt. The parse functions fill their output from a
+ * message's payload and return false when the payload lacks the topic's
+ * fields; the writers build and write one to_mqtt file.
+ */
+
+constexpr const char* BRIDGE_FROM_MQTT_DIR = "bridge/from_mqtt";
+constexpr const char* BRIDGE_TO_MQTT_DIR = "bridge/to_mqtt";
+
+/**
+ * @brief Age below which an unparsable from_mqtt file may still be mid-write
+ *
+ * The bridge writes its files in place, so a reader can see a prefix.
+ */
+constexpr long BRIDGE_PARTIAL_FILE_MS = 1000;
+
+/**
+ * @brief Outcome of read_bridge_file()
+ */
+enum class BridgeFileRead {
+    PARSED,     // message holds the file's JSON
+    PENDING,    // Does not parse, but is young enough to be mid-write: read it again later
+    INVALID     // Does not parse and never will: remove it
+};
+
+/**
+ * @brief Parse one from_mqtt file without throwing
+ */
+BridgeFileRead read_bridge_file(const std::string& path, nlohmann::json& message);
+
+/**
+ * @brief Source timestamp of a message (payload's, else the envelope's, else 0)
+ */
+long bridge_message_timestamp_ms(const nlohmann::json& message);
+
+bool parse_bridge_sensors(const nlohmann::json& message, RawSensorData& data);
+
+/**
+ * @brief Operator command; false unless at least one command field is present
+ */
+bool parse_bridge_command(const nlohmann::json& message, OperatorCommand& cmd);
+
+/**
+ * @brief Route setpoint (target_x, target_y, target_speed)
+ */
+bool parse_bridge_setpoint(const nlohmann::json& message, NavigationSetpoint& setpoint);
+
+/**
+ * @brief Obstacle list (replaces obstacles on success)
+ */
+bool parse_bridge_obstacles(const nlohmann::json& message, std::vector<Obstacle>& obstacles);
+
+/**
+ * @brief Write <ms>_truck_<id>_commands.json (acceleration, steering, arrived)
+ *
+ * @param timestamp_ms Time of the control cycle that produced the output.
+ *                     The bridge publishes the newest file of a topic, so
+ *                     one truck's writes must be made in cycle order.
+ */
+bool write_bridge_actuator_output(int truck_id, const ActuatorOutput& output, long timestamp_ms);
+
+/**
+ * @brief Write <ms>_truck_<id>_state.json (automatic, fault)
+ *
+ * @param timestamp_ms Time of the control cycle (see write_bridge_actuator_output())
+ */
+bool write_bridge_truck_state(int truck_id, const TruckState& state, long timestamp_ms);
+
+#endif // BRIDGE_MESSAGES_H
@@ -0,0 +1,187 @@
+#ifndef BRIDGE_TRACE_H
+#define BRIDGE_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+/**
+ * @file bridge_trace.h
+ * @brief Record and replay of the MQTT bridge input files
+ *
+ * The bridge delivers sensors, commands, setpoints and obstacles as JSON
+ * files in bridge/from_mqtt, which the main loop deletes once read. With
+ * BRIDGE_RECORD_FILE=<path>, every such file is appended to a trace before
+ * it is deleted, including files superseded by a newer one in the same
+ * cycle. A record holds:
+ *
+ *   [BridgeTraceRecordHeader][file name][file contents]
+ *
+ * The arrival time is the file's modification time (when the bridge wrote
+ * it), in microseconds. The trace is gzip-compressed: about 10x smaller
+ * than the JSON files it holds.
+ *
+ * With BRIDGE_REPLAY_FILE=<path>, a replay thread writes the recorded
+ * files back into bridge/from_mqtt at their original spacing divided by
+ * BRIDGE_REPLAY_SPEED (default 1). Each file is written to a temporary
+ * name and renamed, so the main loop never reads a partial file. Source
+ * timestamps ("timestamp" and "payload.timestamp") are shifted by the
+ * replay offset, so input ages and the freshness checks are the same as
+ * in the field. The main loop reads the replayed files through its usual
+ * path. Records are replayed in the order the main loop consumed them.
+ * At speeds where files arrive faster than one per 50 ms cycle, the main
+ * loop skips superseded files exactly as it does in the field. No MQTT
+ * bridge may run during a replay.
+ */
+
+constexpr char BRIDGE_TRACE_MAGIC[8] = {'T', 'R', 'K', 'B', 'T', 'R', '0', '1'};
+
+enum class BridgeTopic : uint8_t {
+    SENSORS,
+    COMMANDS,
+    SETPOINT,
+    OBSTACLES,
+    COUNT
+};
+
+constexpr size_t BRIDGE_TOPIC_COUNT = static_cast<size_t>(BridgeTopic::COUNT);
+
+struct BridgeTraceFileHeader {
+    char magic[8];
+    int32_t truck_id;
+    uint32_t reserved;
+    int64_t created_ms;         // Wall clock when recording started
+};
+
+struct BridgeTraceRecordHeader {
+    int64_t arrival_us;         // File modification time (wall clock, microseconds)
+    uint32_t name_bytes;
+    uint32_t content_bytes;
+    uint8_t topic;              // BridgeTopic
+    uint8_t reserved[7];
+};
+
+/**
+ * @brief One recorded bridge file
+ */
+struct BridgeTraceRecord {
+    int64_t arrival_us;
+    BridgeTopic topic;
+    std::string name;           // File name in bridge/from_mqtt
+    std::string content;        // JSON text as read
+};
+
+/**
+ * @brief Appends bridge files to a trace (main loop thread)
+ */
+class BridgeTraceWriter {
+public:
+    BridgeTraceWriter();
+    ~BridgeTraceWriter();
+
+    bool open(const std::string& path, int truck_id);
+    void close();
+    bool is_open() const { return file_ != nullptr; }
+
+    /**
+     * @brief Record a bridge file before it is deleted
+     *
+     * Reads the file's contents and modification time.
+     *
+     * @return false if the file could not be read or the trace written
+     */
+    bool record(BridgeTopic topic, const std::string& path);
+
+    long get_records() const { return records_; }
+
+private:
+    gzFile file_;
+    long records_;
+};
+
+/**
+ * @brief Sequential trace reader
+ */
+class BridgeTraceReader {
+public:
+    BridgeTraceReader();
+    ~BridgeTraceReader();
+
+    bool open(const std::string& path);
+    void close();
+
+    /**
+     * @brief Read the next record
+     *
+     * @return false at the end of the trace (or on a truncated record)
+     */
+    bool next(BridgeTraceRecord& record);
+
+    int truck_id() const { return header_.truck_id; }
+    int64_t created_ms() const { return header_.created_ms; }
+
+private:
+    gzFile file_;
+    BridgeTraceFileHeader header_;
+};
+
+/**
+ * @brief Writes a trace's files back into the bridge directory on schedule
+ */
+class BridgeReplayer {
+public:
+    /**
+     * @param speed Replay speed factor (2.0 = twice as fast)
+     * @param bridge_dir Directory the main loop reads (bridge/from_mqtt)
+     */
+    BridgeReplayer(double speed, std::string bridge_dir);
+    ~BridgeReplayer();
+
+    /**
+     * @brief Open the trace and start the replay thread
+     *
+     * @param on_finished Called on the replay thread after the last record
+     */
+    bool start(const std::string& path, std::function<void()> on_finished = nullptr);
+    void stop();
+
+    int truck_id() const { return reader_truck_id_; }
+    long get_replayed() const { return replayed_.load(); }
+
+    /**
+     * @brief How late records were written relative to their schedule
+     */
+    long get_late_p99_us() const;
+    long get_late_max_us() const;
+
+private:
+    void replay_loop();
+
+    /**
+     * @brief Shift the source timestamps of a JSON message by offset_ms
+     */
+    static std::string shift_timestamps(const std::string& content, long offset_ms);
+
+    double speed_;
+    std::string bridge_dir_;
+    BridgeTraceReader reader_;
+    int reader_truck_id_;
+    std::function<void()> on_finished_;
+    std::thread replay_thread_;
+    std::atomic<bool> running_;
+    std::atomic<long> replayed_;
+    mutable std::mutex late_mutex_;
+    std::vector<long> late_us_;         // Per record lateness (replay thread)
+};
+
+/**
+ * @brief Topic name as used in the trace tools and logs
+ */
+const char* bridge_topic_name(BridgeTopic topic);
+
+#endif // BRIDGE_TRACE_H
@@ -0,0 +1,84 @@
+#ifndef CHANGE_SIGNAL_H
+#define CHANGE_SIGNAL_H
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @brief Versioned wakeup for a task that sleeps until an input changes
+ *
+ * Producers call notify() after changing an input; it bumps a version
+ * counter and only enters the kernel while a waiter is actually asleep, so
+ * notifying a busy or polling consumer is a single atomic increment and
+ * never blocks (safe from lock-free producers and RT threads).
+ *
+ * The consumer remembers the version it last acted on and calls
+ * wait_until() with it, which sleeps on the version word itself (futex).
+ * The kernel re-checks the word before sleeping, so a notify() racing
+ * with the consumer going to sleep is never lost.
+ */
+class ChangeSignal {
+public:
+    ChangeSignal() : version_(0), waiters_(0) {}
+
+    /**
+     * @brief Record an input change and wake the waiter (any thread)
+     */
+    void notify() {
+        version_.fetch_add(1);
+        if (waiters_.load() > 0) {
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&version_), FUTEX_WAKE_PRIVATE, INT_MAX,
+                    nullptr, nullptr, 0);
+        }
+    }
+
+    /**
+     * @brief Current input version
+     */
+    uint32_t version() const { return version_.load(); }
+
+    /**
+     * @brief Sleep until the version differs from seen or deadline passes
+     *
+     * @param seen Version the caller last acted on
+     * @param deadline Latest wakeup time
+     * @return true if an input changed
+     */
+    bool wait_until(uint32_t seen, std::chrono::steady_clock::time_point deadline) {
+        auto deadline_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            deadline.time_since_epoch()).count();
+        struct timespec abs_timeout;
+        abs_timeout.tv_sec = static_cast<time_t>(deadline_ns / 1000000000LL);
+        abs_timeout.tv_nsec = static_cast<long>(deadline_ns % 1000000000LL);
+
+        waiters_.fetch_add(1);
+        while (version_.load() == seen) {
+            // steady_clock is CLOCK_MONOTONIC, the FUTEX_WAIT_BITSET default
+            long result = syscall(SYS_futex, reinterpret_cast<uint32_t*>(&version_),
+                                  FUTEX_WAIT_BITSET_PRIVATE, seen, &abs_timeout, nullptr,
+                                  FUTEX_BITSET_MATCH_ANY);
+            if (result == -1 && errno == ETIMEDOUT) {
+                break;
+            }
+        }
+        waiters_.fetch_sub(1);
+        return version_.load() != seen;
+    }
+
+private:
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+                  "futex word must be a plain lock-free 32-bit atomic");
+
+    std::atomic<uint32_t> version_;     // Bumped on every input change (futex word)
+    std::atomic<int> waiters_;          // Threads inside wait_until()
+};
+
+#endif // CHANGE_SIGNAL_H
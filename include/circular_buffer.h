@@ -1,6 +1,7 @@
 #ifndef CIRCULAR_BUFFER_H
 #define CIRCULAR_BUFFER_H
 
+#include "log_limiter.h"
 #include <mutex>
 #include <condition_variable>
 #include <cstddef>
@@ -114,6 +115,8 @@ private:
     size_t read_index_;               // Consumer read position
     size_t write_index_;              // Producer write position
     size_t count_;                    // Current number of elements
+    long overwrite_count_;            // Samples discarded while full
+    Logger::SiteRateLimiter overwrite_log_limiter_;   // Per buffer; overwrites are steady state, so DEBUG only
 
     mutable std::mutex mutex_;        // Mutex for critical section protection
     std::condition_variable not_full_;  // Condition: buffer is not full
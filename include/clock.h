@@ -0,0 +1,204 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include "change_signal.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file clock.h
+ * @brief Time source injected into the tasks
+ *
+ * The tasks read the time, timestamp their records and sleep through a
+ * Clock instead of calling std::chrono and std::this_thread directly.
+ * SystemClock, the default (Clock::system()), maps to steady_clock,
+ * system_clock and sleep_until. SimulatedClock advances virtual time only
+ * when every task is asleep, so a scenario runs as fast as the tasks
+ * execute and gives the same results on every run.
+ *
+ * A task thread takes part in the clock's scheduling through an ID
+ * registered in start(), on the caller's thread:
+ *
+ *   clock_thread_ = clock_->register_thread("SensorProcessing");
+ *   // task thread:
+ *   clock_->begin_thread(clock_thread_);
+ *   ... clock_->sleep_until(clock_thread_, next_execution); ...
+ *   // stop(), before join():
+ *   clock_->release_thread(clock_thread_);
+ */
+
+constexpr int64_t SIMULATED_CLOCK_WALL_START_US = 1767225600000000LL;   // 2026-01-01T00:00:00Z
+constexpr int64_t SIMULATED_CLOCK_STEADY_START_NS = 1000000000LL;       // Nonzero, like CLOCK_MONOTONIC
+
+class Clock {
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    virtual ~Clock() = default;
+
+    /**
+     * @brief Monotonic time (steady_clock)
+     */
+    virtual time_point now() const = 0;
+
+    /**
+     * @brief Wall clock time in microseconds since the epoch (system_clock)
+     */
+    virtual int64_t wall_us() const = 0;
+
+    long long now_ns() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(now().time_since_epoch()).count();
+    }
+
+    long wall_ms() const { return static_cast<long>(wall_us() / 1000); }
+
+    /**
+     * @brief Register a task thread before it is started
+     *
+     * @param name Thread name (for diagnostics)
+     * @return ID to pass to the thread calls below
+     */
+    virtual int register_thread(const std::string& name) = 0;
+
+    /**
+     * @brief First call on the task thread; returns when it may run
+     */
+    virtual void begin_thread(int id) = 0;
+
+    /**
+     * @brief Let a stopping thread run to its exit (call before join())
+     */
+    virtual void release_thread(int id) = 0;
+
+    /**
+     * @brief Sleep until deadline
+     */
+    virtual void sleep_until(int id, time_point deadline) = 0;
+
+    /**
+     * @brief Sleep until signal's version differs from seen or deadline passes
+     */
+    virtual void wait_until(int id, ChangeSignal& signal, uint32_t seen, time_point deadline) = 0;
+
+    /**
+     * @brief Process-wide real time clock
+     */
+    static Clock& system();
+};
+
+/**
+ * @brief Real time: steady_clock, system_clock and the kernel's sleeps
+ */
+class SystemClock : public Clock {
+public:
+    time_point now() const override { return std::chrono::steady_clock::now(); }
+
+    int64_t wall_us() const override {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    int register_thread(const std::string&) override { return 0; }
+    void begin_thread(int) override {}
+    void release_thread(int) override {}
+
+    void sleep_until(int, time_point deadline) override {
+        std::this_thread::sleep_until(deadline);
+    }
+
+    void wait_until(int, ChangeSignal& signal, uint32_t seen, time_point deadline) override {
+        signal.wait_until(seen, deadline);
+    }
+};
+
+/**
+ * @brief Virtual time advanced deterministically by a driver
+ *
+ * Registered threads run one at a time. The driver (the thread calling
+ * run_until()) hands the turn to the registered thread with the earliest
+ * wake time, ties going to the earliest registered, and sets the time to
+ * that wake time. The thread runs its cycle, with the time frozen, until it
+ * sleeps again. A thread waiting on a ChangeSignal is due as soon as the
+ * signal's version has changed. When no thread is due before the end of
+ * the run, the time jumps to the end and run_until() returns.
+ *
+ * Because exactly one thread runs at a time and the order only depends on
+ * virtual time, a scenario whose inputs are set by the driver between
+ * run_until() calls gives bit-identical results on every run. Threads that
+ * are not registered (the main loop, FaultEventDispatcher, the DataCollector
+ * writer) keep running in real time and read the virtual time; their
+ * output is reproducible only as far as it does not depend on when they
+ * run. A registered thread must not block on anything but this clock while
+ * it holds the turn.
+ *
+ * Register and start all the tasks before the first run_until(), and stop
+ * them after the last one returns.
+ */
+class SimulatedClock : public Clock {
+public:
+    explicit SimulatedClock(int64_t wall_start_us = SIMULATED_CLOCK_WALL_START_US);
+
+    time_point now() const override {
+        return time_point(std::chrono::nanoseconds(now_ns_.load(std::memory_order_acquire)));
+    }
+
+    int64_t wall_us() const override {
+        return wall_start_us_ + (now_ns_.load(std::memory_order_acquire) - SIMULATED_CLOCK_STEADY_START_NS) / 1000;
+    }
+
+    int register_thread(const std::string& name) override;
+    void begin_thread(int id) override;
+    void release_thread(int id) override;
+    void sleep_until(int id, time_point deadline) override;
+    void wait_until(int id, ChangeSignal& signal, uint32_t seen, time_point deadline) override;
+
+    /**
+     * @brief Run the registered threads until the virtual time reaches end
+     */
+    void run_until(time_point end);
+
+    void run_for(std::chrono::nanoseconds duration) { run_until(now() + duration); }
+
+    /**
+     * @brief Number of turns handed to the threads so far
+     */
+    long get_turns() const { return turns_; }
+
+private:
+    struct SimulatedThread {
+        std::string name;
+        bool waiting = false;           // Blocked in the clock, turn given back
+        bool released = false;
+        time_point wake;
+        ChangeSignal* signal = nullptr; // wait_until(): due once the version moves
+        uint32_t seen = 0;
+        std::unique_ptr<std::condition_variable> turn_given;
+    };
+
+    /**
+     * @brief Give the turn back and block until it returns (mutex_ held)
+     */
+    void yield(std::unique_lock<std::mutex>& lock, int id);
+
+    /**
+     * @brief Move the virtual time forward (never back)
+     */
+    void advance_to(time_point time);
+
+    int64_t wall_start_us_;
+    std::atomic<long long> now_ns_;
+    std::mutex mutex_;
+    std::condition_variable turn_returned_;     // Driver wakeup
+    std::vector<SimulatedThread> threads_;
+    int turn_;                          // Thread holding the turn, -1 for the driver
+    long turns_;
+};
+
+#endif // CLOCK_H
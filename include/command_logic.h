@@ -2,8 +2,17 @@
 #define COMMAND_LOGIC_H
 
 #include "circular_buffer.h"
+#include "clock.h"
 #include "common_types.h"
 #include "performance_monitor.h"
+#include "rt_worker_pool.h"
+#include "watchdog.h"
+#include "fault_status.h"
+#include "command_mode_machine.h"
+#include "mpsc_queue.h"
+#include "change_signal.h"
+#include "telemetry_capture.h"
+#include <array>
 #include <thread>
 #include <atomic>
 #include <mutex>
@@ -16,6 +25,16 @@ constexpr int MIN_STEERING_ANGLE = -180;
 constexpr int MAX_VELOCITY = 100;
 constexpr int MIN_VELOCITY = -100;
 constexpr int MANUAL_MODE_TIMEOUT_MS = 1000;
+constexpr size_t COMMAND_QUEUE_CAPACITY = 64;
+constexpr int COMMAND_LOGIC_DEFAULT_IDLE_WAKEUP_MS = 15;
+
+/**
+ * @brief Operator command stamped when it was queued
+ */
+struct TimedCommand {
+    OperatorCommand command;
+    long long enqueued_ns;   // Steady clock time of set_command()
+};
 
 /**
  * @brief Command Logic Task
@@ -25,15 +44,27 @@ constexpr int MANUAL_MODE_TIMEOUT_MS = 1000;
  *
  * 1. Reads processed sensor data from circular buffer (Consumer)
  * 2. Monitors fault conditions
- * 3. Processes operator commands (mode switches, rearm)
+ * 3. Drains queued operator commands (mode switches, rearm, motion)
  * 4. Determines truck state (manual/automatic, fault/ok)
  * 5. Calculates actuator outputs based on current mode
  *
- * State Machine:
+ * State Machine (COMMAND_MODE_TABLE in command_mode_machine.h):
  * - Manual Mode: Direct operator control of velocity/steering
  * - Automatic Mode: Navigation control determines outputs
  * - Fault State: Overrides other states, requires rearm
  *
+ * Every input is mapped to a CommandModeEvent and applied with a single
+ * table lookup; each mode change is traced as a mode_transition event.
+ *
+ * Change-Driven Cycle:
+ * - Commands, navigation output changes, fault word changes and the
+ *   watchdog safe-output release bump an input version (ChangeSignal).
+ * - The task runs at most once per period and otherwise sleeps until the
+ *   version changes or the manual-mode timeout expires; state_mutex_ is
+ *   only taken when there is something to apply.
+ * - With unchanged inputs it still wakes every idle_wakeup_ms to report
+ *   its watchdog heartbeat.
+ *
  * Real-Time Automation Concepts:
  * - State machine implementation
  * - Consumer in Producer-Consumer pattern
@@ -72,13 +103,34 @@ public:
     bool is_running() const { return running_; }
 
     /**
-     * @brief Set operator command (from Local Interface)
+     * @brief Queue an operator command (from Local Interface / bridge)
      *
-     * Thread-safe method to receive commands from operator.
+     * Lock-free and safe to call from any number of threads; never waits
+     * on state_mutex_. The task drains the queue every cycle:
+     * - Discrete inputs (auto/manual mode, rearm) are applied one by one
+     *   in arrival order, so none is lost within a period.
+     * - Continuous inputs are coalesced: the newest accelerate value wins
+     *   and steering deltas are summed.
      *
      * @param cmd Operator command structure
+     * @return false if the queue was full and the command was dropped
+     */
+    bool set_command(const OperatorCommand& cmd);
+
+    /**
+     * @brief Get the deepest command queue observed at drain time
+     */
+    size_t get_max_command_queue_depth() const { return max_command_queue_depth_; }
+
+    /**
+     * @brief Get number of commands dropped because the queue was full
+     */
+    long get_dropped_command_count() const { return dropped_command_count_; }
+
+    /**
+     * @brief Get number of continuous commands merged into a later one
      */
-    void set_command(const OperatorCommand& cmd);
+    long get_coalesced_command_count() const { return coalesced_command_count_; }
 
     /**
      * @brief Get current truck state
@@ -117,11 +169,109 @@ public:
     void set_navigation_output(const ActuatorOutput& output);
 
     /**
-     * @brief Handle fault updates from Fault Monitoring task
+     * @brief Signal to notify when an externally published input changes
      *
-     * @param type Current fault type
+     * Pass to FaultMonitoring::add_fault_listener() so a new fault wakes
+     * the task immediately instead of at its next idle wakeup.
+     */
+    ChangeSignal& get_input_signal() { return input_signal_; }
+
+    /**
+     * @brief Set the longest sleep while inputs are unchanged
+     *
+     * Must stay below the watchdog timeout. Must be called before start().
+     *
+     * @param idle_wakeup_ms Idle heartbeat interval in milliseconds
+     */
+    void set_idle_wakeup_ms(int idle_wakeup_ms);
+
+    /**
+     * @brief Get number of cycles that applied changed inputs
+     */
+    long get_work_cycle_count() const { return work_cycle_count_; }
+
+    /**
+     * @brief Get number of heartbeat-only cycles (inputs unchanged)
+     */
+    long get_idle_cycle_count() const { return idle_cycle_count_; }
+
+    /**
+     * @brief Attach the fault word published by Fault Monitoring
+     *
+     * Polled lock-free every cycle; a new fault stops the outputs in the
+     * same cycle it is observed. Must be called before start().
+     *
+     * @param status Fault word (nullptr disables fault polling)
+     */
+    void set_fault_status(const FaultStatus* status);
+
+    /**
+     * @brief Force zero actuator output without taking any lock
+     *
+     * Used by the watchdog when a task stops reporting. While engaged,
+     * get_state() reports a fault and get_actuator_output() returns a
+     * stopped truck even if this task's own thread is hung. Each call
+     * must be paired with one release_safe_output(); several tasks may be
+     * in an outage at once.
+     */
+    void engage_safe_output();
+
+    /**
+     * @brief Release one engagement; the last one releases the safe output and latches a fault
+     *
+     * Lock-free like engage_safe_output(): it runs on the watchdog thread,
+     * which must not block on a hung CommandLogic. The fault is latched
+     * by this task's next cycle, and get_state() and get_actuator_output()
+     * report the safe output until then. The truck stays in fault state
+     * until the operator rearms.
+     */
+    void release_safe_output();
+
+    /**
+     * @brief Attach the watchdog heartbeat slot reported every cycle
+     *
+     * Must be called before start().
+     *
+     * @param handle Handle returned by Watchdog::register_task()
+     */
+    void set_heartbeat_handle(Watchdog::HeartbeatHandle handle);
+
+    /**
+     * @brief Capture every actuator output change and TruckState transition
+     *
+     * The state and output at start() are captured too, so the capture
+     * log can be replayed from its first record. Must be called before
+     * start().
+     *
+     * @param capture Capture ring (nullptr disables capture)
+     */
+    void set_telemetry_capture(TelemetryCapture* capture);
+
+    /**
+     * @brief Use a different time source (simulation)
+     *
+     * Also restarts the manual-mode timeout from the new clock's time.
+     * Must be called before start().
+     *
+     * @param clock Clock for command timing and the task's sleeps
      */
-    void on_fault_update(FaultType type);
+    void set_clock(Clock* clock);
+
+    /**
+     * @brief Run the cycle as a job of a shared worker pool (fleet mode)
+     *
+     * Must be called before start(). start() then adds a job released
+     * every period instead of starting a thread: input changes are picked
+     * up at the next release rather than waking the task at once.
+     *
+     * @param pool Worker pool (nullptr: own thread)
+     */
+    void set_worker_pool(RtWorkerPool* pool);
+
+    /**
+     * @brief Get number of mode changes applied since construction
+     */
+    long get_mode_transition_count() const { return mode_transition_count_; }
 
 private:
     /**
@@ -130,15 +280,76 @@ private:
     void task_loop();
 
     /**
-     * @brief Process operator commands and update state
+     * @brief One cycle: apply changed inputs, or only beat the heartbeat
+     *
+     * @param start_time Cycle start
+     * @return true if inputs had changed and were applied
+     */
+    bool run_cycle(Clock::time_point start_time);
+
+    /**
+     * @brief Apply a fault change observed in the fault word
+     *
+     * Caller must hold state_mutex_.
+     *
+     * @param type Current fault type
      */
-    void process_commands();
+    void apply_fault_update(FaultType type);
+
+    /**
+     * @brief Move every queued command into a local batch (no locks)
+     *
+     * @param batch Destination batch
+     * @return size_t Number of commands drained
+     */
+    size_t drain_commands(std::array<TimedCommand, COMMAND_QUEUE_CAPACITY>& batch);
+
+    /**
+     * @brief Apply a drained batch (caller must hold state_mutex_)
+     *
+     * @param batch Commands in arrival order
+     * @param count Number of commands in the batch
+     */
+    void apply_commands(const std::array<TimedCommand, COMMAND_QUEUE_CAPACITY>& batch, size_t count);
+
+    /**
+     * @brief Apply the mode switch / rearm part of one command
+     *
+     * @param cmd Operator command
+     */
+    void apply_discrete_command(const OperatorCommand& cmd);
+
+    /**
+     * @brief Step the mode state machine (caller must hold state_mutex_)
+     *
+     * Looks the event up in COMMAND_MODE_TABLE, runs the entry's actions,
+     * and traces the transition if the mode changed.
+     *
+     * @param event Input event
+     */
+    void dispatch_mode_event(CommandModeEvent event);
 
     /**
      * @brief Calculate actuator outputs based on current mode and commands
      */
     void calculate_actuator_outputs();
 
+    /**
+     * @brief Time at which the manual-mode timeout will stop the truck
+     *
+     * Caller must hold state_mutex_.
+     *
+     * @return Deadline, or time_point::max() if no timeout is pending
+     */
+    Clock::time_point manual_timeout_deadline() const;
+
+    /**
+     * @brief Capture actuator_output_ if it changed since the last capture
+     *
+     * Caller must hold state_mutex_.
+     */
+    void capture_actuator_output();
+
     CircularBuffer& buffer_;            // Reference to shared buffer
     int period_ms_;                     // Task period in milliseconds
 
@@ -147,19 +358,47 @@ private:
 
     // Protected state variables
     mutable std::mutex state_mutex_;
-    TruckState current_state_;          // Current operational state
+    CommandMode mode_;                  // State machine mode
+    TruckState current_state_;          // Flags derived from mode_
     ActuatorOutput actuator_output_;    // Current actuator values
     SensorData latest_sensor_data_;     // Latest sensor reading
-    OperatorCommand pending_command_;   // Pending operator command
+    OperatorCommand pending_command_;   // Coalesced continuous inputs (accelerate, steering)
     ActuatorOutput navigation_output_;  // Output from navigation control
 
-    bool command_pending_;              // Flag for new command
-    bool fault_rearmed_;                // Flag for fault rearm action
+    std::atomic<int> safe_output_engagements_;  // Watchdog outages holding the safe output
+    std::atomic<bool> fault_latch_requested_;   // Last outage recovered, latch on the next cycle
+
+    bool safe_output_active() const;
+
+    MpscQueue<TimedCommand, COMMAND_QUEUE_CAPACITY> command_queue_; // Lock-free operator command queue
+    std::atomic<size_t> max_command_queue_depth_;   // Deepest queue seen at drain
+    std::atomic<long> dropped_command_count_;       // Commands rejected by a full queue
+    std::atomic<long> coalesced_command_count_;     // Continuous commands merged
+
+    std::atomic<long> mode_transition_count_;       // Mode changes applied
     FaultType latest_fault_type_;       // Current fault status from monitoring
 
-    std::chrono::steady_clock::time_point last_command_time_; // Timestamp of last command
+    const FaultStatus* fault_status_;   // Lock-free fault word (optional)
+    uint32_t observed_fault_sequence_;  // Last fault word change applied
+
+    Clock::time_point last_command_time_; // Timestamp of last command
+
+    ChangeSignal input_signal_;         // Input version and task wakeup
+    uint32_t observed_input_version_;   // input_signal_ version last applied
+    Clock::time_point manual_deadline_; // Manual-mode timeout to wake for
+    int idle_wakeup_ms_;                // Longest sleep with unchanged inputs
+    TelemetryCapture* capture_;         // Full-rate capture (optional)
+    ActuatorOutput captured_output_;    // Last actuator output captured
+    std::atomic<long> work_cycle_count_;    // Cycles that applied inputs
+    std::atomic<long> idle_cycle_count_;    // Heartbeat-only cycles
+
+    Watchdog::HeartbeatHandle heartbeat_handle_; // Watchdog heartbeat slot
 
     PerformanceMonitor* perf_monitor_;  // Performance monitoring (optional)
+    Clock* clock_;                      // Time source (Clock::system() by default)
+    int clock_thread_;                  // Task thread's ID in clock_
+    RtWorkerPool* worker_pool_;         // Runs the cycle instead of task_thread_ (optional)
+    RtWorkerPool::JobId pool_job_;
 };
 
 #endif // COMMAND_LOGIC_H
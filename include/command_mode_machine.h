@@ -0,0 +1,225 @@
+#ifndef COMMAND_MODE_MACHINE_H
+#define COMMAND_MODE_MACHINE_H
+
+#include "common_types.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Operating modes of the Command Logic state machine
+ */
+enum class CommandMode : uint8_t {
+    MANUAL,
+    AUTOMATIC,
+    FAULT       // Latched; outputs stopped, manual until rearmed
+};
+
+constexpr size_t COMMAND_MODE_COUNT = 3;
+
+/**
+ * @brief Inputs of the Command Logic state machine
+ */
+enum class CommandModeEvent : uint8_t {
+    AUTO_REQUEST,          // Operator c_automatico
+    MANUAL_REQUEST,        // Operator c_man
+    REARM_FAULT_CLEARED,   // Operator c_rearme, no fault active
+    REARM_FAULT_ACTIVE,    // Operator c_rearme, fault still active
+    FAULT_DETECTED,        // Fault Monitoring reported a fault
+    FAULT_LATCHED          // Watchdog released its safe output
+};
+
+constexpr size_t COMMAND_MODE_EVENT_COUNT = 6;
+
+/**
+ * @brief Side effects of a transition (bit flags)
+ */
+enum CommandModeAction : uint8_t {
+    MODE_ACTION_NONE = 0,
+    MODE_ACTION_REJECT_AUTO = 1 << 0,     // Log mode_reject (fault)
+    MODE_ACTION_REARM_FAILED = 1 << 1,    // Log rearm_failed
+    MODE_ACTION_REPORT_FAULT = 1 << 2     // Log fault_detected_ext
+};
+
+/**
+ * @brief One table entry: next mode and actions to run
+ */
+struct CommandModeTransition {
+    CommandMode next;
+    uint8_t actions;
+};
+
+using CommandModeTable = std::array<std::array<CommandModeTransition, COMMAND_MODE_EVENT_COUNT>, COMMAND_MODE_COUNT>;
+
+/**
+ * @brief Transition rules (the single source of the mode logic)
+ *
+ * The switch statements have no default branch so -Wswitch reports any
+ * mode or event added without a rule.
+ */
+constexpr CommandModeTransition command_mode_rule(CommandMode mode, CommandModeEvent event) {
+    switch (event) {
+        case CommandModeEvent::FAULT_DETECTED:
+        case CommandModeEvent::FAULT_LATCHED:
+            return {CommandMode::FAULT,
+                    static_cast<uint8_t>(mode == CommandMode::FAULT || event == CommandModeEvent::FAULT_LATCHED
+                                             ? MODE_ACTION_NONE
+                                             : MODE_ACTION_REPORT_FAULT)};
+        case CommandModeEvent::AUTO_REQUEST:
+            switch (mode) {
+                case CommandMode::MANUAL:    return {CommandMode::AUTOMATIC, MODE_ACTION_NONE};
+                case CommandMode::AUTOMATIC: return {CommandMode::AUTOMATIC, MODE_ACTION_NONE};
+                case CommandMode::FAULT:     return {CommandMode::FAULT, MODE_ACTION_REJECT_AUTO};
+            }
+            break;
+        case CommandModeEvent::MANUAL_REQUEST:
+            switch (mode) {
+                case CommandMode::MANUAL:    return {CommandMode::MANUAL, MODE_ACTION_NONE};
+                case CommandMode::AUTOMATIC: return {CommandMode::MANUAL, MODE_ACTION_NONE};
+                case CommandMode::FAULT:     return {CommandMode::FAULT, MODE_ACTION_NONE};
+            }
+            break;
+        case CommandModeEvent::REARM_FAULT_CLEARED:
+            return {mode == CommandMode::FAULT ? CommandMode::MANUAL : mode, MODE_ACTION_NONE};
+        case CommandModeEvent::REARM_FAULT_ACTIVE:
+            return {mode,
+                    static_cast<uint8_t>(mode == CommandMode::FAULT ? MODE_ACTION_REARM_FAILED : MODE_ACTION_NONE)};
+    }
+    return {CommandMode::FAULT, MODE_ACTION_NONE};
+}
+
+/**
+ * @brief Build the modes x events table from command_mode_rule()
+ */
+constexpr CommandModeTable make_command_mode_table() {
+    CommandModeTable table{};
+    for (size_t mode = 0; mode < COMMAND_MODE_COUNT; mode++) {
+        for (size_t event = 0; event < COMMAND_MODE_EVENT_COUNT; event++) {
+            table[mode][event] = command_mode_rule(static_cast<CommandMode>(mode),
+                                                   static_cast<CommandModeEvent>(event));
+        }
+    }
+    return table;
+}
+
+inline constexpr CommandModeTable COMMAND_MODE_TABLE = make_command_mode_table();
+
+/**
+ * @brief Runtime step: one table lookup
+ */
+constexpr CommandModeTransition command_mode_step(CommandMode mode, CommandModeEvent event) {
+    return COMMAND_MODE_TABLE[static_cast<size_t>(mode)][static_cast<size_t>(event)];
+}
+
+/**
+ * @brief Truck state flags reported for a mode
+ */
+constexpr TruckState truck_state_for(CommandMode mode) {
+    return TruckState{mode == CommandMode::FAULT, mode == CommandMode::AUTOMATIC};
+}
+
+constexpr const char* command_mode_name(CommandMode mode) {
+    switch (mode) {
+        case CommandMode::MANUAL:    return "MANUAL";
+        case CommandMode::AUTOMATIC: return "AUTO";
+        case CommandMode::FAULT:     return "FAULT";
+    }
+    return "UNK";
+}
+
+constexpr const char* command_mode_event_name(CommandModeEvent event) {
+    switch (event) {
+        case CommandModeEvent::AUTO_REQUEST:        return "auto_req";
+        case CommandModeEvent::MANUAL_REQUEST:      return "manual_req";
+        case CommandModeEvent::REARM_FAULT_CLEARED: return "rearm";
+        case CommandModeEvent::REARM_FAULT_ACTIVE:  return "rearm_active_fault";
+        case CommandModeEvent::FAULT_DETECTED:      return "fault";
+        case CommandModeEvent::FAULT_LATCHED:       return "watchdog_latch";
+    }
+    return "unk";
+}
+
+// ---------------------------------------------------------------------------
+// Compile-time verification of every (mode, event) entry
+// ---------------------------------------------------------------------------
+
+namespace command_mode_checks {
+
+constexpr bool all_entries_valid() {
+    for (const auto& row : COMMAND_MODE_TABLE) {
+        for (const auto& entry : row) {
+            if (static_cast<size_t>(entry.next) >= COMMAND_MODE_COUNT) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+constexpr bool faults_always_latch() {
+    for (size_t mode = 0; mode < COMMAND_MODE_COUNT; mode++) {
+        if (COMMAND_MODE_TABLE[mode][static_cast<size_t>(CommandModeEvent::FAULT_DETECTED)].next != CommandMode::FAULT ||
+            COMMAND_MODE_TABLE[mode][static_cast<size_t>(CommandModeEvent::FAULT_LATCHED)].next != CommandMode::FAULT) {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr bool fault_left_only_by_successful_rearm() {
+    const auto& row = COMMAND_MODE_TABLE[static_cast<size_t>(CommandMode::FAULT)];
+    for (size_t event = 0; event < COMMAND_MODE_EVENT_COUNT; event++) {
+        bool rearm = static_cast<CommandModeEvent>(event) == CommandModeEvent::REARM_FAULT_CLEARED;
+        CommandMode expected = rearm ? CommandMode::MANUAL : CommandMode::FAULT;
+        if (row[event].next != expected) {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr bool automatic_entered_only_from_manual_request() {
+    for (size_t mode = 0; mode < COMMAND_MODE_COUNT; mode++) {
+        for (size_t event = 0; event < COMMAND_MODE_EVENT_COUNT; event++) {
+            bool enters_auto = static_cast<CommandMode>(mode) != CommandMode::AUTOMATIC &&
+                               COMMAND_MODE_TABLE[mode][event].next == CommandMode::AUTOMATIC;
+            bool allowed = static_cast<CommandMode>(mode) == CommandMode::MANUAL &&
+                           static_cast<CommandModeEvent>(event) == CommandModeEvent::AUTO_REQUEST;
+            if (enters_auto && !allowed) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+constexpr bool all_modes_reachable_from_manual() {
+    bool reached[COMMAND_MODE_COUNT] = {};
+    reached[static_cast<size_t>(CommandMode::MANUAL)] = true;
+    for (size_t pass = 0; pass < COMMAND_MODE_COUNT; pass++) {
+        for (size_t mode = 0; mode < COMMAND_MODE_COUNT; mode++) {
+            if (!reached[mode]) {
+                continue;
+            }
+            for (const auto& entry : COMMAND_MODE_TABLE[mode]) {
+                reached[static_cast<size_t>(entry.next)] = true;
+            }
+        }
+    }
+    for (bool mode_reached : reached) {
+        if (!mode_reached) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(all_entries_valid(), "Command mode table has an out-of-range next mode");
+static_assert(faults_always_latch(), "Every mode must latch FAULT on a fault event");
+static_assert(fault_left_only_by_successful_rearm(), "FAULT may only be left by a rearm with no active fault");
+static_assert(automatic_entered_only_from_manual_request(), "AUTOMATIC may only be entered from MANUAL on request");
+static_assert(all_modes_reachable_from_manual(), "Every mode must be reachable from MANUAL");
+
+} // namespace command_mode_checks
+
+#endif // COMMAND_MODE_MACHINE_H
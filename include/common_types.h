@@ -1,6 +1,11 @@
 #ifndef COMMON_TYPES_H
 #define COMMON_TYPES_H
 
+#include <cstddef>
+#include <cstdint>
+
+constexpr size_t CACHE_LINE_SIZE_BYTES = 64;
+
 /**
  * @brief Truck operation states
  *
@@ -72,7 +77,22 @@ enum class FaultType {
     TEMPERATURE_ALERT,    // T > 95°C
     TEMPERATURE_CRITICAL, // T > 120°C
     ELECTRICAL,           // Electrical system fault
-    HYDRAULIC             // Hydraulic system fault
+    HYDRAULIC,            // Hydraulic system fault
+    STALE_DATA            // Periodic input older than its max age
 };
 
+constexpr size_t FAULT_TYPE_COUNT = 6;  // Including NONE
+
+/**
+ * @brief Set of simultaneously active faults (one bit per FaultType)
+ */
+using FaultMask = uint32_t;
+
+/**
+ * @brief Bit of a fault type in a FaultMask (NONE has no bit)
+ */
+constexpr FaultMask fault_bit(FaultType type) {
+    return type == FaultType::NONE ? 0 : FaultMask{1} << static_cast<unsigned>(type);
+}
+
 #endif // COMMON_TYPES_H
@@ -1,15 +1,43 @@
 #ifndef DATA_COLLECTOR_H
 #define DATA_COLLECTOR_H
 
+#include "best_effort_executor.h"
+#include "change_signal.h"
 #include "circular_buffer.h"
+#include "clock.h"
 #include "common_types.h"
+#include "log_limiter.h"
+#include "mpsc_queue.h"
 #include "performance_monitor.h"
+#include "rt_worker_pool.h"
+#include "rotating_log_file.h"
+#include "telemetry_capture.h"
+#include "telemetry_store.h"
+#include "watchdog.h"
 #include <thread>
 #include <atomic>
+#include <chrono>
 #include <mutex>
-#include <fstream>
 #include <string>
 
+constexpr size_t DATA_COLLECTOR_QUEUE_CAPACITY = 1024;
+constexpr int DATA_COLLECTOR_COMMIT_INTERVAL_MS = 1000;
+constexpr size_t DATA_COLLECTOR_COMMIT_BYTES = 64 * 1024;
+constexpr int DATA_COLLECTOR_DURABLE_TIMEOUT_MS = 500;
+constexpr size_t DATA_COLLECTOR_STATE_BYTES = 16;
+constexpr size_t DATA_COLLECTOR_DESCRIPTION_BYTES = 96;
+constexpr int DATA_COLLECTOR_TELEMETRY_FLUSH_MS = 60000;    // Longest a row waits for its segment to be sealed
+constexpr int DATA_COLLECTOR_WRITER_POLL_MS = 100;          // Writer job period on an executor
+constexpr int DATA_COLLECTOR_RETENTION_IDLE_MS = 60000;     // Store retention backstop (woken on rollover)
+
+/**
+ * @brief When log_event() may return relative to the record reaching disk
+ */
+enum class LogDurability {
+    BUFFERED,   // Return once queued; written by the next group commit
+    DURABLE     // Force a commit and wait until the record is fdatasync'ed
+};
+
 /**
  * @brief Event log entry structure
  */
@@ -33,9 +61,41 @@ struct EventLog {
  *
  * Logs are stored in CSV format for easy analysis.
  *
+ * log_event() never touches the file: it copies the record into a
+ * lock-free MPSC queue and returns. A writer thread drains the queue,
+ * formats the whole batch into one buffer and group-commits it with a
+ * single write() + fdatasync() when the commit interval elapses, the
+ * batch reaches the byte threshold, or a DURABLE record (fault events)
+ * arrives. A DURABLE caller blocks until its record is on disk.
+ *
+ * The CSV logs are RotatingLogFile segments (rotating_log_file.h):
+ * preallocated, rolled by size and age, gzip-compressed once closed and
+ * pruned by a retention policy, so a long shift never grows one file.
+ *
+ * With the telemetry store enabled the writer also appends every record
+ * to a columnar file (telemetry_store.h),
+ * logs/truck_<id>_<start_ms>_<seq>.tlm, about 7x smaller than the CSV. Its
+ * segments are sealed when full or DATA_COLLECTOR_TELEMETRY_FLUSH_MS after
+ * the previous seal; the CSV remains the durable record. The store follows
+ * the CSV rotation policy: once the file reaches segment_bytes or is
+ * segment_ms old it is closed (footer written) and a new file is started,
+ * its <seq> keeping two rollovers in one millisecond apart. As for the CSV
+ * segments, retention runs on a background thread, not in the commit: it
+ * deletes the oldest closed store files beyond retain_segments /
+ * retain_bytes after each rollover.
+ *
+ * With a TelemetryCapture attached, the writer also drains its staging
+ * ring (every sensor sample, actuator change and state transition) into
+ * logs/truck_<id>_capture.csv, on the same group commit schedule.
+ *
+ * With a BestEffortExecutor, the writer and the periodic status record
+ * are executor jobs instead of threads. The writer job runs every
+ * DATA_COLLECTOR_WRITER_POLL_MS and is woken like the thread, so a timed
+ * commit may run up to one poll period late.
+ *
  * Real-Time Automation Concepts:
  * - Data logging and persistence
- * - File I/O with mutex protection
+ * - Group-committed file I/O off the producer threads
  * - System monitoring and diagnostics
  */
 class DataCollector {
@@ -71,22 +131,71 @@ public:
     bool is_running() const { return running_; }
 
     /**
-     * @brief Log an event to disk
+     * @brief Queue an event for the CSV log (any thread)
+     *
+     * State and description are truncated to DATA_COLLECTOR_STATE_BYTES and
+     * DATA_COLLECTOR_DESCRIPTION_BYTES.
      *
      * @param event Event log entry to write
+     * @param durability BUFFERED returns at once; DURABLE waits for the commit
+     * @return false if the record was dropped (queue full) or, for DURABLE,
+     *         not committed within DATA_COLLECTOR_DURABLE_TIMEOUT_MS
      */
-    void log_event(const EventLog& event);
+    bool log_event(const EventLog& event, LogDurability durability = LogDurability::BUFFERED);
 
     /**
-     * @brief Log an event with description
+     * @brief Queue an event with description (any thread)
      *
      * @param state Truck state description
      * @param position_x X coordinate
      * @param position_y Y coordinate
      * @param description Event description
+     * @param durability BUFFERED returns at once; DURABLE waits for the commit
+     * @return false if the record was dropped or a DURABLE commit timed out
+     */
+    bool log_event(const std::string& state, int position_x, int position_y,
+                   const std::string& description,
+                   LogDurability durability = LogDurability::BUFFERED);
+
+    /**
+     * @brief Set the group commit triggers
+     *
+     * Must be called before start().
+     *
+     * @param interval_ms Longest time a buffered record waits for a commit
+     * @param flush_bytes Formatted batch size that forces a commit
+     */
+    void set_group_commit(int interval_ms, size_t flush_bytes);
+
+    /**
+     * @brief Set segment rotation, preallocation and retention of the logs
+     *
+     * Applies to both CSV logs and, by size, age and retention, to the
+     * telemetry store files. Must be called before start().
+     */
+    void set_log_rotation(const RotatingLogConfig& config);
+
+    /**
+     * @brief Also write records to the columnar telemetry store
+     *
+     * Must be called before start().
+     */
+    void set_telemetry_store(bool enabled);
+
+    /**
+     * @brief Drain a full-rate capture ring to the capture CSV
+     *
+     * Must be called before start().
+     *
+     * @param capture Capture ring fed by the RT tasks (nullptr disables it)
      */
-    void log_event(const std::string& state, int position_x, int position_y,
-                   const std::string& description);
+    void set_telemetry_capture(TelemetryCapture* capture);
+
+    long get_capture_written() const { return capture_written_.load(); }
+
+    long get_records_written() const { return records_written_.load(); }
+    long get_commit_count() const { return commit_count_.load(); }
+    long get_dropped_records() const { return dropped_records_.load(); }
 
     /**
      * @brief Set current truck state (from Command Logic)
@@ -95,12 +204,72 @@ public:
      */
     void set_truck_state(const TruckState& state);
 
+    /**
+     * @brief Attach the watchdog heartbeat slot reported every cycle
+     *
+     * Must be called before start().
+     *
+     * @param handle Handle returned by Watchdog::register_task()
+     */
+    void set_heartbeat_handle(Watchdog::HeartbeatHandle handle);
+
+    /**
+     * @brief Use a different time source (simulation)
+     *
+     * Record timestamps and the periodic status task follow the clock.
+     * The writer thread's group commit pacing and the DURABLE wait stay
+     * in real time: they bound disk latency, not truck behaviour. Must be
+     * called before start().
+     *
+     * @param clock Clock for timestamps and the log period sleep
+     */
+    void set_clock(Clock* clock);
+
+    /**
+     * @brief Run the cycle as a job of a shared worker pool (fleet mode)
+     *
+     * Must be called before start(). start() then adds the periodic
+     * status record as a job; the writer keeps its own thread.
+     *
+     * @param pool Worker pool (nullptr: own thread)
+     */
+    void set_worker_pool(RtWorkerPool* pool);
+
+    /**
+     * @brief Run the writer (and, without a worker pool, the status
+     *        record) as best-effort executor jobs
+     *
+     * Must be called before start(). A DURABLE log_event() called from an
+     * executor task helps run queued tasks while it waits for the commit.
+     *
+     * @param executor Executor (nullptr: own threads)
+     */
+    void set_executor(BestEffortExecutor* executor);
+
 private:
+    /**
+     * @brief Queued log record (trivially copyable queue cell)
+     */
+    struct QueuedEvent {
+        long timestamp;
+        int truck_id;
+        int position_x;
+        int position_y;
+        bool durable;
+        char state[DATA_COLLECTOR_STATE_BYTES];
+        char description[DATA_COLLECTOR_DESCRIPTION_BYTES];
+    };
+
     /**
      * @brief Main task loop
      */
     void task_loop();
 
+    /**
+     * @brief One period: log the periodic status record
+     */
+    void run_cycle();
+
     /**
      * @brief Get current timestamp in milliseconds
      *
@@ -108,16 +277,97 @@ private:
      */
     long get_timestamp() const;
 
+    /**
+     * @brief Writer thread: run writer cycles until stopped
+     */
+    void writer_loop();
+
+    /**
+     * @brief Reset the writer's commit and report schedule (before start)
+     */
+    void writer_begin();
+
+    /**
+     * @brief Drain, format and group-commit queued records
+     *
+     * @param running false for the final cycle, which commits everything
+     * @return Latest time for the next cycle
+     */
+    std::chrono::steady_clock::time_point writer_cycle(bool running);
+
+    /**
+     * @brief Wake the writer thread or job early
+     */
+    void wake_writer();
+
+    /**
+     * @brief Append one record as a CSV line to write_buffer_ and as a
+     *        row to the telemetry store
+     */
+    void format_record(const QueuedEvent& event);
+
+    /**
+     * @brief Append + fdatasync() the pending batch (writer thread)
+     *
+     * @param position Queue position just past the last formatted record
+     */
+    void commit(size_t position);
+
+    /**
+     * @brief Append one capture record as a CSV line to capture_buffer_
+     */
+    void format_capture(const CaptureRecord& record);
+
+    /**
+     * @brief Append + fdatasync() the pending capture lines (writer thread)
+     */
+    void commit_capture();
+
     /**
      * @brief Open log file for writing
      */
     void open_log_file();
 
+    /**
+     * @brief Start a new telemetry store file and wake the retention thread
+     */
+    void open_telemetry_store();
+
+    /**
+     * @brief Write the telemetry store footer and close it
+     */
+    void close_telemetry_store();
+
+    /**
+     * @brief Roll the telemetry store if it passed the size or age limit (writer thread)
+     */
+    void rotate_telemetry_store();
+
+    /**
+     * @brief Retention thread: apply store retention on every rollover until stopped
+     */
+    void telemetry_retention_loop();
+
+    /**
+     * @brief Stop the retention thread after a last pass
+     */
+    void stop_telemetry_retention();
+
+    /**
+     * @brief Delete the oldest closed telemetry store files beyond retention (retention thread)
+     */
+    void apply_telemetry_retention();
+
     /**
      * @brief Close log file
      */
     void close_log_file();
 
+    /**
+     * @brief Log a segment rollover of file if its rollover count moved past seen
+     */
+    void report_rollover(const RotatingLogFile& file, long& seen);
+
     CircularBuffer& buffer_;                // Reference to shared buffer
     int truck_id_;                          // Truck ID
     int log_period_ms_;                     // Logging period
@@ -125,14 +375,68 @@ private:
     std::atomic<bool> running_;             // Task execution flag
     std::thread task_thread_;               // Task thread
 
-    mutable std::mutex log_mutex_;          // Protects log file access
-    std::ofstream log_file_;                // Log file stream
+    RotatingLogFile log_file_;              // Log file (writer thread once started)
     std::string log_filename_;              // Log file name
+    RotatingLogConfig rotation_;            // Segment rotation of both CSV logs
+    MpscQueue<QueuedEvent, DATA_COLLECTOR_QUEUE_CAPACITY> event_queue_;
+    ChangeSignal writer_signal_;            // Producers -> writer (durable record or queue filling up)
+    ChangeSignal commit_signal_;            // Writer -> DURABLE callers
+    std::atomic<size_t> committed_position_; // Queue positions below this are on disk
+    std::thread writer_thread_;             // Group commit writer
+    std::atomic<bool> writer_running_;      // Writer execution flag
+    int commit_interval_ms_;                // Group commit interval
+    size_t commit_bytes_;                   // Group commit byte threshold
+    std::string write_buffer_;              // Formatted batch (writer thread)
+    size_t drained_position_;               // Queue position of the next pop (writer thread)
+    std::chrono::steady_clock::time_point next_commit_;     // Writer thread
+    bool durable_pending_;                  // Formatted DURABLE record awaits commit (writer thread)
+
+    bool telemetry_enabled_;                // Write the columnar store too
+    TelemetryStoreWriter telemetry_;        // Columnar store (writer thread once started)
+    std::string telemetry_filename_;        // Active store file
+    std::chrono::steady_clock::time_point telemetry_opened_; // Active store start (writer thread)
+    long telemetry_sequence_;               // Store files opened, the names' <seq> (writer thread)
+    long telemetry_rollovers_;              // Store files rolled (writer thread)
+    std::atomic<long> telemetry_deleted_;   // Store files removed by retention (retention thread)
+    std::mutex telemetry_active_mutex_;     // Guards telemetry_active_
+    std::string telemetry_active_;          // Open store file retention must skip, or empty
+    ChangeSignal telemetry_retention_signal_; // Writer -> retention thread (a store file was opened)
+    std::atomic<bool> telemetry_retention_running_;
+    std::thread telemetry_retention_thread_;
+    std::chrono::steady_clock::time_point telemetry_sealed_; // Last segment seal (writer thread)
+
+    TelemetryCapture* capture_;             // Full-rate capture ring (optional)
+    RotatingLogFile capture_file_;          // Capture CSV (writer thread once started)
+    std::string capture_filename_;          // Capture CSV file name
+    std::string capture_buffer_;            // Formatted capture lines (writer thread)
+    long capture_pending_;                  // Records in capture_buffer_
+    std::atomic<long> capture_written_;     // Capture records committed
+    std::chrono::steady_clock::time_point next_capture_report_; // Writer thread
+    long reported_capture_written_;         // capture_stats baseline (writer thread)
+    long reported_capture_dropped_;
+    long log_rollovers_;                    // Rollovers already logged (writer thread)
+    long capture_rollovers_;
+
+    std::atomic<long> records_written_;     // Records committed to disk
+    std::atomic<long> commit_count_;        // write()+fdatasync() pairs
+    std::atomic<long> bytes_written_;       // Bytes committed
+    std::atomic<long> dropped_records_;     // Records lost to a full queue
+    Logger::SiteRateLimiter queue_full_log_limiter_;    // log_queue_full warnings of this collector
+    std::atomic<long> durable_timeouts_;    // DURABLE calls that gave up waiting
 
     mutable std::mutex state_mutex_;        // Protects state data
     TruckState current_state_;              // Current truck state
 
+    Watchdog::HeartbeatHandle heartbeat_handle_; // Watchdog heartbeat slot
+
     PerformanceMonitor* perf_monitor_;      // Performance monitoring (optional)
+    Clock* clock_;                          // Time source (Clock::system() by default)
+    int clock_thread_;                      // Status task thread's ID in clock_
+    RtWorkerPool* worker_pool_;             // Runs the cycle instead of task_thread_ (optional)
+    RtWorkerPool::JobId pool_job_;
+    BestEffortExecutor* executor_;          // Runs the writer and status jobs (optional)
+    BestEffortExecutor::JobId writer_job_;
+    BestEffortExecutor::JobId status_job_;
 };
 
 #endif // DATA_COLLECTOR_H
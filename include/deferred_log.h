@@ -0,0 +1,413 @@
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#include "flight_recorder.h"
+#include "log_limiter.h"
+#include "logger.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @file deferred_log.h
+ * @brief Deferred-format ("nanolog-style") logging for hot paths
+ *
+ * Each LOGF_* call site owns a static CallSite that registers its level,
+ * module and format once. The format lists the keys in output order;
+ * items written as "key=value" are constant, bare keys take the next
+ * argument:
+ *
+ *   LOGF_DEBUG(NC, "event=nav_update,dist,cur_x", dist, x);
+ *   -> 1731283456789|DBG|NC|event=nav_update,dist=12,cur_x=40
+ *
+ * A call below the capture level (the log level, or DEBUG while the flight
+ * recorder runs) costs one relaxed atomic load. Otherwise the arguments are
+ * copied as raw bytes into a record. Records at or above the log level go
+ * to one of two sinks:
+ * - Text mode (default): the record is formatted and printed right away,
+ *   producing exactly the LOG_* output.
+ * - Deferred mode (enable_deferred() / LOG_DEFERRED_FILE): the record is
+ *   copied into a lock-free per-thread ring and a background writer
+ *   appends it to a binary file. Formatting happens offline in
+ *   deferred_log_decode. LOG_* streams are routed to the same file as
+ *   preformatted text, so the decoded file is the complete log.
+ *
+ * LOGF_EVERY_N and LOGF_RATE_LIMITED add a lock-free per-site sampler or
+ * token bucket (log_limiter.h) for high-rate events; their records end
+ * with suppressed=<calls dropped since the previous record>:
+ *
+ *   LOGF_EVERY_N(DEBUG, SP, 50, "event=write,temp", temp);
+ *   -> ...|DBG|SP|event=write,temp=75,suppressed=49
+ *
+ * While the flight recorder runs (flight_recorder.h) every LOGF_* record,
+ * including DEBUG ones below the log level, is also copied into the
+ * thread's flight ring. LOGF_FLIGHT records go only there.
+ *
+ * Strings are copied (truncated to DEFERRED_LOG_MAX_STRING_BYTES), so
+ * temporaries are safe to pass.
+ */
+
+namespace Logger {
+
+constexpr size_t DEFERRED_LOG_THREAD_RING_BYTES = 1 << 16;
+constexpr size_t DEFERRED_LOG_MAX_STRING_BYTES = 64;
+constexpr size_t DEFERRED_LOG_MAX_RECORD_BYTES = 1024;
+constexpr int DEFERRED_LOG_FLUSH_PERIOD_MS = 20;
+constexpr size_t DEFERRED_LOG_MAX_SITES = 4096;
+
+// Binary file layout: magic, then entries. Each entry is one type byte:
+//   'S' u32 site_id, u8 level, u8 module, u16 format_len, format bytes
+//   'C' i64 ticks, i64 system_clock_ns (tick calibration, every flush)
+//   'R' u16 record_len, record bytes
+// Records: u32 site_id, i64 ticks (deferred_ticks()), encoded args.
+constexpr char DEFERRED_LOG_MAGIC[8] = {'T', 'R', 'K', 'D', 'L', 'O', 'G', '1'};
+constexpr uint8_t DEFERRED_ENTRY_SITE = 'S';
+constexpr uint8_t DEFERRED_ENTRY_CALIBRATION = 'C';
+constexpr uint8_t DEFERRED_ENTRY_RECORD = 'R';
+constexpr size_t DEFERRED_RECORD_HEADER_BYTES = sizeof(uint32_t) + sizeof(int64_t);
+
+// Format of the sites that carry preformatted LOG_* text
+constexpr const char* DEFERRED_LOG_TEXT_FORMAT = "*";
+
+/**
+ * @brief Argument encodings (one tag byte before each value)
+ */
+enum class DeferredArg : uint8_t {
+    INT,        // int64_t
+    UINT,       // uint64_t
+    DOUBLE,     // double
+    BOOL,       // uint8_t
+    STRING      // u16 length + bytes
+};
+
+/**
+ * @brief Record timestamp source
+ *
+ * On x86 this is the TSC (a few ns, versus ~35 ns for system_clock), which
+ * the decoder maps to wall-clock time through the calibration entries.
+ * Elsewhere it is system_clock nanoseconds.
+ */
+inline int64_t deferred_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return static_cast<int64_t>(__rdtsc());
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * @brief Number of bare keys (arguments) in a LOGF_* format
+ */
+constexpr size_t deferred_arg_count(const char* format) {
+    size_t count = 0;
+    bool item_has_value = false;
+    bool item_empty = true;
+    for (const char* p = format;; ++p) {
+        if (*p == ',' || *p == '\0') {
+            if (!item_empty && !item_has_value) {
+                count++;
+            }
+            if (*p == '\0') {
+                break;
+            }
+            item_has_value = false;
+            item_empty = true;
+        } else {
+            item_empty = false;
+            if (*p == '=') {
+                item_has_value = true;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Static description of one LOGF_* call site
+ *
+ * Registered once (function-local static); the id indexes the site table
+ * written to deferred log files.
+ */
+class CallSite {
+public:
+    CallSite(Level level, Module module, const char* format);
+
+    uint32_t id() const { return id_; }
+    Level level() const { return level_; }
+    Module module() const { return module_; }
+    const char* format() const { return format_; }
+
+private:
+    uint32_t id_;
+    Level level_;
+    Module module_;
+    const char* format_;
+};
+
+/**
+ * @brief Start deferred mode, writing records to a binary file
+ *
+ * @param path Output file (truncated)
+ * @return false if the file could not be opened
+ */
+bool enable_deferred(const std::string& path);
+
+/**
+ * @brief Flush every thread ring, stop the writer and close the file
+ */
+void disable_deferred();
+
+/**
+ * @brief Check whether deferred mode is active
+ */
+bool deferred_enabled();
+
+/**
+ * @brief Records dropped because a thread ring was full, or logged while the thread was exiting
+ */
+long deferred_dropped_count();
+
+/**
+ * @brief Number of registered call sites (async-signal-safe)
+ */
+size_t deferred_site_count();
+
+/**
+ * @brief Registered call site by id, or nullptr (async-signal-safe)
+ */
+const CallSite* deferred_site(size_t id);
+
+/**
+ * @brief Hand an encoded record to the active sinks
+ *
+ * @param site Registered call site
+ * @param record Record bytes (header + encoded args)
+ * @param size Record size in bytes
+ */
+void submit_deferred(const CallSite& site, const char* record, size_t size);
+
+/**
+ * @brief Route a preformatted LOG_* line to the deferred file
+ */
+void log_deferred_text(Level level, Module module, const std::string& body);
+
+/**
+ * @brief Copy a preformatted LOG_* line into the flight recorder
+ */
+void flight_record_text(Level level, Module module, const std::string& body);
+
+/**
+ * @brief Map record ticks to wall-clock ns using calibration entries
+ *
+ * Interpolates between the two calibration points around the tick value
+ * (extrapolating from the nearest pair at the ends).
+ *
+ * @param calibration (ticks, wall-clock ns) pairs sorted by ticks
+ */
+int64_t deferred_ticks_to_ns(const std::vector<std::pair<int64_t, int64_t>>& calibration, int64_t ticks);
+
+/**
+ * @brief Rebuild the key=value body of a record
+ *
+ * Shared by text mode and the offline decoder so both print the same.
+ *
+ * @param format Call site format
+ * @param args Encoded arguments (after the record header)
+ * @param size Size of the encoded arguments
+ * @param out Destination body
+ * @return false if the arguments are malformed
+ */
+bool format_deferred_body(const char* format, const char* args, size_t size, std::string& out);
+
+namespace deferred_detail {
+
+template <typename T>
+constexpr size_t max_encoded_size() {
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, bool>) {
+        return 2;
+    } else if constexpr (std::is_arithmetic_v<U> && !std::is_same_v<U, char>) {
+        return 1 + 8;
+    } else if constexpr (std::is_enum_v<U>) {
+        return 1 + 8;
+    } else {
+        return 1 + sizeof(uint16_t) + DEFERRED_LOG_MAX_STRING_BYTES;
+    }
+}
+
+inline char* put_bytes(char* p, const void* src, size_t size) {
+    std::memcpy(p, src, size);
+    return p + size;
+}
+
+inline char* put_string(char* p, const char* text, size_t length) {
+    if (length > DEFERRED_LOG_MAX_STRING_BYTES) {
+        length = DEFERRED_LOG_MAX_STRING_BYTES;
+    }
+    *p++ = static_cast<char>(DeferredArg::STRING);
+    uint16_t stored = static_cast<uint16_t>(length);
+    p = put_bytes(p, &stored, sizeof(stored));
+    return put_bytes(p, text, length);
+}
+
+template <typename T>
+inline char* encode_arg(char* p, const T& value) {
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, bool>) {
+        *p++ = static_cast<char>(DeferredArg::BOOL);
+        *p++ = value ? 1 : 0;
+        return p;
+    } else if constexpr (std::is_same_v<U, char>) {
+        return put_string(p, &value, 1);
+    } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+        int64_t stored = value;
+        *p++ = static_cast<char>(DeferredArg::INT);
+        return put_bytes(p, &stored, sizeof(stored));
+    } else if constexpr (std::is_integral_v<U>) {
+        uint64_t stored = value;
+        *p++ = static_cast<char>(DeferredArg::UINT);
+        return put_bytes(p, &stored, sizeof(stored));
+    } else if constexpr (std::is_enum_v<U>) {
+        int64_t stored = static_cast<int64_t>(value);
+        *p++ = static_cast<char>(DeferredArg::INT);
+        return put_bytes(p, &stored, sizeof(stored));
+    } else if constexpr (std::is_floating_point_v<U>) {
+        double stored = value;
+        *p++ = static_cast<char>(DeferredArg::DOUBLE);
+        return put_bytes(p, &stored, sizeof(stored));
+    } else if constexpr (std::is_same_v<U, std::string>) {
+        return put_string(p, value.data(), value.size());
+    } else {
+        static_assert(std::is_convertible_v<U, const char*>, "LOGF_*: unsupported argument type");
+        const char* text = value;
+        return put_string(p, text, text ? strnlen(text, DEFERRED_LOG_MAX_STRING_BYTES) : 0);
+    }
+}
+
+} // namespace deferred_detail
+
+namespace deferred_detail {
+
+/**
+ * @brief Encode one LOGF_* call and pass the record to submit
+ */
+template <size_t ExpectedArgs, typename Submit, typename... Args>
+inline void encode_record(const CallSite& site, Submit submit, const Args&... args) {
+    static_assert(sizeof...(Args) == ExpectedArgs,
+                  "LOGF_*: argument count does not match the bare keys in the format");
+    constexpr size_t capacity = DEFERRED_RECORD_HEADER_BYTES +
+                                (size_t{0} + ... + max_encoded_size<Args>());
+    static_assert(capacity <= DEFERRED_LOG_MAX_RECORD_BYTES, "LOGF_*: too many arguments");
+
+    char record[capacity];
+    uint32_t id = site.id();
+    int64_t ticks = deferred_ticks();
+    char* p = put_bytes(record, &id, sizeof(id));
+    p = put_bytes(p, &ticks, sizeof(ticks));
+    ((p = encode_arg(p, args)), ...);
+    submit(record, static_cast<size_t>(p - record));
+}
+
+} // namespace deferred_detail
+
+/**
+ * @brief Encode one LOGF_* call (capture level already checked)
+ */
+template <size_t ExpectedArgs, typename... Args>
+inline void log_deferred(const CallSite& site, const Args&... args) {
+    deferred_detail::encode_record<ExpectedArgs>(
+        site, [&site](const char* record, size_t size) { submit_deferred(site, record, size); }, args...);
+}
+
+/**
+ * @brief Encode one LOGF_FLIGHT call (recorder already checked)
+ */
+template <size_t ExpectedArgs, typename... Args>
+inline void log_flight(const CallSite& site, const Args&... args) {
+    deferred_detail::encode_record<ExpectedArgs>(
+        site, [](const char* record, size_t size) { FlightRecorder::record(record, size); }, args...);
+}
+
+} // namespace Logger
+
+#define LOGF_AT(lvl, mod, format, ...)                                                          \
+    do {                                                                                        \
+        if (Logger::Level::lvl >= Logger::capture_level()) {                                    \
+            static const Logger::CallSite logf_site_(Logger::Level::lvl, Logger::Module::mod, format); \
+            Logger::log_deferred<Logger::deferred_arg_count(format)>(logf_site_, ##__VA_ARGS__); \
+        }                                                                                       \
+    } while (0)
+
+#define LOGF_DEBUG(mod, format, ...) LOGF_AT(DEBUG, mod, format, ##__VA_ARGS__)
+#define LOGF_INFO(mod, format, ...)  LOGF_AT(INFO,  mod, format, ##__VA_ARGS__)
+#define LOGF_WARN(mod, format, ...)  LOGF_AT(WARN,  mod, format, ##__VA_ARGS__)
+#define LOGF_ERR(mod, format, ...)   LOGF_AT(ERR,   mod, format, ##__VA_ARGS__)
+#define LOGF_CRIT(mod, format, ...)  LOGF_AT(CRIT,  mod, format, ##__VA_ARGS__)
+
+// Sampled: emits 1 call in n (a constant), with ",suppressed=<n-1>" appended
+#define LOGF_EVERY_N(lvl, mod, n, format, ...)                                                  \
+    do {                                                                                        \
+        if (Logger::Level::lvl >= Logger::capture_level()) {                                    \
+            static Logger::SiteSampler<n> logf_sampler_;                                        \
+            uint64_t logf_suppressed_;                                                          \
+            if (logf_sampler_.admit(logf_suppressed_)) {                                        \
+                static const Logger::CallSite logf_site_(Logger::Level::lvl, Logger::Module::mod, \
+                                                         format ",suppressed");                 \
+                Logger::log_deferred<Logger::deferred_arg_count(format ",suppressed")>(         \
+                    logf_site_, ##__VA_ARGS__, logf_suppressed_);                               \
+            }                                                                                   \
+        }                                                                                       \
+    } while (0)
+
+// Token bucket: per_second sustained, burst back-to-back, with
+// ",suppressed=<rejected since the last record>" appended
+#define LOGF_RATE_LIMITED(lvl, mod, per_second, burst, format, ...)                             \
+    do {                                                                                        \
+        if (Logger::Level::lvl >= Logger::capture_level()) {                                    \
+            static Logger::SiteRateLimiter logf_limiter_(per_second, burst);                    \
+            uint64_t logf_suppressed_;                                                          \
+            if (logf_limiter_.admit(logf_suppressed_)) {                                        \
+                static const Logger::CallSite logf_site_(Logger::Level::lvl, Logger::Module::mod, \
+                                                         format ",suppressed");                 \
+                Logger::log_deferred<Logger::deferred_arg_count(format ",suppressed")>(         \
+                    logf_site_, ##__VA_ARGS__, logf_suppressed_);                               \
+            }                                                                                   \
+        }                                                                                       \
+    } while (0)
+
+// As LOGF_EVERY_N / LOGF_RATE_LIMITED, admitted by a caller-owned
+// Logger::SiteSampler or Logger::SiteRateLimiter instead of a call-site
+// static, so each instance of a class (one per truck in a fleet) is
+// sampled on its own
+#define LOGF_LIMITED_BY(limiter, lvl, mod, format, ...)                                         \
+    do {                                                                                        \
+        if (Logger::Level::lvl >= Logger::capture_level()) {                                    \
+            uint64_t logf_suppressed_;                                                          \
+            if ((limiter).admit(logf_suppressed_)) {                                            \
+                static const Logger::CallSite logf_site_(Logger::Level::lvl, Logger::Module::mod, \
+                                                         format ",suppressed");                 \
+                Logger::log_deferred<Logger::deferred_arg_count(format ",suppressed")>(         \
+                    logf_site_, ##__VA_ARGS__, logf_suppressed_);                               \
+            }                                                                                   \
+        }                                                                                       \
+    } while (0)
+
+// Flight-recorder-only samples (recorded as DEBUG, never printed)
+#define LOGF_FLIGHT(mod, format, ...)                                                           \
+    do {                                                                                        \
+        if (FlightRecorder::enabled()) {                                                        \
+            static const Logger::CallSite logf_site_(Logger::Level::DEBUG, Logger::Module::mod, format); \
+            Logger::log_flight<Logger::deferred_arg_count(format)>(logf_site_, ##__VA_ARGS__);  \
+        }                                                                                       \
+    } while (0)
+
+#endif // DEFERRED_LOG_H
@@ -0,0 +1,178 @@
+#ifndef FAULT_EVENT_DISPATCHER_H
+#define FAULT_EVENT_DISPATCHER_H
+
+#include "best_effort_executor.h"
+#include "change_signal.h"
+#include "circular_buffer.h"
+#include "clock.h"
+#include "common_types.h"
+#include "performance_monitor.h"
+#include "spsc_ring.h"
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <functional>
+
+constexpr size_t FAULT_EVENT_QUEUE_CAPACITY = 64;
+constexpr int FAULT_EVENT_DISPATCH_POLL_MS = 10;         // Backstop only: post() wakes the thread
+constexpr int FAULT_EVENT_EXECUTOR_POLL_MS = 500;       // Backstop only: post() wakes the job
+
+/**
+ * @brief Fault event callback type
+ *
+ * Allows other tasks to register callbacks for fault events
+ */
+using FaultCallback = std::function<void(FaultType, const SensorData&)>;
+
+/**
+ * @brief Predictive advisory callback type
+ *
+ * Called with true when the temperature trend predicts an alert and with
+ * false when the prediction clears. An advisory never changes the fault
+ * state, so it has its own callbacks instead of a FaultType.
+ */
+using AdvisoryCallback = std::function<void(bool active, const SensorData&)>;
+
+/**
+ * @brief What a FaultEvent reports
+ */
+enum class FaultEventKind {
+    FAULT_CHANGE,   // Latched fault set changed (fault callbacks)
+    TREND_ALERT,    // Temperature trend predicts an alert (advisory callbacks)
+    TREND_CLEAR     // Prediction cleared (advisory callbacks)
+};
+
+/**
+ * @brief Fault change or advisory captured on the fault monitoring thread
+ */
+struct FaultEvent {
+    FaultType type;          // Highest-priority active fault
+    FaultMask active_mask;   // All active faults
+    SensorData data;
+    long long detected_ns;
+    FaultEventKind kind = FaultEventKind::FAULT_CHANGE;
+};
+
+/**
+ * @brief Asynchronous delivery of fault events to logging/notification consumers
+ *
+ * The real-time fault monitoring thread only posts events into a lock-free
+ * SPSC queue. A best-effort dispatcher thread drains the queue, writes the
+ * structured fault log and runs the registered callbacks, so slow consumers
+ * (file writes, string formatting, foreign locks) never execute on the
+ * SCHED_FIFO thread. Dispatch delay is recorded as "FaultDispatch".
+ *
+ * With a BestEffortExecutor the dispatcher has no thread: delivery is a
+ * HIGH lane periodic job, woken by post().
+ *
+ * Real-Time Automation Concepts:
+ * - Separation of hard real-time and best-effort work
+ * - Observer pattern (callbacks)
+ */
+class FaultEventDispatcher {
+public:
+    /**
+     * @brief Construct dispatcher
+     *
+     * @param perf_monitor Records dispatch delay (optional)
+     */
+    explicit FaultEventDispatcher(PerformanceMonitor* perf_monitor = nullptr);
+
+    /**
+     * @brief Stop dispatcher thread, delivering queued events first
+     */
+    ~FaultEventDispatcher();
+
+    /**
+     * @brief Start the dispatcher thread
+     */
+    void start();
+
+    /**
+     * @brief Stop the dispatcher thread after draining the queue
+     */
+    void stop();
+
+    /**
+     * @brief Register a consumer callback
+     *
+     * @param callback Function to call for every fault change
+     */
+    void register_callback(FaultCallback callback);
+
+    /**
+     * @brief Register a consumer of TREND_ALERT/TREND_CLEAR events
+     *
+     * @param callback Function to call for every advisory change
+     */
+    void register_advisory_callback(AdvisoryCallback callback);
+
+    /**
+     * @brief Queue an event for delivery (lock-free, single producer)
+     *
+     * @param event Fault change to deliver
+     * @return false if the queue was full and the event was dropped
+     */
+    bool post(const FaultEvent& event);
+
+    /**
+     * @brief Time source for the dispatch delay (must match the poster's)
+     *
+     * Must be called before start().
+     */
+    void set_clock(Clock* clock);
+
+    /**
+     * @brief Deliver on a best-effort executor instead of a thread
+     *
+     * Must be called before start().
+     *
+     * @param executor Executor (nullptr: own thread)
+     */
+    void set_executor(BestEffortExecutor* executor);
+
+    /**
+     * @brief Get number of events dropped because the queue was full
+     */
+    long get_dropped_event_count() const { return dropped_event_count_; }
+
+private:
+    /**
+     * @brief Dispatcher thread loop
+     */
+    void dispatch_loop();
+
+    /**
+     * @brief Deliver every queued event
+     */
+    void drain_queue();
+
+    /**
+     * @brief Log one event and run the callbacks
+     */
+    void deliver(const FaultEvent& event);
+
+    /**
+     * @brief Run the advisory callbacks for a TREND_* event
+     */
+    void deliver_advisory(const FaultEvent& event);
+
+    SpscRing<FaultEvent, FAULT_EVENT_QUEUE_CAPACITY> event_queue_;
+    std::atomic<long> dropped_event_count_;
+
+    std::atomic<bool> running_;
+    std::thread dispatch_thread_;
+    ChangeSignal wakeup_;                   // Bumped by post()/stop(); a post racing the sleep is not lost
+
+    std::mutex callback_mutex_;
+    std::vector<FaultCallback> callbacks_;
+    std::vector<AdvisoryCallback> advisory_callbacks_;
+
+    PerformanceMonitor* perf_monitor_;
+    Clock* clock_;
+    BestEffortExecutor* executor_;          // Delivers instead of dispatch_thread_ (optional)
+    BestEffortExecutor::JobId executor_job_;
+};
+
+#endif // FAULT_EVENT_DISPATCHER_H
@@ -2,25 +2,42 @@
 #define FAULT_MONITORING_H
 
 #include "circular_buffer.h"
+#include "clock.h"
 #include "common_types.h"
 #include "performance_monitor.h"
+#include "rt_worker_pool.h"
+#include "watchdog.h"
+#include "input_freshness_monitor.h"
+#include "fault_status.h"
+#include "fault_event_dispatcher.h"
+#include "sensor_processing.h"
+#include "temperature_trend_estimator.h"
+#include "fault_state_machine.h"
+#include "change_signal.h"
 #include <thread>
 #include <atomic>
 #include <mutex>
-#include <condition_variable>
 #include <vector>
-#include <functional>
 
 constexpr int FAULT_MONITORING_THREAD_PRIORITY = 90;
 constexpr int CRITICAL_TEMPERATURE_THRESHOLD_FM = 120;
 constexpr int ALERT_TEMPERATURE_THRESHOLD_FM = 95;
+constexpr size_t PREDICTIVE_ALERT_WINDOW_SAMPLES = 150;      // 3 s at the 20 ms sensor period
+constexpr double PREDICTIVE_ALERT_MIN_SLOPE_C_PER_S = 0.5;
+constexpr long PREDICTIVE_ALERT_CLEAR_HORIZON_FACTOR = 2;     // Clear only beyond 2x the horizon
+constexpr double ALERT_TEMPERATURE_CLEAR_BELOW_FM = 90.0;
+constexpr double CRITICAL_TEMPERATURE_CLEAR_BELOW_FM = 115.0;
+constexpr int TEMPERATURE_ALERT_SET_SAMPLES = 3;
+constexpr int STALE_DATA_CLEAR_SAMPLES = 5;
+constexpr long FAULT_NOTIFICATION_MIN_INTERVAL_MS = 1000;
 
 /**
- * @brief Fault event callback type
- *
- * Allows other tasks to register callbacks for fault events
+ * @brief When sensor faults are evaluated
  */
-using FaultCallback = std::function<void(FaultType, const SensorData&)>;
+enum class FaultEvaluationMode {
+    PERIODIC,         // Poll peek_latest() every task period
+    WRITE_TRIGGERED   // Evaluate each sample from the SensorProcessing post-write hook
+};
 
 /**
  * @brief Fault Monitoring Task
@@ -30,16 +47,35 @@ using FaultCallback = std::function<void(FaultType, const SensorData&)>;
  * - Temperature critical (T > 120°C)
  * - Electrical system faults
  * - Hydraulic system faults
+ * - Stale periodic bridge inputs (via InputFreshnessMonitor)
+ *
+ * In WRITE_TRIGGERED mode sensor faults are evaluated synchronously on
+ * every new sample (on_sensor_sample), and the raw unfiltered temperature
+ * is also checked against the critical threshold so filter lag does not
+ * delay a critical fault. The periodic loop then only evaluates input
+ * freshness and re-combines it with the latest sample.
  *
- * When a fault is detected, this task triggers events to:
- * - Command Logic (via shared state)
- * - Navigation Control (to disable control)
- * - Data Collector (for logging)
+ * Every fault type is latched independently by a FaultStateMachine
+ * (hysteresis band + debounce counts), so simultaneous faults are kept in
+ * a FaultMask and a temperature hovering at a threshold does not toggle
+ * the fault on every sample. When the latched set changes, this task:
+ * - Publishes it in a lock-free FaultStatus word polled by Command Logic
+ *   and Navigation Control every cycle (stop path, never rate-limited)
+ * - Posts an event to the FaultEventDispatcher, which logs it and runs the
+ *   registered callbacks (e.g. Data Collector) on a best-effort thread.
+ *   Escalations are posted immediately; other changes are coalesced to at
+ *   most one event per FAULT_NOTIFICATION_MIN_INTERVAL_MS.
+ *
+ * A rolling least-squares temperature trend predicting the 95°C crossing
+ * within the configured horizon is only an advisory: it is logged as
+ * temp_trend_alert and posted to the dispatcher as a TREND_ALERT (then
+ * TREND_CLEAR) event for the advisory callbacks, but never enters the
+ * FaultMask, so a forecast cannot latch Command Logic's FAULT.
  *
  * Real-Time Automation Concepts:
  * - Event-driven communication
- * - Condition variables for event notification
- * - Observer pattern (callbacks)
+ * - Lock-free publication of shared state
+ * - Observer pattern (callbacks, dispatched asynchronously)
  */
 class FaultMonitoring {
 public:
@@ -75,15 +111,146 @@ public:
     /**
      * @brief Register a callback for fault events
      *
+     * Callbacks run on the dispatcher (its thread or executor job), never
+     * on the monitoring thread.
+     *
      * @param callback Function to call when fault detected
      */
     void register_fault_callback(FaultCallback callback);
 
     /**
-     * @brief Get current fault type
+     * @brief Register a callback for predictive temperature advisories
+     *
+     * Runs on the dispatcher like the fault callbacks. Advisories are raised
+     * only while set_predictive_alert_horizon() is enabled.
+     *
+     * @param callback Function to call when the advisory is raised or cleared
+     */
+    void register_advisory_callback(AdvisoryCallback callback);
+
+    /**
+     * @brief Get current (highest-priority) fault type
      */
     FaultType get_current_fault() const;
 
+    /**
+     * @brief Get all currently latched faults
+     */
+    FaultMask get_active_faults() const;
+
+    /**
+     * @brief Get debounce/transition statistics of one fault type
+     */
+    FaultCounters get_fault_counters(FaultType type) const;
+
+    /**
+     * @brief Get number of fault events posted to the dispatcher
+     */
+    long get_notification_count() const { return notification_count_; }
+
+    /**
+     * @brief Get number of fault changes folded into a later notification
+     */
+    long get_coalesced_notification_count() const { return coalesced_notification_count_; }
+
+    /**
+     * @brief Get the lock-free fault word for control tasks
+     */
+    const FaultStatus& get_fault_status() const { return fault_status_; }
+
+    /**
+     * @brief Attach the watchdog heartbeat slot reported every cycle
+     *
+     * Must be called before start().
+     *
+     * @param handle Handle returned by Watchdog::register_task()
+     */
+    void set_heartbeat_handle(Watchdog::HeartbeatHandle handle);
+
+    /**
+     * @brief Attach the bridge input freshness monitor evaluated every cycle
+     *
+     * Must be called before start().
+     *
+     * @param monitor Freshness monitor (nullptr disables the check)
+     */
+    void set_input_freshness_monitor(InputFreshnessMonitor* monitor);
+
+    /**
+     * @brief Wake a change-driven task whenever the fault word changes
+     *
+     * notify() is called right after each FaultStatus publish, from the
+     * thread that evaluated the fault. Must be called before start().
+     *
+     * @param listener Signal to notify
+     */
+    void add_fault_listener(ChangeSignal* listener);
+
+    /**
+     * @brief Select periodic or write-triggered sensor fault evaluation
+     *
+     * Must be called before start(). WRITE_TRIGGERED requires
+     * on_sensor_sample() to be installed as the SensorProcessing sample hook.
+     *
+     * @param mode Evaluation mode (default: PERIODIC)
+     */
+    void set_evaluation_mode(FaultEvaluationMode mode);
+
+    /**
+     * @brief Enable predictive temperature advisories
+     *
+     * Raises the temperature trend advisory when the trend is projected to
+     * cross the alert threshold within the horizon. TEMPERATURE_ALERT
+     * itself still follows the measured temperature. The advisory clears
+     * once the crossing is projected beyond twice the horizon (or the trend
+     * stops rising). Must be called before start().
+     *
+     * @param horizon_ms Prediction horizon in milliseconds (0 disables)
+     */
+    void set_predictive_alert_horizon(long horizon_ms);
+
+    /**
+     * @brief Use a different time source (simulation)
+     *
+     * Also used by the dispatcher for its delay measurement. Must be
+     * called before start().
+     *
+     * @param clock Clock for freshness checks, fault timestamps and the period sleep
+     */
+    void set_clock(Clock* clock);
+
+    /**
+     * @brief Run the cycle as a job of a shared worker pool (fleet mode)
+     *
+     * Must be called before start(). start() then adds a periodic job
+     * instead of starting a thread; the event dispatcher keeps its thread
+     * unless set_executor() moves it too.
+     *
+     * @param pool Worker pool (nullptr: own thread)
+     */
+    void set_worker_pool(RtWorkerPool* pool);
+
+    /**
+     * @brief Deliver fault events on a best-effort executor
+     *
+     * Must be called before start().
+     *
+     * @param executor Executor (nullptr: dispatcher thread)
+     */
+    void set_executor(BestEffortExecutor* executor);
+
+    /**
+     * @brief Evaluate a freshly written sample (SensorProcessing post-write hook)
+     *
+     * Ignored in PERIODIC mode. Records "FaultDetect" latency from raw
+     * sample arrival to fault change.
+     *
+     * @param raw Unfiltered sample
+     * @param filtered Sample written to the buffer
+     * @param raw_arrival_ns Monotonic clock time the raw sample was received (ns)
+     */
+    void on_sensor_sample(const RawSensorData& raw, const SensorData& filtered, long long raw_arrival_ns);
+
 private:
     /**
      * @brief Main task loop
@@ -91,20 +258,41 @@ private:
     void task_loop();
 
     /**
-     * @brief Check sensor data for faults
+     * @brief One period: freshness, sensor faults (PERIODIC mode), publication
+     */
+    void run_cycle();
+
+    /**
+     * @brief Feed one sensor sample to the fault state machine
      *
-     * @param data Sensor data to check
-     * @return FaultType Type of fault detected (or NONE)
+     * Caller must hold evaluation_mutex_.
+     *
+     * @param data Filtered sensor sample
+     * @param critical_temperature Temperature checked against the critical band
+     *                             (raw value in write-triggered mode)
+     */
+    void observe_sensor_faults(const SensorData& data, int critical_temperature);
+
+    /**
+     * @brief Publish latched fault changes and (rate-limited) notify
+     *
+     * Caller must hold evaluation_mutex_.
+     *
+     * @param data Sensor data reported with the event
+     * @return true if the latched fault set changed
      */
-    FaultType check_for_faults(const SensorData& data);
+    bool publish_fault_changes(const SensorData& data);
 
     /**
-     * @brief Notify all registered callbacks of fault event
+     * @brief Feed a new sample to the temperature trend (caller must hold evaluation_mutex_)
+     *
+     * Samples with an already seen timestamp are ignored, so the same
+     * buffer entry may be passed repeatedly. Updates the trend advisory.
      *
-     * @param fault_type Type of fault detected
-     * @param data Sensor data at time of fault
+     * @param data Filtered sensor sample
      */
-    void notify_fault_event(FaultType fault_type, const SensorData& data);
+    void update_temperature_trend(const SensorData& data);
+
 
     CircularBuffer& buffer_;                // Reference to shared buffer
     int period_ms_;                         // Task period
@@ -112,13 +300,34 @@ private:
     std::atomic<bool> running_;             // Task execution flag
     std::thread task_thread_;               // Task thread
 
-    mutable std::mutex fault_mutex_;        // Protects fault state
-    FaultType current_fault_;               // Current active fault
+    FaultEvaluationMode evaluation_mode_;   // Periodic or write-triggered evaluation
+
+    mutable std::mutex evaluation_mutex_;   // Serializes fault evaluation (task + sample hook)
+    FaultStateMachine fault_states_;        // Debounced per-fault latches
+    FaultMask published_mask_;              // Latched set last published to FaultStatus
+    FaultMask notified_mask_;               // Latched set last posted to the dispatcher
+    bool notification_pending_;             // Change waiting for the rate limit
+    long long last_notification_ns_;        // Steady time of the last posted event
+    std::atomic<long> notification_count_;  // Events posted
+    std::atomic<long> coalesced_notification_count_; // Changes folded into later events
+
+    TemperatureTrendEstimator temperature_trend_; // Rolling temperature slope
+    long predictive_horizon_ms_;            // Early-alert horizon (0 = disabled)
+    long last_trend_sample_ms_;             // Timestamp of last sample fed to the trend
+    bool predicted_alert_;                  // Crossing predicted within the horizon
+    std::atomic<long> trend_alert_count_;   // Advisories raised
+    FaultStatus fault_status_;              // Published fault word for control tasks
+    FaultEventDispatcher dispatcher_;       // Async logging/callback delivery
+    std::vector<ChangeSignal*> fault_listeners_; // Woken on every publish
 
-    std::mutex callback_mutex_;             // Protects callback list
-    std::vector<FaultCallback> callbacks_;  // Registered fault callbacks
+    Watchdog::HeartbeatHandle heartbeat_handle_; // Watchdog heartbeat slot
+    InputFreshnessMonitor* freshness_monitor_;   // Bridge input age supervision (optional)
 
     PerformanceMonitor* perf_monitor_;      // Performance monitoring (optional)
+    Clock* clock_;                          // Time source (Clock::system() by default)
+    int clock_thread_;                      // Task thread's ID in clock_
+    RtWorkerPool* worker_pool_;             // Runs the cycle instead of task_thread_ (optional)
+    RtWorkerPool::JobId pool_job_;
 };
 
 #endif // FAULT_MONITORING_H
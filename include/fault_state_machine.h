@@ -0,0 +1,109 @@
+#ifndef FAULT_STATE_MACHINE_H
+#define FAULT_STATE_MACHINE_H
+
+#include "common_types.h"
+#include <array>
+
+constexpr int DEFAULT_FAULT_SET_SAMPLES = 1;
+constexpr int DEFAULT_FAULT_CLEAR_SAMPLES = 10;
+
+/**
+ * @brief Hysteresis band and debounce counts of one fault type
+ *
+ * The condition asserts while value > set_above and, once latched, only
+ * releases when value < clear_below. The latched state changes after
+ * set_samples consecutive asserting observations (set) or clear_samples
+ * consecutive released observations (clear).
+ */
+struct FaultHysteresis {
+    double set_above;
+    double clear_below;
+    int set_samples;
+    int clear_samples;
+};
+
+/**
+ * @brief Band for boolean conditions observed with observe_flag()
+ */
+FaultHysteresis flag_hysteresis(int set_samples, int clear_samples);
+
+/**
+ * @brief Per-fault transition statistics
+ */
+struct FaultCounters {
+    long activations;         // Debounced set transitions
+    long clears;              // Debounced clear transitions
+    long suppressed_toggles;  // Observations that flipped the raw condition without a transition
+};
+
+/**
+ * @brief Debounced, hysteresis-based latch for every fault type
+ *
+ * Tracks each FaultType independently so simultaneous faults are all
+ * visible in active_mask(). Boolean conditions use observe_flag(); analog
+ * values (temperature) use observe_level() with their hysteresis band.
+ *
+ * Not thread-safe; FaultMonitoring serializes access.
+ */
+class FaultStateMachine {
+public:
+    /**
+     * @brief Construct with flag bands, latching on the first asserting
+     *        observation and clearing after DEFAULT_FAULT_CLEAR_SAMPLES
+     */
+    FaultStateMachine();
+
+    /**
+     * @brief Override the hysteresis band and debounce of one fault type
+     */
+    void configure(FaultType type, const FaultHysteresis& rule);
+
+    /**
+     * @brief Feed an analog observation
+     *
+     * @return true if the latched state of this fault changed
+     */
+    bool observe_level(FaultType type, double value);
+
+    /**
+     * @brief Feed a boolean observation
+     *
+     * @return true if the latched state of this fault changed
+     */
+    bool observe_flag(FaultType type, bool asserted);
+
+    /**
+     * @brief Get all latched faults
+     */
+    FaultMask active_mask() const { return active_mask_; }
+
+    /**
+     * @brief Get transition statistics of one fault type
+     */
+    FaultCounters get_counters(FaultType type) const;
+
+    /**
+     * @brief Most severe fault in a mask (NONE if empty)
+     *
+     * Severity: TEMPERATURE_CRITICAL > ELECTRICAL > HYDRAULIC > STALE_DATA > TEMPERATURE_ALERT
+     */
+    static FaultType highest_priority(FaultMask mask);
+
+    /**
+     * @brief Severity rank used by highest_priority() (NONE = 0)
+     */
+    static int severity_rank(FaultType type);
+
+private:
+    struct FaultChannel {
+        FaultHysteresis rule;
+        bool condition;       // Raw condition after hysteresis, before debounce
+        int streak;           // Consecutive observations disagreeing with the latch
+        FaultCounters counters;
+    };
+
+    std::array<FaultChannel, FAULT_TYPE_COUNT> channels_;
+    FaultMask active_mask_;
+};
+
+#endif // FAULT_STATE_MACHINE_H
@@ -0,0 +1,87 @@
+#ifndef FAULT_STATUS_H
+#define FAULT_STATUS_H
+
+#include "common_types.h"
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Lock-free fault word shared by the fault monitor and control tasks
+ *
+ * The highest-priority fault type, the mask of all active faults and a
+ * change sequence number are packed into one atomic word, so control tasks
+ * detect and react to every fault change with a single acquire load and
+ * never wait on the fault monitor. The detection
+ * timestamp is published alongside for fault-to-stop latency measurement.
+ *
+ * Single writer (FaultMonitoring), any number of readers.
+ */
+class FaultStatus {
+public:
+    /**
+     * @brief Consistent view of the published fault
+     */
+    struct Snapshot {
+        FaultType type;
+        FaultMask active_mask;
+        uint32_t sequence;
+        long long detected_ns;
+    };
+
+    FaultStatus() : fault_word_(0), detected_ns_(0) {}
+
+    /**
+     * @brief Publish a new fault state (writer thread only)
+     *
+     * @param type New highest-priority fault type
+     * @param active_mask All active faults
+     * @param detected_ns Steady clock time of detection (ns)
+     */
+    void publish(FaultType type, FaultMask active_mask, long long detected_ns) {
+        uint64_t previous_word = fault_word_.load(std::memory_order_relaxed);
+        uint64_t next_sequence = (previous_word >> SEQUENCE_SHIFT) + 1;
+        detected_ns_.store(detected_ns, std::memory_order_relaxed);
+        fault_word_.store((next_sequence << SEQUENCE_SHIFT) |
+                          ((static_cast<uint64_t>(active_mask) & FIELD_MASK) << FAULT_TYPE_BITS) |
+                          static_cast<uint64_t>(type),
+                          std::memory_order_release);
+    }
+
+    /**
+     * @brief Read the current fault state
+     */
+    Snapshot snapshot() const {
+        uint64_t word = fault_word_.load(std::memory_order_acquire);
+        Snapshot result;
+        result.type = static_cast<FaultType>(word & FIELD_MASK);
+        result.active_mask = static_cast<FaultMask>((word >> FAULT_TYPE_BITS) & FIELD_MASK);
+        result.sequence = static_cast<uint32_t>(word >> SEQUENCE_SHIFT);
+        result.detected_ns = detected_ns_.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    /**
+     * @brief Read only the current fault type
+     */
+    FaultType current() const {
+        return static_cast<FaultType>(fault_word_.load(std::memory_order_acquire) & FIELD_MASK);
+    }
+
+    /**
+     * @brief Read only the mask of active faults
+     */
+    FaultMask active_mask() const {
+        return static_cast<FaultMask>((fault_word_.load(std::memory_order_acquire) >> FAULT_TYPE_BITS) & FIELD_MASK);
+    }
+
+private:
+    static constexpr unsigned FAULT_TYPE_BITS = 8;
+    static constexpr unsigned SEQUENCE_SHIFT = 2 * FAULT_TYPE_BITS;   // type | mask | sequence
+    static constexpr uint64_t FIELD_MASK = (uint64_t{1} << FAULT_TYPE_BITS) - 1;
+    static_assert(FAULT_TYPE_COUNT <= FAULT_TYPE_BITS, "FaultMask must fit in 8 bits");
+
+    std::atomic<uint64_t> fault_word_;
+    std::atomic<long long> detected_ns_;
+};
+
+#endif // FAULT_STATUS_H
@@ -0,0 +1,167 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include "best_effort_executor.h"
+#include "bridge_messages.h"
+#include "bridge_trace.h"
+#include "circular_buffer.h"
+#include "command_logic.h"
+#include "data_collector.h"
+#include "fault_monitoring.h"
+#include "input_freshness_monitor.h"
+#include "navigation_control.h"
+#include "performance_monitor.h"
+#include "rotating_log_file.h"
+#include "route_planning.h"
+#include "rt_worker_pool.h"
+#include "sensor_processing.h"
+#include "watchdog.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @file fleet.h
+ * @brief Several trucks hosted by one truck_control process (fleet mode)
+ *
+ * Each truck keeps its own pipeline: circular buffer, Sensor Processing
+ * filters, Command Logic, Fault Monitoring, Navigation Control, Data
+ * Collector, route planner and input freshness monitor. Trucks share no
+ * control state. What is shared is the machinery: the periodic cycles of
+ * every truck run on one RtWorkerPool instead of one thread per task, one
+ * Watchdog supervises all of them (tasks named "<Task>#<truck_id>"), and
+ * one PerformanceMonitor aggregates the timing per task kind.
+ *
+ * The soft work runs on one BestEffortExecutor: each truck's fault event
+ * delivery, Data Collector status record and log writer are executor jobs.
+ *
+ * One main loop serves the whole fleet. Every cycle it lists
+ * bridge/from_mqtt once, then runs one executor task per truck that
+ * applies the newest file of each of the truck's topics, passes state,
+ * setpoint and navigation output between its tasks, and writes the
+ * to_mqtt actuator and state files on change or every
+ * state_update_interval cycles, as the single-truck loop does.
+ *
+ * LocalInterface is not started. Watchdog fail-fast is disabled: it would
+ * abort every truck for the failure of one.
+ */
+
+struct FleetConfig {
+    int first_truck_id;
+    int truck_count;
+    size_t workers;                     // RtWorkerPool threads
+    size_t best_effort_workers;         // BestEffortExecutor threads
+    std::vector<int> best_effort_cpus;  // BestEffortExecutor affinity (empty: unpinned)
+    int main_loop_period_ms;
+    int state_update_interval;          // Main loop cycles between forced to_mqtt writes
+
+    int sensor_filter_order;
+    int sensor_processing_period_ms;
+    int command_logic_period_ms;
+    int fault_monitoring_period_ms;
+    int navigation_control_period_ms;
+    int data_collector_period_ms;
+
+    int watchdog_tick_ms;
+    int sensor_processing_timeout_ms;
+    int command_logic_timeout_ms;
+    int fault_monitoring_timeout_ms;
+    int navigation_control_timeout_ms;
+    int data_collector_timeout_ms;
+    int restart_after_failures;
+    int max_restarts_per_outage;
+
+    FaultEvaluationMode fault_evaluation_mode;
+    long predictive_alert_horizon_ms;
+    std::array<InputFreshnessLimit, INPUT_TOPIC_COUNT> input_limits;
+    bool telemetry_store;
+    RotatingLogConfig log_rotation;
+};
+
+class Fleet {
+public:
+    explicit Fleet(const FleetConfig& config);
+    ~Fleet();
+
+    /**
+     * @brief Start the pools, every truck's tasks and the watchdog
+     */
+    void start();
+
+    /**
+     * @brief Run the fleet main loop until running is cleared
+     */
+    void run(const std::atomic<bool>& running);
+
+    void stop();
+
+    PerformanceMonitor& get_perf_monitor() { return perf_monitor_; }
+
+    size_t get_truck_count() const { return trucks_.size(); }
+
+private:
+    struct Truck {
+        int id;
+        CircularBuffer buffer;
+        InputFreshnessMonitor input_freshness;
+        SensorProcessing sensor_task;
+        CommandLogic command_task;
+        FaultMonitoring fault_task;
+        NavigationControl nav_task;
+        DataCollector data_collector;
+        RoutePlanning route_planner;
+
+        ActuatorOutput last_actuator_output;
+        TruckState last_state;
+
+        Truck(int truck_id, const FleetConfig& config, PerformanceMonitor* perf_monitor);
+    };
+
+    using TopicFiles = std::array<std::vector<std::string>, BRIDGE_TOPIC_COUNT>;   // Indexed by BridgeTopic
+
+    void configure(Truck& truck);
+
+    /**
+     * @brief List bridge/from_mqtt once and sort the files of this fleet's trucks
+     *
+     * @param files Per truck (index from first_truck_id), per topic, file paths
+     */
+    void scan_bridge(std::vector<TopicFiles>& files) const;
+
+    /**
+     * @brief Apply each topic's files, then remove them
+     *
+     * Commands are applied file by file in order, so two commands in one
+     * cycle both reach CommandLogic's queue; the other topics apply only
+     * their newest file. As in the single-truck loop, each file is parsed on
+     * its own: one that fails is left in place while it may still be
+     * mid-write (BRIDGE_PARTIAL_FILE_MS), then removed with a
+     * bridge_parse_err, so it never blocks the files after it.
+     */
+    void apply_bridge_inputs(Truck& truck, TopicFiles& files);
+
+    /**
+     * @brief Parse one bridge message and hand it to the truck's tasks
+     */
+    void apply_bridge_message(Truck& truck, BridgeTopic topic, const nlohmann::json& message, long now_ms);
+
+    /**
+     * @brief Pass state, setpoint and outputs between the truck's tasks
+     *
+     * Writes the truck's bridge outputs inline, stamped with cycle_ms, so
+     * they are published in cycle order.
+     */
+    void step(Truck& truck, bool force_update, long cycle_ms);
+
+    FleetConfig config_;
+    PerformanceMonitor perf_monitor_;
+    RtWorkerPool pool_;
+    BestEffortExecutor best_effort_;
+    Watchdog watchdog_;
+    std::vector<std::unique_ptr<Truck>> trucks_;
+    bool started_;
+};
+
+#endif // FLEET_H
@@ -0,0 +1,138 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @file flight_recorder.h
+ * @brief Always-on in-memory flight recorder
+ *
+ * Every thread that logs gets a fixed-size ring mmap'd from a file in
+ * /dev/shm (or the recorder directory when there is no /dev/shm). Each
+ * LOGF_* record is copied into it at every level, including DEBUG below
+ * the active log level. So are the LOG_* lines that pass the level filter
+ * and LOGF_FLIGHT samples (per-cycle task execution times). The oldest data is overwritten, so a ring always holds the last
+ * few seconds of detail for its thread. A write is a memcpy into prefaulted
+ * pages with no lock and no syscall.
+ *
+ * A dump snapshots every ring into <directory>/dump_<ms>_<reason>/. It is
+ * triggered by:
+ * - a watchdog fault,
+ * - any CRIT log,
+ * - SIGINT,
+ * - a fatal signal (SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT). The crashing
+ *   thread writes this dump itself, using async-signal-safe calls only.
+ * The flight_recorder_merge tool turns a dump into a single timeline.
+ *
+ * At most FLIGHT_RECORDER_MAX_THREADS rings exist. A thread that exits
+ * hands its slot back but its ring keeps its records, so a dump still shows
+ * the last cycles of a task the watchdog restarted. A new thread reuses the
+ * ring that was freed longest ago once every slot has been mapped. A thread
+ * that finds every slot live records nothing; get_stats() counts it.
+ *
+ * Ring files are removed on a clean stop(). After a SIGKILL they remain as
+ * /dev/shm/truck_flight_<pid>_<tid>.bin, with the same layout as the ring
+ * files of a dump.
+ */
+
+constexpr const char* FLIGHT_RECORDER_DIRECTORY = "logs/flight";
+constexpr const char* FLIGHT_RECORDER_RING_DIRECTORY = "/dev/shm";
+constexpr size_t FLIGHT_RECORDER_RING_BYTES = 256 * 1024;     // Per thread, ~8 s at DEBUG rates
+constexpr size_t FLIGHT_RECORDER_MAX_THREADS = 64;
+constexpr int FLIGHT_RECORDER_MIN_DUMP_INTERVAL_MS = 5000;    // Coalesces CRIT storms
+constexpr int FLIGHT_RECORDER_MAX_DUMPS = 16;                 // Per process run
+
+// Ring file layout: FlightRingHeader padded to FLIGHT_RING_HEADER_BYTES,
+// then data_bytes of ring data. Records are stored as u16 length + deferred
+// log record (deferred_log.h) and may wrap. [oldest, write_pos) are
+// monotonic byte positions of the complete records still in the ring.
+constexpr char FLIGHT_RING_MAGIC[8] = {'T', 'R', 'K', 'F', 'L', 'T', '0', '1'};
+constexpr size_t FLIGHT_RING_HEADER_BYTES = 4096;
+
+// Dumps also contain sites.bin: a deferred log file with the site table and
+// two calibration entries (recorder start and dump time) but no records.
+constexpr const char* FLIGHT_DUMP_SITES_FILE = "sites.bin";
+
+struct FlightRingHeader {
+    char magic[8];
+    uint32_t header_bytes;
+    uint32_t data_bytes;
+    int32_t pid;
+    int32_t tid;
+    std::atomic<uint64_t> oldest;       // First complete record
+    std::atomic<uint64_t> write_pos;    // End of the last complete record
+};
+
+static_assert(sizeof(FlightRingHeader) <= FLIGHT_RING_HEADER_BYTES, "flight ring header too large");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "flight ring positions must be lock-free");
+
+namespace FlightRecorder {
+
+struct Stats {
+    size_t rings;               // Rings mapped
+    size_t live_rings;          // Held by a running thread
+    long rings_reused;          // Exited threads' rings handed to new threads
+    long rings_refused;         // Threads left without a ring (no free slot or mapping failed)
+    long dumps;
+    long suppressed_dumps;
+};
+
+/**
+ * @brief Start recording and install the fatal signal handlers
+ *
+ * Call once from main() before the tasks start.
+ *
+ * @param directory Directory for ring files and dumps (created if missing)
+ * @param ring_bytes Ring data size per thread (rounded up to a power of two)
+ * @return false if the directory could not be created
+ */
+bool start(const std::string& directory = FLIGHT_RECORDER_DIRECTORY,
+           size_t ring_bytes = FLIGHT_RECORDER_RING_BYTES);
+
+/**
+ * @brief Write any pending dump, restore the signal handlers and remove the ring files
+ */
+void stop();
+
+/**
+ * @brief Check whether the recorder is running
+ */
+bool enabled();
+
+/**
+ * @brief Copy one encoded deferred log record into the calling thread's ring
+ *
+ * Lock-free, and no syscall after the thread's first record (which maps
+ * its ring).
+ */
+void record(const char* record, size_t size);
+
+/**
+ * @brief Request a dump from the recorder thread
+ *
+ * Async-signal-safe and never blocks, so it can be called from RT threads
+ * and signal handlers. Requests within FLIGHT_RECORDER_MIN_DUMP_INTERVAL_MS
+ * of the previous dump are dropped unless bypass_rate_limit is set (a
+ * repeat of the same reason is dropped either way).
+ *
+ * @param reason String literal used in the dump directory name
+ * @param bypass_rate_limit Dump even if the previous dump was recent
+ */
+void trigger(const char* reason, bool bypass_rate_limit = false);
+
+/**
+ * @brief Dumps written so far
+ */
+long dump_count();
+
+/**
+ * @brief Ring slot and dump counters (for the performance report)
+ */
+Stats get_stats();
+
+} // namespace FlightRecorder
+
+#endif // FLIGHT_RECORDER_H
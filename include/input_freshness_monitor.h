@@ -0,0 +1,112 @@
+#ifndef INPUT_FRESHNESS_MONITOR_H
+#define INPUT_FRESHNESS_MONITOR_H
+
+#include "common_types.h"
+#include "performance_monitor.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief Bridge input topics supervised for data age
+ */
+enum class InputTopic {
+    SENSORS,
+    COMMANDS,
+    SETPOINT,
+    OBSTACLES
+};
+
+constexpr size_t INPUT_TOPIC_COUNT = 4;
+
+/**
+ * @brief Data-age limits for one input topic
+ */
+struct InputFreshnessLimit {
+    long max_age_ms;                 // Maximum tolerated age of the newest data
+    bool expects_periodic_updates;   // Newest data keeps aging between messages
+};
+
+/**
+ * @brief Sensor-freshness watchdog for bridge inputs
+ *
+ * Tracks the source timestamp of every message read from the bridge and
+ * compares its age against a per-topic limit:
+ *
+ * - Periodic topics (sensors): once the first message arrives, the age of
+ *   the newest data is re-evaluated continuously, so a stalled bridge or
+ *   simulator raises FaultType::STALE_DATA even when no message arrives at
+ *   all.
+ * - Sporadic topics (commands, setpoints, obstacles): only the age at
+ *   arrival is checked; messages older than the limit are reported as stale
+ *   so the caller can discard them instead of acting on old data. Obstacle
+ *   files are only written while a peer truck reports, so their silence is
+ *   not a fault.
+ *
+ * Arrival ages are recorded as "InputAge.<topic>" histograms in the
+ * PerformanceMonitor. Arrivals and evaluation may run on different threads;
+ * all shared state is atomic.
+ *
+ * Real-Time Automation Concepts:
+ * - Data validity / freshness supervision
+ * - Fail-safe reaction to stalled producers
+ */
+class InputFreshnessMonitor {
+public:
+    /**
+     * @brief Construct monitor with per-topic limits
+     *
+     * @param limits Limits indexed by InputTopic
+     * @param perf_monitor Receives age histograms (optional)
+     */
+    InputFreshnessMonitor(const std::array<InputFreshnessLimit, INPUT_TOPIC_COUNT>& limits,
+                          PerformanceMonitor* perf_monitor = nullptr);
+
+    /**
+     * @brief Record one message read from the bridge
+     *
+     * @param topic Input topic
+     * @param source_timestamp_ms Producer timestamp (epoch ms, 0 if unknown)
+     * @param arrival_timestamp_ms Time the message was read (epoch ms)
+     * @return true if the message is within its topic's age limit
+     */
+    bool record_arrival(InputTopic topic, long source_timestamp_ms, long arrival_timestamp_ms);
+
+    /**
+     * @brief Evaluate periodic topics for staleness
+     *
+     * @param now_ms Current time (epoch ms)
+     * @return FaultType STALE_DATA if any armed periodic topic is too old, else NONE
+     */
+    FaultType evaluate(long now_ms);
+
+    /**
+     * @brief Get the age of the newest data on a topic
+     *
+     * @return long Age in ms, or -1 if nothing has arrived yet
+     */
+    long get_data_age_ms(InputTopic topic, long now_ms) const;
+
+    /**
+     * @brief Get number of messages that exceeded their limit on arrival
+     */
+    long get_stale_message_count(InputTopic topic) const;
+
+    /**
+     * @brief Short topic name used in logs and metrics
+     */
+    static const char* topic_name(InputTopic topic);
+
+private:
+    struct TopicState {
+        std::atomic<long> newest_source_timestamp_ms{0};
+        std::atomic<long> stale_message_count{0};
+        std::atomic<bool> stale_reported{false};
+    };
+
+    std::array<InputFreshnessLimit, INPUT_TOPIC_COUNT> limits_;
+    std::array<TopicState, INPUT_TOPIC_COUNT> topic_states_;
+    PerformanceMonitor* perf_monitor_;
+};
+
+#endif // INPUT_FRESHNESS_MONITOR_H
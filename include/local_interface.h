@@ -1,6 +1,7 @@
 #ifndef LOCAL_INTERFACE_H
 #define LOCAL_INTERFACE_H
 
+#include "best_effort_executor.h"
 #include "circular_buffer.h"
 #include "common_types.h"
 #include "performance_monitor.h"
@@ -21,6 +22,9 @@
  * In Stage 1, this provides a simple terminal display.
  * Full keyboard interaction will be integrated with all tasks.
  *
+ * With a BestEffortExecutor the display refresh is a LOW lane job instead
+ * of a thread.
+ *
  * Real-Time Automation Concepts:
  * - Human-machine interface (HMI)
  * - Operator interaction in real-time systems
@@ -71,12 +75,26 @@ public:
      */
     void set_actuator_output(const ActuatorOutput& output);
 
+    /**
+     * @brief Refresh the display as a best-effort executor job
+     *
+     * Must be called before start().
+     *
+     * @param executor Executor (nullptr: own thread)
+     */
+    void set_executor(BestEffortExecutor* executor);
+
 private:
     /**
      * @brief Main display loop
      */
     void task_loop();
 
+    /**
+     * @brief One period: sample the buffer and refresh the display
+     */
+    void run_cycle();
+
     /**
      * @brief Display current truck status
      */
@@ -95,6 +113,8 @@ private:
     size_t buffer_count_;                   // Debug: buffer count
 
     PerformanceMonitor* perf_monitor_;      // Performance monitoring (optional)
+    BestEffortExecutor* executor_;          // Runs the cycle instead of task_thread_ (optional)
+    BestEffortExecutor::JobId executor_job_;
 };
 
 #endif // LOCAL_INTERFACE_H
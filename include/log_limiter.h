@@ -0,0 +1,103 @@
+#ifndef LOG_LIMITER_H
+#define LOG_LIMITER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @file log_limiter.h
+ * @brief Lock-free per-call-site log sampling and rate limiting
+ *
+ * Used through LOGF_EVERY_N and LOGF_RATE_LIMITED (deferred_log.h), which
+ * keep one limiter per call site as a function-local static, or through
+ * LOGF_LIMITED_BY with a limiter owned by an object instance. admit() can be
+ * called concurrently from any number of threads: state is a single atomic
+ * updated with fetch_add or CAS, never a lock. Every emitted record carries
+ * the number of calls suppressed since the previous one.
+ */
+
+namespace Logger {
+
+/**
+ * @brief 1-in-Every sampling: emits calls 0, Every, 2*Every, ...
+ *
+ * Every is a template argument so the modulo compiles to a multiply.
+ */
+template <uint64_t Every>
+class SiteSampler {
+public:
+    static_assert(Every > 0, "sampling period must be positive");
+
+    constexpr SiteSampler() : calls_(0) {}
+
+    /**
+     * @brief Decide whether this call is emitted
+     *
+     * @param suppressed Set to the calls skipped since the previous emitted one
+     * @return true to emit
+     */
+    bool admit(uint64_t& suppressed) {
+        uint64_t call = calls_.fetch_add(1, std::memory_order_relaxed);
+        if (call % Every != 0) {
+            return false;
+        }
+        // Call indices are unique, so exactly Every-1 calls fall between
+        // two emitted ones whatever the thread interleaving.
+        suppressed = call == 0 ? 0 : Every - 1;
+        return true;
+    }
+
+private:
+    std::atomic<uint64_t> calls_;
+};
+
+/**
+ * @brief Token bucket: rate per second sustained, burst back-to-back
+ *
+ * Implemented as GCRA: one atomic "theoretical arrival time" advanced by
+ * the emission interval per admitted call, so a bucket is a single CAS.
+ */
+class SiteRateLimiter {
+public:
+    constexpr SiteRateLimiter(double per_second, uint32_t burst)
+        : interval_ns_(static_cast<int64_t>(1e9 / (per_second > 0.0 ? per_second : 1.0))),
+          limit_ns_(interval_ns_ * static_cast<int64_t>(burst > 0 ? burst : 1)),
+          arrival_ns_(0),
+          suppressed_(0) {}
+
+    /**
+     * @brief Take a token if one is available
+     *
+     * @param suppressed Set to the calls rejected since the previous admitted one
+     * @return true to emit
+     */
+    bool admit(uint64_t& suppressed) {
+        int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        int64_t arrival = arrival_ns_.load(std::memory_order_relaxed);
+        for (;;) {
+            int64_t next = std::max(arrival, now_ns) + interval_ns_;
+            if (next - now_ns > limit_ns_) {
+                suppressed_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (arrival_ns_.compare_exchange_weak(arrival, next, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    int64_t interval_ns_;               // 1 / rate
+    int64_t limit_ns_;                  // burst * interval
+    std::atomic<int64_t> arrival_ns_;   // Theoretical arrival time of the next token
+    std::atomic<uint64_t> suppressed_;  // Rejected since the last admitted call
+};
+
+} // namespace Logger
+
+#endif // LOG_LIMITER_H
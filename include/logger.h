@@ -20,6 +20,13 @@
  *
  * Format: timestamp|level|module|event|data
  * Example: 1731283456789|INFO|SP|WRITE|temp=75,buf=42
+ *
+ * Hot paths use the LOGF_* macros from deferred_log.h, which register
+ * their format once per call site and can defer formatting to an offline
+ * decoder (LOG_DEFERRED_FILE=<path>).
+ *
+ * LOG_FILE=<path> sends the text lines to a RotatingLogFile (size/age
+ * rollover, compression, retention) instead of stdout.
  */
 
 namespace Logger {
@@ -102,6 +109,11 @@ private:
  */
 void init(Level min_level = Level::INFO);
 
+/**
+ * @brief Flush and stop deferred logging (call once before exit)
+ */
+void shutdown();
+
 /**
  * @brief Set minimum log level at runtime
  */
@@ -112,6 +124,25 @@ void set_level(Level min_level);
  */
 Level get_level();
 
+/**
+ * @brief Record LOGF_* calls at every level regardless of the log level
+ *
+ * Used by the flight recorder; records below the log level are still not
+ * printed.
+ */
+void set_capture_all(bool enabled);
+
+/**
+ * @brief Lowest level any sink records (log level, or DEBUG when capturing all)
+ */
+Level capture_level();
+
+/**
+ * @brief Write one formatted line to stdout
+ * @param body Comma-separated key=value pairs
+ */
+void write_line(Level level, Module module, const std::string& body);
+
 /**
  * @brief Create a log entry
  * @param level Log severity level
@@ -0,0 +1,118 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include "common_types.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Bounded lock-free multi-producer/single-consumer queue
+ *
+ * Every cell carries a sequence number (Vyukov bounded queue): producers
+ * claim a cell with one compare-and-swap on the enqueue position and
+ * publish it by bumping the cell's sequence, so producers never wait on
+ * each other or on the consumer and FIFO order is preserved. Only one
+ * thread may pop.
+ *
+ * @tparam T Trivially copyable element type
+ * @tparam Capacity Number of cells (power of two)
+ */
+template <typename T, size_t Capacity>
+class MpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "MpscQueue capacity must be a power of two");
+
+public:
+    MpscQueue() {
+        for (size_t i = 0; i < Capacity; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Append an element (any thread)
+     *
+     * @return false if the queue is full
+     */
+    bool try_push(const T& item) {
+        size_t position;
+        return try_push(item, position);
+    }
+
+    /**
+     * @brief Append an element and report its queue position (any thread)
+     *
+     * Positions count up from 0 in pop order, so the consumer can tell a
+     * producer when its element has been handled.
+     *
+     * @param position Set to the element's position on success
+     * @return false if the queue is full
+     */
+    bool try_push(const T& item, size_t& position) {
+        position = enqueue_position_.load(std::memory_order_relaxed);
+        Cell* cell;
+
+        while (true) {
+            cell = &cells_[position & (Capacity - 1)];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+            if (difference == 0) {
+                if (enqueue_position_.compare_exchange_weak(position, position + 1,
+                                                            std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = enqueue_position_.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = item;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Remove the oldest element (consumer thread only)
+     *
+     * @return false if the queue is empty
+     */
+    bool try_pop(T& item) {
+        size_t position = dequeue_position_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[position & (Capacity - 1)];
+
+        if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+
+        item = cell.data;
+        cell.sequence.store(position + Capacity, std::memory_order_release);
+        dequeue_position_.store(position + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Approximate number of queued elements
+     */
+    size_t size() const {
+        size_t enqueued = enqueue_position_.load(std::memory_order_relaxed);
+        size_t dequeued = dequeue_position_.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::array<Cell, Capacity> cells_;
+    alignas(CACHE_LINE_SIZE_BYTES) std::atomic<size_t> enqueue_position_{0};
+    alignas(CACHE_LINE_SIZE_BYTES) std::atomic<size_t> dequeue_position_{0};
+};
+
+#endif // MPSC_QUEUE_H
@@ -2,8 +2,12 @@
 #define NAVIGATION_CONTROL_H
 
 #include "circular_buffer.h"
+#include "clock.h"
 #include "common_types.h"
 #include "performance_monitor.h"
+#include "rt_worker_pool.h"
+#include "watchdog.h"
+#include "fault_status.h"
 #include <thread>
 #include <atomic>
 #include <mutex>
@@ -88,11 +92,13 @@ public:
     void set_truck_state(const TruckState& state);
 
     /**
-     * @brief Handle fault updates from Fault Monitoring task
+     * @brief Attach the fault word published by Fault Monitoring
      *
-     * @param type Current fault type
+     * Polled lock-free every cycle. Must be called before start().
+     *
+     * @param status Fault word (nullptr disables fault polling)
      */
-    void on_fault_update(FaultType type);
+    void set_fault_status(const FaultStatus* status);
 
     /**
      * @brief Get current control output
@@ -101,12 +107,54 @@ public:
      */
     ActuatorOutput get_output() const;
 
+    /**
+     * @brief Attach the watchdog heartbeat slot reported every cycle
+     *
+     * Must be called before start().
+     *
+     * @param handle Handle returned by Watchdog::register_task()
+     */
+    void set_heartbeat_handle(Watchdog::HeartbeatHandle handle);
+
+    /**
+     * @brief Use a different time source (simulation)
+     *
+     * Must be called before start().
+     *
+     * @param clock Clock for the period sleep and latency timestamps
+     */
+    void set_clock(Clock* clock);
+
+    /**
+     * @brief Run the cycle as a job of a shared worker pool (fleet mode)
+     *
+     * Must be called before start(). start() then adds a periodic job
+     * instead of starting a thread.
+     *
+     * @param pool Worker pool (nullptr: own thread)
+     */
+    void set_worker_pool(RtWorkerPool* pool);
+
 private:
     /**
      * @brief Main control loop
      */
     void task_loop();
 
+    /**
+     * @brief One period: apply fault updates and run the controllers
+     */
+    void run_cycle();
+
+    /**
+     * @brief Apply a fault change observed in the fault word
+     *
+     * Caller must hold control_mutex_.
+     *
+     * @param type Current fault type
+     */
+    void apply_fault_update(FaultType type);
+
     /**
      * @brief Calculate angle from current position to target
      */
@@ -133,7 +181,16 @@ private:
     TruckState truck_state_;                // Current truck state
     ActuatorOutput output_;                 // Current control outputs
 
+    const FaultStatus* fault_status_;       // Lock-free fault word (optional)
+    uint32_t observed_fault_sequence_;      // Last fault word change applied
+
+    Watchdog::HeartbeatHandle heartbeat_handle_; // Watchdog heartbeat slot
+
     PerformanceMonitor* perf_monitor_;      // Performance monitoring (optional)
+    Clock* clock_;                          // Time source (Clock::system() by default)
+    int clock_thread_;                      // Task thread's ID in clock_
+    RtWorkerPool* worker_pool_;             // Runs the cycle instead of task_thread_ (optional)
+    RtWorkerPool::JobId pool_job_;
 };
 
 #endif // NAVIGATION_CONTROL_H
@@ -1,11 +1,17 @@
 #ifndef PERFORMANCE_MONITOR_H
 #define PERFORMANCE_MONITOR_H
 
+#include "clock.h"
 #include <chrono>
 #include <string>
+#include <sstream>
 #include <mutex>
 #include <map>
 #include <vector>
+#include <array>
+#include <climits>
+
+constexpr size_t LATENCY_HISTOGRAM_BUCKETS = 32;
 
 /**
  * @brief Performance monitoring for real-time tasks
@@ -58,6 +64,34 @@ public:
         }
     };
 
+    /**
+     * @brief Event latency statistics (detection, recovery, data age, ...)
+     *
+     * Histogram bucket 0 counts samples below 1μs and bucket i counts
+     * samples in [2^(i-1), 2^i) μs; the last bucket absorbs everything above.
+     */
+    struct LatencyStats {
+        std::string metric_name;
+        long sample_count;
+        long min_us;
+        long max_us;
+        double avg_us;
+        std::array<long, LATENCY_HISTOGRAM_BUCKETS> histogram;
+
+        LatencyStats()
+            : sample_count(0)
+            , min_us(LONG_MAX)
+            , max_us(0)
+            , avg_us(0.0)
+            , histogram{} {}
+
+        /**
+         * @brief Upper bound of the histogram bucket holding the given percentile
+         * @param percentile Value in (0, 100]
+         */
+        long percentile_upper_bound_us(double percentile) const;
+    };
+
     /**
      * @brief Register a task for monitoring
      * @param task_name Unique task identifier
@@ -70,7 +104,7 @@ public:
      * @param task_name Task identifier
      * @return Start timepoint (pass to end_measurement)
      */
-    std::chrono::steady_clock::time_point start_measurement(const std::string& task_name);
+    Clock::time_point start_measurement(const std::string& task_name);
 
     /**
      * @brief End timing and update statistics
@@ -78,7 +112,7 @@ public:
      * @param start_time Timepoint from start_measurement
      */
     void end_measurement(const std::string& task_name,
-                        std::chrono::steady_clock::time_point start_time);
+                        Clock::time_point start_time);
 
     /**
      * @brief Get statistics for a specific task
@@ -93,6 +127,20 @@ public:
      */
     std::map<std::string, TaskStats> get_all_stats() const;
 
+    /**
+     * @brief Record one latency sample for a named event metric
+     * @param metric_name Metric identifier (created on first use)
+     * @param latency_us Measured latency in microseconds
+     */
+    void record_latency(const std::string& metric_name, long latency_us);
+
+    /**
+     * @brief Get latency statistics for a metric
+     * @param metric_name Metric identifier
+     * @return Latency statistics (copy, empty if unknown)
+     */
+    LatencyStats get_latency_stats(const std::string& metric_name) const;
+
     /**
      * @brief Reset statistics for a task
      * @param task_name Task identifier
@@ -121,13 +169,27 @@ public:
      */
     bool has_deadline_violations() const;
 
+    /**
+     * @brief Use a different time source (simulation)
+     *
+     * Must be the clock of the measured tasks, and set before they start.
+     * Under a SimulatedClock, execution times measure virtual time (zero
+     * for a cycle that does not sleep).
+     *
+     * @param clock Clock for start_measurement() and end_measurement()
+     */
+    void set_clock(Clock* clock);
+
 private:
     mutable std::mutex mutex_;
+    Clock* clock_ = &Clock::system();   // Time source
     std::map<std::string, TaskStats> task_stats_;
+    std::map<std::string, LatencyStats> latency_stats_;
 
     // Helper methods
     void update_statistics(TaskStats& stats, long execution_us);
     double calculate_std_dev(const std::vector<long>& samples, double mean) const;
+    void append_latency_report(std::ostringstream& oss) const;
 };
 
 /**
@@ -159,7 +221,7 @@ public:
 private:
     PerformanceMonitor& monitor_;
     std::string task_name_;
-    std::chrono::steady_clock::time_point start_time_;
+    Clock::time_point start_time_;
 };
 
 #endif // PERFORMANCE_MONITOR_H
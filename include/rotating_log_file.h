@@ -0,0 +1,183 @@
+#ifndef ROTATING_LOG_FILE_H
+#define ROTATING_LOG_FILE_H
+
+#include "change_signal.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @file rotating_log_file.h
+ * @brief Append-only text log split into preallocated, rotated segments
+ *
+ * The active segment keeps the log's own name (logs/truck_1_log.csv), so
+ * the live file is always found under the same path. A segment is rolled
+ * when the next append would take it past segment_bytes or when it is
+ * segment_ms old. The closed segment is renamed to <stem>.<close_ms><ext> and is
+ * then gzip-compressed to <stem>.<close_ms><ext>.gz in the background.
+ * Retention deletes the oldest closed segments beyond retain_segments or
+ * retain_bytes.
+ *
+ * Segments are preallocated to segment_bytes and written with pwrite()
+ * at the end of the data. The file size and extent map never change
+ * between rollovers, so fdatasync() only flushes data blocks. The
+ * background thread prepares the next segment ahead of time: fallocate(),
+ * then zeros written over it and synced, because a write into an
+ * fallocate()d but never written extent still has to convert it (a
+ * metadata update). A rollover is then two renames on the writer's path;
+ * the closed segment is truncated to its data, closed and compressed in
+ * the background. On open, a live segment left by a crash is resumed
+ * after its last newline.
+ *
+ * The live segment is therefore always segment_bytes long: its data is
+ * followed by a NUL tail up to the preallocated size until the segment is
+ * closed (rollover or close()). tail, grep -a and spreadsheet imports see
+ * that tail; truck_log_query stops at the last newline, and
+ * `tr -d '\0' < file` strips it. It is not trimmed on each sync because
+ * a size change would make every fdatasync() flush metadata again. With
+ * preallocate = false the live file holds only its data.
+ *
+ * Not thread-safe: one writer at a time.
+ */
+
+constexpr size_t ROTATING_LOG_SEGMENT_BYTES = 64 * 1024 * 1024;
+constexpr long ROTATING_LOG_SEGMENT_MS = 60L * 60 * 1000;
+constexpr size_t ROTATING_LOG_RETAIN_SEGMENTS = 168;                    // One week of hourly segments
+constexpr size_t ROTATING_LOG_RETAIN_BYTES = 1024L * 1024 * 1024;       // On-disk bytes of closed segments
+
+struct RotatingLogConfig {
+    size_t segment_bytes = ROTATING_LOG_SEGMENT_BYTES;  // Roll before a segment would pass this size
+    long segment_ms = ROTATING_LOG_SEGMENT_MS;          // Roll a segment this old (0: size only)
+    bool preallocate = true;                            // fallocate() segments and keep a spare ready
+    bool compress = true;                               // gzip closed segments in the background
+    size_t retain_segments = ROTATING_LOG_RETAIN_SEGMENTS; // Closed segments kept (0: unlimited)
+    size_t retain_bytes = ROTATING_LOG_RETAIN_BYTES;    // Closed segment bytes kept (0: unlimited)
+};
+
+class RotatingLogFile {
+public:
+    RotatingLogFile();
+    ~RotatingLogFile();
+
+    RotatingLogFile(const RotatingLogFile&) = delete;
+    RotatingLogFile& operator=(const RotatingLogFile&) = delete;
+
+    /**
+     * @brief Open or resume the active segment and start the background thread
+     *
+     * @param path Active segment path; closed segments go next to it
+     * @param header Written at the start of every segment (may be empty)
+     * @param config Rotation, preallocation and retention settings
+     * @return false if the active segment could not be opened
+     */
+    bool open(const std::string& path, const std::string& header,
+              const RotatingLogConfig& config = RotatingLogConfig());
+
+    /**
+     * @brief Append bytes (whole lines), rolling the segment first if due
+     *
+     * Data is never split across segments; an append larger than
+     * segment_bytes gets a segment of its own.
+     */
+    bool append(const char* data, size_t size);
+
+    /**
+     * @brief fdatasync() the active segment
+     */
+    bool sync();
+
+    /**
+     * @brief Truncate the active segment to its data and stop the background thread
+     *
+     * Closed segments still waiting for compression are compressed by the
+     * next open().
+     */
+    void close();
+
+    bool is_open() const { return fd_ >= 0; }
+    const std::string& path() const { return path_; }
+
+    long get_rollovers() const { return rollovers_.load(); }
+    long get_compressed() const { return compressed_.load(); }
+    long get_deleted() const { return deleted_.load(); }
+
+    /**
+     * @brief Rollovers that had to create the next segment inline (no spare ready)
+     */
+    long get_spare_misses() const { return spare_misses_.load(); }
+
+private:
+    /**
+     * @brief Close the active segment and switch to the next one
+     */
+    bool roll();
+
+    /**
+     * @brief Create a segment file holding only the header
+     *
+     * @param zero_fill Also write zeros over the preallocated range (background only)
+     * @return Descriptor, or -1
+     */
+    int create_segment(const std::string& path, bool zero_fill) const;
+
+    /**
+     * @brief Name for a segment closed now (unique within the directory)
+     */
+    std::string closed_name() const;
+
+    /**
+     * @brief Background thread: spare segment, compression, retention
+     */
+    void maintenance_loop();
+
+    /**
+     * @brief Queue uncompressed closed segments left by an earlier run
+     */
+    void queue_leftovers();
+
+    /**
+     * @brief A rolled segment waiting for the background thread
+     */
+    struct ClosedSegmentFile {
+        std::string path;
+        int fd;                         // Still open from the writer, or -1 (left by an earlier run)
+        size_t used;                    // Data bytes when fd is open
+    };
+
+    /**
+     * @brief Truncate a closed segment to its data and close it
+     */
+    void finish_segment(ClosedSegmentFile& segment);
+
+    bool compress_segment(const std::string& path);
+    void apply_retention();
+
+    std::string path_;                  // Active segment
+    std::string stem_;                  // Path without extension
+    std::string extension_;             // e.g. ".csv"
+    std::string spare_path_;            // Preallocated next segment
+    std::string header_;
+    RotatingLogConfig config_;
+
+    int fd_;                            // Active segment
+    size_t used_;                       // Data bytes in the active segment
+    std::chrono::steady_clock::time_point opened_; // Active segment start
+
+    std::mutex mutex_;                  // Guards spare_fd_ and pending_
+    int spare_fd_;                      // Ready spare segment, or -1
+    std::deque<ClosedSegmentFile> pending_; // Closed segments to finish and compress
+    ChangeSignal maintenance_signal_;   // Writer -> background thread
+    std::atomic<bool> maintenance_running_;
+    std::thread maintenance_thread_;
+
+    std::atomic<long> rollovers_;
+    std::atomic<long> compressed_;
+    std::atomic<long> deleted_;
+    std::atomic<long> spare_misses_;
+};
+
+#endif // ROTATING_LOG_FILE_H
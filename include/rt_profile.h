@@ -0,0 +1,110 @@
+#ifndef RT_PROFILE_H
+#define RT_PROFILE_H
+
+#include <cstddef>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * @file rt_profile.h
+ * @brief Startup profile: CPU placement, memory locking and prefaulting of the threads
+ *
+ * A JSON profile (RT_PROFILE_FILE) says where each thread role runs and
+ * how memory is prepared before the first control cycle:
+ *
+ *   {
+ *     "cpus": {"Main": "0", "BestEffort": "0", "Watchdog": "1",
+ *              "SensorProcessing": "2", "CommandLogic": "3", ...},
+ *     "lock_memory": true,
+ *     "prefault_stack_kb": 512,
+ *     "prefault_heap_kb": 16384,
+ *     "prefault_thread_heap_kb": 256,
+ *     "heap_arenas": 0,
+ *     "strict": false
+ *   }
+ *
+ * apply() runs once at startup. It disables heap trimming and mmap'ed
+ * allocations so prefaulted heap stays mapped, then calls mlockall(),
+ * touches the main heap arena, and pins every thread already running
+ * (the logger's, the flight recorder's and main) to the "Main" CPUs.
+ * Threads started later inherit that set until they pin themselves.
+ * It then checks that the CPUs of the SCHED_FIFO roles are listed in the
+ * host's isolcpus and nohz_full sets and are not shared with the soft
+ * roles. With "strict", a failed mlockall() or isolation check makes
+ * apply() fail.
+ *
+ * Every task thread calls enter_thread() before its first cycle. That
+ * pins it to its role's CPUs, touches its stack and its heap arena, and
+ * registers it for the performance report. The report then shows, per
+ * thread, the minor and major page faults, CPU migrations and
+ * involuntary context switches since that point. The baseline comes from
+ * getrusage(RUSAGE_THREAD) and /proc/self/task/<tid>/sched, and the
+ * current values from /proc/self/task/<tid>/{stat,sched}. Threads
+ * register even without a profile, so the report always has this
+ * section.
+ */
+class RtProfile {
+public:
+    struct Config {
+        std::map<std::string, std::vector<int>> cpus;  // Role -> CPU set (missing: not pinned)
+        bool lock_memory = false;                       // mlockall(MCL_CURRENT | MCL_FUTURE)
+        size_t prefault_stack_bytes = 0;                // Touched by each thread in enter_thread()
+        size_t prefault_heap_bytes = 0;                 // Main arena, touched by apply()
+        size_t prefault_thread_heap_bytes = 0;          // Each thread's arena, touched in enter_thread()
+        int heap_arenas = 0;                            // M_ARENA_MAX (0: glibc default)
+        bool strict = false;                            // mlockall or isolation failure fails apply()
+    };
+
+    /**
+     * @brief Read a JSON profile
+     *
+     * Unknown keys and roles are errors, so a misspelt role cannot
+     * silently leave a task unpinned.
+     *
+     * @param error Set to the reason on failure
+     */
+    static bool load(const std::string& path, Config& config, std::string& error);
+
+    /**
+     * @brief Lock and prefault memory, pin the running threads, check isolation
+     *
+     * Call once from main, before any task starts.
+     *
+     * @return false if strict and memory locking or the isolation check failed
+     */
+    static bool apply(const Config& config);
+
+    /**
+     * @brief CPU set of a role (empty if the profile does not pin it)
+     */
+    static std::vector<int> role_cpus(const std::string& role);
+
+    /**
+     * @brief Prepare and register the calling thread (call from the thread)
+     *
+     * @param role Profile role (SensorProcessing, RtWorkerPool, BestEffort, ...)
+     * @param thread_name Name in the report (default: role)
+     */
+    static void enter_thread(const std::string& role, const std::string& thread_name = "");
+
+    /**
+     * @brief Append the per-thread page fault and migration table
+     */
+    static void append_thread_report(std::ostringstream& oss);
+
+    /**
+     * @brief Parse a CPU list as in /sys and isolcpus= ("2-3,6")
+     *
+     * @return false if the text is empty or malformed
+     */
+    static bool parse_cpu_list(const std::string& text, std::vector<int>& cpus);
+
+    /**
+     * @brief Format a sorted CPU list with ranges ("2-3,6"), "all" if empty
+     */
+    static std::string format_cpu_list(const std::vector<int>& cpus);
+};
+
+#endif // RT_PROFILE_H
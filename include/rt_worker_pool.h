@@ -0,0 +1,126 @@
+#ifndef RT_WORKER_POOL_H
+#define RT_WORKER_POOL_H
+
+#include "performance_monitor.h"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr int RT_WORKER_POOL_THREAD_PRIORITY = 70;
+
+/**
+ * @file rt_worker_pool.h
+ * @brief Fixed set of SCHED_FIFO threads running periodic task cycles
+ *
+ * A process that hosts several trucks (fleet mode) would otherwise start
+ * one thread per task per truck. Instead, each task adds its cycle to the
+ * pool as a periodic job and the pool's workers run every job.
+ *
+ * Jobs are released once per period and run earliest release first. A job
+ * never runs on two workers at once, so a task's cycle keeps the
+ * single-threaded guarantees it had on its own thread. A cycle that ends
+ * after its next release counts as an overrun, and the next release moves
+ * to the current time instead of running back-to-back cycles to catch up.
+ * Each release's lateness (start time minus release time) is recorded as
+ * the "RtPoolRelease" latency metric.
+ *
+ * The pool keeps real time (steady_clock); it is not driven by a
+ * SimulatedClock. A cycle must not block on anything but short locks:
+ * while it waits, it holds a worker.
+ */
+class RtWorkerPool {
+public:
+    using JobId = int;
+
+    struct Stats {
+        size_t workers;
+        size_t jobs;
+        long runs;
+        long overruns;
+        long max_lateness_us;
+    };
+
+    /**
+     * @brief Construct the pool (workers are started by start())
+     *
+     * @param workers Number of worker threads
+     * @param rt_priority SCHED_FIFO priority of the workers
+     * @param perf_monitor Receives release lateness (optional)
+     */
+    explicit RtWorkerPool(size_t workers, int rt_priority = RT_WORKER_POOL_THREAD_PRIORITY,
+                          PerformanceMonitor* perf_monitor = nullptr);
+
+    ~RtWorkerPool();
+
+    void start();
+
+    /**
+     * @brief Stop the workers after their current cycles (jobs stay added)
+     */
+    void stop();
+
+    /**
+     * @brief Add a periodic job, first released now
+     *
+     * @param name Job name (for diagnostics)
+     * @param period_ms Release period in milliseconds
+     * @param cycle One task cycle
+     * @return ID to pass to remove()
+     */
+    JobId add_periodic(const std::string& name, int period_ms, std::function<void()> cycle);
+
+    /**
+     * @brief Remove a job, waiting for a cycle in progress to end
+     *
+     * Must not be called from the job's own cycle.
+     */
+    void remove(JobId id);
+
+    Stats get_stats() const;
+
+private:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    struct Job {
+        std::string name;
+        std::chrono::nanoseconds period;
+        std::function<void()> cycle;
+        time_point release;
+        bool running = false;
+        long runs = 0;
+        long overruns = 0;
+    };
+
+    struct Release {
+        time_point time;
+        JobId id;
+        bool operator>(const Release& other) const {
+            return time != other.time ? time > other.time : id > other.id;
+        }
+    };
+
+    void worker_loop(size_t index);
+
+    size_t worker_count_;
+    int rt_priority_;
+    PerformanceMonitor* perf_monitor_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable release_changed_;   // Workers: earlier release or stop
+    std::condition_variable cycle_done_;        // remove(): a cycle ended
+    std::vector<std::unique_ptr<Job>> jobs_;    // Indexed by JobId, nullptr once removed
+    std::priority_queue<Release, std::vector<Release>, std::greater<Release>> releases_;
+    std::vector<std::thread> workers_;
+    bool running_;
+    long overruns_;
+    long runs_;
+    long max_lateness_us_;
+};
+
+#endif // RT_WORKER_POOL_H
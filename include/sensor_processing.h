@@ -2,12 +2,20 @@
 #define SENSOR_PROCESSING_H
 
 #include "circular_buffer.h"
+#include "clock.h"
+#include "log_limiter.h"
 #include "performance_monitor.h"
+#include "rt_worker_pool.h"
+#include "telemetry_capture.h"
+#include "watchdog.h"
 #include <thread>
 #include <atomic>
 #include <deque>
+#include <mutex>
+#include <functional>
 
 constexpr int SENSOR_PROCESSING_THREAD_PRIORITY = 60;
+constexpr uint64_t SENSOR_PROCESSING_WRITE_LOG_EVERY = 50;     // DEBUG write record sampling
 
 /**
  * @brief Raw sensor readings from the truck's sensors
@@ -24,6 +32,19 @@ struct RawSensorData {
     bool fault_hydraulic;   // Hydraulic fault flag
 };
 
+/**
+ * @brief Post-write hook invoked for every processed sample
+ *
+ * Runs synchronously on the sensor processing thread right after the
+ * filtered sample is written to the buffer.
+ *
+ * @param raw Unfiltered sample the filtered value was computed from
+ * @param filtered Sample written to the buffer
+ * @param raw_arrival_ns Steady clock time the raw sample was received (ns)
+ */
+using SensorSampleHook = std::function<void(const RawSensorData& raw, const SensorData& filtered,
+                                            long long raw_arrival_ns)>;
+
 /**
  * @brief Sensor Processing Task
  *
@@ -86,6 +107,53 @@ public:
      */
     void set_raw_data(const RawSensorData& data);
 
+    /**
+     * @brief Attach the watchdog heartbeat slot reported every cycle
+     *
+     * Must be called before start().
+     *
+     * @param handle Handle returned by Watchdog::register_task()
+     */
+    void set_heartbeat_handle(Watchdog::HeartbeatHandle handle);
+
+    /**
+     * @brief Attach a hook run after every buffer write
+     *
+     * Must be called before start(). Keep the hook short: it executes
+     * inside this task's period.
+     *
+     * @param hook Post-write hook (empty function disables it)
+     */
+    void set_sample_hook(SensorSampleHook hook);
+
+    /**
+     * @brief Capture every filtered sample written to the buffer
+     *
+     * Must be called before start().
+     *
+     * @param capture Capture ring (nullptr disables capture)
+     */
+    void set_telemetry_capture(TelemetryCapture* capture);
+
+    /**
+     * @brief Use a different time source (simulation)
+     *
+     * Must be called before start().
+     *
+     * @param clock Clock for timestamps and the period sleep
+     */
+    void set_clock(Clock* clock);
+
+    /**
+     * @brief Run the cycle as a job of a shared worker pool (fleet mode)
+     *
+     * Must be called before start(). start() then adds a periodic job
+     * instead of starting a thread.
+     *
+     * @param pool Worker pool (nullptr: own thread)
+     */
+    void set_worker_pool(RtWorkerPool* pool);
+
 private:
     /**
      * @brief Main task loop executed by the thread
@@ -94,6 +162,11 @@ private:
      */
     void task_loop();
 
+    /**
+     * @brief One period: filter the latest raw sample and write it
+     */
+    void run_cycle();
+
     /**
      * @brief Apply moving average filter to position data
      *
@@ -113,7 +186,15 @@ private:
     std::atomic<bool> running_;         // Flag to control task execution
     std::thread task_thread_;           // Thread executing the task
 
+    Watchdog::HeartbeatHandle heartbeat_handle_; // Watchdog heartbeat slot
+    SensorSampleHook sample_hook_;      // Post-write hook (optional)
+    TelemetryCapture* capture_;         // Full-rate capture (optional)
+
     PerformanceMonitor* perf_monitor_;  // Performance monitoring (optional)
+    Clock* clock_;                      // Time source (Clock::system() by default)
+    int clock_thread_;                  // Task thread's ID in clock_
+    RtWorkerPool* worker_pool_;         // Runs the cycle instead of task_thread_ (optional)
+    RtWorkerPool::JobId pool_job_;
 
     // Moving average history for each filtered sensor
     std::deque<int> position_x_history_;
@@ -123,7 +204,10 @@ private:
 
     // Current raw sensor data (simulated for Stage 1)
     RawSensorData current_raw_data_;
+    long long raw_arrival_ns_;          // Monotonic clock time of last set_raw_data()
     std::mutex raw_data_mutex_;         // Protect access to raw data
+
+    Logger::SiteSampler<SENSOR_PROCESSING_WRITE_LOG_EVERY> write_log_sampler_;   // Per task instance
 };
 
 #endif // SENSOR_PROCESSING_H
@@ -0,0 +1,73 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include "common_types.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief Bounded lock-free single-producer/single-consumer ring
+ *
+ * try_push() and try_pop() never block and never allocate, so a hard
+ * real-time producer can hand work to a best-effort consumer thread.
+ * Exactly one thread may push and exactly one thread may pop.
+ *
+ * @tparam T Trivially copyable element type
+ * @tparam Capacity Number of slots (power of two)
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscRing capacity must be a power of two");
+
+public:
+    /**
+     * @brief Append an element (producer thread only)
+     *
+     * @return false if the ring is full
+     */
+    bool try_push(const T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        items_[tail & (Capacity - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Remove the oldest element (consumer thread only)
+     *
+     * @return false if the ring is empty
+     */
+    bool try_pop(T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items_[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Approximate number of queued elements
+     */
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Check if the ring is (approximately) empty
+     */
+    bool is_empty() const { return size() == 0; }
+
+private:
+    alignas(CACHE_LINE_SIZE_BYTES) std::atomic<size_t> head_{0};
+    alignas(CACHE_LINE_SIZE_BYTES) std::atomic<size_t> tail_{0};
+    alignas(CACHE_LINE_SIZE_BYTES) std::array<T, Capacity> items_{};
+};
+
+#endif // SPSC_RING_H
@@ -0,0 +1,121 @@
+#ifndef TELEMETRY_CAPTURE_H
+#define TELEMETRY_CAPTURE_H
+
+#include "change_signal.h"
+#include "circular_buffer.h"
+#include "clock.h"
+#include "common_types.h"
+#include "log_limiter.h"
+#include "mpsc_queue.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+constexpr size_t TELEMETRY_CAPTURE_CAPACITY = 4096;        // Staging ring cells
+constexpr int TELEMETRY_CAPTURE_DRAIN_INTERVAL_MS = 100;   // Longest a record waits in the ring
+constexpr int TELEMETRY_CAPTURE_REPORT_INTERVAL_MS = 10000; // capture_stats log period
+
+/**
+ * @brief What a capture record holds
+ */
+enum class CaptureKind : uint8_t {
+    SENSOR,     // Every filtered sample written to the circular buffer
+    ACTUATOR,   // Every change of the Command Logic actuator output
+    STATE,      // Every TruckState transition
+    COUNT
+};
+
+constexpr size_t CAPTURE_KIND_COUNT = static_cast<size_t>(CaptureKind::COUNT);
+
+/**
+ * @brief One captured event (trivially copyable staging ring cell)
+ *
+ * Only the member matching kind is meaningful.
+ */
+struct CaptureRecord {
+    int64_t timestamp_us;       // Wall clock at capture (microseconds)
+    CaptureKind kind;
+    SensorData sensor;
+    ActuatorOutput actuator;
+    TruckState state;
+};
+
+/**
+ * @brief Full-rate capture of sensor samples, actuator changes and state transitions
+ *
+ * The RT tasks call the record_*() methods on their own threads: a record
+ * is timestamped and copied into a preallocated lock-free MPSC ring, with
+ * no lock, allocation or syscall. The DataCollector writer thread drains
+ * the ring at least every TELEMETRY_CAPTURE_DRAIN_INTERVAL_MS and group
+ * commits the records to logs/truck_<id>_capture.csv.
+ *
+ * A producer that finds the ring half full wakes the writer early (one
+ * futex wake). A full ring drops the new record and counts it per kind;
+ * nothing ever blocks a producer. The ring holds 4096 records, over 20 s of the
+ * system's normal sensor (50 Hz) and actuator change rates.
+ */
+class TelemetryCapture {
+public:
+    TelemetryCapture();
+
+    /**
+     * @brief Capture a filtered sample (Sensor Processing thread)
+     */
+    void record_sensor(const SensorData& data);
+
+    /**
+     * @brief Capture a new actuator output (Command Logic thread)
+     */
+    void record_actuator(const ActuatorOutput& output);
+
+    /**
+     * @brief Capture a truck state transition (Command Logic thread)
+     */
+    void record_state(const TruckState& state);
+
+    /**
+     * @brief Signal to notify when the ring is filling up
+     *
+     * Set by DataCollector::set_telemetry_capture() before the producers start.
+     */
+    void set_drain_signal(ChangeSignal* signal) { drain_signal_ = signal; }
+
+    /**
+     * @brief Time source for record timestamps (set before the producers start)
+     */
+    void set_clock(Clock* clock) { clock_ = clock; }
+
+    /**
+     * @brief Take the oldest record (single consumer: DataCollector writer)
+     *
+     * @return false if the ring is empty
+     */
+    bool try_pop(CaptureRecord& record) { return ring_.try_pop(record); }
+
+    size_t pending() const { return ring_.size(); }
+
+    long get_recorded(CaptureKind kind) const { return recorded_[static_cast<size_t>(kind)].load(); }
+    long get_dropped(CaptureKind kind) const { return dropped_[static_cast<size_t>(kind)].load(); }
+
+    /**
+     * @brief Records dropped on a full ring, all kinds
+     */
+    long get_dropped_total() const;
+
+    /**
+     * @brief Text name of a kind, as written in the capture CSV
+     */
+    static const char* kind_name(CaptureKind kind);
+
+private:
+    void push(CaptureRecord& record);
+
+    MpscQueue<CaptureRecord, TELEMETRY_CAPTURE_CAPACITY> ring_;   // Staging ring
+    ChangeSignal* drain_signal_;                        // Consumer wakeup (optional)
+    Clock* clock_;                                      // Timestamp source
+    std::atomic<long> recorded_[CAPTURE_KIND_COUNT];    // Accepted into the ring
+    std::atomic<long> dropped_[CAPTURE_KIND_COUNT];     // Lost to a full ring
+    Logger::SiteRateLimiter drop_log_limiter_;          // capture_drop warnings of this ring
+};
+
+#endif // TELEMETRY_CAPTURE_H
@@ -0,0 +1,351 @@
+#ifndef TELEMETRY_STORE_H
+#define TELEMETRY_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file telemetry_store.h
+ * @brief Columnar binary store for DataCollector event records
+ *
+ * A store file is a header page, then fixed-size segments, then a time
+ * index footer:
+ *
+ *   [TelemetryFileHeader, padded to TELEMETRY_FILE_HEADER_BYTES]
+ *   [segment 0][segment 1]...   each exactly segment_bytes, page aligned
+ *   [TelemetrySegmentIndex x N][TelemetryFooterTail]
+ *
+ * A segment holds the rows of one batch column by column:
+ * - timestamp, truck_id, position_x, position_y: zigzag varint of the
+ *   delta to the previous row (the first row's delta is from 0),
+ * - state, description: varint id into the segment's dictionary,
+ * - dictionary: varint length + bytes per distinct string.
+ * Each segment is self-contained, so a reader can decode any one of them
+ * from the index alone. The unused tail of a segment is left as a file
+ * hole and takes no disk blocks.
+ *
+ * The writer seals a segment when the next row might not fit, on flush()
+ * and on close(), writing it through an mmap of its file range. The
+ * footer is written by close(); without it (crash) the reader rebuilds the
+ * index by walking the segments. The reader maps the whole file and hands
+ * out string_views into the mapping: decoding copies nothing.
+ */
+
+constexpr char TELEMETRY_FILE_MAGIC[8] = {'T', 'R', 'K', 'T', 'L', 'M', '0', '1'};
+constexpr char TELEMETRY_SEGMENT_MAGIC[4] = {'T', 'S', 'E', 'G'};
+constexpr char TELEMETRY_FOOTER_MAGIC[4] = {'T', 'I', 'D', 'X'};
+constexpr size_t TELEMETRY_FILE_HEADER_BYTES = 4096;
+constexpr size_t TELEMETRY_SEGMENT_BYTES = 16 * 1024;       // Multiple of the page size
+constexpr size_t TELEMETRY_MAX_STRING_BYTES = 255;          // Longer states/descriptions are truncated
+
+enum TelemetryColumn : uint32_t {
+    TELEMETRY_COLUMN_TIMESTAMP,
+    TELEMETRY_COLUMN_TRUCK_ID,
+    TELEMETRY_COLUMN_STATE,
+    TELEMETRY_COLUMN_POSITION_X,
+    TELEMETRY_COLUMN_POSITION_Y,
+    TELEMETRY_COLUMN_DESCRIPTION,
+    TELEMETRY_COLUMN_DICTIONARY,
+    TELEMETRY_COLUMN_COUNT
+};
+
+struct TelemetryFileHeader {
+    char magic[8];
+    uint32_t header_bytes;
+    uint32_t segment_bytes;
+    int64_t created_ms;
+};
+
+struct TelemetrySegmentHeader {
+    char magic[4];
+    uint32_t used_bytes;                                // Header + columns
+    uint32_t row_count;
+    uint32_t dictionary_entries;
+    int64_t min_timestamp;
+    int64_t max_timestamp;
+    uint32_t column_offset[TELEMETRY_COLUMN_COUNT];     // From the segment start
+    uint32_t column_bytes[TELEMETRY_COLUMN_COUNT];
+};
+
+struct TelemetrySegmentIndex {
+    uint64_t offset;                                    // From the file start
+    int64_t min_timestamp;
+    int64_t max_timestamp;
+    uint32_t row_count;
+    uint32_t used_bytes;
+};
+
+struct TelemetryFooterTail {
+    uint32_t segment_count;
+    char magic[4];
+};
+
+static_assert(TELEMETRY_SEGMENT_BYTES % 4096 == 0, "segments must be page aligned");
+static_assert(sizeof(TelemetryFileHeader) <= TELEMETRY_FILE_HEADER_BYTES, "telemetry file header too large");
+
+/**
+ * @brief One decoded row; strings point into the reader's mapping
+ */
+struct TelemetryRow {
+    int64_t timestamp;
+    int truck_id;
+    std::string_view state;
+    int position_x;
+    int position_y;
+    std::string_view description;
+};
+
+namespace telemetry_detail {
+
+inline uint64_t zigzag_encode(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t zigzag_decode(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+inline void append_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+inline bool read_varint(const uint8_t*& cursor, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && cursor < end; shift += 7) {
+        uint8_t byte = *cursor++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace telemetry_detail
+
+/**
+ * @brief Read-only view of one segment inside a mapped store file
+ */
+class TelemetrySegmentView {
+public:
+    /**
+     * @brief Validate the segment header and load its dictionary
+     *
+     * @param segment Start of the segment in the mapping
+     * @param size Bytes available from segment (at least its used_bytes)
+     * @return false if the segment is missing or malformed
+     */
+    bool load(const char* segment, size_t size);
+
+    const TelemetrySegmentHeader& header() const { return header_; }
+
+    /**
+     * @brief Decode every row with min_ts <= timestamp <= max_ts
+     *
+     * @param fn Called with each matching const TelemetryRow&
+     * @return Rows passed to fn, or -1 if a column is malformed
+     */
+    template <typename Fn>
+    long for_each(int64_t min_ts, int64_t max_ts, Fn&& fn) const {
+        const uint8_t* cursor[TELEMETRY_COLUMN_DICTIONARY];
+        const uint8_t* end[TELEMETRY_COLUMN_DICTIONARY];
+        for (uint32_t column = 0; column < TELEMETRY_COLUMN_DICTIONARY; column++) {
+            cursor[column] = reinterpret_cast<const uint8_t*>(segment_ + header_.column_offset[column]);
+            end[column] = cursor[column] + header_.column_bytes[column];
+        }
+
+        int64_t value[TELEMETRY_COLUMN_DICTIONARY] = {};
+        long matched = 0;
+        TelemetryRow row;
+        for (uint32_t i = 0; i < header_.row_count; i++) {
+            uint64_t raw[TELEMETRY_COLUMN_DICTIONARY];
+            for (uint32_t column = 0; column < TELEMETRY_COLUMN_DICTIONARY; column++) {
+                if (!telemetry_detail::read_varint(cursor[column], end[column], raw[column])) {
+                    return -1;
+                }
+            }
+            value[TELEMETRY_COLUMN_TIMESTAMP] += telemetry_detail::zigzag_decode(raw[TELEMETRY_COLUMN_TIMESTAMP]);
+            value[TELEMETRY_COLUMN_TRUCK_ID] += telemetry_detail::zigzag_decode(raw[TELEMETRY_COLUMN_TRUCK_ID]);
+            value[TELEMETRY_COLUMN_POSITION_X] += telemetry_detail::zigzag_decode(raw[TELEMETRY_COLUMN_POSITION_X]);
+            value[TELEMETRY_COLUMN_POSITION_Y] += telemetry_detail::zigzag_decode(raw[TELEMETRY_COLUMN_POSITION_Y]);
+            if (value[TELEMETRY_COLUMN_TIMESTAMP] < min_ts || value[TELEMETRY_COLUMN_TIMESTAMP] > max_ts) {
+                continue;
+            }
+            if (raw[TELEMETRY_COLUMN_STATE] >= dictionary_.size() ||
+                raw[TELEMETRY_COLUMN_DESCRIPTION] >= dictionary_.size()) {
+                return -1;
+            }
+            row.timestamp = value[TELEMETRY_COLUMN_TIMESTAMP];
+            row.truck_id = static_cast<int>(value[TELEMETRY_COLUMN_TRUCK_ID]);
+            row.state = dictionary_[raw[TELEMETRY_COLUMN_STATE]];
+            row.position_x = static_cast<int>(value[TELEMETRY_COLUMN_POSITION_X]);
+            row.position_y = static_cast<int>(value[TELEMETRY_COLUMN_POSITION_Y]);
+            row.description = dictionary_[raw[TELEMETRY_COLUMN_DESCRIPTION]];
+            fn(static_cast<const TelemetryRow&>(row));
+            matched++;
+        }
+        return matched;
+    }
+
+private:
+    const char* segment_ = nullptr;
+    TelemetrySegmentHeader header_ = {};
+    std::vector<std::string_view> dictionary_;
+};
+
+/**
+ * @brief Append-only writer of one store file (single thread)
+ */
+class TelemetryStoreWriter {
+public:
+    TelemetryStoreWriter();
+    ~TelemetryStoreWriter();
+
+    TelemetryStoreWriter(const TelemetryStoreWriter&) = delete;
+    TelemetryStoreWriter& operator=(const TelemetryStoreWriter&) = delete;
+
+    /**
+     * @brief Create (or truncate) the store file and write its header
+     *
+     * @param segment_bytes Segment size, a multiple of the page size
+     * @return false if the file could not be created
+     */
+    bool open(const std::string& path, size_t segment_bytes = TELEMETRY_SEGMENT_BYTES);
+
+    /**
+     * @brief Add a row to the active segment, sealing it first if full
+     *
+     * @return false if the store is closed or a segment write failed
+     */
+    bool append(int64_t timestamp, int truck_id, std::string_view state,
+                int position_x, int position_y, std::string_view description);
+
+    /**
+     * @brief Seal the active segment if it holds rows
+     *
+     * The segment is on disk (msync) when this returns true.
+     */
+    bool flush();
+
+    /**
+     * @brief Flush, write the time index footer and close the file
+     */
+    bool close();
+
+    bool is_open() const { return fd_ >= 0; }
+    uint32_t pending_rows() const { return row_count_; }
+    long rows_written() const { return rows_written_; }
+    long segments_written() const { return static_cast<long>(index_.size()); }
+
+    /**
+     * @brief File size so far (segments are counted at full size)
+     */
+    uint64_t file_bytes() const;
+
+private:
+    /**
+     * @brief Dictionary id of text, adding it to the segment if new
+     */
+    uint32_t dictionary_id(std::string_view text);
+
+    /**
+     * @brief Encoded size of the active segment
+     */
+    size_t used_bytes() const;
+
+    /**
+     * @brief Write the active segment to the next slot through an mmap
+     */
+    bool seal();
+
+    void reset_segment();
+
+    int fd_;
+    size_t segment_bytes_;
+    uint64_t footer_offset_;                        // Where the next segment (or the footer) goes
+    std::string columns_[TELEMETRY_COLUMN_COUNT];   // Active segment
+    std::map<std::string, uint32_t, std::less<>> dictionary_;
+    uint32_t row_count_;
+    int64_t previous_[TELEMETRY_COLUMN_DICTIONARY]; // Delta bases (numeric columns only)
+    int64_t min_timestamp_;
+    int64_t max_timestamp_;
+    std::vector<TelemetrySegmentIndex> index_;
+    long rows_written_;
+};
+
+/**
+ * @brief Zero-copy reader of a store file
+ */
+class TelemetryStoreReader {
+public:
+    TelemetryStoreReader();
+    ~TelemetryStoreReader();
+
+    TelemetryStoreReader(const TelemetryStoreReader&) = delete;
+    TelemetryStoreReader& operator=(const TelemetryStoreReader&) = delete;
+
+    /**
+     * @brief Map a store file and load its time index
+     *
+     * Uses the footer when present, otherwise walks the segments.
+     *
+     * @return false if the file is missing or not a store file
+     */
+    bool open(const std::string& path);
+
+    void close();
+
+    const std::vector<TelemetrySegmentIndex>& segments() const { return index_; }
+    bool has_footer() const { return has_footer_; }
+    size_t file_bytes() const { return size_; }
+
+    /**
+     * @brief Load one segment of the index
+     */
+    bool segment(size_t index, TelemetrySegmentView& view) const;
+
+    /**
+     * @brief Decode the rows with min_ts <= timestamp <= max_ts
+     *
+     * Segments whose index range misses [min_ts, max_ts] are not touched.
+     *
+     * @param fn Called with each matching const TelemetryRow&
+     * @return Rows passed to fn; malformed segments are skipped
+     */
+    template <typename Fn>
+    long scan(int64_t min_ts, int64_t max_ts, Fn&& fn) const {
+        long matched = 0;
+        TelemetrySegmentView view;
+        for (size_t i = 0; i < index_.size(); i++) {
+            if (index_[i].max_timestamp < min_ts || index_[i].min_timestamp > max_ts || !segment(i, view)) {
+                continue;
+            }
+            long rows = view.for_each(min_ts, max_ts, fn);
+            if (rows > 0) {
+                matched += rows;
+            }
+        }
+        return matched;
+    }
+
+private:
+    bool load_footer();
+    void walk_segments();
+
+    const char* data_;
+    size_t size_;
+    uint32_t segment_bytes_;
+    uint32_t header_bytes_;
+    std::vector<TelemetrySegmentIndex> index_;
+    bool has_footer_;
+};
+
+#endif // TELEMETRY_STORE_H
@@ -0,0 +1,94 @@
+#ifndef TEMPERATURE_TREND_ESTIMATOR_H
+#define TEMPERATURE_TREND_ESTIMATOR_H
+
+#include <cstddef>
+#include <vector>
+
+constexpr size_t DEFAULT_TREND_WINDOW_SAMPLES = 50;
+
+/**
+ * @brief Rolling least-squares slope estimator for a sampled signal
+ *
+ * Fits a line v(t) = a + b*t over the last N samples and extrapolates it
+ * to predict when a threshold will be crossed. Each add_sample() updates
+ * the running sums (Σt, Σv, Σt², Σtv) in O(1):
+ *
+ * - Times are kept relative to the newest sample; moving the origin is a
+ *   closed-form correction of the sums, so values stay small and the
+ *   normal equations do not lose precision over long runs.
+ * - The evicted sample is subtracted from the sums.
+ * - Once per full window wrap the sums are re-accumulated from the window
+ *   (amortized O(1)) to bound floating-point drift.
+ *
+ * Not thread-safe; owned by a single task.
+ */
+class TemperatureTrendEstimator {
+public:
+    /**
+     * @brief Construct estimator
+     *
+     * @param window_samples Number of samples in the regression window (>= 2)
+     */
+    explicit TemperatureTrendEstimator(size_t window_samples = DEFAULT_TREND_WINDOW_SAMPLES);
+
+    /**
+     * @brief Add a sample (timestamps must be non-decreasing)
+     *
+     * @param timestamp_ms Sample time in milliseconds
+     * @param value Sample value
+     */
+    void add_sample(long timestamp_ms, double value);
+
+    /**
+     * @brief Discard all samples
+     */
+    void reset();
+
+    /**
+     * @brief Check if the regression window is full
+     */
+    bool is_ready() const { return count_ == window_.size(); }
+
+    /**
+     * @brief Fitted slope in units per second (0 if fewer than 2 samples)
+     */
+    double slope_per_second() const;
+
+    /**
+     * @brief Fitted value at the newest sample time
+     */
+    double fitted_value() const;
+
+    /**
+     * @brief Predict time until the fitted line reaches a threshold
+     *
+     * @param threshold Value to reach (from below)
+     * @param min_slope_per_second Slopes below this are treated as flat
+     * @return long Milliseconds until the crossing, 0 if already reached,
+     *              -1 if the window is not full or the trend is not rising
+     */
+    long predict_ms_to_reach(double threshold, double min_slope_per_second) const;
+
+private:
+    struct Sample {
+        long timestamp_ms;
+        double value;
+    };
+
+    /**
+     * @brief Re-accumulate the sums from the window contents
+     */
+    void resum();
+
+    std::vector<Sample> window_;    // Ring of the last N samples
+    size_t next_;                   // Next ring slot to write
+    size_t count_;                  // Samples currently in the window
+    long origin_ms_;                // Newest sample time (t = 0 for the sums)
+
+    double sum_t_;                  // Σt   (seconds, relative to origin)
+    double sum_v_;                  // Σv
+    double sum_tt_;                 // Σt²
+    double sum_tv_;                 // Σt·v
+};
+
+#endif // TEMPERATURE_TREND_ESTIMATOR_H
@@ -0,0 +1,93 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Hierarchical timing wheel for large numbers of deadlines
+ *
+ * Entries are identified by a dense index in [0, capacity). Scheduling and
+ * cancelling an entry are O(1); advancing one tick costs O(1) plus the
+ * entries that expire or cascade down from a coarser level.
+ *
+ * Layout: one fine level of 256 one-tick buckets followed by three coarse
+ * levels of 64 buckets each, covering roughly 2^26 ticks (about 18 hours at
+ * a 1 ms tick). Deadlines further out are clamped to the wheel horizon, so
+ * owners must re-validate an expiry against their own clock.
+ *
+ * Not thread-safe: a single owner thread schedules and advances.
+ *
+ * Real-Time Automation Concepts:
+ * - Timer management with bounded per-tick cost
+ * - Deadline supervision at scale
+ */
+class TimingWheel {
+public:
+    /**
+     * @brief Construct an empty wheel
+     *
+     * @param capacity Number of entry ids the wheel can hold
+     */
+    explicit TimingWheel(size_t capacity);
+
+    /**
+     * @brief Schedule (or reschedule) an entry
+     *
+     * Deadlines at or before the current tick expire on the next advance().
+     *
+     * @param entry_id Entry index in [0, capacity)
+     * @param deadline_tick Absolute tick at which the entry expires
+     */
+    void schedule(size_t entry_id, uint64_t deadline_tick);
+
+    /**
+     * @brief Remove an entry if scheduled
+     *
+     * @param entry_id Entry index in [0, capacity)
+     */
+    void cancel(size_t entry_id);
+
+    /**
+     * @brief Check whether an entry is currently scheduled
+     */
+    bool is_scheduled(size_t entry_id) const;
+
+    /**
+     * @brief Advance the wheel by one tick
+     *
+     * @param expired_entry_ids Receives ids whose deadline has been reached
+     */
+    void advance(std::vector<size_t>& expired_entry_ids);
+
+    /**
+     * @brief Get the current tick
+     */
+    uint64_t current_tick() const { return current_tick_; }
+
+    /**
+     * @brief Get the number of scheduled entries
+     */
+    size_t scheduled_count() const { return scheduled_count_; }
+
+private:
+    struct WheelEntry {
+        size_t next;
+        size_t prev;
+        size_t bucket;
+        uint64_t deadline_tick;
+    };
+
+    void link(size_t entry_id, size_t bucket);
+    void unlink(size_t entry_id);
+    size_t select_bucket(uint64_t deadline_tick) const;
+    void cascade(size_t bucket);
+
+    std::vector<WheelEntry> entries_;
+    std::vector<size_t> bucket_heads_;
+    uint64_t current_tick_;
+    size_t scheduled_count_;
+};
+
+#endif // TIMING_WHEEL_H
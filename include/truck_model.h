@@ -0,0 +1,63 @@
+#ifndef TRUCK_MODEL_H
+#define TRUCK_MODEL_H
+
+#include "common_types.h"
+#include "sensor_processing.h"
+#include <cstdint>
+
+/**
+ * @file truck_model.h
+ * @brief Truck plant model of the mine simulator (python_gui/mine_simulation.py)
+ *
+ * One frame() is one 60 Hz simulator frame: the acceleration command moves
+ * the velocity, the steering command turns the heading at a bounded rate,
+ * the truck moves on the 1000x700 map, and the engine heats while the
+ * truck runs fast and cools otherwise. sample() returns the sensors with
+ * the simulator's noise amplitudes, drawn from a seeded xorshift generator
+ * so a run can be repeated exactly.
+ */
+
+constexpr int TRUCK_MODEL_FRAMES_PER_SECOND = 60;
+constexpr double TRUCK_MODEL_MAX_SPEED = 5.0;
+constexpr double TRUCK_MODEL_ACCELERATION_RATE = 0.3;
+constexpr double TRUCK_MODEL_MAX_TURN_RATE_DEGREES = 5.0;
+constexpr double TRUCK_MODEL_MAP_WIDTH = 1000.0;
+constexpr double TRUCK_MODEL_MAP_HEIGHT = 700.0;
+constexpr double TRUCK_MODEL_TEMPERATURE_BASE = 75.0;
+constexpr double TRUCK_MODEL_TEMPERATURE_MIN = 20.0;
+constexpr double TRUCK_MODEL_TEMPERATURE_MAX = 150.0;
+constexpr double TRUCK_MODEL_TEMPERATURE_INCREASE_RATE = 0.1;
+constexpr double TRUCK_MODEL_TEMPERATURE_DECREASE_RATE = 0.05;
+constexpr double TRUCK_MODEL_VELOCITY_HEATING_THRESHOLD = 2.0;
+constexpr int TRUCK_MODEL_NOISE_POSITION = 2;
+constexpr int TRUCK_MODEL_NOISE_ANGLE = 1;
+constexpr int TRUCK_MODEL_NOISE_TEMPERATURE = 2;
+constexpr uint64_t TRUCK_MODEL_DEFAULT_NOISE_SEED = 0x9E3779B97F4A7C15ULL;
+
+struct TruckModel {
+    double x;
+    double y;
+    double angle;           // Heading, degrees [0, 360)
+    double velocity;        // Pixels per frame
+    double temperature;     // Degrees C
+    bool fault_electrical;
+    bool fault_hydraulic;
+    uint64_t noise_state;
+
+    TruckModel(double start_x, double start_y, uint64_t noise_seed = TRUCK_MODEL_DEFAULT_NOISE_SEED);
+
+    /**
+     * @brief Advance one simulator frame under the actuator command
+     */
+    void frame(const ActuatorOutput& output);
+
+    /**
+     * @brief Sensor readings with noise (advances the noise generator)
+     */
+    RawSensorData sample();
+
+private:
+    int noise(int amplitude);
+};
+
+#endif // TRUCK_MODEL_H
@@ -6,8 +6,19 @@
 #include <mutex>
 #include <chrono>
 #include <string>
-#include <map>
+#include <vector>
+#include <memory>
 #include <functional>
+#include <deque>
+#include <condition_variable>
+#include "clock.h"
+#include "timing_wheel.h"
+#include "performance_monitor.h"
+#include "common_types.h"
+
+constexpr size_t DEFAULT_MAX_MONITORED_TASKS = 64;
+constexpr int DEFAULT_WATCHDOG_TICK_PERIOD_MS = 1;
+constexpr int WATCHDOG_THREAD_PRIORITY = 95;
 
 /**
  * @brief Watchdog Timer for Hard Real-Time Systems
@@ -17,6 +28,24 @@
  * their status. If a task fails to report within its timeout period,
  * the watchdog triggers a fault handler.
  *
+ * Each registered task owns a cache-line-padded heartbeat slot holding an
+ * atomic timestamp. Reporting a heartbeat is a single relaxed store into
+ * that slot, so a fault handler that blocks never delays a task's heartbeat.
+ *
+ * Deadlines are kept in a hierarchical timing wheel owned by the watchdog
+ * thread and advanced every tick (1 ms by default), so each timeout is
+ * detected within one tick of expiry regardless of how many entities are
+ * monitored. Heartbeats re-arm lazily: when a slot's wheel entry expires,
+ * the watchdog reads the slot and, if a newer heartbeat arrived, reschedules
+ * the entry at last_heartbeat + timeout in O(1) instead of raising a fault.
+ *
+ * Each task may carry an escalating RecoveryPolicy. On the first timeout the
+ * watchdog thread forces a safe actuator output (lock-free, never blocks);
+ * after further consecutive timeouts a dedicated recovery thread restarts
+ * the task cooperatively; if the task still does not recover the process
+ * fails fast so an external supervisor can restart it. Time-to-safe-state
+ * and time-to-recovery are recorded in the PerformanceMonitor.
+ *
  * Real-Time Automation Concepts:
  * - Fault tolerance and detection
  * - Heartbeat/keepalive protocol
@@ -31,14 +60,26 @@
  * Usage Example:
  * ```cpp
  * Watchdog watchdog;
- * watchdog.register_task("FaultMonitoring", 200);  // 200ms timeout
+ * Watchdog::HeartbeatHandle handle = watchdog.register_task("FaultMonitoring", 200);
  * watchdog.start();
  *
  * // In task loop:
- * watchdog.heartbeat("FaultMonitoring");
+ * Watchdog::heartbeat(handle);
  * ```
  */
 class Watchdog {
+private:
+    /**
+     * @brief Per-task heartbeat slot, padded to avoid false sharing
+     *
+     * A last_heartbeat_ns of zero means the task has never reported.
+     */
+    struct alignas(CACHE_LINE_SIZE_BYTES) HeartbeatSlot {
+        std::atomic<long long> last_heartbeat_ns{0};
+        std::atomic<bool> active{false};
+        int timeout_ms{0};
+    };
+
 public:
     /**
      * @brief Fault handler callback type
@@ -48,12 +89,56 @@ public:
      */
     using FaultHandler = std::function<void(const std::string&, long)>;
 
+    /**
+     * @brief Escalating recovery actions for one monitored task
+     *
+     * Any action may be left empty. Failure counts refer to consecutive
+     * timeouts within one outage; zero disables that escalation step.
+     * enter_safe_state runs on the watchdog thread and must not block;
+     * restart_task runs on the recovery thread and may block.
+     */
+    struct RecoveryPolicy {
+        std::function<void()> enter_safe_state;
+        std::function<void()> restart_task;
+        std::function<void()> on_recovered;
+        int restart_after_failures;
+        int max_restarts_per_outage;
+        int fail_fast_after_failures;
+
+        RecoveryPolicy()
+            : restart_after_failures(0)
+            , max_restarts_per_outage(0)
+            , fail_fast_after_failures(0) {}
+    };
+
+    /**
+     * @brief Lightweight reference to a registered task's heartbeat slot
+     *
+     * Default-constructed handles are invalid and heartbeats through them
+     * are ignored, so tasks run unchanged without a watchdog.
+     */
+    class HeartbeatHandle {
+    public:
+        HeartbeatHandle() : slot_(nullptr), clock_(nullptr) {}
+        bool is_valid() const { return slot_ != nullptr; }
+
+    private:
+        friend class Watchdog;
+        HeartbeatHandle(HeartbeatSlot* slot, const Clock* clock) : slot_(slot), clock_(clock) {}
+        HeartbeatSlot* slot_;
+        const Clock* clock_;        // Watchdog's time source
+    };
+
     /**
      * @brief Construct watchdog timer
      *
-     * @param check_period_ms How often to check task status (default: 100ms)
+     * @param tick_period_ms Timing wheel resolution (default: 1ms)
+     * @param max_monitored_tasks Number of heartbeat slots to preallocate
+     * @param perf_monitor Records detection latency per task (optional)
      */
-    Watchdog(int check_period_ms = 100);
+    Watchdog(int tick_period_ms = DEFAULT_WATCHDOG_TICK_PERIOD_MS,
+             size_t max_monitored_tasks = DEFAULT_MAX_MONITORED_TASKS,
+             PerformanceMonitor* perf_monitor = nullptr);
 
     /**
      * @brief Destroy watchdog and stop monitoring
@@ -78,14 +163,21 @@ public:
     /**
      * @brief Register a task for monitoring
      *
+     * Registering a name that is already monitored returns its existing handle.
+     *
      * @param task_name Unique task identifier
      * @param timeout_ms Maximum time between heartbeats (ms)
+     * @return HeartbeatHandle Handle to pass to heartbeat() (invalid if no slot is free)
      */
-    void register_task(const std::string& task_name, int timeout_ms);
+    HeartbeatHandle register_task(const std::string& task_name, int timeout_ms);
 
     /**
      * @brief Unregister a task from monitoring
      *
+     * If the task is in an outage, the watchdog thread ends it on its next
+     * tick and runs the policy's on_recovered, so a safe output engaged for
+     * this task is released.
+     *
      * @param task_name Task to remove
      */
     void unregister_task(const std::string& task_name);
@@ -93,22 +185,51 @@ public:
     /**
      * @brief Report heartbeat from task (task is alive)
      *
-     * Tasks must call this periodically to avoid timeout.
+     * Tasks must call this periodically to avoid timeout. Lock-free and
+     * allocation-free: a single relaxed store of the current time.
      *
-     * @param task_name Task identifier
+     * @param handle Handle returned by register_task()
      */
-    void heartbeat(const std::string& task_name);
+    static void heartbeat(HeartbeatHandle handle) {
+        if (handle.slot_) {
+            handle.slot_->last_heartbeat_ns.store(handle.clock_->now_ns(), std::memory_order_relaxed);
+        }
+    }
 
     /**
      * @brief Set custom fault handler
      *
      * Default handler logs error. Custom handler can implement
      * recovery actions like restarting tasks or shutting down.
+     * Must be set before start().
      *
      * @param handler Callback function for fault events
      */
     void set_fault_handler(FaultHandler handler);
 
+    /**
+     * @brief Attach an escalating recovery policy to a registered task
+     *
+     * Policies are read by the watchdog threads without locking, so the
+     * call is rejected (logged, returns false) from start() until stop()
+     * has joined them.
+     *
+     * @param task_name Registered task identifier
+     * @param policy Recovery actions and escalation thresholds
+     * @return true if the task is registered and the watchdog is not running
+     */
+    bool set_recovery_policy(const std::string& task_name, const RecoveryPolicy& policy);
+
+    /**
+     * @brief Use a different time source (simulation)
+     *
+     * Heartbeat handles carry the clock, so this must be called before
+     * register_task() and start().
+     *
+     * @param clock Clock for heartbeats, deadlines and the tick sleep
+     */
+    void set_clock(Clock* clock);
+
     /**
      * @brief Get number of registered tasks
      */
@@ -135,13 +256,13 @@ public:
 
 private:
     /**
-     * @brief Internal structure for task monitoring
+     * @brief Watchdog-thread-private bookkeeping for a slot
      */
-    struct TaskInfo {
-        int timeout_ms;                                    // Maximum time between heartbeats
-        std::chrono::steady_clock::time_point last_heartbeat;  // Last heartbeat time
-        bool ever_reported;                                // Has task ever reported?
-        int consecutive_failures;                          // Consecutive timeout count
+    struct SlotMonitorState {
+        long long last_fault_ns;
+        long long outage_deadline_ns;
+        int consecutive_failures;
+        int restarts_this_outage;
     };
 
     /**
@@ -150,13 +271,49 @@ private:
     void watchdog_loop();
 
     /**
-     * @brief Check if task has timed out
+     * @brief Schedule wheel entries for slots registered since the last tick
+     *
+     * @param now_ns Current steady clock time in nanoseconds
+     */
+    void arm_new_slots(long long now_ns);
+
+    /**
+     * @brief Re-arm an expired slot or raise a fault if it has timed out
      *
-     * @param task_name Task to check
-     * @param info Task information
-     * @return true if timed out
+     * @param slot_index Index of the expired slot
+     * @param now_ns Current steady clock time in nanoseconds
      */
-    bool is_timed_out(const std::string& task_name, const TaskInfo& info);
+    void handle_expired_slot(size_t slot_index, long long now_ns);
+
+    /**
+     * @brief Raise a timeout fault and apply the slot's escalation step
+     */
+    void raise_timeout(size_t slot_index, long long now_ns, long long last_heartbeat_ns);
+
+    /**
+     * @brief End an outage once the task reports again
+     */
+    void complete_recovery(size_t slot_index, long long last_heartbeat_ns);
+
+    /**
+     * @brief Reset a slot's outage and run its on_recovered action
+     */
+    void end_outage(size_t slot_index);
+
+    /**
+     * @brief Escalate recovery for a slot after a timeout
+     */
+    void escalate_recovery(size_t slot_index, long long now_ns);
+
+    /**
+     * @brief Recovery thread loop executing blocking task restarts
+     */
+    void recovery_loop();
+
+    /**
+     * @brief Convert an absolute steady clock time to a wheel tick (rounded up)
+     */
+    uint64_t tick_for_time(long long time_ns) const;
 
     /**
      * @brief Default fault handler (logs error)
@@ -166,15 +323,37 @@ private:
      */
     void default_fault_handler(const std::string& task_name, long elapsed_ms);
 
-    int check_period_ms_;                              // Watchdog check period
-    std::atomic<bool> running_;                        // Watchdog running flag
-    std::thread watchdog_thread_;                      // Watchdog thread
+    int tick_period_ms_;
+    long long tick_period_ns_;
+    size_t max_monitored_tasks_;
+    std::atomic<bool> running_;
+    std::thread watchdog_thread_;
+
+    std::unique_ptr<HeartbeatSlot[]> slots_;
+    std::vector<std::string> slot_names_;
+    std::vector<SlotMonitorState> slot_monitor_states_;
+    std::atomic<size_t> registered_slot_count_;
+    mutable std::mutex registration_mutex_;
+
+    TimingWheel timing_wheel_;
+    long long wheel_epoch_ns_;
+    size_t armed_slot_count_;
+    std::vector<size_t> expired_slot_ids_;
+
+    PerformanceMonitor* perf_monitor_;
+    Clock* clock_;                      // Time source (Clock::system() by default)
+    int clock_thread_;                  // Watchdog thread's ID in clock_
 
-    mutable std::mutex tasks_mutex_;                   // Protects task map
-    std::map<std::string, TaskInfo> monitored_tasks_;  // Registered tasks
+    std::vector<RecoveryPolicy> recovery_policies_;
+    bool policies_in_use_;              // Threads may read recovery_policies_ (registration_mutex_)
+    std::unique_ptr<std::atomic<bool>[]> restart_pending_;
+    std::thread recovery_thread_;
+    std::mutex recovery_mutex_;
+    std::condition_variable recovery_requested_;
+    std::deque<size_t> pending_restart_slots_;
 
-    FaultHandler fault_handler_;                       // Fault callback
-    std::atomic<int> fault_count_;                     // Total faults detected
+    FaultHandler fault_handler_;
+    std::atomic<int> fault_count_;
 };
 
 #endif // WATCHDOG_H
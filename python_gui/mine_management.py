@@ -450,7 +450,8 @@ class MineManagementGUI:
             setpoint_data = {
                 "target_x": x,
                 "target_y": y,
-                "target_speed": DEFAULT_TARGET_SPEED
+                "target_speed": DEFAULT_TARGET_SPEED,
+                "timestamp": int(time.time() * 1000)
             }
 
             topic = MQTT_TOPIC_SETPOINT.format(self.selected_truck)
@@ -470,7 +471,8 @@ class MineManagementGUI:
 
         command_data = {
             "auto_mode": automatic,
-            "manual_mode": not automatic
+            "manual_mode": not automatic,
+            "timestamp": int(time.time() * 1000)
         }
 
         topic = MQTT_TOPIC_COMMANDS.format(self.selected_truck)
@@ -484,7 +486,7 @@ class MineManagementGUI:
         if not self.selected_truck or not self.mqtt_connected:
             return
 
-        command_data = {"rearm": True}
+        command_data = {"rearm": True, "timestamp": int(time.time() * 1000)}
 
         topic = MQTT_TOPIC_COMMANDS.format(self.selected_truck)
         payload = json.dumps(command_data)
@@ -531,6 +533,7 @@ class MineManagementGUI:
         if not self.selected_truck:
             return
 
+        data["timestamp"] = int(time.time() * 1000)
         topic = MQTT_TOPIC_COMMANDS.format(self.selected_truck)
         payload = json.dumps(data)
         self.mqtt_client.publish(topic, payload)
@@ -0,0 +1,386 @@
+#include "best_effort_executor.h"
+#include "deferred_log.h"
+#include "logger.h"
+#include "rt_profile.h"
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+
+namespace {
+
+// Worker identity of the calling thread, for submit() and help()
+thread_local const BestEffortExecutor* tls_executor = nullptr;
+thread_local size_t tls_worker = 0;
+
+long elapsed_us(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return static_cast<long>(std::chrono::duration_cast<std::chrono::microseconds>(to - from).count());
+}
+
+void store_max(std::atomic<long>& target, long value) {
+    long current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+BestEffortExecutor::BestEffortExecutor(size_t workers, size_t max_jobs, PerformanceMonitor* perf_monitor)
+    : worker_count_(std::max<size_t>(workers, 1)),
+      max_jobs_(max_jobs),
+      perf_monitor_(perf_monitor),
+      running_(false),
+      next_worker_(0),
+      jobs_(max_jobs),
+      next_generation_(0),
+      wake_requests_(new std::atomic<bool>[max_jobs]()),
+      wake_pending_(false),
+      steals_(0),
+      rejected_(0) {
+    for (size_t lane = 0; lane < BEST_EFFORT_LANE_COUNT; lane++) {
+        lane_runs_[lane] = 0;
+        lane_max_wait_us_[lane] = 0;
+    }
+    for (size_t i = 0; i < worker_count_; i++) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+}
+
+BestEffortExecutor::~BestEffortExecutor() {
+    stop();
+}
+
+void BestEffortExecutor::set_cpu_affinity(const std::vector<int>& cpus) {
+    cpus_ = cpus;
+}
+
+void BestEffortExecutor::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : cpus_) {
+        CPU_SET(cpu, &cpu_set);
+    }
+
+    int failed = 0;
+    int last_error = 0;
+    for (size_t i = 0; i < worker_count_; i++) {
+        workers_[i]->thread = std::thread(&BestEffortExecutor::worker_loop, this, i);
+        if (!cpus_.empty()) {
+            int result = pthread_setaffinity_np(workers_[i]->thread.native_handle(), sizeof(cpu_set), &cpu_set);
+            if (result != 0) {
+                failed++;
+                last_error = result;
+            }
+        }
+    }
+
+    if (failed == 0) {
+        LOG_INFO(MAIN) << "event" << "be_pool_start" << "workers" << worker_count_
+                       << "cpus" << RtProfile::format_cpu_list(cpus_);
+    } else {
+        LOG_WARN(MAIN) << "event" << "be_pool_start" << "workers" << worker_count_
+                       << "cpus" << "failed" << "failed_workers" << failed << "errno" << last_error;
+    }
+}
+
+void BestEffortExecutor::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    work_signal_.notify();
+
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+
+    // Tasks submitted while the last worker was leaving
+    Task task;
+    while (take_task(0, task)) {
+        run_task(task, false);
+    }
+
+    Stats stats = get_stats();
+    LOG_INFO(MAIN) << "event" << "be_pool_stop" << "jobs" << stats.jobs
+                   << "runs_high" << stats.runs[0] << "runs_normal" << stats.runs[1] << "runs_low" << stats.runs[2]
+                   << "max_wait_us_high" << stats.max_wait_us[0] << "max_wait_us_normal" << stats.max_wait_us[1]
+                   << "max_wait_us_low" << stats.max_wait_us[2]
+                   << "steals" << stats.steals << "rejected" << stats.rejected;
+}
+
+bool BestEffortExecutor::submit(WorkLane lane, const char* name, std::function<void()> task) {
+    if (!running_.load()) {
+        rejected_++;
+        return false;
+    }
+
+    size_t index = tls_executor == this ? tls_worker : next_worker_.fetch_add(1) % worker_count_;
+    push_task(index, Task{-1, 0, lane, name, std::move(task), std::chrono::steady_clock::now()});
+    work_signal_.notify();
+    return true;
+}
+
+void BestEffortExecutor::parallel_for(WorkLane lane, const char* name, size_t count,
+                                      const std::function<void(size_t)>& body) {
+    // Shared with the tasks: the last one may still be inside notify() when the caller returns
+    struct Batch {
+        std::atomic<size_t> remaining;
+        ChangeSignal done;
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->remaining = count;
+
+    for (size_t i = 0; i < count; i++) {
+        bool queued = submit(lane, name, [batch, &body, i] {
+            body(i);
+            if (batch->remaining.fetch_sub(1) == 1) {
+                batch->done.notify();
+            }
+        });
+        if (!queued) {
+            body(i);
+            batch->remaining--;
+        }
+    }
+
+    while (batch->remaining.load() > 0) {
+        uint32_t seen = batch->done.version();
+        if (batch->remaining.load() == 0) {
+            break;
+        }
+        batch->done.wait_until(seen, std::chrono::steady_clock::now() +
+                                     std::chrono::milliseconds(BEST_EFFORT_IDLE_WAIT_MS));
+    }
+}
+
+BestEffortExecutor::JobId BestEffortExecutor::add_periodic(WorkLane lane, const char* name, int period_ms,
+                                                           std::function<void()> cycle) {
+    JobId id = -1;
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        auto slot = std::find(jobs_.begin(), jobs_.end(), nullptr);
+        if (slot != jobs_.end()) {
+            id = static_cast<JobId>(slot - jobs_.begin());
+            auto job = std::make_unique<Job>();
+            job->name = name;
+            job->lane = lane;
+            job->period = std::chrono::milliseconds(period_ms);
+            job->cycle = std::move(cycle);
+            job->release = std::chrono::steady_clock::now();
+            job->generation = next_generation_++;
+            releases_.push(Release{job->release, id, job->generation});
+            *slot = std::move(job);
+        }
+    }
+
+    if (id < 0) {
+        LOG_ERR(MAIN) << "event" << "be_pool_full" << "job" << name << "max_jobs" << max_jobs_;
+        return -1;
+    }
+    work_signal_.notify();
+    return id;
+}
+
+void BestEffortExecutor::wake(JobId id) {
+    if (id < 0 || static_cast<size_t>(id) >= max_jobs_) {
+        return;
+    }
+    wake_requests_[id].store(true);
+    wake_pending_.store(true);
+    work_signal_.notify();
+}
+
+void BestEffortExecutor::remove(JobId id) {
+    std::unique_lock<std::mutex> lock(jobs_mutex_);
+    if (id < 0 || static_cast<size_t>(id) >= jobs_.size() || !jobs_[id]) {
+        return;
+    }
+
+    // A queued task or pending release of the job is dropped when reached
+    cycle_done_.wait(lock, [&] { return !jobs_[id]->running; });
+    LOG_DEBUG(MAIN) << "event" << "be_pool_remove" << "job" << jobs_[id]->name << "runs" << jobs_[id]->runs;
+    jobs_[id].reset();
+}
+
+bool BestEffortExecutor::help() {
+    if (tls_executor != this) {
+        return false;
+    }
+
+    release_jobs(tls_worker);
+    Task task;
+    if (!take_task(tls_worker, task)) {
+        return false;
+    }
+    // The caller goes back to waiting, not to its loop: the other workers
+    // must see the job's next release
+    run_task(task, true);
+    return true;
+}
+
+BestEffortExecutor::Stats BestEffortExecutor::get_stats() const {
+    Stats stats;
+    stats.workers = worker_count_;
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        stats.jobs = static_cast<size_t>(std::count_if(jobs_.begin(), jobs_.end(),
+                                                       [](const std::unique_ptr<Job>& job) { return job != nullptr; }));
+    }
+    for (size_t lane = 0; lane < BEST_EFFORT_LANE_COUNT; lane++) {
+        stats.runs[lane] = lane_runs_[lane].load();
+        stats.max_wait_us[lane] = lane_max_wait_us_[lane].load();
+    }
+    stats.steals = steals_.load();
+    stats.rejected = rejected_.load();
+    return stats;
+}
+
+void BestEffortExecutor::worker_loop(size_t index) {
+    RtProfile::enter_thread("BestEffort", "BestEffort#" + std::to_string(index));
+    tls_executor = this;
+    tls_worker = index;
+
+    while (true) {
+        uint32_t seen = work_signal_.version();
+        time_point next_release = release_jobs(index);
+
+        Task task;
+        if (take_task(index, task)) {
+            run_task(task, false);
+            continue;
+        }
+        if (!running_.load()) {
+            break;
+        }
+        work_signal_.wait_until(seen, next_release);
+    }
+
+    tls_executor = nullptr;
+}
+
+BestEffortExecutor::time_point BestEffortExecutor::release_jobs(size_t index) {
+    std::lock_guard<std::mutex> lock(jobs_mutex_);
+    auto now = std::chrono::steady_clock::now();
+    auto idle_deadline = now + std::chrono::milliseconds(BEST_EFFORT_IDLE_WAIT_MS);
+    if (!running_.load()) {
+        return idle_deadline;
+    }
+
+    if (wake_pending_.exchange(false)) {
+        for (size_t id = 0; id < jobs_.size(); id++) {
+            if (!wake_requests_[id].exchange(false) || !jobs_[id]) {
+                continue;
+            }
+            Job& job = *jobs_[id];
+            if (job.running) {
+                job.rerun = true;
+            } else if (!job.queued) {
+                // Replaces the pending release, which is dropped when reached
+                job.release = now;
+                job.generation = next_generation_++;
+                releases_.push(Release{now, static_cast<JobId>(id), job.generation});
+            }
+        }
+    }
+
+    while (!releases_.empty()) {
+        Release next = releases_.top();
+        Job* job = jobs_[next.id].get();
+        if (!job || job->generation != next.generation) {
+            releases_.pop();
+            continue;
+        }
+        if (next.time > now) {
+            return std::min(next.time, idle_deadline);
+        }
+        releases_.pop();
+        job->queued = true;
+        push_task(index, Task{next.id, next.generation, job->lane, job->name, nullptr, next.time});
+    }
+    return idle_deadline;
+}
+
+void BestEffortExecutor::push_task(size_t index, Task task) {
+    Worker& worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.lanes[static_cast<size_t>(task.lane)].push_back(std::move(task));
+}
+
+bool BestEffortExecutor::take_task(size_t index, Task& task) {
+    for (size_t lane = 0; lane < BEST_EFFORT_LANE_COUNT; lane++) {
+        for (size_t offset = 0; offset < worker_count_; offset++) {
+            Worker& worker = *workers_[(index + offset) % worker_count_];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            auto& queue = worker.lanes[lane];
+            if (queue.empty()) {
+                continue;
+            }
+            task = std::move(queue.front());
+            queue.pop_front();
+            if (offset > 0) {
+                steals_++;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void BestEffortExecutor::run_task(Task& task, bool notify_release) {
+    Job* job = nullptr;
+    if (task.job >= 0) {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        job = jobs_[task.job].get();
+        if (!job || job->generation != task.generation) {
+            return;         // Removed after its release was queued
+        }
+        job->queued = false;
+        job->running = true;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    long wait_us = elapsed_us(task.queued, start);
+    size_t lane = static_cast<size_t>(task.lane);
+    lane_runs_[lane]++;
+    store_max(lane_max_wait_us_[lane], wait_us);
+
+    try {
+        if (job) {
+            job->cycle();
+        } else {
+            task.run();
+        }
+    } catch (const std::exception&) {
+        LOGF_RATE_LIMITED(ERR, MAIN, 1, 1, "event=be_task_exception,task", task.name);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    if (perf_monitor_) {
+        perf_monitor_->record_latency(std::string("BestEffortWait.") + task.name, wait_us);
+        perf_monitor_->record_latency(std::string("BestEffortRun.") + task.name, elapsed_us(start, end));
+    }
+
+    if (job) {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        job->running = false;
+        job->runs++;
+        if (job->rerun) {
+            job->rerun = false;
+            job->release = end;
+        } else {
+            job->release += job->period;
+            if (job->release < end) {
+                job->release = end;
+            }
+        }
+        releases_.push(Release{job->release, task.job, job->generation});
+        cycle_done_.notify_all();
+    }
+    if (job && notify_release) {
+        work_signal_.notify();
+    }
+}
@@ -0,0 +1,136 @@
+#include "bridge_messages.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+bool write_bridge_file(int truck_id, const char* topic_name, const json& payload, long timestamp) {
+    try {
+        if (!fs::exists(BRIDGE_TO_MQTT_DIR)) {
+            fs::create_directories(BRIDGE_TO_MQTT_DIR);
+        }
+
+        std::string filename = std::string(BRIDGE_TO_MQTT_DIR) + "/" + std::to_string(timestamp) + "_truck_" +
+                               std::to_string(truck_id) + "_" + topic_name + ".json";
+
+        json message = {
+            {"topic", "truck/" + std::to_string(truck_id) + "/" + topic_name},
+            {"payload", payload}
+        };
+
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << message.dump(2);
+        return static_cast<bool>(file);
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+} // namespace
+
+BridgeFileRead read_bridge_file(const std::string& path, json& message) {
+    std::ifstream file(path);
+    if (file.is_open()) {
+        message = json::parse(file, nullptr, false);
+        if (!message.is_discarded()) {
+            return BridgeFileRead::PARSED;
+        }
+    }
+
+    std::error_code error;
+    fs::file_time_type written = fs::last_write_time(path, error);
+    if (error) {
+        return BridgeFileRead::INVALID;
+    }
+    auto age = fs::file_time_type::clock::now() - written;
+    return age < std::chrono::milliseconds(BRIDGE_PARTIAL_FILE_MS) ? BridgeFileRead::PENDING
+                                                                    : BridgeFileRead::INVALID;
+}
+
+long bridge_message_timestamp_ms(const json& message) {
+    if (message.contains("payload") && message["payload"].is_object() &&
+        message["payload"].contains("timestamp")) {
+        return message["payload"].value("timestamp", 0L);
+    }
+    return message.value("timestamp", 0L);
+}
+
+bool parse_bridge_sensors(const json& message, RawSensorData& data) {
+    if (!message.contains("payload")) {
+        return false;
+    }
+    const json& payload = message["payload"];
+    data.position_x = payload.value("position_x", 0);
+    data.position_y = payload.value("position_y", 0);
+    data.angle_x = payload.value("angle_x", 0);
+    data.temperature = payload.value("temperature", 0);
+    data.fault_electrical = payload.value("fault_electrical", false);
+    data.fault_hydraulic = payload.value("fault_hydraulic", false);
+    return true;
+}
+
+bool parse_bridge_command(const json& message, OperatorCommand& cmd) {
+    if (!message.contains("payload")) {
+        return false;
+    }
+    const json& payload = message["payload"];
+    if (!payload.contains("auto_mode") && !payload.contains("manual_mode") && !payload.contains("rearm") &&
+        !payload.contains("accelerate") && !payload.contains("steer_left") && !payload.contains("steer_right")) {
+        return false;
+    }
+    cmd.auto_mode = payload.value("auto_mode", false);
+    cmd.manual_mode = payload.value("manual_mode", false);
+    cmd.rearm = payload.value("rearm", false);
+    cmd.accelerate = payload.value("accelerate", 0);
+    cmd.steer_left = payload.value("steer_left", 0);
+    cmd.steer_right = payload.value("steer_right", 0);
+    return true;
+}
+
+bool parse_bridge_setpoint(const json& message, NavigationSetpoint& setpoint) {
+    if (!message.contains("payload")) {
+        return false;
+    }
+    const json& payload = message["payload"];
+    setpoint.target_position_x = payload.value("target_x", 0);
+    setpoint.target_position_y = payload.value("target_y", 0);
+    setpoint.target_speed = payload.value("target_speed", 0);
+    return true;
+}
+
+bool parse_bridge_obstacles(const json& message, std::vector<Obstacle>& obstacles) {
+    if (!message.contains("payload") || !message["payload"].contains("obstacles")) {
+        return false;
+    }
+    obstacles.clear();
+    for (const auto& item : message["payload"]["obstacles"]) {
+        Obstacle obs;
+        obs.id = item.value("id", 0);
+        obs.x = item.value("x", 0);
+        obs.y = item.value("y", 0);
+        obstacles.push_back(obs);
+    }
+    return true;
+}
+
+bool write_bridge_actuator_output(int truck_id, const ActuatorOutput& output, long timestamp_ms) {
+    return write_bridge_file(truck_id, "commands", {
+        {"acceleration", output.velocity},
+        {"steering", output.steering},
+        {"arrived", output.arrived}
+    }, timestamp_ms);
+}
+
+bool write_bridge_truck_state(int truck_id, const TruckState& state, long timestamp_ms) {
+    return write_bridge_file(truck_id, "state", {
+        {"automatic", state.automatic},
+        {"fault", state.fault}
+    }, timestamp_ms);
+}
@@ -0,0 +1,262 @@
+#include "bridge_trace.h"
+#include "deferred_log.h"
+#include "json.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int64_t wall_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool gz_write_all(gzFile file, const void* data, size_t size) {
+    return size == 0 || gzwrite(file, data, static_cast<unsigned>(size)) == static_cast<int>(size);
+}
+
+bool gz_read_all(gzFile file, void* data, size_t size) {
+    return size == 0 || gzread(file, data, static_cast<unsigned>(size)) == static_cast<int>(size);
+}
+
+} // namespace
+
+const char* bridge_topic_name(BridgeTopic topic) {
+    switch (topic) {
+        case BridgeTopic::SENSORS: return "sensors";
+        case BridgeTopic::COMMANDS: return "commands";
+        case BridgeTopic::SETPOINT: return "setpoint";
+        case BridgeTopic::OBSTACLES: return "obstacles";
+        default: return "unknown";
+    }
+}
+
+BridgeTraceWriter::BridgeTraceWriter() : file_(nullptr), records_(0) {}
+
+BridgeTraceWriter::~BridgeTraceWriter() {
+    close();
+}
+
+bool BridgeTraceWriter::open(const std::string& path, int truck_id) {
+    close();
+    file_ = gzopen(path.c_str(), "wb6");
+    if (!file_) {
+        return false;
+    }
+    BridgeTraceFileHeader header{};
+    std::memcpy(header.magic, BRIDGE_TRACE_MAGIC, sizeof(header.magic));
+    header.truck_id = truck_id;
+    header.created_ms = wall_us() / 1000;
+    if (!gz_write_all(file_, &header, sizeof(header))) {
+        close();
+        return false;
+    }
+    records_ = 0;
+    return true;
+}
+
+void BridgeTraceWriter::close() {
+    if (file_) {
+        gzclose(file_);
+        file_ = nullptr;
+    }
+}
+
+bool BridgeTraceWriter::record(BridgeTopic topic, const std::string& path) {
+    if (!file_) {
+        return false;
+    }
+    struct stat file_stat;
+    std::ifstream input(path, std::ios::binary);
+    if (!input.is_open() || ::stat(path.c_str(), &file_stat) != 0) {
+        return false;
+    }
+    std::ostringstream content;
+    content << input.rdbuf();
+    std::string text = content.str();
+    std::string name = fs::path(path).filename().string();
+
+    BridgeTraceRecordHeader header{};
+    header.arrival_us = static_cast<int64_t>(file_stat.st_mtim.tv_sec) * 1000000 + file_stat.st_mtim.tv_nsec / 1000;
+    header.name_bytes = static_cast<uint32_t>(name.size());
+    header.content_bytes = static_cast<uint32_t>(text.size());
+    header.topic = static_cast<uint8_t>(topic);
+    if (!gz_write_all(file_, &header, sizeof(header)) || !gz_write_all(file_, name.data(), name.size()) ||
+        !gz_write_all(file_, text.data(), text.size())) {
+        return false;
+    }
+    records_++;
+    return true;
+}
+
+BridgeTraceReader::BridgeTraceReader() : file_(nullptr), header_{} {}
+
+BridgeTraceReader::~BridgeTraceReader() {
+    close();
+}
+
+bool BridgeTraceReader::open(const std::string& path) {
+    close();
+    file_ = gzopen(path.c_str(), "rb");
+    if (!file_) {
+        return false;
+    }
+    if (!gz_read_all(file_, &header_, sizeof(header_)) ||
+        std::memcmp(header_.magic, BRIDGE_TRACE_MAGIC, sizeof(header_.magic)) != 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void BridgeTraceReader::close() {
+    if (file_) {
+        gzclose(file_);
+        file_ = nullptr;
+    }
+}
+
+bool BridgeTraceReader::next(BridgeTraceRecord& record) {
+    BridgeTraceRecordHeader header;
+    if (!file_ || !gz_read_all(file_, &header, sizeof(header)) || header.topic >= BRIDGE_TOPIC_COUNT) {
+        return false;
+    }
+    record.arrival_us = header.arrival_us;
+    record.topic = static_cast<BridgeTopic>(header.topic);
+    record.name.resize(header.name_bytes);
+    record.content.resize(header.content_bytes);
+    return gz_read_all(file_, record.name.data(), record.name.size()) &&
+           gz_read_all(file_, record.content.data(), record.content.size());
+}
+
+BridgeReplayer::BridgeReplayer(double speed, std::string bridge_dir)
+    : speed_(speed > 0.0 ? speed : 1.0),
+      bridge_dir_(std::move(bridge_dir)),
+      reader_truck_id_(0),
+      running_(false),
+      replayed_(0) {
+}
+
+BridgeReplayer::~BridgeReplayer() {
+    stop();
+}
+
+bool BridgeReplayer::start(const std::string& path, std::function<void()> on_finished) {
+    if (running_ || !reader_.open(path)) {
+        return false;
+    }
+    reader_truck_id_ = reader_.truck_id();
+    on_finished_ = std::move(on_finished);
+    fs::create_directories(bridge_dir_);
+    running_ = true;
+    replay_thread_ = std::thread(&BridgeReplayer::replay_loop, this);
+    return true;
+}
+
+void BridgeReplayer::stop() {
+    running_ = false;
+    if (replay_thread_.joinable()) {
+        replay_thread_.join();
+    }
+    reader_.close();
+}
+
+void BridgeReplayer::replay_loop() {
+    BridgeTraceRecord record;
+    bool first = true;
+    int64_t trace_start_us = 0;
+    auto replay_start = std::chrono::steady_clock::now();
+    auto previous_due = replay_start;
+    int64_t replay_start_wall_us = wall_us();
+
+    LOGF_INFO(MAIN, "event=replay_start,truck_id,speed_x100", reader_truck_id_, static_cast<long>(speed_ * 100));
+    while (running_ && reader_.next(record)) {
+        if (first) {
+            trace_start_us = record.arrival_us;
+            first = false;
+        }
+        auto offset = std::chrono::microseconds(
+            static_cast<int64_t>(static_cast<double>(record.arrival_us - trace_start_us) / speed_));
+        // Records are in the order the main loop consumed them, which is not
+        // strictly arrival order across topics; keep that order
+        auto due = std::max(previous_due, replay_start + offset);
+        previous_due = due;
+        // Sleep in short steps so stop() is honoured during long gaps
+        while (running_ && std::chrono::steady_clock::now() < due) {
+            std::this_thread::sleep_until(std::min(due, std::chrono::steady_clock::now() +
+                                                        std::chrono::milliseconds(100)));
+        }
+        if (!running_) {
+            break;
+        }
+
+        int64_t now_us = wall_us();
+        long shift_ms = static_cast<long>((now_us - record.arrival_us) / 1000);
+        std::string content = shift_timestamps(record.content, shift_ms);
+        std::string target = bridge_dir_ + "/" + record.name;
+        std::string temporary = target + ".replay";
+        {
+            std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+            output.write(content.data(), static_cast<std::streamsize>(content.size()));
+        }
+        std::error_code error;
+        fs::rename(temporary, target, error);
+
+        long late_us = static_cast<long>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - due).count());
+        {
+            std::lock_guard<std::mutex> lock(late_mutex_);
+            late_us_.push_back(late_us);
+        }
+        replayed_++;
+        LOGF_EVERY_N(DEBUG, MAIN, 500, "event=replay_progress,replayed,topic,late_us",
+                     replayed_.load(), bridge_topic_name(record.topic), late_us);
+    }
+
+    double elapsed_s = static_cast<double>(wall_us() - replay_start_wall_us) / 1e6;
+    LOGF_INFO(MAIN, "event=replay_done,replayed,elapsed_ms,late_p99_us,late_max_us",
+              replayed_.load(), static_cast<long>(elapsed_s * 1000), get_late_p99_us(), get_late_max_us());
+    if (running_ && on_finished_) {
+        on_finished_();
+    }
+}
+
+std::string BridgeReplayer::shift_timestamps(const std::string& content, long offset_ms) {
+    try {
+        nlohmann::json message = nlohmann::json::parse(content);
+        if (message.contains("timestamp") && message["timestamp"].is_number_integer()) {
+            message["timestamp"] = message["timestamp"].get<long>() + offset_ms;
+        }
+        if (message.contains("payload") && message["payload"].is_object() &&
+            message["payload"].contains("timestamp") && message["payload"]["timestamp"].is_number_integer()) {
+            message["payload"]["timestamp"] = message["payload"]["timestamp"].get<long>() + offset_ms;
+        }
+        return message.dump();
+    } catch (const std::exception&) {
+        return content;     // Replayed as recorded; the main loop sees the same parse error
+    }
+}
+
+long BridgeReplayer::get_late_p99_us() const {
+    std::lock_guard<std::mutex> lock(late_mutex_);
+    if (late_us_.empty()) {
+        return 0;
+    }
+    std::vector<long> sorted = late_us_;
+    size_t index = std::min(sorted.size() - 1, sorted.size() * 99 / 100);
+    std::nth_element(sorted.begin(), sorted.begin() + static_cast<long>(index), sorted.end());
+    return sorted[index];
+}
+
+long BridgeReplayer::get_late_max_us() const {
+    std::lock_guard<std::mutex> lock(late_mutex_);
+    return late_us_.empty() ? 0 : *std::max_element(late_us_.begin(), late_us_.end());
+}
@@ -1,9 +1,9 @@
 #include "circular_buffer.h"
-#include "logger.h"
+#include "deferred_log.h"
 #include <cstring>
 
 CircularBuffer::CircularBuffer()
-    : read_index_(0), write_index_(0), count_(0) {
+    : read_index_(0), write_index_(0), count_(0), overwrite_count_(0), overwrite_log_limiter_(1, 5) {
     std::memset(buffer_, 0, sizeof(buffer_));
 }
 
@@ -16,10 +16,8 @@ void CircularBuffer::write(const SensorData& data) {
         read_index_ = (read_index_ + 1) % BUFFER_SIZE;
         count_--;
 
-        static int overwrite_count = 0;
-        if (++overwrite_count % 100 == 0) {
-            LOG_WARN(CB) << "event" << "overwrite" << "count" << overwrite_count;
-        }
+        overwrite_count_++;
+        LOGF_LIMITED_BY(overwrite_log_limiter_, DEBUG, CB, "event=overwrite,count", overwrite_count_);
     }
 
     buffer_[write_index_] = data;
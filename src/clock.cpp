@@ -0,0 +1,112 @@
+#include "clock.h"
+#include <algorithm>
+
+Clock& Clock::system() {
+    static SystemClock clock;
+    return clock;
+}
+
+SimulatedClock::SimulatedClock(int64_t wall_start_us)
+    : wall_start_us_(wall_start_us),
+      now_ns_(SIMULATED_CLOCK_STEADY_START_NS),
+      turn_(-1),
+      turns_(0) {
+}
+
+int SimulatedClock::register_thread(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SimulatedThread thread;
+    thread.name = name;
+    thread.wake = now();
+    thread.turn_given = std::make_unique<std::condition_variable>();
+    threads_.push_back(std::move(thread));
+    return static_cast<int>(threads_.size() - 1);
+}
+
+void SimulatedClock::begin_thread(int id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    threads_[id].wake = now();
+    yield(lock, id);
+}
+
+void SimulatedClock::release_thread(int id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    threads_[id].released = true;
+    threads_[id].turn_given->notify_one();
+    turn_returned_.notify_one();
+}
+
+void SimulatedClock::sleep_until(int id, time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (threads_[id].released || deadline <= now()) {
+        return;
+    }
+    threads_[id].wake = deadline;
+    yield(lock, id);
+}
+
+void SimulatedClock::wait_until(int id, ChangeSignal& signal, uint32_t seen, time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (threads_[id].released || deadline <= now() || signal.version() != seen) {
+        return;
+    }
+    threads_[id].wake = deadline;
+    threads_[id].signal = &signal;
+    threads_[id].seen = seen;
+    yield(lock, id);
+    threads_[id].signal = nullptr;
+}
+
+void SimulatedClock::yield(std::unique_lock<std::mutex>& lock, int id) {
+    threads_[id].waiting = true;
+    if (turn_ == id) {
+        turn_ = -1;
+    }
+    turn_returned_.notify_one();
+    // threads_ may grow while this thread sleeps: index it again on wakeup
+    threads_[id].turn_given->wait(lock, [this, id]() { return turn_ == id || threads_[id].released; });
+    threads_[id].waiting = false;
+}
+
+void SimulatedClock::run_until(time_point end) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // Wait for the running thread to sleep again and for every started
+        // thread to reach the clock
+        turn_returned_.wait(lock, [this]() {
+            return turn_ == -1 && std::all_of(threads_.begin(), threads_.end(), [](const SimulatedThread& thread) {
+                return thread.waiting || thread.released;
+            });
+        });
+
+        int next = -1;
+        time_point next_wake = time_point::max();
+        for (size_t i = 0; i < threads_.size(); i++) {
+            const SimulatedThread& thread = threads_[i];
+            if (thread.released) {
+                continue;
+            }
+            time_point wake = thread.signal && thread.signal->version() != thread.seen ? now() : thread.wake;
+            if (wake < next_wake) {
+                next_wake = wake;
+                next = static_cast<int>(i);
+            }
+        }
+
+        if (next < 0 || next_wake > end) {
+            advance_to(end);
+            return;
+        }
+        advance_to(next_wake);
+        turn_ = next;
+        turns_++;
+        threads_[next].turn_given->notify_one();
+    }
+}
+
+void SimulatedClock::advance_to(time_point time) {
+    if (time > now()) {
+        now_ns_.store(std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count(),
+                      std::memory_order_release);
+    }
+}
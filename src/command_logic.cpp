@@ -1,20 +1,40 @@
 #include "command_logic.h"
 #include "logger.h"
-#include "watchdog.h"
+#include "deferred_log.h"
+#include "rt_profile.h"
+#include <algorithm>
 #include <chrono>
 #include <pthread.h>
 #include <cstring>
 
+constexpr long COMMAND_DROP_LOG_INTERVAL = 100;
+
 CommandLogic::CommandLogic(CircularBuffer& buffer, int period_ms, PerformanceMonitor* perf_monitor)
     : buffer_(buffer),
       period_ms_(period_ms),
       running_(false),
-      command_pending_(false),
-      fault_rearmed_(false),
+      safe_output_engagements_(0),
+      fault_latch_requested_(false),
+      max_command_queue_depth_(0),
+      dropped_command_count_(0),
+      coalesced_command_count_(0),
+      mode_transition_count_(0),
+      fault_status_(nullptr),
+      observed_fault_sequence_(0),
       last_command_time_(std::chrono::steady_clock::now()),
-      perf_monitor_(perf_monitor) {
-    current_state_.fault = false;
-    current_state_.automatic = false;
+      observed_input_version_(0),
+      manual_deadline_(Clock::time_point::max()),
+      idle_wakeup_ms_(COMMAND_LOGIC_DEFAULT_IDLE_WAKEUP_MS),
+      capture_(nullptr),
+      work_cycle_count_(0),
+      idle_cycle_count_(0),
+      perf_monitor_(perf_monitor),
+      clock_(&Clock::system()),
+      clock_thread_(0),
+      worker_pool_(nullptr),
+      pool_job_(-1) {
+    mode_ = CommandMode::MANUAL;
+    current_state_ = truck_state_for(mode_);
     latest_sensor_data_ = {};
     latest_fault_type_ = FaultType::NONE;
 
@@ -30,7 +50,23 @@ void CommandLogic::start() {
         return;
     }
 
+    if (capture_) {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        capture_->record_state(current_state_);
+        capture_->record_actuator(actuator_output_);
+        captured_output_ = actuator_output_;
+    }
+
     running_ = true;
+    manual_deadline_ = Clock::time_point::max();
+    observed_input_version_ = input_signal_.version() - 1;   // Force a first full cycle
+    if (worker_pool_) {
+        pool_job_ = worker_pool_->add_periodic("CommandLogic", period_ms_, [this] { run_cycle(clock_->now()); });
+        LOG_INFO(CL) << "event" << "start" << "pool_job" << pool_job_;
+        return;
+    }
+
+    clock_thread_ = clock_->register_thread("CommandLogic");
     task_thread_ = std::thread(&CommandLogic::task_loop, this);
 
     pthread_t native_handle = task_thread_.native_handle();
@@ -51,41 +87,125 @@ void CommandLogic::stop() {
     }
 
     running_ = false;
+    if (worker_pool_) {
+        worker_pool_->remove(pool_job_);
+    }
+    input_signal_.notify();
+    clock_->release_thread(clock_thread_);
 
     if (task_thread_.joinable()) {
         task_thread_.join();
     }
 
-    LOG_INFO(CL) << "event" << "stop";
+    LOG_INFO(CL) << "event" << "stop"
+                 << "mode_transitions" << mode_transition_count_.load()
+                 << "work_cycles" << work_cycle_count_.load()
+                 << "idle_cycles" << idle_cycle_count_.load()
+                 << "cmd_max_depth" << max_command_queue_depth_.load()
+                 << "cmd_dropped" << dropped_command_count_.load()
+                 << "cmd_coalesced" << coalesced_command_count_.load();
 }
 
-void CommandLogic::set_command(const OperatorCommand& cmd) {
-    std::lock_guard<std::mutex> lock(state_mutex_);
-    pending_command_ = cmd;
-    command_pending_ = true;
-    last_command_time_ = std::chrono::steady_clock::now();
+bool CommandLogic::set_command(const OperatorCommand& cmd) {
+    long long now_ns = clock_->now_ns();
+
+    if (!command_queue_.try_push(TimedCommand{cmd, now_ns})) {
+        long dropped = ++dropped_command_count_;
+        if (dropped % COMMAND_DROP_LOG_INTERVAL == 1) {
+            LOGF_WARN(CL, "event=cmd_drop,reason=queue_full,dropped", dropped);
+        }
+        return false;
+    }
+    input_signal_.notify();
+    return true;
 }
 
-void CommandLogic::on_fault_update(FaultType type) {
-    std::lock_guard<std::mutex> lock(state_mutex_);
+void CommandLogic::set_fault_status(const FaultStatus* status) {
+    fault_status_ = status;
+}
+
+void CommandLogic::apply_fault_update(FaultType type) {
     latest_fault_type_ = type;
     
     if (type != FaultType::NONE) {
-        if (!current_state_.fault) {
-            LOG_CRIT(CL) << "event" << "fault_detected_ext" << "type" << static_cast<int>(type);
-        }
-        current_state_.fault = true;
-        current_state_.automatic = false;
-        fault_rearmed_ = false;
+        dispatch_mode_event(CommandModeEvent::FAULT_DETECTED);
+    }
+}
+
+void CommandLogic::dispatch_mode_event(CommandModeEvent event) {
+    CommandModeTransition transition = command_mode_step(mode_, event);
+
+    if (transition.actions & MODE_ACTION_REPORT_FAULT) {
+        LOGF_CRIT(CL, "event=fault_detected_ext,type", static_cast<int>(latest_fault_type_));
+    }
+    if (transition.actions & MODE_ACTION_REJECT_AUTO) {
+        LOGF_WARN(CL, "event=mode_reject,reason=fault");
+    }
+    if (transition.actions & MODE_ACTION_REARM_FAILED) {
+        LOGF_WARN(CL, "event=rearm_failed,active_fault", static_cast<int>(latest_fault_type_));
+    }
+
+    if (transition.next == mode_) {
+        return;
+    }
+
+    LOGF_INFO(CL, "event=mode_transition,from,to,trigger",
+              command_mode_name(mode_), command_mode_name(transition.next), command_mode_event_name(event));
+
+    TruckState previous_state = current_state_;
+    mode_ = transition.next;
+    current_state_ = truck_state_for(mode_);
+    mode_transition_count_++;
+
+    if (capture_ && (current_state_.fault != previous_state.fault ||
+                     current_state_.automatic != previous_state.automatic)) {
+        capture_->record_state(current_state_);
     }
 }
 
+void CommandLogic::engage_safe_output() {
+    if (safe_output_engagements_.fetch_add(1, std::memory_order_acq_rel) > 0) {
+        return;
+    }
+
+    // What get_state() and get_actuator_output() now report
+    if (capture_) {
+        capture_->record_state(TruckState{true, false});
+        capture_->record_actuator(ActuatorOutput());
+    }
+}
+
+void CommandLogic::release_safe_output() {
+    // Request the latch first so the outputs stay safe until it is applied
+    fault_latch_requested_.store(true, std::memory_order_release);
+    int remaining = safe_output_engagements_.fetch_sub(1, std::memory_order_acq_rel) - 1;
+    input_signal_.notify();
+
+    LOGF_WARN(CL, "event=safe_output_release,engaged", remaining);
+}
+
+bool CommandLogic::safe_output_active() const {
+    return safe_output_engagements_.load(std::memory_order_acquire) > 0 ||
+           fault_latch_requested_.load(std::memory_order_acquire);
+}
+
 TruckState CommandLogic::get_state() const {
+    if (safe_output_active()) {
+        TruckState safe_state;
+        safe_state.fault = true;
+        safe_state.automatic = false;
+        return safe_state;
+    }
+
     std::lock_guard<std::mutex> lock(state_mutex_);
     return current_state_;
 }
 
 ActuatorOutput CommandLogic::get_actuator_output() const {
+    if (safe_output_active()) {
+        return ActuatorOutput();
+    }
+
     std::lock_guard<std::mutex> lock(state_mutex_);
     return actuator_output_;
 }
@@ -96,70 +216,193 @@ SensorData CommandLogic::get_latest_sensor_data() const {
 }
 
 void CommandLogic::set_navigation_output(const ActuatorOutput& output) {
-    std::lock_guard<std::mutex> lock(state_mutex_);
-    navigation_output_ = output;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        if (output.velocity == navigation_output_.velocity &&
+            output.steering == navigation_output_.steering &&
+            output.arrived == navigation_output_.arrived) {
+            return;
+        }
+        navigation_output_ = output;
+    }
+    input_signal_.notify();
+}
+
+void CommandLogic::set_idle_wakeup_ms(int idle_wakeup_ms) {
+    idle_wakeup_ms_ = idle_wakeup_ms;
+}
+
+void CommandLogic::set_telemetry_capture(TelemetryCapture* capture) {
+    capture_ = capture;
+}
+
+void CommandLogic::set_heartbeat_handle(Watchdog::HeartbeatHandle handle) {
+    heartbeat_handle_ = handle;
+}
+
+void CommandLogic::set_clock(Clock* clock) {
+    clock_ = clock;
+    last_command_time_ = clock_->now();
+}
+
+void CommandLogic::set_worker_pool(RtWorkerPool* pool) {
+    worker_pool_ = pool;
 }
 
 void CommandLogic::task_loop() {
-    auto next_execution = std::chrono::steady_clock::now();
+    RtProfile::enter_thread("CommandLogic");
+    clock_->begin_thread(clock_thread_);
+    auto next_execution = clock_->now();
 
     while (running_) {
-        auto start_time = std::chrono::steady_clock::now();
+        auto start_time = clock_->now();
+        bool inputs_changed = run_cycle(start_time);
 
+        // Sleep until an input changes, the manual-mode timeout expires or
+        // the heartbeat is due. Cycles that applied inputs are spaced at
+        // least one period apart; heartbeat-only cycles do not delay the
+        // next change.
+        if (inputs_changed) {
+            next_execution += std::chrono::milliseconds(period_ms_);
+        } else {
+            next_execution = start_time;
+        }
+        auto heartbeat_deadline = start_time + std::chrono::milliseconds(idle_wakeup_ms_);
+        auto wake_deadline = std::min(heartbeat_deadline, manual_deadline_);
+        if (running_ && wake_deadline > next_execution) {
+            clock_->wait_until(clock_thread_, input_signal_, observed_input_version_, wake_deadline);
+        }
+        clock_->sleep_until(clock_thread_, next_execution);
+
+        auto now = clock_->now();
+        if (now > next_execution) {
+            next_execution = now;
+        }
+    }
+}
+
+bool CommandLogic::run_cycle(Clock::time_point start_time) {
+    // Read the version before the inputs so a change made while this
+    // cycle runs wakes the next one.
+    uint32_t input_version = input_signal_.version();
+    FaultStatus::Snapshot fault_snapshot{};
+    bool fault_changed = false;
+    if (fault_status_) {
+        fault_snapshot = fault_status_->snapshot();
+        fault_changed = fault_snapshot.sequence != observed_fault_sequence_;
+    }
+
+    bool latch_requested = fault_latch_requested_.load(std::memory_order_acquire);
+    bool inputs_changed = input_version != observed_input_version_ || fault_changed ||
+                          latch_requested || start_time >= manual_deadline_;
+    observed_input_version_ = input_version;
+
+    std::array<TimedCommand, COMMAND_QUEUE_CAPACITY> command_batch;
+    size_t command_count = 0;
+
+    if (inputs_changed) {
         SensorData sensor_data = buffer_.peek_latest();
+        command_count = drain_commands(command_batch);
 
-        {
-            std::lock_guard<std::mutex> lock(state_mutex_);
-            latest_sensor_data_ = sensor_data;
-            
-            if (command_pending_) {
-                process_commands();
-                command_pending_ = false;
-            }
-            
-            if (current_state_.fault && fault_rearmed_) {
-                if (latest_fault_type_ == FaultType::NONE) {
-                    LOG_INFO(CL) << "event" << "fault_clear";
-                    current_state_.fault = false;
-                } else {
-                    LOG_WARN(CL) << "event" << "rearm_failed" << "active_fault" << static_cast<int>(latest_fault_type_);
-                }
-                fault_rearmed_ = false;
-            }
-            calculate_actuator_outputs();
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        latest_sensor_data_ = sensor_data;
+
+        if (fault_changed) {
+            observed_fault_sequence_ = fault_snapshot.sequence;
+            apply_fault_update(fault_snapshot.type);
         }
 
-        if (Watchdog::get_instance()) {
-            Watchdog::get_instance()->heartbeat("CommandLogic");
+        // Cleared under state_mutex_: a reader that sees it clear then reads the latched state
+        if (latch_requested && fault_latch_requested_.exchange(false, std::memory_order_acq_rel)) {
+            dispatch_mode_event(CommandModeEvent::FAULT_LATCHED);
         }
+        
+        apply_commands(command_batch, command_count);
+        calculate_actuator_outputs();
+        capture_actuator_output();
+        manual_deadline_ = manual_timeout_deadline();
+        work_cycle_count_++;
+    } else {
+        idle_cycle_count_++;
+    }
 
-        if (perf_monitor_) {
-            perf_monitor_->end_measurement("CommandLogic", start_time);
+    if (command_count > 0 && perf_monitor_) {
+        long long now_ns = clock_->now_ns();
+        for (size_t i = 0; i < command_count; i++) {
+            perf_monitor_->record_latency("CommandLatency",
+                                          static_cast<long>((now_ns - command_batch[i].enqueued_ns) / 1000));
         }
+    }
+
+    if (fault_changed && fault_snapshot.type != FaultType::NONE && perf_monitor_) {
+        long long now_ns = clock_->now_ns();
+        perf_monitor_->record_latency("FaultToStop.CommandLogic",
+                                      static_cast<long>((now_ns - fault_snapshot.detected_ns) / 1000));
+    }
+
+    Watchdog::heartbeat(heartbeat_handle_);
 
-        next_execution += std::chrono::milliseconds(period_ms_);
-        std::this_thread::sleep_until(next_execution);
+    if (perf_monitor_) {
+        perf_monitor_->end_measurement("CommandLogic", start_time);
     }
+
+    return inputs_changed;
 }
 
-void CommandLogic::process_commands() {
-    if (pending_command_.auto_mode && !current_state_.automatic) {
-        if (!current_state_.fault) {
-            current_state_.automatic = true;
-            LOG_INFO(CL) << "event" << "mode_change" << "mode" << "auto";
-        } else {
-            LOG_WARN(CL) << "event" << "mode_reject" << "reason" << "fault";
-        }
+size_t CommandLogic::drain_commands(std::array<TimedCommand, COMMAND_QUEUE_CAPACITY>& batch) {
+    size_t depth = command_queue_.size();
+    if (depth > max_command_queue_depth_) {
+        max_command_queue_depth_ = depth;
     }
 
-    if (pending_command_.manual_mode && current_state_.automatic) {
-        current_state_.automatic = false;
-        LOG_INFO(CL) << "event" << "mode_change" << "mode" << "manual";
+    size_t count = 0;
+    while (count < batch.size() && command_queue_.try_pop(batch[count])) {
+        count++;
     }
-    if (pending_command_.rearm && current_state_.fault) {
-        fault_rearmed_ = true;
-        LOG_INFO(CL) << "event" << "rearm_req";
+    return count;
+}
+
+void CommandLogic::apply_commands(const std::array<TimedCommand, COMMAND_QUEUE_CAPACITY>& batch, size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const OperatorCommand& cmd = batch[i].command;
+        apply_discrete_command(cmd);
+
+        pending_command_.accelerate = cmd.accelerate;
+        pending_command_.steer_left += cmd.steer_left;
+        pending_command_.steer_right += cmd.steer_right;
     }
+
+    coalesced_command_count_ += static_cast<long>(count - 1);
+    last_command_time_ = Clock::time_point(
+        std::chrono::nanoseconds(batch[count - 1].enqueued_ns));
+}
+
+void CommandLogic::apply_discrete_command(const OperatorCommand& cmd) {
+    if (cmd.auto_mode) {
+        dispatch_mode_event(CommandModeEvent::AUTO_REQUEST);
+    }
+    if (cmd.manual_mode) {
+        dispatch_mode_event(CommandModeEvent::MANUAL_REQUEST);
+    }
+
+    // The rearm is resolved before the next queued command so that
+    // "rearm, auto" in one period behaves as if sent periods apart.
+    if (cmd.rearm) {
+        dispatch_mode_event(latest_fault_type_ == FaultType::NONE
+                                ? CommandModeEvent::REARM_FAULT_CLEARED
+                                : CommandModeEvent::REARM_FAULT_ACTIVE);
+    }
+}
+
+Clock::time_point CommandLogic::manual_timeout_deadline() const {
+    if (current_state_.fault || current_state_.automatic || actuator_output_.velocity == 0) {
+        return Clock::time_point::max();
+    }
+    return last_command_time_ + std::chrono::milliseconds(MANUAL_MODE_TIMEOUT_MS + 1);
 }
 
 void CommandLogic::calculate_actuator_outputs() {
@@ -172,7 +415,7 @@ void CommandLogic::calculate_actuator_outputs() {
     if (current_state_.automatic) {
         actuator_output_ = navigation_output_;
     } else {
-        auto now = std::chrono::steady_clock::now();
+        auto now = clock_->now();
         auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_command_time_).count();
 
         if (elapsed_ms > MANUAL_MODE_TIMEOUT_MS) {
@@ -200,3 +443,14 @@ void CommandLogic::calculate_actuator_outputs() {
         }
     }
 }
+
+void CommandLogic::capture_actuator_output() {
+    if (!capture_ ||
+        (actuator_output_.velocity == captured_output_.velocity &&
+         actuator_output_.steering == captured_output_.steering &&
+         actuator_output_.arrived == captured_output_.arrived)) {
+        return;
+    }
+    capture_->record_actuator(actuator_output_);
+    captured_output_ = actuator_output_;
+}
@@ -1,22 +1,132 @@
 #include "data_collector.h"
-#include "logger.h"
-#include "watchdog.h"
+#include "deferred_log.h"
+#include "rt_profile.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
 #include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <initializer_list>
 #include <sstream>
-#include <iomanip>
+
+namespace {
+
+constexpr const char* CSV_HEADER = "Timestamp,TruckID,State,PositionX,PositionY,Description\n";
+constexpr const char* CAPTURE_CSV_HEADER =
+    "TimestampUs,TruckID,Kind,PositionX,PositionY,Angle,Temperature,FaultElectrical,FaultHydraulic,"
+    "Velocity,Steering,Arrived,Fault,Automatic\n";
+
+void copy_truncated(char* dest, size_t capacity, const std::string& text) {
+    size_t length = std::min(text.size(), capacity - 1);
+    std::memcpy(dest, text.data(), length);
+    dest[length] = '\0';
+}
+
+void append_number(std::string& out, long value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+void append_fields(std::string& out, std::initializer_list<long> values) {
+    for (long value : values) {
+        out.push_back(',');
+        append_number(out, value);
+    }
+}
+
+struct StoreFile {
+    long stamp;
+    long sequence;
+    std::filesystem::path path;
+    size_t bytes;
+};
+
+/**
+ * @brief Closed store files of a truck (logs/truck_<id>_<start_ms>[_<seq>].tlm but active), oldest first
+ */
+std::vector<StoreFile> list_closed_store_files(int truck_id, const std::string& active) {
+    std::string prefix = "truck_" + std::to_string(truck_id) + "_";
+    std::filesystem::path active_path(active);
+    std::vector<StoreFile> closed;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator("logs", error)) {
+        std::string name = entry.path().filename().string();
+        if (entry.path().extension() != ".tlm" || name.compare(0, prefix.size(), prefix) != 0 ||
+            entry.path() == active_path) {
+            continue;
+        }
+        std::string stamp = entry.path().stem().string().substr(prefix.size());
+        std::string sequence;
+        size_t separator = stamp.find('_');
+        if (separator != std::string::npos) {
+            sequence = stamp.substr(separator + 1);
+            stamp.resize(separator);
+            if (sequence.empty() || sequence.find_first_not_of("0123456789") != std::string::npos) {
+                continue;
+            }
+        }
+        if (stamp.empty() || stamp.find_first_not_of("0123456789") != std::string::npos) {
+            continue;
+        }
+        std::error_code size_error;
+        uintmax_t bytes = entry.file_size(size_error);
+        closed.push_back({std::stol(stamp), sequence.empty() ? 0 : std::stol(sequence), entry.path(),
+                          size_error ? 0 : static_cast<size_t>(bytes)});
+    }
+    std::sort(closed.begin(), closed.end(), [](const StoreFile& a, const StoreFile& b) {
+        return a.stamp != b.stamp ? a.stamp < b.stamp : a.sequence < b.sequence;
+    });
+    return closed;
+}
+
+} // namespace
 
 DataCollector::DataCollector(CircularBuffer& buffer, int truck_id, int log_period_ms, PerformanceMonitor* perf_monitor)
     : buffer_(buffer),
       truck_id_(truck_id),
       log_period_ms_(log_period_ms),
       running_(false),
-      perf_monitor_(perf_monitor) {
+      committed_position_(0),
+      writer_running_(false),
+      commit_interval_ms_(DATA_COLLECTOR_COMMIT_INTERVAL_MS),
+      commit_bytes_(DATA_COLLECTOR_COMMIT_BYTES),
+      drained_position_(0),
+      durable_pending_(false),
+      telemetry_enabled_(false),
+      telemetry_sequence_(0),
+      telemetry_rollovers_(0),
+      telemetry_deleted_(0),
+      telemetry_retention_running_(false),
+      capture_(nullptr),
+      capture_pending_(0),
+      capture_written_(0),
+      reported_capture_written_(0),
+      reported_capture_dropped_(0),
+      log_rollovers_(0),
+      capture_rollovers_(0),
+      records_written_(0),
+      commit_count_(0),
+      bytes_written_(0),
+      dropped_records_(0),
+      queue_full_log_limiter_(1, 1),
+      durable_timeouts_(0),
+      perf_monitor_(perf_monitor),
+      clock_(&Clock::system()),
+      clock_thread_(0),
+      worker_pool_(nullptr),
+      pool_job_(-1),
+      executor_(nullptr),
+      writer_job_(-1),
+      status_job_(-1) {
     current_state_.fault = false;
     current_state_.automatic = false;
 
     std::ostringstream filename;
     filename << "logs/truck_" << truck_id_ << "_log.csv";
     log_filename_ = filename.str();
+    capture_filename_ = "logs/truck_" + std::to_string(truck_id_) + "_capture.csv";
 
     LOG_INFO(DC) << "event" << "init"
                  << "truck_id" << truck_id_
@@ -33,9 +143,35 @@ void DataCollector::start() {
         return;
     }
 
+    if (telemetry_enabled_) {
+        telemetry_retention_running_ = true;
+        telemetry_retention_thread_ = std::thread(&DataCollector::telemetry_retention_loop, this);
+    }
     open_log_file();
 
+    writer_begin();
+    writer_running_ = true;
+    if (executor_) {
+        writer_job_ = executor_->add_periodic(WorkLane::NORMAL, "DataCollectorWriter", DATA_COLLECTOR_WRITER_POLL_MS,
+                                              [this] { writer_cycle(true); });
+    } else {
+        writer_thread_ = std::thread(&DataCollector::writer_loop, this);
+    }
+
     running_ = true;
+    if (worker_pool_) {
+        pool_job_ = worker_pool_->add_periodic("DataCollector", log_period_ms_, [this] { run_cycle(); });
+        LOG_INFO(DC) << "event" << "start" << "pool_job" << pool_job_;
+        return;
+    }
+    if (executor_) {
+        status_job_ = executor_->add_periodic(WorkLane::NORMAL, "DataCollector", log_period_ms_,
+                                              [this] { run_cycle(); });
+        LOG_INFO(DC) << "event" << "start" << "executor_job" << status_job_ << "writer_job" << writer_job_;
+        return;
+    }
+
+    clock_thread_ = clock_->register_thread("DataCollector");
     task_thread_ = std::thread(&DataCollector::task_loop, this);
 
     LOG_INFO(DC) << "event" << "start";
@@ -47,14 +183,48 @@ void DataCollector::stop() {
     }
 
     running_ = false;
+    if (worker_pool_) {
+        worker_pool_->remove(pool_job_);
+    }
+    if (executor_) {
+        executor_->remove(status_job_);
+        status_job_ = -1;
+    }
+    clock_->release_thread(clock_thread_);
 
     if (task_thread_.joinable()) {
         task_thread_.join();
     }
 
+    // The writer drains and commits everything queued before it exits
+    writer_running_ = false;
+    if (executor_) {
+        executor_->remove(writer_job_);
+        writer_job_ = -1;
+        writer_cycle(false);
+    }
+    writer_signal_.notify();
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
+    }
+
     close_log_file();
+    stop_telemetry_retention();
 
-    LOG_INFO(DC) << "event" << "stop";
+    LOG_INFO(DC) << "event" << "stop"
+                 << "records" << records_written_.load()
+                 << "commits" << commit_count_.load()
+                 << "bytes" << bytes_written_.load()
+                 << "dropped" << dropped_records_.load()
+                 << "durable_timeouts" << durable_timeouts_.load();
+    if (capture_) {
+        LOG_INFO(DC) << "event" << "capture_stop"
+                     << "written" << capture_written_.load()
+                     << "sensor" << capture_->get_recorded(CaptureKind::SENSOR)
+                     << "actuator" << capture_->get_recorded(CaptureKind::ACTUATOR)
+                     << "state" << capture_->get_recorded(CaptureKind::STATE)
+                     << "dropped" << capture_->get_dropped_total();
+    }
 }
 
 void DataCollector::set_truck_state(const TruckState& state) {
@@ -62,21 +232,63 @@ void DataCollector::set_truck_state(const TruckState& state) {
     current_state_ = state;
 }
 
-void DataCollector::log_event(const EventLog& event) {
-    std::lock_guard<std::mutex> lock(log_mutex_);
+bool DataCollector::log_event(const EventLog& event, LogDurability durability) {
+    auto start_time = std::chrono::steady_clock::now();
+
+    QueuedEvent queued;
+    queued.timestamp = event.timestamp;
+    queued.truck_id = event.truck_id;
+    queued.position_x = event.position_x;
+    queued.position_y = event.position_y;
+    queued.durable = durability == LogDurability::DURABLE;
+    copy_truncated(queued.state, sizeof(queued.state), event.state);
+    copy_truncated(queued.description, sizeof(queued.description), event.description);
+
+    size_t position;
+    if (!event_queue_.try_push(queued, position)) {
+        long dropped = ++dropped_records_;
+        LOGF_LIMITED_BY(queue_full_log_limiter_, WARN, DC, "event=log_queue_full,dropped", dropped);
+        return false;
+    }
+    // Buffered records wait for the writer's own timer unless the queue is
+    // filling up, so the common path never enters the kernel.
+    if (queued.durable || event_queue_.size() >= DATA_COLLECTOR_QUEUE_CAPACITY / 2) {
+        wake_writer();
+    }
+
+    bool committed = true;
+    if (queued.durable) {
+        auto deadline = start_time + std::chrono::milliseconds(DATA_COLLECTOR_DURABLE_TIMEOUT_MS);
+        while (committed_position_.load(std::memory_order_acquire) <= position) {
+            uint32_t seen = commit_signal_.version();
+            if (committed_position_.load(std::memory_order_acquire) > position) {
+                break;
+            }
+            if (!writer_running_ || std::chrono::steady_clock::now() >= deadline) {
+                durable_timeouts_++;
+                LOG_WARN(DC) << "event" << "durable_timeout" << "desc" << event.description;
+                committed = false;
+                break;
+            }
+            // On an executor worker the writer job may be queued behind this task
+            if (executor_ && executor_->help()) {
+                continue;
+            }
+            commit_signal_.wait_until(seen, deadline);
+        }
+    }
 
-    if (log_file_.is_open()) {
-        log_file_ << event.timestamp << ","
-                  << event.truck_id << ","
-                  << event.state << ","
-                  << event.position_x << ","
-                  << event.position_y << ","
-                  << event.description << std::endl;
+    if (perf_monitor_) {
+        auto latency_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_time).count();
+        perf_monitor_->record_latency(queued.durable ? "DataCollectorDurable" : "DataCollectorLog",
+                                      static_cast<long>(latency_us));
     }
+    return committed;
 }
 
-void DataCollector::log_event(const std::string& state, int position_x, int position_y,
-                              const std::string& description) {
+bool DataCollector::log_event(const std::string& state, int position_x, int position_y,
+                              const std::string& description, LogDurability durability) {
     EventLog event;
     event.timestamp = get_timestamp();
     event.truck_id = truck_id_;
@@ -85,73 +297,425 @@ void DataCollector::log_event(const std::string& state, int position_x, int posi
     event.position_y = position_y;
     event.description = description;
 
-    log_event(event);
+    return log_event(event, durability);
 }
 
-void DataCollector::task_loop() {
-    auto next_execution = std::chrono::steady_clock::now();
+void DataCollector::set_group_commit(int interval_ms, size_t flush_bytes) {
+    commit_interval_ms_ = interval_ms;
+    commit_bytes_ = flush_bytes;
+}
 
-    while (running_) {
-        auto start_time = std::chrono::steady_clock::now();
+void DataCollector::set_log_rotation(const RotatingLogConfig& config) {
+    rotation_ = config;
+}
 
-        SensorData sensor_data = buffer_.peek_latest();
-        TruckState state;
-        {
-            std::lock_guard<std::mutex> lock(state_mutex_);
-            state = current_state_;
+void DataCollector::report_rollover(const RotatingLogFile& file, long& seen) {
+    long rollovers = file.get_rollovers();
+    if (rollovers != seen) {
+        seen = rollovers;
+        LOGF_INFO(DC, "event=log_rollover,file,rollovers,spare_misses,compressed,deleted",
+                  file.path().c_str(), rollovers, file.get_spare_misses(),
+                  file.get_compressed(), file.get_deleted());
+    }
+}
+
+void DataCollector::set_telemetry_store(bool enabled) {
+    telemetry_enabled_ = enabled;
+}
+
+void DataCollector::set_telemetry_capture(TelemetryCapture* capture) {
+    capture_ = capture;
+    if (capture_) {
+        capture_->set_drain_signal(&writer_signal_);
+    }
+}
+
+void DataCollector::writer_loop() {
+    RtProfile::enter_thread("DataCollectorWriter");
+    while (true) {
+        bool running = writer_running_.load();
+        uint32_t seen = writer_signal_.version();
+        auto wake = writer_cycle(running);
+        if (!running) {
+            break;
         }
-        std::ostringstream state_str;
-        if (state.fault) {
-            state_str << "FAULT";
-        } else if (state.automatic) {
-            state_str << "AUTO";
-        } else {
-            state_str << "MANUAL";
+        writer_signal_.wait_until(seen, wake);
+    }
+}
+
+void DataCollector::writer_begin() {
+    auto now = std::chrono::steady_clock::now();
+    next_commit_ = now + std::chrono::milliseconds(commit_interval_ms_);
+    next_capture_report_ = now + std::chrono::milliseconds(TELEMETRY_CAPTURE_REPORT_INTERVAL_MS);
+    durable_pending_ = false;
+    reported_capture_written_ = capture_written_.load();
+    reported_capture_dropped_ = capture_ ? capture_->get_dropped_total() : 0;
+    write_buffer_.reserve(commit_bytes_ + 256);
+    capture_buffer_.reserve(commit_bytes_ + 256);
+}
+
+std::chrono::steady_clock::time_point DataCollector::writer_cycle(bool running) {
+    auto interval = std::chrono::milliseconds(commit_interval_ms_);
+    auto report_interval = std::chrono::milliseconds(TELEMETRY_CAPTURE_REPORT_INTERVAL_MS);
+    QueuedEvent event;
+    CaptureRecord record;
+
+    while (event_queue_.try_pop(event)) {
+        format_record(event);
+        drained_position_++;
+        durable_pending_ = durable_pending_ || event.durable;
+        if (write_buffer_.size() >= commit_bytes_) {
+            commit(drained_position_);
+            durable_pending_ = false;
         }
-        log_event(state_str.str(),
-                 sensor_data.position_x,
-                 sensor_data.position_y,
-                 "Periodic status update");
+    }
 
-        if (Watchdog::get_instance()) {
-            Watchdog::get_instance()->heartbeat("DataCollector");
+    while (capture_ && capture_->try_pop(record)) {
+        format_capture(record);
+        if (capture_buffer_.size() >= commit_bytes_) {
+            commit_capture();
         }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (durable_pending_ || now >= next_commit_ || !running) {
+        commit(drained_position_);
+        commit_capture();
+        durable_pending_ = false;
+        next_commit_ = now + interval;
+    }
+
+    if (capture_ && (now >= next_capture_report_ || !running)) {
+        auto window = now - (next_capture_report_ - report_interval);
+        long written = capture_written_.load();
+        long dropped = capture_->get_dropped_total();
+        double rate = static_cast<double>(written - reported_capture_written_) /
+                      std::chrono::duration<double>(window).count();
+        LOGF_INFO(DC, "event=capture_stats,rate_per_s,written,dropped,dropped_window",
+                  static_cast<long>(rate), written, dropped, dropped - reported_capture_dropped_);
+        reported_capture_written_ = written;
+        reported_capture_dropped_ = dropped;
+        next_capture_report_ = now + report_interval;
+    }
+
+    auto wake = next_commit_;
+    if (capture_) {
+        wake = std::min(wake, now + std::chrono::milliseconds(TELEMETRY_CAPTURE_DRAIN_INTERVAL_MS));
+    }
+    return wake;
+}
+
+void DataCollector::wake_writer() {
+    if (executor_) {
+        executor_->wake(writer_job_);
+    } else {
+        writer_signal_.notify();
+    }
+}
+
+void DataCollector::format_record(const QueuedEvent& event) {
+    append_number(write_buffer_, event.timestamp);
+    write_buffer_.push_back(',');
+    append_number(write_buffer_, event.truck_id);
+    write_buffer_.push_back(',');
+    write_buffer_.append(event.state);
+    write_buffer_.push_back(',');
+    append_number(write_buffer_, event.position_x);
+    write_buffer_.push_back(',');
+    append_number(write_buffer_, event.position_y);
+    write_buffer_.push_back(',');
+    write_buffer_.append(event.description);
+    write_buffer_.push_back('\n');
+
+    if (telemetry_.is_open() &&
+        !telemetry_.append(event.timestamp, event.truck_id, event.state,
+                           event.position_x, event.position_y, event.description)) {
+        LOGF_RATE_LIMITED(ERR, DC, 1, 1, "event=telemetry_write_failed,errno", errno);
+    }
+}
+
+void DataCollector::commit(size_t position) {
+    if (write_buffer_.empty()) {
+        return;
+    }
+    auto start_time = std::chrono::steady_clock::now();
+    long records = static_cast<long>(position - committed_position_.load(std::memory_order_relaxed));
+
+    bool ok = log_file_.append(write_buffer_.data(), write_buffer_.size()) && log_file_.sync();
+    report_rollover(log_file_, log_rollovers_);
+    if (ok) {
+        records_written_ += records;
+        commit_count_++;
+        bytes_written_ += static_cast<long>(write_buffer_.size());
+        committed_position_.store(position, std::memory_order_release);
+        commit_signal_.notify();
+    } else {
+        int error = errno;
+        LOGF_RATE_LIMITED(ERR, DC, 1, 1, "event=commit_failed,records,errno", records, error);
+    }
+    write_buffer_.clear();
 
-        if (perf_monitor_) {
-            perf_monitor_->end_measurement("DataCollector", start_time);
+    if (telemetry_.pending_rows() > 0 &&
+        start_time - telemetry_sealed_ >= std::chrono::milliseconds(DATA_COLLECTOR_TELEMETRY_FLUSH_MS)) {
+        if (!telemetry_.flush()) {
+            LOGF_RATE_LIMITED(ERR, DC, 1, 1, "event=telemetry_write_failed,errno", errno);
         }
+        telemetry_sealed_ = start_time;
+    }
+    rotate_telemetry_store();
+
+    if (perf_monitor_) {
+        auto latency_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_time).count();
+        perf_monitor_->record_latency("DataCollectorCommit", static_cast<long>(latency_us));
+    }
+}
+
+void DataCollector::format_capture(const CaptureRecord& record) {
+    append_number(capture_buffer_, record.timestamp_us);
+    capture_buffer_.push_back(',');
+    append_number(capture_buffer_, truck_id_);
+    capture_buffer_.push_back(',');
+    capture_buffer_.append(TelemetryCapture::kind_name(record.kind));
+    switch (record.kind) {
+        case CaptureKind::SENSOR:
+            append_fields(capture_buffer_, {record.sensor.position_x, record.sensor.position_y,
+                                            record.sensor.angle_x, record.sensor.temperature,
+                                            record.sensor.fault_electrical, record.sensor.fault_hydraulic});
+            capture_buffer_.append(",,,,,\n");
+            break;
+        case CaptureKind::ACTUATOR:
+            capture_buffer_.append(",,,,,,");
+            append_fields(capture_buffer_, {record.actuator.velocity, record.actuator.steering,
+                                            record.actuator.arrived});
+            capture_buffer_.append(",,\n");
+            break;
+        default:
+            capture_buffer_.append(",,,,,,,,,");
+            append_fields(capture_buffer_, {record.state.fault, record.state.automatic});
+            capture_buffer_.push_back('\n');
+            break;
+    }
+    capture_pending_++;
+}
+
+void DataCollector::commit_capture() {
+    if (capture_buffer_.empty()) {
+        return;
+    }
+    bool ok = capture_file_.append(capture_buffer_.data(), capture_buffer_.size()) && capture_file_.sync();
+    report_rollover(capture_file_, capture_rollovers_);
+    if (ok) {
+        capture_written_ += capture_pending_;
+    } else {
+        int error = errno;
+        LOGF_RATE_LIMITED(ERR, DC, 1, 1, "event=commit_failed,file=capture,records,errno", capture_pending_, error);
+    }
+    capture_buffer_.clear();
+    capture_pending_ = 0;
+}
+
+void DataCollector::set_heartbeat_handle(Watchdog::HeartbeatHandle handle) {
+    heartbeat_handle_ = handle;
+}
+
+void DataCollector::set_clock(Clock* clock) {
+    clock_ = clock;
+}
+
+void DataCollector::set_worker_pool(RtWorkerPool* pool) {
+    worker_pool_ = pool;
+}
+
+void DataCollector::set_executor(BestEffortExecutor* executor) {
+    executor_ = executor;
+}
+
+void DataCollector::task_loop() {
+    RtProfile::enter_thread("DataCollector");
+    clock_->begin_thread(clock_thread_);
+    auto next_execution = clock_->now();
+
+    while (running_) {
+        run_cycle();
 
         next_execution += std::chrono::milliseconds(log_period_ms_);
-        std::this_thread::sleep_until(next_execution);
+        clock_->sleep_until(clock_thread_, next_execution);
+    }
+}
+
+void DataCollector::run_cycle() {
+    auto start_time = clock_->now();
+
+    SensorData sensor_data = buffer_.peek_latest();
+    TruckState state;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        state = current_state_;
+    }
+    const char* state_str = state.fault ? "FAULT" : (state.automatic ? "AUTO" : "MANUAL");
+    log_event(state_str,
+              sensor_data.position_x,
+              sensor_data.position_y,
+              "Periodic status update");
+
+    Watchdog::heartbeat(heartbeat_handle_);
+
+    if (perf_monitor_) {
+        perf_monitor_->end_measurement("DataCollector", start_time);
     }
 }
 
 long DataCollector::get_timestamp() const {
-    auto now = std::chrono::system_clock::now();
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch());
-    return ms.count();
+    return clock_->wall_ms();
 }
 
 void DataCollector::open_log_file() {
-    std::lock_guard<std::mutex> lock(log_mutex_);
-
-    log_file_.open(log_filename_, std::ios::out | std::ios::app);
-
-    if (log_file_.is_open()) {
-        log_file_.seekp(0, std::ios::end);
-        if (log_file_.tellp() == 0) {
-            log_file_ << "Timestamp,TruckID,State,PositionX,PositionY,Description" << std::endl;
-        }
+    if (log_file_.open(log_filename_, CSV_HEADER, rotation_)) {
         LOG_DEBUG(DC) << "event" << "file_open" << "file" << log_filename_;
     } else {
         LOG_ERR(DC) << "event" << "file_err" << "file" << log_filename_;
     }
+
+    if (capture_) {
+        if (capture_file_.open(capture_filename_, CAPTURE_CSV_HEADER, rotation_)) {
+            LOG_DEBUG(DC) << "event" << "file_open" << "file" << capture_filename_;
+        } else {
+            LOG_ERR(DC) << "event" << "file_err" << "file" << capture_filename_;
+        }
+    }
+
+    if (telemetry_enabled_) {
+        open_telemetry_store();
+    }
 }
 
 void DataCollector::close_log_file() {
-    std::lock_guard<std::mutex> lock(log_mutex_);
+    log_file_.close();
+    capture_file_.close();
+    close_telemetry_store();
+}
+
+void DataCollector::open_telemetry_store() {
+    // <seq> keeps a file rolled in the same millisecond (or left by an earlier run) from being reopened
+    std::string prefix = "logs/truck_" + std::to_string(truck_id_) + "_" + std::to_string(get_timestamp()) + "_";
+    std::error_code error;
+    do {
+        telemetry_filename_ = prefix + std::to_string(telemetry_sequence_++) + ".tlm";
+    } while (std::filesystem::exists(telemetry_filename_, error));
+
+    {
+        std::lock_guard<std::mutex> lock(telemetry_active_mutex_);
+        telemetry_active_ = telemetry_filename_;
+    }
+    if (telemetry_.open(telemetry_filename_)) {
+        telemetry_sealed_ = std::chrono::steady_clock::now();
+        telemetry_opened_ = telemetry_sealed_;
+        LOG_DEBUG(DC) << "event" << "file_open" << "file" << telemetry_filename_;
+    } else {
+        LOG_ERR(DC) << "event" << "file_err" << "file" << telemetry_filename_;
+    }
+    telemetry_retention_signal_.notify();
+}
+
+void DataCollector::close_telemetry_store() {
+    if (!telemetry_.is_open()) {
+        return;
+    }
+    if (!telemetry_.close()) {
+        LOG_ERR(DC) << "event" << "telemetry_write_failed" << "file" << telemetry_filename_;
+    }
+    {
+        std::lock_guard<std::mutex> lock(telemetry_active_mutex_);
+        telemetry_active_.clear();
+    }
+    LOG_INFO(DC) << "event" << "telemetry_close"
+                 << "file" << telemetry_filename_
+                 << "rows" << telemetry_.rows_written()
+                 << "segments" << telemetry_.segments_written();
+}
+
+void DataCollector::rotate_telemetry_store() {
+    if (!telemetry_.is_open()) {
+        return;
+    }
+    bool full = rotation_.segment_bytes > 0 && telemetry_.file_bytes() >= rotation_.segment_bytes;
+    bool expired = rotation_.segment_ms > 0 &&
+                   std::chrono::steady_clock::now() - telemetry_opened_ >=
+                       std::chrono::milliseconds(rotation_.segment_ms);
+    if (!full && !expired) {
+        return;
+    }
+
+    close_telemetry_store();
+    open_telemetry_store();
+    telemetry_rollovers_++;
+    LOGF_INFO(DC, "event=log_rollover,file,rollovers,deleted", telemetry_filename_.c_str(),
+              telemetry_rollovers_, telemetry_deleted_.load());
+}
+
+void DataCollector::telemetry_retention_loop() {
+    uint32_t seen = telemetry_retention_signal_.version() - 1;     // First pass: files left by earlier runs
+    while (true) {
+        bool running = telemetry_retention_running_.load();
+        uint32_t version = telemetry_retention_signal_.version();
+        if (version != seen || !running) {
+            seen = version;
+            apply_telemetry_retention();
+        }
+        if (!running) {
+            break;
+        }
+        telemetry_retention_signal_.wait_until(seen, std::chrono::steady_clock::now() +
+                                                         std::chrono::milliseconds(DATA_COLLECTOR_RETENTION_IDLE_MS));
+    }
+}
+
+void DataCollector::stop_telemetry_retention() {
+    telemetry_retention_running_ = false;
+    telemetry_retention_signal_.notify();
+    if (telemetry_retention_thread_.joinable()) {
+        telemetry_retention_thread_.join();
+    }
+}
+
+void DataCollector::apply_telemetry_retention() {
+    if (rotation_.retain_segments == 0 && rotation_.retain_bytes == 0) {
+        return;
+    }
+
+    // The writer names the active file before creating it, so a file opened
+    // during the scan was listed as closed only if the name changed: rescan
+    std::vector<StoreFile> closed;
+    std::string active;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(telemetry_active_mutex_);
+            active = telemetry_active_;
+        }
+        closed = list_closed_store_files(truck_id_, active);
+        std::lock_guard<std::mutex> lock(telemetry_active_mutex_);
+        if (telemetry_active_ == active) {
+            break;
+        }
+    }
 
-    if (log_file_.is_open()) {
-        log_file_.close();
+    std::error_code error;
+    size_t total = 0;
+    for (const auto& file : closed) {
+        total += file.bytes;
+    }
+    size_t count = closed.size();
+    for (const auto& file : closed) {
+        bool over_count = rotation_.retain_segments > 0 && count > rotation_.retain_segments;
+        bool over_bytes = rotation_.retain_bytes > 0 && total > rotation_.retain_bytes;
+        if (!over_count && !over_bytes) {
+            break;
+        }
+        if (std::filesystem::remove(file.path, error)) {
+            telemetry_deleted_++;
+        }
+        count--;
+        total -= file.bytes;
     }
 }
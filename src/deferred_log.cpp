@@ -0,0 +1,519 @@
+#include "deferred_log.h"
+#include "common_types.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace Logger {
+
+namespace {
+
+constexpr size_t LEVEL_COUNT = 5;
+constexpr size_t MODULE_COUNT = 9;
+
+/**
+ * @brief Byte ring written by one logging thread, drained by the writer
+ *
+ * Records are stored as u16 length + bytes and may wrap around the end.
+ */
+class ThreadLogRing {
+public:
+    ThreadLogRing()
+        : head_(0), tail_(0), dropped_(0), exited_(false), bytes_(new char[DEFERRED_LOG_THREAD_RING_BYTES]) {}
+
+    bool push(const char* record, size_t size) {
+        uint16_t length = static_cast<uint16_t>(size);
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t needed = sizeof(length) + size;
+        if (DEFERRED_LOG_THREAD_RING_BYTES - (tail - head_.load(std::memory_order_acquire)) < needed) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        copy_in(tail, reinterpret_cast<const char*>(&length), sizeof(length));
+        copy_in(tail + sizeof(length), record, size);
+        tail_.store(tail + needed, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Append every complete record to out as 'R' entries (writer only)
+     */
+    void drain(std::string& out) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        char record[DEFERRED_LOG_MAX_RECORD_BYTES];
+        while (head != tail) {
+            uint16_t length;
+            copy_out(head, reinterpret_cast<char*>(&length), sizeof(length));
+            copy_out(head + sizeof(length), record, length);
+            out.push_back(static_cast<char>(DEFERRED_ENTRY_RECORD));
+            out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            out.append(record, length);
+            head += sizeof(length) + length;
+        }
+        head_.store(head, std::memory_order_release);
+    }
+
+    long dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Owner thread is exiting: its last record is already pushed
+     */
+    void mark_exited() { exited_.store(true, std::memory_order_release); }
+    bool exited() const { return exited_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Ring drained and on the free list (registry mutex held)
+     */
+    void clear_exited() { exited_.store(false, std::memory_order_relaxed); }
+
+private:
+    void copy_in(size_t position, const char* data, size_t size) {
+        size_t offset = position % DEFERRED_LOG_THREAD_RING_BYTES;
+        size_t first = std::min(size, DEFERRED_LOG_THREAD_RING_BYTES - offset);
+        std::memcpy(bytes_.get() + offset, data, first);
+        std::memcpy(bytes_.get(), data + first, size - first);
+    }
+
+    void copy_out(size_t position, char* data, size_t size) const {
+        size_t offset = position % DEFERRED_LOG_THREAD_RING_BYTES;
+        size_t first = std::min(size, DEFERRED_LOG_THREAD_RING_BYTES - offset);
+        std::memcpy(data, bytes_.get() + offset, first);
+        std::memcpy(data + first, bytes_.get(), size - first);
+    }
+
+    alignas(CACHE_LINE_SIZE_BYTES) std::atomic<size_t> head_;   // Writer position
+    alignas(CACHE_LINE_SIZE_BYTES) std::atomic<size_t> tail_;   // Logging thread position
+    std::atomic<long> dropped_;                                 // Records lost to a full ring
+    std::atomic<bool> exited_;
+    std::unique_ptr<char[]> bytes_;
+};
+
+/**
+ * @brief Registered call sites and thread rings
+ *
+ * The site table is fixed-size so the flight recorder can read it from a
+ * signal handler without the mutex. Rings are never deleted: once the
+ * writer has drained the ring of an exited thread, it goes on the free
+ * list for the next new thread.
+ */
+struct DeferredRegistry {
+    std::mutex mutex;
+    std::atomic<const CallSite*> sites[DEFERRED_LOG_MAX_SITES];
+    std::atomic<size_t> site_count{0};
+    std::vector<std::unique_ptr<ThreadLogRing>> rings;
+    std::vector<ThreadLogRing*> free_rings;     // Exited and drained
+    long records_after_exit = 0;                // Logged from thread_local destructors after the ring went back
+};
+
+DeferredRegistry& registry() {
+    static DeferredRegistry instance;
+    return instance;
+}
+
+std::atomic<bool> g_deferred_enabled{false};
+std::mutex g_writer_mutex;                  // Guards writer lifecycle and file
+std::condition_variable g_writer_wakeup;
+std::thread g_writer_thread;
+bool g_writer_running = false;
+FILE* g_deferred_file = nullptr;
+size_t g_sites_written = 0;
+
+// The ring pointer has a trivial destructor, so thread_ring() stays safe to
+// call from other thread_local destructors after RingRelease has run.
+thread_local ThreadLogRing* t_ring = nullptr;
+thread_local bool t_ring_released = false;
+
+/**
+ * @brief Hands the thread's ring back to the writer when the thread exits
+ */
+struct RingRelease {
+    ~RingRelease() {
+        if (t_ring) {
+            t_ring->mark_exited();
+            t_ring = nullptr;
+        }
+        t_ring_released = true;
+    }
+};
+
+/**
+ * @brief The calling thread's ring, nullptr once the thread is exiting
+ */
+ThreadLogRing* thread_ring() {
+    if (!t_ring && !t_ring_released) {
+        thread_local RingRelease release;
+        (void)release;
+        DeferredRegistry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        if (!reg.free_rings.empty()) {
+            t_ring = reg.free_rings.back();
+            reg.free_rings.pop_back();
+        } else {
+            reg.rings.push_back(std::make_unique<ThreadLogRing>());
+            t_ring = reg.rings.back().get();
+        }
+    }
+    return t_ring;
+}
+
+/**
+ * @brief Push to the calling thread's ring (dropped once the thread is exiting)
+ */
+void push_thread_record(const char* record, size_t size) {
+    ThreadLogRing* ring = thread_ring();
+    if (ring) {
+        ring->push(record, size);
+        return;
+    }
+    DeferredRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.records_after_exit++;
+}
+
+const CallSite& text_site(Level level, Module module) {
+    static const auto sites = []() {
+        std::vector<std::unique_ptr<CallSite>> table;
+        for (size_t level_index = 0; level_index < LEVEL_COUNT; level_index++) {
+            for (size_t module_index = 0; module_index < MODULE_COUNT; module_index++) {
+                table.push_back(std::make_unique<CallSite>(static_cast<Level>(level_index),
+                                                           static_cast<Module>(module_index),
+                                                           DEFERRED_LOG_TEXT_FORMAT));
+            }
+        }
+        return table;
+    }();
+    return *sites[static_cast<size_t>(level) * MODULE_COUNT + static_cast<size_t>(module)];
+}
+
+/**
+ * @brief Encode a preformatted LOG_* line as a text-site record
+ *
+ * @param record Destination, DEFERRED_LOG_MAX_RECORD_BYTES long
+ * @return Record size in bytes
+ */
+size_t encode_text_record(Level level, Module module, const std::string& body, char* record) {
+    const CallSite& site = text_site(level, module);
+    uint32_t id = site.id();
+    int64_t ticks = deferred_ticks();
+    size_t length = std::min(body.size(), DEFERRED_LOG_MAX_RECORD_BYTES - DEFERRED_RECORD_HEADER_BYTES - 3);
+
+    char* p = deferred_detail::put_bytes(record, &id, sizeof(id));
+    p = deferred_detail::put_bytes(p, &ticks, sizeof(ticks));
+    *p++ = static_cast<char>(DeferredArg::STRING);
+    uint16_t stored = static_cast<uint16_t>(length);
+    p = deferred_detail::put_bytes(p, &stored, sizeof(stored));
+    p = deferred_detail::put_bytes(p, body.data(), length);
+    return static_cast<size_t>(p - record);
+}
+
+/**
+ * @brief Append a ticks/wall-clock pair for the decoder
+ */
+void append_calibration(std::string& out) {
+    int64_t before = deferred_ticks();
+    int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    int64_t ticks = before + (deferred_ticks() - before) / 2;
+    out.push_back(static_cast<char>(DEFERRED_ENTRY_CALIBRATION));
+    out.append(reinterpret_cast<const char*>(&ticks), sizeof(ticks));
+    out.append(reinterpret_cast<const char*>(&now_ns), sizeof(now_ns));
+}
+
+/**
+ * @brief Drain all rings and append to the file (caller holds g_writer_mutex)
+ */
+void flush_rings() {
+    std::string records;
+    std::string site_entries;
+    append_calibration(site_entries);
+    DeferredRegistry& reg = registry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (auto& ring : reg.rings) {
+            // Read the flag first: records pushed before the exit are
+            // then all visible to this drain.
+            bool exited = ring->exited();
+            ring->drain(records);
+            if (exited) {
+                ring->clear_exited();
+                reg.free_rings.push_back(ring.get());
+            }
+        }
+        // Sites are registered before their first record, so every site
+        // referenced by the drained records is already in the table.
+        size_t site_count = std::min(reg.site_count.load(), DEFERRED_LOG_MAX_SITES);
+        for (; g_sites_written < site_count; g_sites_written++) {
+            const CallSite* site = reg.sites[g_sites_written].load();
+            uint32_t id = site->id();
+            uint16_t format_length = static_cast<uint16_t>(std::strlen(site->format()));
+            site_entries.push_back(static_cast<char>(DEFERRED_ENTRY_SITE));
+            site_entries.append(reinterpret_cast<const char*>(&id), sizeof(id));
+            site_entries.push_back(static_cast<char>(site->level()));
+            site_entries.push_back(static_cast<char>(site->module()));
+            site_entries.append(reinterpret_cast<const char*>(&format_length), sizeof(format_length));
+            site_entries.append(site->format(), format_length);
+        }
+    }
+
+    if (g_deferred_file) {
+        std::fwrite(site_entries.data(), 1, site_entries.size(), g_deferred_file);
+        std::fwrite(records.data(), 1, records.size(), g_deferred_file);
+        std::fflush(g_deferred_file);
+    }
+}
+
+void writer_loop() {
+    std::unique_lock<std::mutex> lock(g_writer_mutex);
+    while (g_writer_running) {
+        g_writer_wakeup.wait_for(lock, std::chrono::milliseconds(DEFERRED_LOG_FLUSH_PERIOD_MS));
+        flush_rings();
+    }
+}
+
+template <typename T>
+bool read_value(const char*& p, const char* end, T& value) {
+    if (static_cast<size_t>(end - p) < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+bool format_arg(const char*& p, const char* end, std::ostringstream& out) {
+    uint8_t tag;
+    if (!read_value(p, end, tag)) {
+        return false;
+    }
+    switch (static_cast<DeferredArg>(tag)) {
+        case DeferredArg::INT: {
+            int64_t value;
+            if (!read_value(p, end, value)) return false;
+            out << value;
+            return true;
+        }
+        case DeferredArg::UINT: {
+            uint64_t value;
+            if (!read_value(p, end, value)) return false;
+            out << value;
+            return true;
+        }
+        case DeferredArg::DOUBLE: {
+            double value;
+            if (!read_value(p, end, value)) return false;
+            out << value;
+            return true;
+        }
+        case DeferredArg::BOOL: {
+            uint8_t value;
+            if (!read_value(p, end, value)) return false;
+            out << (value ? 1 : 0);
+            return true;
+        }
+        case DeferredArg::STRING: {
+            uint16_t length;
+            if (!read_value(p, end, length) || static_cast<size_t>(end - p) < length) return false;
+            out.write(p, length);
+            p += length;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+CallSite::CallSite(Level level, Module module, const char* format)
+    : level_(level), module_(module), format_(format) {
+    DeferredRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    size_t id = reg.site_count.load(std::memory_order_relaxed);
+    id_ = static_cast<uint32_t>(id);
+    // Past the table the site still logs in text mode, but its records
+    // cannot be decoded from files.
+    if (id < DEFERRED_LOG_MAX_SITES) {
+        reg.sites[id].store(this, std::memory_order_release);
+    }
+    reg.site_count.store(id + 1, std::memory_order_release);
+}
+
+size_t deferred_site_count() {
+    return std::min(registry().site_count.load(std::memory_order_acquire), DEFERRED_LOG_MAX_SITES);
+}
+
+const CallSite* deferred_site(size_t id) {
+    return id < DEFERRED_LOG_MAX_SITES ? registry().sites[id].load(std::memory_order_acquire) : nullptr;
+}
+
+bool enable_deferred(const std::string& path) {
+    std::lock_guard<std::mutex> lock(g_writer_mutex);
+    if (g_writer_running) {
+        return true;
+    }
+
+    g_deferred_file = std::fopen(path.c_str(), "wb");
+    if (!g_deferred_file) {
+        write_line(Level::ERR, Module::MAIN, "event=deferred_log_open_failed,path=" + path);
+        return false;
+    }
+    std::fwrite(DEFERRED_LOG_MAGIC, 1, sizeof(DEFERRED_LOG_MAGIC), g_deferred_file);
+    std::string calibration;
+    append_calibration(calibration);
+    std::fwrite(calibration.data(), 1, calibration.size(), g_deferred_file);
+    g_sites_written = 0;
+
+    // Register the LOG_* text sites before any thread can use them
+    text_site(Level::DEBUG, Module::MAIN);
+
+    g_writer_running = true;
+    g_writer_thread = std::thread(writer_loop);
+    g_deferred_enabled.store(true, std::memory_order_release);
+
+    write_line(Level::INFO, Module::MAIN, "event=deferred_log_start,path=" + path);
+    return true;
+}
+
+void disable_deferred() {
+    {
+        std::lock_guard<std::mutex> lock(g_writer_mutex);
+        if (!g_writer_running) {
+            return;
+        }
+        g_deferred_enabled.store(false, std::memory_order_release);
+        g_writer_running = false;
+    }
+    g_writer_wakeup.notify_all();
+    g_writer_thread.join();
+
+    std::lock_guard<std::mutex> lock(g_writer_mutex);
+    flush_rings();
+    std::fclose(g_deferred_file);
+    g_deferred_file = nullptr;
+
+    size_t rings = 0;
+    {
+        DeferredRegistry& reg = registry();
+        std::lock_guard<std::mutex> reg_lock(reg.mutex);
+        rings = reg.rings.size();
+    }
+    write_line(Level::INFO, Module::MAIN,
+               "event=deferred_log_stop,dropped=" + std::to_string(deferred_dropped_count()) +
+               ",rings=" + std::to_string(rings));
+}
+
+bool deferred_enabled() {
+    return g_deferred_enabled.load(std::memory_order_acquire);
+}
+
+long deferred_dropped_count() {
+    DeferredRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    long dropped = reg.records_after_exit;
+    for (const auto& ring : reg.rings) {
+        dropped += ring->dropped();
+    }
+    return dropped;
+}
+
+void submit_deferred(const CallSite& site, const char* record, size_t size) {
+    if (FlightRecorder::enabled()) {
+        FlightRecorder::record(record, size);
+    }
+    if (site.level() < get_level()) {
+        return;
+    }
+    if (site.level() == Level::CRIT) {
+        FlightRecorder::trigger("crit");
+    }
+
+    if (deferred_enabled()) {
+        push_thread_record(record, size);
+        return;
+    }
+
+    std::string body;
+    format_deferred_body(site.format(), record + DEFERRED_RECORD_HEADER_BYTES,
+                         size - DEFERRED_RECORD_HEADER_BYTES, body);
+    write_line(site.level(), site.module(), body);
+}
+
+void log_deferred_text(Level level, Module module, const std::string& body) {
+    char record[DEFERRED_LOG_MAX_RECORD_BYTES];
+    size_t size = encode_text_record(level, module, body, record);
+    push_thread_record(record, size);
+}
+
+void flight_record_text(Level level, Module module, const std::string& body) {
+    char record[DEFERRED_LOG_MAX_RECORD_BYTES];
+    size_t size = encode_text_record(level, module, body, record);
+    FlightRecorder::record(record, size);
+}
+
+int64_t deferred_ticks_to_ns(const std::vector<std::pair<int64_t, int64_t>>& calibration, int64_t ticks) {
+    if (calibration.empty()) {
+        return ticks;
+    }
+    if (calibration.size() == 1) {
+        return calibration[0].second + (ticks - calibration[0].first);
+    }
+    auto upper = std::upper_bound(calibration.begin(), calibration.end(), std::make_pair(ticks, INT64_MAX));
+    size_t index = static_cast<size_t>(upper - calibration.begin());
+    index = std::min(std::max(index, size_t{1}), calibration.size() - 1);
+    const auto& a = calibration[index - 1];
+    const auto& b = calibration[index];
+    if (b.first == a.first) {
+        return a.second;
+    }
+    double ns_per_tick = static_cast<double>(b.second - a.second) / static_cast<double>(b.first - a.first);
+    return a.second + static_cast<int64_t>(static_cast<double>(ticks - a.first) * ns_per_tick);
+}
+
+bool format_deferred_body(const char* format, const char* args, size_t size, std::string& out) {
+    const char* p = args;
+    const char* end = args + size;
+    std::ostringstream body;
+
+    if (std::strcmp(format, DEFERRED_LOG_TEXT_FORMAT) == 0) {
+        bool ok = format_arg(p, end, body);
+        out = body.str();
+        return ok;
+    }
+
+    bool first_pair = true;
+    const char* item = format;
+    while (*item) {
+        const char* item_end = std::strchr(item, ',');
+        if (!item_end) {
+            item_end = item + std::strlen(item);
+        }
+        if (item_end != item) {
+            if (!first_pair) {
+                body << ",";
+            }
+            first_pair = false;
+            body.write(item, item_end - item);
+            if (!std::memchr(item, '=', static_cast<size_t>(item_end - item))) {
+                body << "=";
+                if (!format_arg(p, end, body)) {
+                    out = body.str();
+                    return false;
+                }
+            }
+        }
+        item = *item_end ? item_end + 1 : item_end;
+    }
+
+    out = body.str();
+    return p == end;
+}
+
+} // namespace Logger
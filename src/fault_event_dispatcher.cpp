@@ -0,0 +1,181 @@
+#include "fault_event_dispatcher.h"
+#include "logger.h"
+#include "rt_profile.h"
+#include <chrono>
+
+constexpr long long NANOSECONDS_PER_MICROSECOND = 1000;
+
+FaultEventDispatcher::FaultEventDispatcher(PerformanceMonitor* perf_monitor)
+    : dropped_event_count_(0),
+      running_(false),
+      perf_monitor_(perf_monitor),
+      clock_(&Clock::system()),
+      executor_(nullptr),
+      executor_job_(-1) {
+}
+
+FaultEventDispatcher::~FaultEventDispatcher() {
+    stop();
+}
+
+void FaultEventDispatcher::start() {
+    if (running_) {
+        return;
+    }
+
+    running_ = true;
+    if (executor_) {
+        executor_job_ = executor_->add_periodic(WorkLane::HIGH, "FaultDispatcher", FAULT_EVENT_EXECUTOR_POLL_MS,
+                                                [this] { drain_queue(); });
+        LOG_INFO(FM) << "event" << "dispatcher_start" << "queue_capacity" << FAULT_EVENT_QUEUE_CAPACITY
+                     << "executor_job" << executor_job_;
+        return;
+    }
+    dispatch_thread_ = std::thread(&FaultEventDispatcher::dispatch_loop, this);
+
+    LOG_INFO(FM) << "event" << "dispatcher_start" << "queue_capacity" << FAULT_EVENT_QUEUE_CAPACITY;
+}
+
+void FaultEventDispatcher::stop() {
+    if (!running_) {
+        return;
+    }
+
+    running_ = false;
+    if (executor_) {
+        executor_->remove(executor_job_);
+        executor_job_ = -1;
+        drain_queue();
+    }
+    wakeup_.notify();
+
+    if (dispatch_thread_.joinable()) {
+        dispatch_thread_.join();
+    }
+
+    LOG_INFO(FM) << "event" << "dispatcher_stop" << "dropped" << dropped_event_count_.load();
+}
+
+void FaultEventDispatcher::register_callback(FaultCallback callback) {
+    std::lock_guard<std::mutex> lock(callback_mutex_);
+    callbacks_.push_back(callback);
+}
+
+void FaultEventDispatcher::register_advisory_callback(AdvisoryCallback callback) {
+    std::lock_guard<std::mutex> lock(callback_mutex_);
+    advisory_callbacks_.push_back(callback);
+}
+
+bool FaultEventDispatcher::post(const FaultEvent& event) {
+    if (!event_queue_.try_push(event)) {
+        dropped_event_count_++;
+        return false;
+    }
+
+    if (executor_) {
+        executor_->wake(executor_job_);
+    } else {
+        wakeup_.notify();
+    }
+    return true;
+}
+
+void FaultEventDispatcher::dispatch_loop() {
+    RtProfile::enter_thread("FaultDispatcher");
+    while (running_) {
+        // Version read before draining: a post() after the drain changes it, so the wait returns at once
+        uint32_t seen = wakeup_.version();
+        drain_queue();
+        wakeup_.wait_until(seen, std::chrono::steady_clock::now() +
+                                     std::chrono::milliseconds(FAULT_EVENT_DISPATCH_POLL_MS));
+    }
+
+    drain_queue();
+}
+
+void FaultEventDispatcher::set_clock(Clock* clock) {
+    clock_ = clock;
+}
+
+void FaultEventDispatcher::set_executor(BestEffortExecutor* executor) {
+    executor_ = executor;
+}
+
+void FaultEventDispatcher::drain_queue() {
+    FaultEvent event;
+    while (event_queue_.try_pop(event)) {
+        deliver(event);
+    }
+}
+
+void FaultEventDispatcher::deliver(const FaultEvent& event) {
+    if (perf_monitor_) {
+        long long now_ns = clock_->now_ns();
+        perf_monitor_->record_latency("FaultDispatch",
+                                      static_cast<long>((now_ns - event.detected_ns) / NANOSECONDS_PER_MICROSECOND));
+    }
+
+    if (event.kind != FaultEventKind::FAULT_CHANGE) {
+        deliver_advisory(event);
+        return;
+    }
+
+    const char* fault_code = "UNK";
+    Logger::Level log_level = Logger::Level::WARN;
+
+    switch (event.type) {
+        case FaultType::TEMPERATURE_ALERT:
+            fault_code = "TEMP_WRN";
+            log_level = Logger::Level::WARN;
+            break;
+        case FaultType::TEMPERATURE_CRITICAL:
+            fault_code = "TEMP_CRT";
+            log_level = Logger::Level::CRIT;
+            break;
+        case FaultType::ELECTRICAL:
+            fault_code = "ELEC";
+            log_level = Logger::Level::CRIT;
+            break;
+        case FaultType::HYDRAULIC:
+            fault_code = "HYDR";
+            log_level = Logger::Level::CRIT;
+            break;
+        case FaultType::STALE_DATA:
+            fault_code = "STALE";
+            log_level = Logger::Level::CRIT;
+            break;
+        default:
+            break;
+    }
+
+    Logger::log(log_level, Logger::Module::FM)
+        << "event" << "fault"
+        << "type" << fault_code
+        << "mask" << event.active_mask
+        << "temp" << event.data.temperature
+        << "pos_x" << event.data.position_x
+        << "pos_y" << event.data.position_y;
+
+    std::vector<FaultCallback> callbacks_copy;
+    {
+        std::lock_guard<std::mutex> lock(callback_mutex_);
+        callbacks_copy = callbacks_;
+    }
+
+    for (const auto& callback : callbacks_copy) {
+        callback(event.type, event.data);
+    }
+}
+
+void FaultEventDispatcher::deliver_advisory(const FaultEvent& event) {
+    std::vector<AdvisoryCallback> callbacks_copy;
+    {
+        std::lock_guard<std::mutex> lock(callback_mutex_);
+        callbacks_copy = advisory_callbacks_;
+    }
+
+    bool active = event.kind == FaultEventKind::TREND_ALERT;
+    for (const auto& callback : callbacks_copy) {
+        callback(active, event.data);
+    }
+}
@@ -1,17 +1,43 @@
 #include "fault_monitoring.h"
 #include "logger.h"
-#include "watchdog.h"
+#include "rt_profile.h"
 #include <chrono>
 #include <pthread.h>
 #include <cstring>
-#include <vector>
+#include <algorithm>
 
 FaultMonitoring::FaultMonitoring(CircularBuffer& buffer, int period_ms, PerformanceMonitor* perf_monitor)
     : buffer_(buffer),
       period_ms_(period_ms),
       running_(false),
-      current_fault_(FaultType::NONE),
-      perf_monitor_(perf_monitor) {
+      evaluation_mode_(FaultEvaluationMode::PERIODIC),
+      published_mask_(0),
+      notified_mask_(0),
+      notification_pending_(false),
+      last_notification_ns_(0),
+      notification_count_(0),
+      coalesced_notification_count_(0),
+      temperature_trend_(PREDICTIVE_ALERT_WINDOW_SAMPLES),
+      predictive_horizon_ms_(0),
+      last_trend_sample_ms_(0),
+      predicted_alert_(false),
+      trend_alert_count_(0),
+      dispatcher_(perf_monitor),
+      freshness_monitor_(nullptr),
+      perf_monitor_(perf_monitor),
+      clock_(&Clock::system()),
+      clock_thread_(0),
+      worker_pool_(nullptr),
+      pool_job_(-1) {
+
+    fault_states_.configure(FaultType::TEMPERATURE_ALERT,
+                            FaultHysteresis{ALERT_TEMPERATURE_THRESHOLD_FM, ALERT_TEMPERATURE_CLEAR_BELOW_FM,
+                                            TEMPERATURE_ALERT_SET_SAMPLES, DEFAULT_FAULT_CLEAR_SAMPLES});
+    fault_states_.configure(FaultType::TEMPERATURE_CRITICAL,
+                            FaultHysteresis{CRITICAL_TEMPERATURE_THRESHOLD_FM, CRITICAL_TEMPERATURE_CLEAR_BELOW_FM,
+                                            DEFAULT_FAULT_SET_SAMPLES, DEFAULT_FAULT_CLEAR_SAMPLES});
+    fault_states_.configure(FaultType::STALE_DATA,
+                            flag_hysteresis(DEFAULT_FAULT_SET_SAMPLES, STALE_DATA_CLEAR_SAMPLES));
 
     LOG_INFO(FM) << "event" << "init" << "period_ms" << period_ms_;
 }
@@ -25,7 +51,16 @@ void FaultMonitoring::start() {
         return;
     }
 
+    dispatcher_.start();
+
     running_ = true;
+    if (worker_pool_) {
+        pool_job_ = worker_pool_->add_periodic("FaultMonitoring", period_ms_, [this] { run_cycle(); });
+        LOG_INFO(FM) << "event" << "start" << "pool_job" << pool_job_;
+        return;
+    }
+
+    clock_thread_ = clock_->register_thread("FaultMonitoring");
     task_thread_ = std::thread(&FaultMonitoring::task_loop, this);
 
     pthread_t native_handle = task_thread_.native_handle();
@@ -46,110 +81,217 @@ void FaultMonitoring::stop() {
     }
 
     running_ = false;
+    if (worker_pool_) {
+        worker_pool_->remove(pool_job_);
+    }
+    clock_->release_thread(clock_thread_);
 
     if (task_thread_.joinable()) {
         task_thread_.join();
     }
 
-    LOG_INFO(FM) << "event" << "stop";
+    dispatcher_.stop();
+
+    LOG_INFO(FM) << "event" << "stop"
+                 << "notified" << notification_count_.load()
+                 << "coalesced" << coalesced_notification_count_.load()
+                 << "alert_toggles_suppressed"
+                 << get_fault_counters(FaultType::TEMPERATURE_ALERT).suppressed_toggles
+                 << "trend_alerts" << trend_alert_count_.load();
 }
 
 void FaultMonitoring::register_fault_callback(FaultCallback callback) {
-    std::lock_guard<std::mutex> lock(callback_mutex_);
-    callbacks_.push_back(callback);
+    dispatcher_.register_callback(callback);
+}
+
+void FaultMonitoring::register_advisory_callback(AdvisoryCallback callback) {
+    dispatcher_.register_advisory_callback(callback);
 }
 
 FaultType FaultMonitoring::get_current_fault() const {
-    std::lock_guard<std::mutex> lock(fault_mutex_);
-    return current_fault_;
+    return fault_status_.current();
+}
+
+FaultMask FaultMonitoring::get_active_faults() const {
+    return fault_status_.active_mask();
+}
+
+FaultCounters FaultMonitoring::get_fault_counters(FaultType type) const {
+    std::lock_guard<std::mutex> lock(evaluation_mutex_);
+    return fault_states_.get_counters(type);
+}
+
+void FaultMonitoring::set_heartbeat_handle(Watchdog::HeartbeatHandle handle) {
+    heartbeat_handle_ = handle;
+}
+
+void FaultMonitoring::set_input_freshness_monitor(InputFreshnessMonitor* monitor) {
+    freshness_monitor_ = monitor;
+}
+
+void FaultMonitoring::add_fault_listener(ChangeSignal* listener) {
+    fault_listeners_.push_back(listener);
+}
+
+void FaultMonitoring::set_evaluation_mode(FaultEvaluationMode mode) {
+    evaluation_mode_ = mode;
+}
+
+void FaultMonitoring::set_predictive_alert_horizon(long horizon_ms) {
+    predictive_horizon_ms_ = horizon_ms;
+}
+
+void FaultMonitoring::set_clock(Clock* clock) {
+    clock_ = clock;
+    dispatcher_.set_clock(clock);
+}
+
+void FaultMonitoring::set_worker_pool(RtWorkerPool* pool) {
+    worker_pool_ = pool;
+}
+
+void FaultMonitoring::set_executor(BestEffortExecutor* executor) {
+    dispatcher_.set_executor(executor);
+}
+
+void FaultMonitoring::on_sensor_sample(const RawSensorData& raw, const SensorData& filtered,
+                                       long long raw_arrival_ns) {
+    if (evaluation_mode_ != FaultEvaluationMode::WRITE_TRIGGERED) {
+        return;
+    }
+
+    bool changed = false;
+    FaultType fault;
+    {
+        std::lock_guard<std::mutex> lock(evaluation_mutex_);
+        observe_sensor_faults(filtered, std::max(raw.temperature, filtered.temperature));
+        changed = publish_fault_changes(filtered);
+        fault = FaultStateMachine::highest_priority(published_mask_);
+    }
+
+    if (changed && fault != FaultType::NONE && perf_monitor_ && raw_arrival_ns > 0) {
+        long long now_ns = clock_->now_ns();
+        perf_monitor_->record_latency("FaultDetect", static_cast<long>((now_ns - raw_arrival_ns) / 1000));
+    }
 }
 
 void FaultMonitoring::task_loop() {
-    auto next_execution = std::chrono::steady_clock::now();
+    RtProfile::enter_thread("FaultMonitoring");
+    clock_->begin_thread(clock_thread_);
+    auto next_execution = clock_->now();
 
     while (running_) {
-        auto start_time = std::chrono::steady_clock::now();
+        run_cycle();
+
+        next_execution += std::chrono::milliseconds(period_ms_);
+        clock_->sleep_until(clock_thread_, next_execution);
+    }
+}
 
-        SensorData sensor_data = buffer_.peek_latest();
-        FaultType fault = check_for_faults(sensor_data);
+void FaultMonitoring::run_cycle() {
+    auto start_time = clock_->now();
 
-        {
-            std::lock_guard<std::mutex> lock(fault_mutex_);
-            if (fault != current_fault_) {
-                current_fault_ = fault;
-                notify_fault_event(fault, sensor_data);
-            }
-        }
+    FaultType freshness_fault = FaultType::NONE;
+    if (freshness_monitor_) {
+        freshness_fault = freshness_monitor_->evaluate(clock_->wall_ms());
+    }
 
-        if (Watchdog::get_instance()) {
-            Watchdog::get_instance()->heartbeat("FaultMonitoring");
+    SensorData sensor_data = buffer_.peek_latest();
+    {
+        std::lock_guard<std::mutex> lock(evaluation_mutex_);
+        if (evaluation_mode_ == FaultEvaluationMode::PERIODIC) {
+            observe_sensor_faults(sensor_data, sensor_data.temperature);
         }
+        fault_states_.observe_flag(FaultType::STALE_DATA, freshness_fault == FaultType::STALE_DATA);
+        publish_fault_changes(sensor_data);
+    }
 
-        if (perf_monitor_) {
-            perf_monitor_->end_measurement("FaultMonitoring", start_time);
-        }
+    Watchdog::heartbeat(heartbeat_handle_);
 
-        next_execution += std::chrono::milliseconds(period_ms_);
-        std::this_thread::sleep_until(next_execution);
+    if (perf_monitor_) {
+        perf_monitor_->end_measurement("FaultMonitoring", start_time);
     }
 }
 
-FaultType FaultMonitoring::check_for_faults(const SensorData& data) {
-    if (data.temperature > CRITICAL_TEMPERATURE_THRESHOLD_FM) {
-        return FaultType::TEMPERATURE_CRITICAL;
+void FaultMonitoring::observe_sensor_faults(const SensorData& data, int critical_temperature) {
+    update_temperature_trend(data);
+
+    fault_states_.observe_level(FaultType::TEMPERATURE_CRITICAL, critical_temperature);
+    fault_states_.observe_flag(FaultType::ELECTRICAL, data.fault_electrical);
+    fault_states_.observe_flag(FaultType::HYDRAULIC, data.fault_hydraulic);
+    fault_states_.observe_level(FaultType::TEMPERATURE_ALERT, data.temperature);
+}
+
+bool FaultMonitoring::publish_fault_changes(const SensorData& data) {
+    FaultMask mask = fault_states_.active_mask();
+    long long now_ns = clock_->now_ns();
+
+    bool changed = mask != published_mask_;
+    if (changed) {
+        FaultType fault = FaultStateMachine::highest_priority(mask);
+        fault_status_.publish(fault, mask, now_ns);
+        for (ChangeSignal* listener : fault_listeners_) {
+            listener->notify();
+        }
+        if (notification_pending_) {
+            coalesced_notification_count_++;
+        }
+        published_mask_ = mask;
+        notification_pending_ = true;
     }
-    if (data.fault_electrical) {
-        return FaultType::ELECTRICAL;
+
+    if (!notification_pending_) {
+        return changed;
     }
-    if (data.fault_hydraulic) {
-        return FaultType::HYDRAULIC;
+
+    if (published_mask_ == notified_mask_) {
+        notification_pending_ = false;
+        coalesced_notification_count_++;
+        return changed;
     }
-    if (data.temperature > ALERT_TEMPERATURE_THRESHOLD_FM) {
-        return FaultType::TEMPERATURE_ALERT;
+
+    FaultType fault = FaultStateMachine::highest_priority(published_mask_);
+    bool escalation = FaultStateMachine::severity_rank(fault) >
+                      FaultStateMachine::severity_rank(FaultStateMachine::highest_priority(notified_mask_));
+    bool interval_elapsed = now_ns - last_notification_ns_ >= FAULT_NOTIFICATION_MIN_INTERVAL_MS * 1000000LL;
+
+    if (escalation || interval_elapsed) {
+        dispatcher_.post(FaultEvent{fault, published_mask_, data, fault_status_.snapshot().detected_ns});
+        notified_mask_ = published_mask_;
+        last_notification_ns_ = now_ns;
+        notification_pending_ = false;
+        notification_count_++;
     }
 
-    return FaultType::NONE;
+    return changed;
 }
 
-void FaultMonitoring::notify_fault_event(FaultType fault_type, const SensorData& data) {
-    const char* fault_code = "UNK";
-    Logger::Level log_level = Logger::Level::WARN;
-
-    switch (fault_type) {
-        case FaultType::TEMPERATURE_ALERT:
-            fault_code = "TEMP_WRN";
-            log_level = Logger::Level::WARN;
-            break;
-        case FaultType::TEMPERATURE_CRITICAL:
-            fault_code = "TEMP_CRT";
-            log_level = Logger::Level::CRIT;
-            break;
-        case FaultType::ELECTRICAL:
-            fault_code = "ELEC";
-            log_level = Logger::Level::CRIT;
-            break;
-        case FaultType::HYDRAULIC:
-            fault_code = "HYDR";
-            log_level = Logger::Level::CRIT;
-            break;
-        default:
-            break;
+void FaultMonitoring::update_temperature_trend(const SensorData& data) {
+    if (predictive_horizon_ms_ <= 0 || data.timestamp == last_trend_sample_ms_) {
+        return;
     }
 
-    Logger::log(log_level, Logger::Module::FM)
-        << "event" << "fault"
-        << "type" << fault_code
-        << "temp" << data.temperature
-        << "pos_x" << data.position_x
-        << "pos_y" << data.position_y;
+    last_trend_sample_ms_ = data.timestamp;
+    temperature_trend_.add_sample(data.timestamp, data.temperature);
 
-    std::vector<FaultCallback> callbacks_copy;
-    {
-        std::lock_guard<std::mutex> lock(callback_mutex_);
-        callbacks_copy = callbacks_;
-    }
+    long eta_ms = temperature_trend_.predict_ms_to_reach(ALERT_TEMPERATURE_THRESHOLD_FM,
+                                                         PREDICTIVE_ALERT_MIN_SLOPE_C_PER_S);
+    long horizon_ms = predicted_alert_ ? predictive_horizon_ms_ * PREDICTIVE_ALERT_CLEAR_HORIZON_FACTOR
+                                       : predictive_horizon_ms_;
+    bool predicted = eta_ms >= 0 && eta_ms <= horizon_ms;
 
-    for (const auto& callback : callbacks_copy) {
-        callback(fault_type, data);
+    if (predicted != predicted_alert_) {
+        predicted_alert_ = predicted;
+        dispatcher_.post(FaultEvent{fault_status_.current(), published_mask_, data, clock_->now_ns(),
+                                    predicted ? FaultEventKind::TREND_ALERT : FaultEventKind::TREND_CLEAR});
+        if (predicted) {
+            trend_alert_count_++;
+            LOG_WARN(FM) << "event" << "temp_trend_alert"
+                         << "eta_ms" << eta_ms
+                         << "slope_c_per_s" << temperature_trend_.slope_per_second()
+                         << "temp" << data.temperature;
+        } else {
+            LOG_INFO(FM) << "event" << "temp_trend_clear" << "temp" << data.temperature;
+        }
     }
 }
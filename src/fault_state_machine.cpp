@@ -0,0 +1,97 @@
+#include "fault_state_machine.h"
+
+constexpr double FLAG_THRESHOLD = 0.5;
+
+FaultHysteresis flag_hysteresis(int set_samples, int clear_samples) {
+    return FaultHysteresis{FLAG_THRESHOLD, FLAG_THRESHOLD, set_samples, clear_samples};
+}
+
+static size_t channel_index(FaultType type) {
+    return static_cast<size_t>(type);
+}
+
+FaultStateMachine::FaultStateMachine()
+    : active_mask_(0) {
+    for (auto& channel : channels_) {
+        channel.rule = flag_hysteresis(DEFAULT_FAULT_SET_SAMPLES, DEFAULT_FAULT_CLEAR_SAMPLES);
+        channel.condition = false;
+        channel.streak = 0;
+        channel.counters = FaultCounters{0, 0, 0};
+    }
+}
+
+void FaultStateMachine::configure(FaultType type, const FaultHysteresis& rule) {
+    if (type == FaultType::NONE) {
+        return;
+    }
+    channels_[channel_index(type)].rule = rule;
+}
+
+bool FaultStateMachine::observe_flag(FaultType type, bool asserted) {
+    return observe_level(type, asserted ? 1.0 : 0.0);
+}
+
+bool FaultStateMachine::observe_level(FaultType type, double value) {
+    if (type == FaultType::NONE) {
+        return false;
+    }
+
+    FaultChannel& channel = channels_[channel_index(type)];
+    bool active = (active_mask_ & fault_bit(type)) != 0;
+
+    bool condition = channel.condition ? !(value < channel.rule.clear_below)
+                                       : value > channel.rule.set_above;
+    if (condition != channel.condition) {
+        channel.condition = condition;
+        channel.counters.suppressed_toggles++;
+    }
+
+    if (condition == active) {
+        channel.streak = 0;
+        return false;
+    }
+
+    channel.streak++;
+    int required = active ? channel.rule.clear_samples : channel.rule.set_samples;
+    if (channel.streak < required) {
+        return false;
+    }
+
+    channel.streak = 0;
+    if (active) {
+        active_mask_ &= ~fault_bit(type);
+        channel.counters.clears++;
+        channel.counters.suppressed_toggles--;
+    } else {
+        active_mask_ |= fault_bit(type);
+        channel.counters.activations++;
+        channel.counters.suppressed_toggles--;
+    }
+    return true;
+}
+
+FaultCounters FaultStateMachine::get_counters(FaultType type) const {
+    return channels_[channel_index(type)].counters;
+}
+
+int FaultStateMachine::severity_rank(FaultType type) {
+    switch (type) {
+        case FaultType::TEMPERATURE_CRITICAL: return 5;
+        case FaultType::ELECTRICAL:           return 4;
+        case FaultType::HYDRAULIC:            return 3;
+        case FaultType::STALE_DATA:           return 2;
+        case FaultType::TEMPERATURE_ALERT:    return 1;
+        default:                              return 0;
+    }
+}
+
+FaultType FaultStateMachine::highest_priority(FaultMask mask) {
+    FaultType highest = FaultType::NONE;
+    for (size_t i = 1; i < FAULT_TYPE_COUNT; i++) {
+        FaultType type = static_cast<FaultType>(i);
+        if ((mask & fault_bit(type)) && severity_rank(type) > severity_rank(highest)) {
+            highest = type;
+        }
+    }
+    return highest;
+}
@@ -0,0 +1,421 @@
+#include "fleet.h"
+#include "bridge_messages.h"
+#include "deferred_log.h"
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int FLEET_INITIAL_X = 100;
+constexpr int FLEET_INITIAL_X_PER_ID = 50;
+constexpr int FLEET_INITIAL_Y = 200;
+constexpr int FLEET_INITIAL_TEMPERATURE = 75;
+constexpr int FLEET_INITIAL_WAYPOINT_X = 500;
+constexpr int FLEET_INITIAL_WAYPOINT_Y = 300;
+constexpr int FLEET_INITIAL_WAYPOINT_SPEED = 50;
+constexpr int FLEET_TASKS_PER_TRUCK = 5;
+constexpr int FLEET_EXECUTOR_JOBS_PER_TRUCK = 3;    // Fault dispatcher, Data Collector status and writer
+
+std::string task_name(const char* task, int truck_id) {
+    return std::string(task) + "#" + std::to_string(truck_id);
+}
+
+template <typename Task>
+Watchdog::RecoveryPolicy make_recovery_policy(Task& task, CommandLogic* safe_output_owner,
+                                              const FleetConfig& config) {
+    Watchdog::RecoveryPolicy policy;
+    if (safe_output_owner) {
+        policy.enter_safe_state = [safe_output_owner]() { safe_output_owner->engage_safe_output(); };
+        policy.on_recovered = [safe_output_owner]() { safe_output_owner->release_safe_output(); };
+    }
+    policy.restart_task = [&task]() {
+        task.stop();
+        task.start();
+    };
+    policy.restart_after_failures = config.restart_after_failures;
+    policy.max_restarts_per_outage = config.max_restarts_per_outage;
+    policy.fail_fast_after_failures = 0;
+    return policy;
+}
+
+} // namespace
+
+Fleet::Truck::Truck(int truck_id, const FleetConfig& config, PerformanceMonitor* perf_monitor)
+    : id(truck_id),
+      input_freshness(config.input_limits, perf_monitor),
+      sensor_task(buffer, config.sensor_filter_order, config.sensor_processing_period_ms, perf_monitor),
+      command_task(buffer, config.command_logic_period_ms, perf_monitor),
+      fault_task(buffer, config.fault_monitoring_period_ms, perf_monitor),
+      nav_task(buffer, config.navigation_control_period_ms, perf_monitor),
+      data_collector(buffer, truck_id, config.data_collector_period_ms, perf_monitor),
+      last_actuator_output{},
+      last_state{} {
+    last_actuator_output.velocity = -999;
+    last_actuator_output.steering = -999;
+}
+
+Fleet::Fleet(const FleetConfig& config)
+    : config_(config),
+      pool_(config.workers, RT_WORKER_POOL_THREAD_PRIORITY, &perf_monitor_),
+      best_effort_(config.best_effort_workers,
+                   std::max(BEST_EFFORT_DEFAULT_MAX_JOBS,
+                            static_cast<size_t>(FLEET_EXECUTOR_JOBS_PER_TRUCK * std::max(config.truck_count, 1))),
+                   &perf_monitor_),
+      watchdog_(config.watchdog_tick_ms,
+                std::max(DEFAULT_MAX_MONITORED_TASKS,
+                         static_cast<size_t>(FLEET_TASKS_PER_TRUCK * std::max(config.truck_count, 1))),
+                &perf_monitor_),
+      started_(false) {
+    perf_monitor_.register_task("SensorProcessing", config_.sensor_processing_period_ms);
+    perf_monitor_.register_task("CommandLogic", config_.command_logic_period_ms);
+    perf_monitor_.register_task("FaultMonitoring", config_.fault_monitoring_period_ms);
+    perf_monitor_.register_task("NavigationControl", config_.navigation_control_period_ms);
+    perf_monitor_.register_task("DataCollector", config_.data_collector_period_ms);
+    best_effort_.set_cpu_affinity(config_.best_effort_cpus);
+
+    trucks_.reserve(config_.truck_count);
+    for (int i = 0; i < config_.truck_count; i++) {
+        trucks_.push_back(std::make_unique<Truck>(config_.first_truck_id + i, config_, &perf_monitor_));
+        configure(*trucks_.back());
+    }
+
+    LOG_INFO(MAIN) << "event" << "fleet_init" << "first_truck_id" << config_.first_truck_id
+                   << "trucks" << config_.truck_count << "workers" << config_.workers
+                   << "best_effort_workers" << config_.best_effort_workers
+                   << "watchdog_tasks" << watchdog_.get_task_count();
+}
+
+Fleet::~Fleet() {
+    stop();
+}
+
+void Fleet::configure(Truck& truck) {
+    SensorProcessing& sensor_task = truck.sensor_task;
+    CommandLogic& command_task = truck.command_task;
+    FaultMonitoring& fault_task = truck.fault_task;
+    NavigationControl& nav_task = truck.nav_task;
+    DataCollector& data_collector = truck.data_collector;
+
+    sensor_task.set_worker_pool(&pool_);
+    command_task.set_worker_pool(&pool_);
+    fault_task.set_worker_pool(&pool_);
+    nav_task.set_worker_pool(&pool_);
+    fault_task.set_executor(&best_effort_);
+    data_collector.set_executor(&best_effort_);
+
+    command_task.set_fault_status(&fault_task.get_fault_status());
+    fault_task.add_fault_listener(&command_task.get_input_signal());
+    nav_task.set_fault_status(&fault_task.get_fault_status());
+
+    fault_task.register_fault_callback(
+        [&data_collector](FaultType type, const SensorData& data) {
+            std::string desc = "Fault detected: " + std::to_string(static_cast<int>(type));
+            if (type == FaultType::NONE) {
+                desc = "Fault cleared";
+            }
+            data_collector.log_event(type == FaultType::NONE ? "OK" : "FAULT",
+                                     data.position_x, data.position_y, desc, LogDurability::DURABLE);
+        }
+    );
+    fault_task.register_advisory_callback(
+        [&data_collector](bool active, const SensorData& data) {
+            data_collector.log_event("ADVISORY", data.position_x, data.position_y,
+                                     active ? "Temperature trend alert" : "Temperature trend cleared");
+        }
+    );
+
+    fault_task.set_input_freshness_monitor(&truck.input_freshness);
+    fault_task.set_evaluation_mode(config_.fault_evaluation_mode);
+    fault_task.set_predictive_alert_horizon(config_.predictive_alert_horizon_ms);
+    if (config_.fault_evaluation_mode == FaultEvaluationMode::WRITE_TRIGGERED) {
+        sensor_task.set_sample_hook(
+            [&fault_task](const RawSensorData& raw, const SensorData& filtered, long long raw_arrival_ns) {
+                fault_task.on_sensor_sample(raw, filtered, raw_arrival_ns);
+            });
+    }
+
+    sensor_task.set_heartbeat_handle(watchdog_.register_task(
+        task_name("SensorProcessing", truck.id), config_.sensor_processing_timeout_ms));
+    command_task.set_heartbeat_handle(watchdog_.register_task(
+        task_name("CommandLogic", truck.id), config_.command_logic_timeout_ms));
+    command_task.set_idle_wakeup_ms(config_.command_logic_timeout_ms / 2);
+    fault_task.set_heartbeat_handle(watchdog_.register_task(
+        task_name("FaultMonitoring", truck.id), config_.fault_monitoring_timeout_ms));
+    nav_task.set_heartbeat_handle(watchdog_.register_task(
+        task_name("NavigationControl", truck.id), config_.navigation_control_timeout_ms));
+    data_collector.set_telemetry_store(config_.telemetry_store);
+    data_collector.set_log_rotation(config_.log_rotation);
+    data_collector.set_heartbeat_handle(watchdog_.register_task(
+        task_name("DataCollector", truck.id), config_.data_collector_timeout_ms));
+
+    watchdog_.set_recovery_policy(task_name("SensorProcessing", truck.id),
+                                  make_recovery_policy(sensor_task, &command_task, config_));
+    watchdog_.set_recovery_policy(task_name("CommandLogic", truck.id),
+                                  make_recovery_policy(command_task, &command_task, config_));
+    watchdog_.set_recovery_policy(task_name("FaultMonitoring", truck.id),
+                                  make_recovery_policy(fault_task, &command_task, config_));
+    watchdog_.set_recovery_policy(task_name("NavigationControl", truck.id),
+                                  make_recovery_policy(nav_task, &command_task, config_));
+    watchdog_.set_recovery_policy(task_name("DataCollector", truck.id),
+                                  make_recovery_policy(data_collector, nullptr, config_));
+
+    truck.route_planner.set_target_waypoint(FLEET_INITIAL_WAYPOINT_X, FLEET_INITIAL_WAYPOINT_Y,
+                                            FLEET_INITIAL_WAYPOINT_SPEED);
+
+    RawSensorData initial_data;
+    initial_data.position_x = FLEET_INITIAL_X + truck.id * FLEET_INITIAL_X_PER_ID;
+    initial_data.position_y = FLEET_INITIAL_Y;
+    initial_data.angle_x = 0;
+    initial_data.temperature = FLEET_INITIAL_TEMPERATURE;
+    initial_data.fault_electrical = false;
+    initial_data.fault_hydraulic = false;
+    sensor_task.set_raw_data(initial_data);
+}
+
+void Fleet::start() {
+    if (started_) {
+        return;
+    }
+    started_ = true;
+
+    pool_.start();
+    best_effort_.start();
+    for (auto& truck : trucks_) {
+        truck->sensor_task.start();
+        truck->command_task.start();
+        truck->fault_task.start();
+        truck->nav_task.start();
+        truck->data_collector.start();
+    }
+    watchdog_.start();
+
+    LOG_INFO(MAIN) << "event" << "fleet_ready" << "trucks" << trucks_.size();
+}
+
+void Fleet::stop() {
+    if (!started_) {
+        return;
+    }
+    started_ = false;
+
+    watchdog_.stop();
+    for (auto& truck : trucks_) {
+        truck->data_collector.stop();
+        truck->nav_task.stop();
+        truck->fault_task.stop();
+        truck->command_task.stop();
+        truck->sensor_task.stop();
+    }
+    best_effort_.stop();
+    pool_.stop();
+
+    LOG_INFO(MAIN) << "event" << "fleet_stop" << "trucks" << trucks_.size();
+}
+
+void Fleet::run(const std::atomic<bool>& running) {
+    std::vector<TopicFiles> files(trucks_.size());
+    int loop_counter = 0;
+    auto next_execution = std::chrono::steady_clock::now();
+
+    while (running) {
+        loop_counter++;
+        bool force_update = (loop_counter % config_.state_update_interval == 0);
+        long cycle_ms = Logger::timestamp_ms();
+
+        scan_bridge(files);
+        best_effort_.parallel_for(WorkLane::HIGH, "FleetTruckStep", trucks_.size(), [&](size_t i) {
+            apply_bridge_inputs(*trucks_[i], files[i]);
+            step(*trucks_[i], force_update, cycle_ms);
+        });
+
+        next_execution += std::chrono::milliseconds(config_.main_loop_period_ms);
+        auto now = std::chrono::steady_clock::now();
+        if (now > next_execution) {
+            next_execution = now;
+        }
+        std::this_thread::sleep_until(next_execution);
+    }
+}
+
+void Fleet::scan_bridge(std::vector<TopicFiles>& files) const {
+    for (auto& truck_files : files) {
+        for (auto& topic_files : truck_files) {
+            topic_files.clear();
+        }
+    }
+
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(BRIDGE_FROM_MQTT_DIR, error)) {
+        if (entry.path().extension() != ".json") {
+            continue;
+        }
+
+        // <ms>_truck_<id>_<topic>.json
+        std::string name = entry.path().filename().string();
+        long timestamp_ms = 0;
+        int truck_id = 0;
+        char topic_name[16] = {};
+        if (std::sscanf(name.c_str(), "%ld_truck_%d_%15[a-z]", &timestamp_ms, &truck_id, topic_name) != 3) {
+            continue;
+        }
+        int index = truck_id - config_.first_truck_id;
+        if (index < 0 || index >= static_cast<int>(files.size())) {
+            continue;       // Another process's truck
+        }
+        for (size_t topic = 0; topic < BRIDGE_TOPIC_COUNT; topic++) {
+            if (std::strcmp(topic_name, bridge_topic_name(static_cast<BridgeTopic>(topic))) == 0) {
+                files[index][topic].push_back(entry.path().string());
+                break;
+            }
+        }
+    }
+
+    for (auto& truck_files : files) {
+        for (auto& topic_files : truck_files) {
+            std::sort(topic_files.begin(), topic_files.end());
+        }
+    }
+}
+
+void Fleet::apply_bridge_inputs(Truck& truck, TopicFiles& files) {
+    long now_ms = Logger::timestamp_ms();
+    std::error_code error;
+
+    for (size_t topic = 0; topic < BRIDGE_TOPIC_COUNT; topic++) {
+        if (files[topic].empty()) {
+            continue;
+        }
+        BridgeTopic bridge_topic = static_cast<BridgeTopic>(topic);
+
+        // Every command is a discrete operator action; the other topics are state, so the newest wins
+        bool newest_only = bridge_topic != BridgeTopic::COMMANDS;
+        size_t first = newest_only ? files[topic].size() - 1 : 0;
+
+        for (size_t i = first; i < files[topic].size(); i++) {
+            const std::string& path = files[topic][i];
+            json message;
+            BridgeFileRead read = read_bridge_file(path, message);
+            if (read == BridgeFileRead::PENDING) {
+                continue;
+            }
+            if (read == BridgeFileRead::INVALID) {
+                LOG_ERR(MAIN) << "event" << "bridge_parse_err" << "truck_id" << truck.id
+                              << "topic" << bridge_topic_name(bridge_topic) << "file" << path;
+                fs::remove(path, error);
+                continue;
+            }
+
+            try {
+                apply_bridge_message(truck, bridge_topic, message, now_ms);
+            } catch (const std::exception& e) {
+                LOGF_RATE_LIMITED(ERR, MAIN, 1, 1, "event=bridge_parse_err,truck_id,topic,error",
+                                  truck.id, bridge_topic_name(bridge_topic), e.what());
+            }
+
+            if (newest_only) {
+                for (const auto& superseded : files[topic]) {
+                    fs::remove(superseded, error);
+                }
+            } else {
+                fs::remove(path, error);
+            }
+        }
+    }
+}
+
+void Fleet::apply_bridge_message(Truck& truck, BridgeTopic topic, const json& message, long now_ms) {
+    long source_timestamp_ms = bridge_message_timestamp_ms(message);
+    switch (topic) {
+        case BridgeTopic::SENSORS: {
+            RawSensorData data;
+            if (parse_bridge_sensors(message, data)) {
+                truck.input_freshness.record_arrival(InputTopic::SENSORS, source_timestamp_ms, now_ms);
+                truck.sensor_task.set_raw_data(data);
+            }
+            break;
+        }
+        case BridgeTopic::COMMANDS: {
+            OperatorCommand cmd;
+            if (parse_bridge_command(message, cmd)) {
+                if (cmd.auto_mode || cmd.manual_mode || cmd.rearm) {
+                    LOG_INFO(MAIN) << "event" << "cmd_recv" << "truck_id" << truck.id
+                                   << "auto" << cmd.auto_mode
+                                   << "manual" << cmd.manual_mode
+                                   << "rearm" << cmd.rearm;
+                }
+                if (truck.input_freshness.record_arrival(InputTopic::COMMANDS, source_timestamp_ms, now_ms)) {
+                    truck.command_task.set_command(cmd);
+                }
+            }
+            break;
+        }
+        case BridgeTopic::SETPOINT: {
+            NavigationSetpoint setpoint;
+            if (parse_bridge_setpoint(message, setpoint)) {
+                LOG_INFO(MAIN) << "event" << "setpoint_recv" << "truck_id" << truck.id
+                               << "tgt_x" << setpoint.target_position_x
+                               << "tgt_y" << setpoint.target_position_y
+                               << "speed" << setpoint.target_speed;
+                if (truck.input_freshness.record_arrival(InputTopic::SETPOINT, source_timestamp_ms, now_ms)) {
+                    truck.route_planner.set_target_waypoint(setpoint.target_position_x,
+                                                            setpoint.target_position_y,
+                                                            setpoint.target_speed);
+                }
+            }
+            break;
+        }
+        case BridgeTopic::OBSTACLES: {
+            std::vector<Obstacle> obstacles;
+            if (parse_bridge_obstacles(message, obstacles)) {
+                truck.input_freshness.record_arrival(InputTopic::OBSTACLES, source_timestamp_ms, now_ms);
+                truck.route_planner.update_obstacles(obstacles);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void Fleet::step(Truck& truck, bool force_update, long cycle_ms) {
+    TruckState state = truck.command_task.get_state();
+    truck.nav_task.set_truck_state(state);
+    truck.data_collector.set_truck_state(state);
+
+    SensorData current_sensor = truck.buffer.peek_latest();
+    NavigationSetpoint setpoint = truck.route_planner.calculate_adjusted_setpoint(
+        current_sensor.position_x, current_sensor.position_y);
+    int dx = setpoint.target_position_x - current_sensor.position_x;
+    int dy = setpoint.target_position_y - current_sensor.position_y;
+    setpoint.target_angle = static_cast<int>(std::atan2(dy, dx) * 180.0 / M_PI);
+    truck.nav_task.set_setpoint(setpoint);
+
+    ActuatorOutput nav_output = truck.nav_task.get_output();
+    truck.command_task.set_navigation_output(nav_output);
+    ActuatorOutput actuator_output = truck.command_task.get_actuator_output();
+
+    if (actuator_output.velocity != truck.last_actuator_output.velocity ||
+        actuator_output.steering != truck.last_actuator_output.steering ||
+        actuator_output.arrived != truck.last_actuator_output.arrived ||
+        force_update) {
+        write_bridge_actuator_output(truck.id, actuator_output, cycle_ms);
+        truck.last_actuator_output = actuator_output;
+    }
+
+    if (state.automatic != truck.last_state.automatic ||
+        state.fault != truck.last_state.fault ||
+        force_update) {
+        write_bridge_truck_state(truck.id, state, cycle_ms);
+        truck.last_state = state;
+    }
+}
@@ -0,0 +1,590 @@
+#include "flight_recorder.h"
+#include "change_signal.h"
+#include "deferred_log.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+namespace FlightRecorder {
+
+namespace {
+
+constexpr size_t PATH_BYTES = 512;
+constexpr int FATAL_SIGNALS[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+constexpr size_t FATAL_SIGNAL_COUNT = sizeof(FATAL_SIGNALS) / sizeof(FATAL_SIGNALS[0]);
+constexpr int RECORDER_POLL_MS = 200;
+
+/**
+ * @brief One thread's mapped ring (single writer: the owning thread)
+ */
+class FlightRing {
+public:
+    FlightRing(char* base, size_t data_bytes)
+        : header_(reinterpret_cast<FlightRingHeader*>(base)),
+          data_(base + FLIGHT_RING_HEADER_BYTES),
+          data_bytes_(data_bytes),
+          mask_(data_bytes - 1) {}
+
+    void push(const char* record, size_t size) {
+        uint16_t length = static_cast<uint16_t>(size);
+        size_t needed = sizeof(length) + size;
+        uint64_t write_pos = header_->write_pos.load(std::memory_order_relaxed);
+        uint64_t oldest = header_->oldest.load(std::memory_order_relaxed);
+
+        // Retire whole records until the new one fits, and publish the new
+        // oldest position before their bytes are overwritten.
+        while (write_pos + needed - oldest > data_bytes_) {
+            uint16_t old_length;
+            copy_out(oldest, reinterpret_cast<char*>(&old_length), sizeof(old_length));
+            oldest += sizeof(old_length) + old_length;
+        }
+        header_->oldest.store(oldest, std::memory_order_release);
+
+        copy_in(write_pos, reinterpret_cast<const char*>(&length), sizeof(length));
+        copy_in(write_pos + sizeof(length), record, size);
+        header_->write_pos.store(write_pos + needed, std::memory_order_release);
+    }
+
+    /**
+     * @brief Hand the ring to a new thread: clear its records, then set the tid
+     */
+    void reset(int tid) {
+        header_->write_pos.store(0, std::memory_order_relaxed);
+        header_->oldest.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        header_->tid = static_cast<int32_t>(tid);
+    }
+
+    const char* base() const { return reinterpret_cast<const char*>(header_); }
+    size_t mapped_bytes() const { return FLIGHT_RING_HEADER_BYTES + data_bytes_; }
+    int tid() const { return header_->tid; }
+
+private:
+    void copy_in(uint64_t position, const char* data, size_t size) {
+        size_t offset = static_cast<size_t>(position & mask_);
+        size_t first = std::min(size, data_bytes_ - offset);
+        std::memcpy(data_ + offset, data, first);
+        std::memcpy(data_, data + first, size - first);
+    }
+
+    void copy_out(uint64_t position, char* data, size_t size) const {
+        size_t offset = static_cast<size_t>(position & mask_);
+        size_t first = std::min(size, data_bytes_ - offset);
+        std::memcpy(data, data_ + offset, first);
+        std::memcpy(data + first, data_, size - first);
+    }
+
+    FlightRingHeader* header_;
+    char* data_;
+    size_t data_bytes_;     // Power of two
+    size_t mask_;
+};
+
+// Everything the signal-context dump reads is fixed-size and set up before
+// the handlers are installed; rings are never unmapped. A thread that exits
+// marks its slot EXITED and keeps its records (a restarted task's last
+// cycles) until a new thread needs the slot: slots never used are taken
+// first, then the one that exited longest ago.
+enum SlotState : int { SLOT_UNUSED = 0, SLOT_LIVE = 1, SLOT_EXITED = 2, SLOT_CLAIMED = 3 };
+
+std::atomic<bool> g_enabled{false};
+char g_directory[PATH_BYTES] = {};
+std::string g_ring_directory;
+size_t g_ring_bytes = FLIGHT_RECORDER_RING_BYTES;
+int64_t g_start_ticks = 0;
+int64_t g_start_wall_ns = 0;
+std::atomic<FlightRing*> g_rings[FLIGHT_RECORDER_MAX_THREADS];
+std::atomic<int> g_slot_states[FLIGHT_RECORDER_MAX_THREADS];
+std::atomic<long> g_slot_exit_order[FLIGHT_RECORDER_MAX_THREADS];
+std::atomic<long> g_exit_sequence{0};
+std::atomic<size_t> g_ring_count{0};            // Slots ever mapped (high-water mark)
+std::atomic<long> g_rings_reused{0};
+std::atomic<long> g_rings_refused{0};
+std::atomic<long> g_dump_sequence{0};
+std::atomic<long> g_dump_count{0};
+
+// Dump requests, serviced by the recorder thread
+std::atomic<const char*> g_pending_reason{nullptr};
+std::atomic<bool> g_pending_bypass{false};
+std::atomic<long> g_suppressed_dumps{0};
+ChangeSignal g_dump_signal;
+std::thread g_recorder_thread;
+std::atomic<bool> g_recorder_running{false};
+int64_t g_last_dump_ms = 0;                 // Recorder thread only
+const char* g_last_dump_reason = nullptr;   // Recorder thread only
+
+struct sigaction g_previous_actions[FATAL_SIGNAL_COUNT];
+
+int64_t wall_clock_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+int current_tid() {
+    return static_cast<int>(syscall(SYS_gettid));
+}
+
+// --- Async-signal-safe helpers (no allocation, no locks, no stdio) -------
+
+void append_text(char* buffer, size_t& length, const char* text) {
+    while (*text && length + 1 < PATH_BYTES) {
+        buffer[length++] = *text++;
+    }
+    buffer[length] = '\0';
+}
+
+void append_number(char* buffer, size_t& length, long long value) {
+    char digits[24];
+    size_t count = 0;
+    unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value)
+                                             : static_cast<unsigned long long>(value);
+    do {
+        digits[count++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        digits[count++] = '-';
+    }
+    char text[24];
+    for (size_t i = 0; i < count; i++) {
+        text[i] = digits[count - 1 - i];
+    }
+    text[count] = '\0';
+    append_text(buffer, length, text);
+}
+
+bool write_all(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = ::write(fd, p, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+void append_calibration_entry(char* entry, size_t& length, int64_t ticks, int64_t wall_ns) {
+    entry[length++] = static_cast<char>(Logger::DEFERRED_ENTRY_CALIBRATION);
+    std::memcpy(entry + length, &ticks, sizeof(ticks));
+    length += sizeof(ticks);
+    std::memcpy(entry + length, &wall_ns, sizeof(wall_ns));
+    length += sizeof(wall_ns);
+}
+
+bool write_sites_file(const char* path) {
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    char entry[64];
+    size_t length = 0;
+    std::memcpy(entry, Logger::DEFERRED_LOG_MAGIC, sizeof(Logger::DEFERRED_LOG_MAGIC));
+    length += sizeof(Logger::DEFERRED_LOG_MAGIC);
+    append_calibration_entry(entry, length, g_start_ticks, g_start_wall_ns);
+    append_calibration_entry(entry, length, Logger::deferred_ticks(), wall_clock_ns());
+    bool ok = write_all(fd, entry, length);
+
+    size_t site_count = Logger::deferred_site_count();
+    for (size_t index = 0; ok && index < site_count; index++) {
+        const Logger::CallSite* site = Logger::deferred_site(index);
+        if (!site) {
+            continue;
+        }
+        uint32_t id = site->id();
+        uint16_t format_length = static_cast<uint16_t>(std::strlen(site->format()));
+        length = 0;
+        entry[length++] = static_cast<char>(Logger::DEFERRED_ENTRY_SITE);
+        std::memcpy(entry + length, &id, sizeof(id));
+        length += sizeof(id);
+        entry[length++] = static_cast<char>(site->level());
+        entry[length++] = static_cast<char>(site->module());
+        std::memcpy(entry + length, &format_length, sizeof(format_length));
+        length += sizeof(format_length);
+        ok = write_all(fd, entry, length) && write_all(fd, site->format(), format_length);
+    }
+
+    ::close(fd);
+    return ok;
+}
+
+/**
+ * @brief Snapshot every ring into a new dump directory (async-signal-safe)
+ *
+ * @param reason Dump reason (directory suffix)
+ * @param out_path Receives the dump directory (PATH_BYTES)
+ * @return Number of rings written, or -1 if the directory failed
+ */
+int dump_rings(const char* reason, char* out_path) {
+    size_t length = 0;
+    out_path[0] = '\0';
+    append_text(out_path, length, g_directory);
+    append_text(out_path, length, "/dump_");
+    append_number(out_path, length, wall_clock_ns() / 1000000);
+    append_text(out_path, length, "_");
+    append_number(out_path, length, g_dump_sequence.fetch_add(1));
+    append_text(out_path, length, "_");
+    append_text(out_path, length, reason);
+    if (::mkdir(out_path, 0755) != 0 && errno != EEXIST) {
+        return -1;
+    }
+
+    char file_path[PATH_BYTES];
+    size_t file_length = 0;
+    file_path[0] = '\0';
+    append_text(file_path, file_length, out_path);
+    append_text(file_path, file_length, "/");
+    append_text(file_path, file_length, FLIGHT_DUMP_SITES_FILE);
+    write_sites_file(file_path);
+
+    int written = 0;
+    size_t ring_count = g_ring_count.load(std::memory_order_acquire);
+    for (size_t index = 0; index < ring_count; index++) {
+        FlightRing* ring = g_rings[index].load(std::memory_order_acquire);
+        if (!ring || g_slot_states[index].load(std::memory_order_acquire) == SLOT_CLAIMED) {
+            continue;
+        }
+        file_length = 0;
+        append_text(file_path, file_length, out_path);
+        append_text(file_path, file_length, "/ring_");
+        append_number(file_path, file_length, ring->tid());
+        append_text(file_path, file_length, ".bin");
+        int fd = ::open(file_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            continue;
+        }
+        if (write_all(fd, ring->base(), ring->mapped_bytes())) {
+            written++;
+        }
+        ::close(fd);
+    }
+    g_dump_count.fetch_add(1, std::memory_order_relaxed);
+    return written;
+}
+
+const char* fatal_signal_reason(int signal) {
+    switch (signal) {
+        case SIGSEGV: return "sigsegv";
+        case SIGBUS:  return "sigbus";
+        case SIGFPE:  return "sigfpe";
+        case SIGILL:  return "sigill";
+        case SIGABRT: return "sigabrt";
+        default:      return "signal";
+    }
+}
+
+void fatal_signal_handler(int signal) {
+    // SA_RESETHAND restored the default action; dump, then die normally
+    char path[PATH_BYTES];
+    dump_rings(fatal_signal_reason(signal), path);
+    ::raise(signal);
+}
+
+// --- Normal context --------------------------------------------------------
+
+std::string ring_file_path(int tid) {
+    return g_ring_directory + "/truck_flight_" + std::to_string(::getpid()) + "_" + std::to_string(tid) + ".bin";
+}
+
+/**
+ * @brief Take the slot of the thread that exited longest ago
+ *
+ * The ring file is renamed to the new tid and the ring cleared.
+ *
+ * @return Slot index, or -1 if every slot belongs to a live thread
+ */
+int reuse_exited_slot(int tid) {
+    while (true) {
+        int oldest = -1;
+        long oldest_order = 0;
+        for (size_t index = 0; index < FLIGHT_RECORDER_MAX_THREADS; index++) {
+            if (g_slot_states[index].load(std::memory_order_acquire) != SLOT_EXITED) {
+                continue;
+            }
+            long order = g_slot_exit_order[index].load(std::memory_order_relaxed);
+            if (oldest < 0 || order < oldest_order) {
+                oldest = static_cast<int>(index);
+                oldest_order = order;
+            }
+        }
+        if (oldest < 0) {
+            return -1;
+        }
+        int expected = SLOT_EXITED;
+        if (!g_slot_states[oldest].compare_exchange_strong(expected, SLOT_CLAIMED,
+                                                          std::memory_order_acq_rel)) {
+            continue;   // Another new thread took it first
+        }
+        FlightRing* ring = g_rings[oldest].load(std::memory_order_acquire);
+        ::rename(ring_file_path(ring->tid()).c_str(), ring_file_path(tid).c_str());
+        ring->reset(tid);
+        g_rings_reused.fetch_add(1, std::memory_order_relaxed);
+        return oldest;
+    }
+}
+
+/**
+ * @brief Map a new ring in a slot never used, or reuse an exited thread's
+ *
+ * @param slot Receives the slot index
+ */
+FlightRing* create_ring(int& slot) {
+    int tid = current_tid();
+    size_t index = g_ring_count.load(std::memory_order_relaxed);
+    while (index < FLIGHT_RECORDER_MAX_THREADS &&
+           !g_ring_count.compare_exchange_weak(index, index + 1, std::memory_order_acq_rel)) {
+    }
+    if (index >= FLIGHT_RECORDER_MAX_THREADS) {
+        slot = reuse_exited_slot(tid);
+        if (slot < 0) {
+            g_rings_refused.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        g_slot_states[slot].store(SLOT_LIVE, std::memory_order_release);
+        return g_rings[slot].load(std::memory_order_acquire);
+    }
+
+    std::string path = ring_file_path(tid);
+    size_t mapped_bytes = FLIGHT_RING_HEADER_BYTES + g_ring_bytes;
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0 || ::ftruncate(fd, static_cast<off_t>(mapped_bytes)) != 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        g_rings_refused.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    // MAP_POPULATE: page faults happen here, not in the RT loop
+    void* base = ::mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        g_rings_refused.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    FlightRingHeader* header = new (base) FlightRingHeader();
+    std::memcpy(header->magic, FLIGHT_RING_MAGIC, sizeof(FLIGHT_RING_MAGIC));
+    header->header_bytes = static_cast<uint32_t>(FLIGHT_RING_HEADER_BYTES);
+    header->data_bytes = static_cast<uint32_t>(g_ring_bytes);
+    header->pid = static_cast<int32_t>(::getpid());
+    header->tid = static_cast<int32_t>(tid);
+    header->oldest.store(0, std::memory_order_relaxed);
+    header->write_pos.store(0, std::memory_order_relaxed);
+
+    FlightRing* ring = new FlightRing(static_cast<char*>(base), g_ring_bytes);
+    g_rings[index].store(ring, std::memory_order_release);
+    g_slot_states[index].store(SLOT_LIVE, std::memory_order_release);
+    slot = static_cast<int>(index);
+    return ring;
+}
+
+// Sentinels for a thread's ring pointer (a thread_local with a trivial
+// destructor, so a record from a later thread_local destructor is safe)
+FlightRing g_refused_ring(nullptr, 1);      // Mapping failed or no slot: stop retrying
+FlightRing g_exited_ring(nullptr, 1);       // Thread is exiting: slot handed back
+
+thread_local FlightRing* t_ring = nullptr;
+
+/**
+ * @brief Hands the thread's slot back when the thread exits
+ */
+struct SlotRelease {
+    int slot = -1;
+    ~SlotRelease() {
+        t_ring = &g_exited_ring;
+        if (slot >= 0) {
+            g_slot_exit_order[slot].store(g_exit_sequence.fetch_add(1), std::memory_order_relaxed);
+            g_slot_states[slot].store(SLOT_EXITED, std::memory_order_release);
+        }
+    }
+};
+
+thread_local SlotRelease t_slot_release;
+
+void service_pending_dump() {
+    const char* reason = g_pending_reason.exchange(nullptr);
+    if (!reason) {
+        return;
+    }
+    bool bypass = g_pending_bypass.exchange(false);
+
+    int64_t now_ms = wall_clock_ns() / 1000000;
+    bool too_soon = g_last_dump_ms != 0 && now_ms - g_last_dump_ms < FLIGHT_RECORDER_MIN_DUMP_INTERVAL_MS;
+    bool repeated = too_soon && std::strcmp(reason, g_last_dump_reason) == 0;
+    if ((too_soon && !bypass) || repeated || g_dump_count.load() >= FLIGHT_RECORDER_MAX_DUMPS) {
+        g_suppressed_dumps.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    char path[PATH_BYTES];
+    int rings = dump_rings(reason, path);
+    g_last_dump_ms = now_ms;
+    g_last_dump_reason = reason;
+    if (rings < 0) {
+        LOG_ERR(MAIN) << "event" << "flight_dump_failed" << "reason" << reason << "path" << path;
+        return;
+    }
+    LOG_WARN(MAIN) << "event" << "flight_dump" << "reason" << reason << "rings" << rings
+                   << "path" << path;
+}
+
+void recorder_loop() {
+    uint32_t seen = g_dump_signal.version();
+    while (g_recorder_running.load()) {
+        g_dump_signal.wait_until(seen, std::chrono::steady_clock::now() +
+                                           std::chrono::milliseconds(RECORDER_POLL_MS));
+        seen = g_dump_signal.version();
+        service_pending_dump();
+    }
+}
+
+} // namespace
+
+bool start(const std::string& directory, size_t ring_bytes) {
+    if (g_enabled.load()) {
+        return true;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error || directory.size() >= PATH_BYTES / 2) {
+        LOG_ERR(MAIN) << "event" << "flight_recorder_start_failed" << "path" << directory;
+        return false;
+    }
+
+    std::strncpy(g_directory, directory.c_str(), sizeof(g_directory) - 1);
+    // tmpfs pages are never written back, so the kernel never write-protects
+    // them for dirty tracking and ring writes never fault.
+    g_ring_directory = std::filesystem::is_directory(FLIGHT_RECORDER_RING_DIRECTORY, error)
+                           ? FLIGHT_RECORDER_RING_DIRECTORY : directory;
+    // Power of two, so ring offsets are a mask rather than a division
+    g_ring_bytes = 4096;
+    while (g_ring_bytes < ring_bytes) {
+        g_ring_bytes <<= 1;
+    }
+    g_start_ticks = Logger::deferred_ticks();
+    g_start_wall_ns = wall_clock_ns();
+
+    for (size_t i = 0; i < FATAL_SIGNAL_COUNT; i++) {
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_handler = fatal_signal_handler;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESETHAND;
+        sigaction(FATAL_SIGNALS[i], &action, &g_previous_actions[i]);
+    }
+
+    g_recorder_running.store(true);
+    g_recorder_thread = std::thread(recorder_loop);
+    g_enabled.store(true, std::memory_order_release);
+    Logger::set_capture_all(true);
+
+    LOG_INFO(MAIN) << "event" << "flight_recorder_start" << "path" << directory
+                   << "ring_kb" << g_ring_bytes / 1024;
+    return true;
+}
+
+void stop() {
+    if (!g_enabled.exchange(false)) {
+        return;
+    }
+    Logger::set_capture_all(false);
+
+    g_recorder_running.store(false);
+    g_dump_signal.notify();
+    g_recorder_thread.join();
+    service_pending_dump();
+
+    for (size_t i = 0; i < FATAL_SIGNAL_COUNT; i++) {
+        sigaction(FATAL_SIGNALS[i], &g_previous_actions[i], nullptr);
+    }
+
+    // Mappings stay valid for threads still holding their ring; only the
+    // backing files go away.
+    size_t ring_count = g_ring_count.load();
+    for (size_t index = 0; index < ring_count; index++) {
+        FlightRing* ring = g_rings[index].load();
+        if (ring) {
+            ::unlink(ring_file_path(ring->tid()).c_str());
+        }
+    }
+
+    Stats stats = get_stats();
+    LOG_INFO(MAIN) << "event" << "flight_recorder_stop" << "dumps" << stats.dumps
+                   << "suppressed" << stats.suppressed_dumps << "rings" << stats.rings
+                   << "rings_reused" << stats.rings_reused << "rings_refused" << stats.rings_refused;
+}
+
+bool enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void record(const char* record, size_t size) {
+    FlightRing* ring = t_ring;
+    if (!ring) {
+        int slot = -1;
+        ring = create_ring(slot);
+        if (!ring) {
+            ring = &g_refused_ring;
+        } else {
+            t_slot_release.slot = slot;
+        }
+        t_ring = ring;
+    }
+    if (ring == &g_refused_ring || ring == &g_exited_ring || size + sizeof(uint16_t) > g_ring_bytes / 4) {
+        return;
+    }
+    ring->push(record, size);
+}
+
+void trigger(const char* reason, bool bypass_rate_limit) {
+    if (!g_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    // Set before the reason so the recorder never sees the reason without
+    // it; if a request is already queued, the bypass upgrades that one.
+    if (bypass_rate_limit) {
+        g_pending_bypass.store(true);
+    }
+    const char* expected = nullptr;
+    g_pending_reason.compare_exchange_strong(expected, reason);
+    g_dump_signal.notify();
+}
+
+long dump_count() {
+    return g_dump_count.load(std::memory_order_relaxed);
+}
+
+Stats get_stats() {
+    Stats stats;
+    stats.rings = g_ring_count.load(std::memory_order_relaxed);
+    stats.live_rings = 0;
+    for (size_t index = 0; index < stats.rings; index++) {
+        if (g_slot_states[index].load(std::memory_order_relaxed) == SLOT_LIVE) {
+            stats.live_rings++;
+        }
+    }
+    stats.rings_reused = g_rings_reused.load(std::memory_order_relaxed);
+    stats.rings_refused = g_rings_refused.load(std::memory_order_relaxed);
+    stats.dumps = g_dump_count.load(std::memory_order_relaxed);
+    stats.suppressed_dumps = g_suppressed_dumps.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace FlightRecorder
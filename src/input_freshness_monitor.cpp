@@ -0,0 +1,98 @@
+#include "input_freshness_monitor.h"
+#include "logger.h"
+#include <algorithm>
+#include <string>
+
+constexpr long MICROSECONDS_PER_MILLISECOND = 1000;
+
+static size_t topic_index(InputTopic topic) {
+    return static_cast<size_t>(topic);
+}
+
+InputFreshnessMonitor::InputFreshnessMonitor(
+    const std::array<InputFreshnessLimit, INPUT_TOPIC_COUNT>& limits,
+    PerformanceMonitor* perf_monitor)
+    : limits_(limits),
+      perf_monitor_(perf_monitor) {
+}
+
+bool InputFreshnessMonitor::record_arrival(InputTopic topic, long source_timestamp_ms,
+                                           long arrival_timestamp_ms) {
+    TopicState& state = topic_states_[topic_index(topic)];
+    const InputFreshnessLimit& limit = limits_[topic_index(topic)];
+
+    long effective_source_ms = source_timestamp_ms > 0 ? source_timestamp_ms : arrival_timestamp_ms;
+    long age_ms = std::max(arrival_timestamp_ms - effective_source_ms, 0L);
+
+    if (perf_monitor_) {
+        perf_monitor_->record_latency(std::string("InputAge.") + topic_name(topic),
+                                      age_ms * MICROSECONDS_PER_MILLISECOND);
+    }
+
+    long previous_ms = state.newest_source_timestamp_ms.load(std::memory_order_relaxed);
+    while (effective_source_ms > previous_ms &&
+           !state.newest_source_timestamp_ms.compare_exchange_weak(
+               previous_ms, effective_source_ms, std::memory_order_relaxed)) {
+    }
+
+    if (age_ms > limit.max_age_ms) {
+        state.stale_message_count.fetch_add(1, std::memory_order_relaxed);
+        LOG_WARN(MAIN) << "event" << "stale_input" << "topic" << topic_name(topic)
+                       << "age_ms" << age_ms << "limit_ms" << limit.max_age_ms;
+        return false;
+    }
+
+    return true;
+}
+
+FaultType InputFreshnessMonitor::evaluate(long now_ms) {
+    FaultType result = FaultType::NONE;
+
+    for (size_t i = 0; i < INPUT_TOPIC_COUNT; ++i) {
+        if (!limits_[i].expects_periodic_updates) {
+            continue;
+        }
+
+        InputTopic topic = static_cast<InputTopic>(i);
+        long age_ms = get_data_age_ms(topic, now_ms);
+        bool stale = age_ms > limits_[i].max_age_ms;
+        bool was_stale = topic_states_[i].stale_reported.exchange(stale, std::memory_order_relaxed);
+
+        if (stale) {
+            result = FaultType::STALE_DATA;
+        }
+
+        if (stale && !was_stale) {
+            LOG_CRIT(MAIN) << "event" << "input_stale" << "topic" << topic_name(topic)
+                           << "age_ms" << age_ms << "limit_ms" << limits_[i].max_age_ms;
+        } else if (!stale && was_stale) {
+            LOG_INFO(MAIN) << "event" << "input_fresh" << "topic" << topic_name(topic)
+                           << "age_ms" << age_ms;
+        }
+    }
+
+    return result;
+}
+
+long InputFreshnessMonitor::get_data_age_ms(InputTopic topic, long now_ms) const {
+    long newest_ms = topic_states_[topic_index(topic)].newest_source_timestamp_ms.load(
+        std::memory_order_relaxed);
+    if (newest_ms == 0) {
+        return -1;
+    }
+    return std::max(now_ms - newest_ms, 0L);
+}
+
+long InputFreshnessMonitor::get_stale_message_count(InputTopic topic) const {
+    return topic_states_[topic_index(topic)].stale_message_count.load(std::memory_order_relaxed);
+}
+
+const char* InputFreshnessMonitor::topic_name(InputTopic topic) {
+    switch (topic) {
+        case InputTopic::SENSORS:   return "sensors";
+        case InputTopic::COMMANDS:  return "commands";
+        case InputTopic::SETPOINT:  return "setpoint";
+        case InputTopic::OBSTACLES: return "obstacles";
+        default:                    return "unknown";
+    }
+}
@@ -1,5 +1,6 @@
 #include "local_interface.h"
 #include "logger.h"
+#include "rt_profile.h"
 #include <iostream>
 #include <iomanip>
 #include <chrono>
@@ -10,7 +11,9 @@ LocalInterface::LocalInterface(CircularBuffer& buffer, int update_period_ms, Per
     : buffer_(buffer),
       update_period_ms_(update_period_ms),
       running_(false),
-      perf_monitor_(perf_monitor) {
+      perf_monitor_(perf_monitor),
+      executor_(nullptr),
+      executor_job_(-1) {
     truck_state_.fault = false;
     truck_state_.automatic = false;
     latest_sensor_data_ = {};
@@ -29,6 +32,12 @@ void LocalInterface::start() {
     }
 
     running_ = true;
+    if (executor_) {
+        executor_job_ = executor_->add_periodic(WorkLane::LOW, "LocalInterface", update_period_ms_,
+                                                [this] { run_cycle(); });
+        LOG_INFO(LI) << "event" << "start" << "executor_job" << executor_job_;
+        return;
+    }
     task_thread_ = std::thread(&LocalInterface::task_loop, this);
 
     LOG_INFO(LI) << "event" << "start";
@@ -40,6 +49,10 @@ void LocalInterface::stop() {
     }
 
     running_ = false;
+    if (executor_) {
+        executor_->remove(executor_job_);
+        executor_job_ = -1;
+    }
 
     if (task_thread_.joinable()) {
         task_thread_.join();
@@ -58,29 +71,38 @@ void LocalInterface::set_actuator_output(const ActuatorOutput& output) {
     actuator_output_ = output;
 }
 
+void LocalInterface::set_executor(BestEffortExecutor* executor) {
+    executor_ = executor;
+}
+
 void LocalInterface::task_loop() {
+    RtProfile::enter_thread("LocalInterface");
     auto next_execution = std::chrono::steady_clock::now();
 
     while (running_) {
-        auto start_time = std::chrono::steady_clock::now();
+        run_cycle();
 
-        size_t buffer_count = buffer_.size();
-        SensorData sensor_data = buffer_.peek_latest();
+        next_execution += std::chrono::milliseconds(update_period_ms_);
+        std::this_thread::sleep_until(next_execution);
+    }
+}
 
-        {
-            std::lock_guard<std::mutex> lock(display_mutex_);
-            latest_sensor_data_ = sensor_data;
-            buffer_count_ = buffer_count;
-        }
+void LocalInterface::run_cycle() {
+    auto start_time = std::chrono::steady_clock::now();
 
-        display_status();
+    size_t buffer_count = buffer_.size();
+    SensorData sensor_data = buffer_.peek_latest();
 
-        if (perf_monitor_) {
-            perf_monitor_->end_measurement("LocalInterface", start_time);
-        }
+    {
+        std::lock_guard<std::mutex> lock(display_mutex_);
+        latest_sensor_data_ = sensor_data;
+        buffer_count_ = buffer_count;
+    }
 
-        next_execution += std::chrono::milliseconds(update_period_ms_);
-        std::this_thread::sleep_until(next_execution);
+    display_status();
+
+    if (perf_monitor_) {
+        perf_monitor_->end_measurement("LocalInterface", start_time);
     }
 }
 
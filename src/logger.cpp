@@ -1,9 +1,20 @@
 #include "logger.h"
+#include "deferred_log.h"
+#include "rotating_log_file.h"
+#include <atomic>
 #include <cstdlib>
 
 namespace Logger {
-static Level g_min_level = Level::INFO;
+static std::atomic<Level> g_min_level{Level::INFO};
+static std::atomic<Level> g_capture_level{Level::INFO};
+static std::atomic<bool> g_capture_all{false};
 static std::mutex g_log_mutex;
+static RotatingLogFile g_log_file;      // LOG_FILE destination (guarded by g_log_mutex)
+
+static void update_capture_level() {
+    g_capture_level.store(g_capture_all.load() ? Level::DEBUG : g_min_level.load(),
+                          std::memory_order_relaxed);
+}
 
 void init(Level min_level) {
     const char* env_level = std::getenv("LOG_LEVEL");
@@ -18,16 +29,60 @@ void init(Level min_level) {
     } else {
         g_min_level = min_level;
     }
+    update_capture_level();
+
+    const char* deferred_path = std::getenv("LOG_DEFERRED_FILE");
+    if (deferred_path && *deferred_path) {
+        enable_deferred(deferred_path);
+    }
+
+    const char* file_path = std::getenv("LOG_FILE");
+    if (file_path && *file_path) {
+        std::lock_guard<std::mutex> lock(g_log_mutex);
+        if (!g_log_file.open(file_path, "")) {
+            std::cerr << "LOG_FILE " << file_path << " could not be opened, logging to stdout" << std::endl;
+        }
+    }
 }
 
-void set_level(Level min_level) {
+void shutdown() {
+    disable_deferred();
     std::lock_guard<std::mutex> lock(g_log_mutex);
-    g_min_level = min_level;
+    g_log_file.close();
+}
+
+void set_level(Level min_level) {
+    g_min_level.store(min_level, std::memory_order_relaxed);
+    update_capture_level();
 }
 
 Level get_level() {
+    return g_min_level.load(std::memory_order_relaxed);
+}
+
+void set_capture_all(bool enabled) {
+    g_capture_all.store(enabled);
+    update_capture_level();
+}
+
+Level capture_level() {
+    return g_capture_level.load(std::memory_order_relaxed);
+}
+
+void write_line(Level level, Module module, const std::string& body) {
     std::lock_guard<std::mutex> lock(g_log_mutex);
-    return g_min_level;
+    if (g_log_file.is_open()) {
+        std::string line = std::to_string(timestamp_ms());
+        line.append("|").append(level_str(level)).append("|").append(module_str(module))
+            .append("|").append(body).append("\n");
+        g_log_file.append(line.data(), line.size());
+        return;
+    }
+    std::cout << timestamp_ms() << "|"
+              << level_str(level) << "|"
+              << module_str(module) << "|"
+              << body
+              << std::endl;
 }
 
 const char* level_str(Level level) {
@@ -72,12 +127,19 @@ LogStream::LogStream(Level level, Module module)
 LogStream::~LogStream() {
     if (!should_log_) return;
 
-    std::lock_guard<std::mutex> lock(g_log_mutex);
-    std::cout << timestamp_ms() << "|"
-              << level_str(level_) << "|"
-              << module_str(module_) << "|"
-              << stream_.str()
-              << std::endl;
+    std::string body = stream_.str();
+    if (FlightRecorder::enabled()) {
+        flight_record_text(level_, module_, body);
+    }
+    if (level_ == Level::CRIT) {
+        FlightRecorder::trigger("crit");
+    }
+
+    if (deferred_enabled()) {
+        log_deferred_text(level_, module_, body);
+        return;
+    }
+    write_line(level_, module_, body);
 }
 
 LogStream log(Level level, Module module) {
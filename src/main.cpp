@@ -8,8 +8,11 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <stdexcept>
 #include <cmath>
 #include "logger.h"
+#include "deferred_log.h"
+#include "flight_recorder.h"
 #include "circular_buffer.h"
 #include "sensor_processing.h"
 #include "command_logic.h"
@@ -18,8 +21,14 @@
 #include "route_planning.h"
 #include "data_collector.h"
 #include "local_interface.h"
+#include "best_effort_executor.h"
+#include "rt_profile.h"
 #include "watchdog.h"
 #include "performance_monitor.h"
+#include "input_freshness_monitor.h"
+#include "bridge_messages.h"
+#include "bridge_trace.h"
+#include "fleet.h"
 #include <sstream>
 #include <map>
 #include "json.hpp"
@@ -30,10 +39,18 @@ constexpr int FAULT_MONITORING_PERIOD_MS = 20;
 constexpr int NAVIGATION_CONTROL_PERIOD_MS = 10;
 constexpr int DATA_COLLECTOR_PERIOD_MS = 100;
 constexpr int LOCAL_INTERFACE_PERIOD_MS = 100;
+constexpr bool DATA_COLLECTOR_TELEMETRY_STORE = true;
+constexpr bool TELEMETRY_CAPTURE_ENABLED = true;
+constexpr size_t DATA_COLLECTOR_SEGMENT_BYTES = 64 * 1024 * 1024;
+constexpr long DATA_COLLECTOR_SEGMENT_MS = 60L * 60 * 1000;
+constexpr size_t DATA_COLLECTOR_RETAIN_SEGMENTS = 168;
+constexpr size_t DATA_COLLECTOR_RETAIN_BYTES = 1024L * 1024 * 1024;
 constexpr int NUMBER_OF_REGISTERED_TASKS_PERF = 6;
+constexpr FaultEvaluationMode FAULT_EVALUATION_MODE = FaultEvaluationMode::WRITE_TRIGGERED;
+constexpr long PREDICTIVE_TEMPERATURE_ALERT_HORIZON_MS = 5000;
 
 constexpr int CIRCULAR_BUFFER_SIZE = 200;
-constexpr int WATCHDOG_CHECK_PERIOD_MS = 100;
+constexpr int WATCHDOG_TICK_PERIOD_MS = 1;
 
 constexpr int SENSOR_PROCESSING_WATCHDOG_TIMEOUT_MS = 60;
 constexpr int COMMAND_LOGIC_WATCHDOG_TIMEOUT_MS = 30;
@@ -41,7 +58,21 @@ constexpr int FAULT_MONITORING_WATCHDOG_TIMEOUT_MS = 60;
 constexpr int NAVIGATION_CONTROL_WATCHDOG_TIMEOUT_MS = 30;
 constexpr int DATA_COLLECTOR_WATCHDOG_TIMEOUT_MS = 300;
 
+constexpr int WATCHDOG_RESTART_AFTER_FAILURES = 2;
+constexpr int WATCHDOG_MAX_RESTARTS_PER_OUTAGE = 1;
+constexpr int WATCHDOG_FAIL_FAST_AFTER_FAILURES = 20;
+
+constexpr long SENSOR_INPUT_MAX_AGE_MS = 200;
+constexpr long COMMAND_INPUT_MAX_AGE_MS = 500;
+constexpr long SETPOINT_INPUT_MAX_AGE_MS = 2000;
+constexpr long OBSTACLE_INPUT_MAX_AGE_MS = 1000;
+
 constexpr int SENSOR_FILTER_ORDER = 5;
+constexpr int BRIDGE_REPLAY_DRAIN_CYCLES = 2;     // Main loop cycles to consume the last replayed files
+constexpr int MAIN_LOOP_PERIOD_MS = 50;
+constexpr int STATE_UPDATE_INTERVAL = 4;          // Main loop cycles between forced to_mqtt writes
+constexpr size_t FLEET_DEFAULT_WORKERS = 4;
+constexpr size_t BEST_EFFORT_WORKERS = 2;
 int g_truck_id = 1;
 
 using json = nlohmann::json;
@@ -49,10 +80,13 @@ namespace fs = std::filesystem;
 
 std::atomic<bool> system_running(true);
 PerformanceMonitor* global_perf_monitor = nullptr;
+BridgeTraceWriter* g_bridge_recorder = nullptr;
+std::atomic<bool> g_replay_finished(false);
 
 void signal_handler(int signal) {
     if (signal == SIGINT) {
         LOG_INFO(MAIN) << "event" << "shutdown_signal";
+        FlightRecorder::trigger("sigint", true);
 
         if (global_perf_monitor) {
             std::cout << "\n";
@@ -64,199 +98,197 @@ void signal_handler(int signal) {
 }
 
 
-bool read_sensor_data_from_bridge(RawSensorData& data) {
-    const std::string bridge_dir = "bridge/from_mqtt";
-    std::vector<fs::path> sensor_files;
-    std::string search_pattern = "truck_" + std::to_string(g_truck_id) + "_sensors";
-
-    try {
-        if (!fs::exists(bridge_dir)) {
-            return false;
-        }
-        
-        for (const auto& entry : fs::directory_iterator(bridge_dir)) {
-            if (entry.path().extension() == ".json" &&
-                entry.path().filename().string().find(search_pattern) != std::string::npos) {
-                sensor_files.push_back(entry.path());
-            }
+void record_bridge_files(BridgeTopic topic, const std::vector<fs::path>& files) {
+    if (!g_bridge_recorder) {
+        return;
+    }
+    for (const auto& path : files) {
+        if (!g_bridge_recorder->record(topic, path.string())) {
+            LOGF_RATE_LIMITED(WARN, MAIN, 1, 1, "event=bridge_record_failed,topic", bridge_topic_name(topic));
         }
+    }
+}
 
-        if (sensor_files.empty()) {
-            return false;
-        }
+/**
+ * @brief This truck's bridge files of a topic, oldest first
+ */
+std::vector<fs::path> list_bridge_files(const char* topic_name) {
+    std::vector<fs::path> files;
+    std::string search_pattern = "truck_" + std::to_string(g_truck_id) + "_" + topic_name;
 
-    
-        std::sort(sensor_files.begin(), sensor_files.end());
-
-        
-        bool success = false;
-        const auto& newest_file = sensor_files.back();
-
-        std::ifstream file(newest_file);
-        if (file.is_open()) {
-            json j = json::parse(file);
-            file.close();
-
-            if (j.contains("payload")) {
-                auto& payload = j["payload"];
-                data.position_x = payload.value("position_x", 0);
-                data.position_y = payload.value("position_y", 0);
-                data.angle_x = payload.value("angle_x", 0);
-                data.temperature = payload.value("temperature", 0);
-                data.fault_electrical = payload.value("fault_electrical", false);
-                data.fault_hydraulic = payload.value("fault_hydraulic", false);
-                success = true;
-            }
-        }
+    if (!fs::exists(BRIDGE_FROM_MQTT_DIR)) {
+        return files;
+    }
 
-        for (const auto& path : sensor_files) {
-            fs::remove(path);
+    for (const auto& entry : fs::directory_iterator(BRIDGE_FROM_MQTT_DIR)) {
+        if (entry.path().extension() == ".json" &&
+            entry.path().filename().string().find(search_pattern) != std::string::npos) {
+            files.push_back(entry.path());
         }
+    }
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
 
-        return success;
+void remove_bridge_files(BridgeTopic topic, const std::vector<fs::path>& files) {
+    record_bridge_files(topic, files);
+    for (const auto& path : files) {
+        fs::remove(path);
+    }
+}
 
-    } catch (const std::exception& e) { }
+/**
+ * @brief Parse the newest bridge file of this truck's topic, then remove them all
+ *
+ * A file that fails to parse throws before anything is removed, so a file
+ * the bridge is still writing is read again on the next cycle.
+ */
+bool take_newest_bridge_message(const char* topic_name, BridgeTopic topic, json& message) {
+    std::vector<fs::path> files = list_bridge_files(topic_name);
+    if (files.empty()) {
+        return false;
+    }
 
-    return false;
+    bool parsed = false;
+    std::ifstream file(files.back());
+    if (file.is_open()) {
+        message = json::parse(file);
+        parsed = true;
+    }
+
+    remove_bridge_files(topic, files);
+    return parsed;
 }
 
+/**
+ * @brief Parse every bridge file of this truck's topic in order, removing those parsed
+ *
+ * For topics whose messages are discrete events (commands), where keeping
+ * only the newest would drop the others. Each file is parsed on its own, so
+ * a corrupt one never holds back the files after it: it is left in place
+ * while it may still be mid-write, then removed with a bridge_parse_err.
+ */
+bool take_all_bridge_messages(const char* topic_name, BridgeTopic topic, std::vector<json>& messages) {
+    std::vector<fs::path> parsed;
+
+    for (const auto& path : list_bridge_files(topic_name)) {
+        json message;
+        switch (read_bridge_file(path.string(), message)) {
+        case BridgeFileRead::PARSED:
+            messages.push_back(std::move(message));
+            parsed.push_back(path);
+            break;
+        case BridgeFileRead::PENDING:
+            break;
+        case BridgeFileRead::INVALID: {
+            LOG_ERR(MAIN) << "event" << "bridge_parse_err" << "topic" << topic_name
+                          << "file" << path.filename().string();
+            std::error_code error;
+            fs::remove(path, error);
+            break;
+        }
+        }
+    }
 
-bool read_commands_from_bridge(OperatorCommand& cmd) {
-    const std::string bridge_dir = "bridge/from_mqtt";
-    std::vector<fs::path> command_files;
-    std::string search_pattern = "truck_" + std::to_string(g_truck_id) + "_commands";
+    remove_bridge_files(topic, parsed);
+    return !messages.empty();
+}
 
+bool read_sensor_data_from_bridge(RawSensorData& data, long& source_timestamp_ms) {
     try {
-        if (!fs::exists(bridge_dir)) {
+        json message;
+        if (!take_newest_bridge_message("sensors", BridgeTopic::SENSORS, message)) {
             return false;
         }
+        source_timestamp_ms = bridge_message_timestamp_ms(message);
+        return parse_bridge_sensors(message, data);
 
-        for (const auto& entry : fs::directory_iterator(bridge_dir)) {
-            if (entry.path().extension() == ".json" &&
-                entry.path().filename().string().find(search_pattern) != std::string::npos) {
-                command_files.push_back(entry.path());
-            }
-        }
+    } catch (const std::exception& e) { }
 
-        if (command_files.empty()) {
-            return false;
-        }
+    return false;
+}
 
-    
-        std::sort(command_files.begin(), command_files.end());
-
-    
-        bool success = false;
-        const auto& newest_file = command_files.back();
-
-        std::ifstream file(newest_file);
-        if (file.is_open()) {
-            json j = json::parse(file);
-            file.close();
-
-            if (j.contains("payload")) {
-                auto& payload = j["payload"];
-
-                bool has_auto_mode = payload.contains("auto_mode");
-                bool has_manual_mode = payload.contains("manual_mode");
-                bool has_rearm = payload.contains("rearm");
-                bool has_accelerate = payload.contains("accelerate");
-                bool has_steer_left = payload.contains("steer_left");
-                bool has_steer_right = payload.contains("steer_right");
-
-                if (has_auto_mode || has_manual_mode || has_rearm ||
-                    has_accelerate || has_steer_left || has_steer_right) {
-                    cmd.auto_mode = payload.value("auto_mode", false);
-                    cmd.manual_mode = payload.value("manual_mode", false);
-                    cmd.rearm = payload.value("rearm", false);
-                    cmd.accelerate = payload.value("accelerate", 0);
-                    cmd.steer_left = payload.value("steer_left", 0);
-                    cmd.steer_right = payload.value("steer_right", 0);
-
-                    if (cmd.auto_mode || cmd.manual_mode || cmd.rearm) {
-                        LOG_INFO(MAIN) << "event" << "cmd_recv"
-                                       << "auto" << cmd.auto_mode
-                                       << "manual" << cmd.manual_mode
-                                       << "rearm" << cmd.rearm;
-                    }
-                    
-                    if (has_accelerate || has_steer_left || has_steer_right) {
-                         LOG_DEBUG(MAIN) << "event" << "cmd_manual" 
-                                         << "acc" << cmd.accelerate
-                                         << "left" << cmd.steer_left
-                                         << "right" << cmd.steer_right;
-                    }
-                    success = true;
-                }
-            }
-        }
 
-        for (const auto& path : command_files) {
-            fs::remove(path);
-        }
+/**
+ * @brief Operator command read from the bridge with its source timestamp
+ */
+struct BridgeCommand {
+    OperatorCommand command;
+    long source_timestamp_ms;
+};
 
-        return success;
+bool parse_command_message(const json& message, OperatorCommand& cmd) {
+    if (!parse_bridge_command(message, cmd)) {
+        return false;
+    }
 
-    } catch (const std::exception& e) {
-        // Log error
+    if (cmd.auto_mode || cmd.manual_mode || cmd.rearm) {
+        LOG_INFO(MAIN) << "event" << "cmd_recv"
+                       << "auto" << cmd.auto_mode
+                       << "manual" << cmd.manual_mode
+                       << "rearm" << cmd.rearm;
     }
 
-    return false;
+    const json& payload = message["payload"];
+    if (payload.contains("accelerate") || payload.contains("steer_left") || payload.contains("steer_right")) {
+         LOG_DEBUG(MAIN) << "event" << "cmd_manual" 
+                         << "acc" << cmd.accelerate
+                         << "left" << cmd.steer_left
+                         << "right" << cmd.steer_right;
+    }
+    return true;
 }
 
-
-bool read_setpoint_from_bridge(NavigationSetpoint& setpoint) {
-    const std::string bridge_dir = "bridge/from_mqtt";
-    std::vector<fs::path> setpoint_files;
-    std::string search_pattern = "truck_" + std::to_string(g_truck_id) + "_setpoint";
-
+/**
+ * @brief Read every pending command file, oldest first
+ *
+ * Each file is one discrete operator action ("rearm" then "auto" in the
+ * same poll must both reach CommandLogic), so none is dropped in favour of
+ * the newest.
+ */
+bool read_commands_from_bridge(std::vector<BridgeCommand>& commands) {
+    std::vector<json> messages;
     try {
-        if (!fs::exists(bridge_dir)) {
+        if (!take_all_bridge_messages("commands", BridgeTopic::COMMANDS, messages)) {
             return false;
         }
+    } catch (const std::exception& e) {
+        LOGF_RATE_LIMITED(ERR, MAIN, 1, 1, "event=bridge_parse_err,topic,error", "commands", e.what());
+        return false;
+    }
 
-        for (const auto& entry : fs::directory_iterator(bridge_dir)) {
-            if (entry.path().extension() == ".json" &&
-                entry.path().filename().string().find(search_pattern) != std::string::npos) {
-                setpoint_files.push_back(entry.path());
+    for (const json& message : messages) {
+        try {
+            BridgeCommand command{OperatorCommand{}, bridge_message_timestamp_ms(message)};
+            if (parse_command_message(message, command.command)) {
+                commands.push_back(command);
             }
+        } catch (const std::exception& e) {
+            LOGF_RATE_LIMITED(ERR, MAIN, 1, 1, "event=bridge_parse_err,topic,error", "commands", e.what());
         }
+    }
 
-        if (setpoint_files.empty()) {
-            return false;
-        }
+    return !commands.empty();
+}
 
-        
-        std::sort(setpoint_files.begin(), setpoint_files.end());
-
-        
-        bool success = false;
-        const auto& newest_file = setpoint_files.back();
-
-        std::ifstream file(newest_file);
-        if (file.is_open()) {
-            json j = json::parse(file);
-            file.close();
-
-            if (j.contains("payload")) {
-                auto& payload = j["payload"];
-                setpoint.target_position_x = payload.value("target_x", 0);
-                setpoint.target_position_y = payload.value("target_y", 0);
-                setpoint.target_speed = payload.value("target_speed", 0);
-                
-                LOG_INFO(MAIN) << "event" << "setpoint_recv"
-                               << "tgt_x" << setpoint.target_position_x
-                               << "tgt_y" << setpoint.target_position_y
-                               << "speed" << setpoint.target_speed;
-                success = true;
-            }
-        }
 
-        for (const auto& path : setpoint_files) {
-            fs::remove(path);
+bool read_setpoint_from_bridge(NavigationSetpoint& setpoint, long& source_timestamp_ms) {
+    try {
+        json message;
+        if (!take_newest_bridge_message("setpoint", BridgeTopic::SETPOINT, message)) {
+            return false;
+        }
+        source_timestamp_ms = bridge_message_timestamp_ms(message);
+        if (!parse_bridge_setpoint(message, setpoint)) {
+            return false;
         }
 
-        return success;
+        LOG_INFO(MAIN) << "event" << "setpoint_recv"
+                       << "tgt_x" << setpoint.target_position_x
+                       << "tgt_y" << setpoint.target_position_y
+                       << "speed" << setpoint.target_speed;
+        return true;
 
     } catch (const std::exception& e) {
         // Log error
@@ -265,122 +297,174 @@ bool read_setpoint_from_bridge(NavigationSetpoint& setpoint) {
     return false;
 }
 
-bool read_obstacles_from_bridge(std::vector<Obstacle>& obstacles) {
-    const std::string bridge_dir = "bridge/from_mqtt";
-    std::vector<fs::path> obstacle_files;
-    std::string search_pattern = "truck_" + std::to_string(g_truck_id) + "_obstacles";
-
+bool read_obstacles_from_bridge(std::vector<Obstacle>& obstacles, long& source_timestamp_ms) {
     try {
-        if (!fs::exists(bridge_dir)) return false;
-
-        for (const auto& entry : fs::directory_iterator(bridge_dir)) {
-            if (entry.path().extension() == ".json" &&
-                entry.path().filename().string().find(search_pattern) != std::string::npos) {
-                obstacle_files.push_back(entry.path());
-            }
-        }
-
-        if (obstacle_files.empty()) return false;
-
-        std::sort(obstacle_files.begin(), obstacle_files.end());
-        const auto& newest_file = obstacle_files.back();
-        bool success = false;
-
-        std::ifstream file(newest_file);
-        if (file.is_open()) {
-            json j = json::parse(file);
-            file.close();
-            if (j.contains("payload") && j["payload"].contains("obstacles")) {
-                obstacles.clear();
-                for (const auto& item : j["payload"]["obstacles"]) {
-                    Obstacle obs;
-                    obs.id = item.value("id", 0);
-                    obs.x = item.value("x", 0);
-                    obs.y = item.value("y", 0);
-                    obstacles.push_back(obs);
-                }
-                success = true;
-            }
-        }
-        
-        for (const auto& path : obstacle_files) {
-            fs::remove(path);
-        }
-        return success;
+        json message;
+        if (!take_newest_bridge_message("obstacles", BridgeTopic::OBSTACLES, message)) return false;
+        source_timestamp_ms = bridge_message_timestamp_ms(message);
+        return parse_bridge_obstacles(message, obstacles);
     } catch (...) { return false; }
 }
 
 
-void write_actuator_commands_to_bridge(int truck_id, const ActuatorOutput& output) {
-    const std::string bridge_dir = "bridge/to_mqtt";
+template <typename Task>
+Watchdog::RecoveryPolicy make_task_recovery_policy(Task& task, CommandLogic* safe_output_owner) {
+    Watchdog::RecoveryPolicy policy;
+    if (safe_output_owner) {
+        policy.enter_safe_state = [safe_output_owner]() { safe_output_owner->engage_safe_output(); };
+        policy.on_recovered = [safe_output_owner]() { safe_output_owner->release_safe_output(); };
+    }
+    policy.restart_task = [&task]() {
+        task.stop();
+        task.start();
+    };
+    policy.restart_after_failures = WATCHDOG_RESTART_AFTER_FAILURES;
+    policy.max_restarts_per_outage = WATCHDOG_MAX_RESTARTS_PER_OUTAGE;
+    policy.fail_fast_after_failures = WATCHDOG_FAIL_FAST_AFTER_FAILURES;
+    return policy;
+}
 
-    try {
-        if (!fs::exists(bridge_dir)) {
-            fs::create_directories(bridge_dir);
-        }
+std::array<InputFreshnessLimit, INPUT_TOPIC_COUNT> input_freshness_limits() {
+    return {{
+        {SENSOR_INPUT_MAX_AGE_MS, true},
+        {COMMAND_INPUT_MAX_AGE_MS, false},
+        {SETPOINT_INPUT_MAX_AGE_MS, false},
+        {OBSTACLE_INPUT_MAX_AGE_MS, false}
+    }};
+}
 
-        auto now = std::chrono::system_clock::now();
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch());
-        long timestamp = ms.count();
-
-        std::ostringstream filename;
-        filename << bridge_dir << "/" << timestamp << "_truck_" << truck_id << "_commands.json";
-
-        json j = {
-            {"topic", "truck/" + std::to_string(truck_id) + "/commands"},
-            {"payload", {
-                {"acceleration", output.velocity},
-                {"steering", output.steering},
-                {"arrived", output.arrived}
-            }}
-        };
-
-        std::ofstream file(filename.str());
-        if (file.is_open()) {
-            file << j.dump(2);
-            file.close();
-        }
+RotatingLogConfig data_collector_log_rotation() {
+    RotatingLogConfig log_rotation;
+    log_rotation.segment_bytes = DATA_COLLECTOR_SEGMENT_BYTES;
+    log_rotation.segment_ms = DATA_COLLECTOR_SEGMENT_MS;
+    log_rotation.retain_segments = DATA_COLLECTOR_RETAIN_SEGMENTS;
+    log_rotation.retain_bytes = DATA_COLLECTOR_RETAIN_BYTES;
+    return log_rotation;
+}
 
-    } catch (const std::exception& e) {
+/**
+ * @brief CPUs of the best-effort workers, from BEST_EFFORT_CPUS ("2-3")
+ *
+ * The RT profile's "BestEffort" set takes precedence. Unset or invalid
+ * leaves the workers unpinned. Pick CPUs the SCHED_FIFO tasks do not run on.
+ */
+std::vector<int> best_effort_cpus() {
+    std::vector<int> cpus = RtProfile::role_cpus("BestEffort");
+    if (!cpus.empty()) {
+        return cpus;
+    }
+    const char* text = std::getenv("BEST_EFFORT_CPUS");
+    if (text && *text && !RtProfile::parse_cpu_list(text, cpus)) {
+        LOG_WARN(MAIN) << "event" << "best_effort_cpus_invalid" << "value" << text;
+        cpus.clear();
     }
+    return cpus;
 }
 
-void write_truck_state_to_bridge(int truck_id, const TruckState& state) {
-    const std::string bridge_dir = "bridge/to_mqtt";
-
+/**
+ * @brief truck_control --fleet <first_truck_id> <count> [workers]
+ *
+ * Hosts count trucks, IDs first_truck_id onwards, in this process.
+ */
+int run_fleet(int argc, char* argv[]) {
+    FleetConfig config;
+    config.workers = FLEET_DEFAULT_WORKERS;
     try {
-        if (!fs::exists(bridge_dir)) {
-            fs::create_directories(bridge_dir);
+        if (argc < 4) {
+            throw std::invalid_argument("missing arguments");
         }
-
-        auto now = std::chrono::system_clock::now();
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch());
-        long timestamp = ms.count();
-
-        std::ostringstream filename;
-        filename << bridge_dir << "/" << timestamp << "_truck_" << truck_id << "_state.json";
-
-        json j = {
-            {"topic", "truck/" + std::to_string(truck_id) + "/state"},
-            {"payload", {
-                {"automatic", state.automatic},
-                {"fault", state.fault}
-            }}
-        };
-
-        std::ofstream file(filename.str());
-        if (file.is_open()) {
-            file << j.dump(2);
-            file.close();
+        config.first_truck_id = std::stoi(argv[2]);
+        config.truck_count = std::stoi(argv[3]);
+        if (argc > 4) {
+            config.workers = static_cast<size_t>(std::stoul(argv[4]));
         }
-
-    } catch (const std::exception& e) {
+        if (config.truck_count < 1 || config.workers < 1) {
+            throw std::invalid_argument("count and workers must be positive");
+        }
+    } catch (const std::exception&) {
+        std::cerr << "usage: " << argv[0] << " --fleet <first_truck_id> <count> [workers]" << std::endl;
+        return 2;
     }
+
+    config.main_loop_period_ms = MAIN_LOOP_PERIOD_MS;
+    config.state_update_interval = STATE_UPDATE_INTERVAL;
+    config.sensor_filter_order = SENSOR_FILTER_ORDER;
+    config.sensor_processing_period_ms = SENSOR_PROCESSING_PERIOD_MS;
+    config.command_logic_period_ms = COMMAND_LOGIC_PERIOD_MS;
+    config.fault_monitoring_period_ms = FAULT_MONITORING_PERIOD_MS;
+    config.navigation_control_period_ms = NAVIGATION_CONTROL_PERIOD_MS;
+    config.data_collector_period_ms = DATA_COLLECTOR_PERIOD_MS;
+    config.watchdog_tick_ms = WATCHDOG_TICK_PERIOD_MS;
+    config.sensor_processing_timeout_ms = SENSOR_PROCESSING_WATCHDOG_TIMEOUT_MS;
+    config.command_logic_timeout_ms = COMMAND_LOGIC_WATCHDOG_TIMEOUT_MS;
+    config.fault_monitoring_timeout_ms = FAULT_MONITORING_WATCHDOG_TIMEOUT_MS;
+    config.navigation_control_timeout_ms = NAVIGATION_CONTROL_WATCHDOG_TIMEOUT_MS;
+    config.data_collector_timeout_ms = DATA_COLLECTOR_WATCHDOG_TIMEOUT_MS;
+    config.restart_after_failures = WATCHDOG_RESTART_AFTER_FAILURES;
+    config.max_restarts_per_outage = WATCHDOG_MAX_RESTARTS_PER_OUTAGE;
+    config.fault_evaluation_mode = FAULT_EVALUATION_MODE;
+    config.predictive_alert_horizon_ms = PREDICTIVE_TEMPERATURE_ALERT_HORIZON_MS;
+    config.input_limits = input_freshness_limits();
+    config.telemetry_store = DATA_COLLECTOR_TELEMETRY_STORE;
+    config.log_rotation = data_collector_log_rotation();
+    config.best_effort_workers = BEST_EFFORT_WORKERS;
+    config.best_effort_cpus = best_effort_cpus();
+
+    std::signal(SIGINT, signal_handler);
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "Autonomous Mining Truck Control System" << std::endl;
+    std::cout << "Fleet: trucks " << config.first_truck_id << ".."
+              << config.first_truck_id + config.truck_count - 1 << ", " << config.workers << " workers" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    LOG_INFO(MAIN) << "event" << "system_start" << "mode" << "fleet"
+                   << "first_truck_id" << config.first_truck_id << "trucks" << config.truck_count;
+
+    Fleet fleet(config);
+    global_perf_monitor = &fleet.get_perf_monitor();
+    fleet.start();
+    fleet.run(system_running);
+
+    LOG_INFO(MAIN) << "event" << "shutdown_start";
+    fleet.stop();
+    global_perf_monitor = nullptr;
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Fleet shutdown complete." << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    LOG_INFO(MAIN) << "event" << "shutdown_complete";
+    FlightRecorder::stop();
+    Logger::shutdown();
+
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
 
     Logger::init(Logger::Level::INFO);
+    FlightRecorder::start(FLIGHT_RECORDER_DIRECTORY);
+
+    // Before any task thread, so they inherit the "Main" CPUs and locked memory
+    const char* profile_path = std::getenv("RT_PROFILE_FILE");
+    if (profile_path && *profile_path) {
+        RtProfile::Config profile;
+        std::string error;
+        if (!RtProfile::load(profile_path, profile, error)) {
+            LOG_ERR(MAIN) << "event" << "rt_profile_invalid" << "path" << profile_path << "error" << error;
+            return 1;
+        }
+        if (!RtProfile::apply(profile)) {
+            LOG_ERR(MAIN) << "event" << "rt_profile_failed" << "path" << profile_path << "strict" << true;
+            return 1;
+        }
+    }
+    RtProfile::enter_thread("Main");
+
+    if (argc > 1 && std::string(argv[1]) == "--fleet") {
+        return run_fleet(argc, argv);
+    }
 
     if (argc > 1) {
         try {
@@ -390,6 +474,35 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    BridgeTraceWriter bridge_recorder;
+    const char* record_path = std::getenv("BRIDGE_RECORD_FILE");
+    if (record_path && *record_path) {
+        if (bridge_recorder.open(record_path, g_truck_id)) {
+            g_bridge_recorder = &bridge_recorder;
+            LOG_INFO(MAIN) << "event" << "bridge_record_start" << "path" << record_path;
+        } else {
+            LOG_ERR(MAIN) << "event" << "bridge_record_failed" << "path" << record_path;
+        }
+    }
+
+    const char* replay_speed = std::getenv("BRIDGE_REPLAY_SPEED");
+    BridgeReplayer bridge_replayer(replay_speed ? std::atof(replay_speed) : 1.0, "bridge/from_mqtt");
+    const char* replay_path = std::getenv("BRIDGE_REPLAY_FILE");
+    bool replaying = false;
+    if (replay_path && *replay_path) {
+        replaying = bridge_replayer.start(replay_path, []() { g_replay_finished = true; });
+        if (!replaying) {
+            LOG_ERR(MAIN) << "event" << "replay_open_failed" << "path" << replay_path;
+            return 1;
+        }
+        // Replayed file names carry the recorded truck's ID
+        if (bridge_replayer.truck_id() != g_truck_id) {
+            LOG_WARN(MAIN) << "event" << "replay_truck_id" << "from" << g_truck_id
+                           << "to" << bridge_replayer.truck_id();
+            g_truck_id = bridge_replayer.truck_id();
+        }
+    }
+
     std::signal(SIGINT, signal_handler);
 
     std::cout << "========================================" << std::endl;
@@ -412,9 +525,16 @@ int main(int argc, char* argv[]) {
 
     LOG_INFO(MAIN) << "event" << "perf_monitor_init" << "tasks" << NUMBER_OF_REGISTERED_TASKS_PERF;
 
+    BestEffortExecutor best_effort(BEST_EFFORT_WORKERS, BEST_EFFORT_DEFAULT_MAX_JOBS, &perf_monitor);
+    best_effort.set_cpu_affinity(best_effort_cpus());
+
+    InputFreshnessMonitor input_freshness(input_freshness_limits(), &perf_monitor);
+
     CircularBuffer buffer;
     LOG_INFO(MAIN) << "event" << "buffer_create" << "size" << CIRCULAR_BUFFER_SIZE;
 
+    TelemetryCapture telemetry_capture;
+
 
     LOG_DEBUG(MAIN) << "event" << "creating_tasks";
 
@@ -428,27 +548,68 @@ int main(int argc, char* argv[]) {
 
     LOG_DEBUG(MAIN) << "event" << "tasks_created";
 
+    if (TELEMETRY_CAPTURE_ENABLED) {
+        sensor_task.set_telemetry_capture(&telemetry_capture);
+        command_task.set_telemetry_capture(&telemetry_capture);
+        data_collector.set_telemetry_capture(&telemetry_capture);
+    }
+
+    fault_task.set_executor(&best_effort);
+    data_collector.set_executor(&best_effort);
+    local_interface.set_executor(&best_effort);
+
+    command_task.set_fault_status(&fault_task.get_fault_status());
+    fault_task.add_fault_listener(&command_task.get_input_signal());
+    nav_task.set_fault_status(&fault_task.get_fault_status());
+
     fault_task.register_fault_callback(
         [&](FaultType type, const SensorData& data) {
-            command_task.on_fault_update(type);
-            nav_task.on_fault_update(type);
-            
             std::string desc = "Fault detected: " + std::to_string(static_cast<int>(type));
             if (type == FaultType::NONE) {
                 desc = "Fault cleared";
             }
-            data_collector.log_event(type == FaultType::NONE ? "OK" : "FAULT", 
-                                   data.position_x, data.position_y, desc);
+            data_collector.log_event(type == FaultType::NONE ? "OK" : "FAULT",
+                                     data.position_x, data.position_y, desc, LogDurability::DURABLE);
+        }
+    );
+    fault_task.register_advisory_callback(
+        [&](bool active, const SensorData& data) {
+            data_collector.log_event("ADVISORY", data.position_x, data.position_y,
+                                     active ? "Temperature trend alert" : "Temperature trend cleared");
         }
     );
 
-    Watchdog watchdog(WATCHDOG_CHECK_PERIOD_MS);
+    fault_task.set_input_freshness_monitor(&input_freshness);
+    fault_task.set_evaluation_mode(FAULT_EVALUATION_MODE);
+    fault_task.set_predictive_alert_horizon(PREDICTIVE_TEMPERATURE_ALERT_HORIZON_MS);
+    if (FAULT_EVALUATION_MODE == FaultEvaluationMode::WRITE_TRIGGERED) {
+        sensor_task.set_sample_hook(
+            [&fault_task](const RawSensorData& raw, const SensorData& filtered, long long raw_arrival_ns) {
+                fault_task.on_sensor_sample(raw, filtered, raw_arrival_ns);
+            });
+    }
+
+    Watchdog watchdog(WATCHDOG_TICK_PERIOD_MS, DEFAULT_MAX_MONITORED_TASKS, &perf_monitor);
     Watchdog::set_instance(&watchdog);
-    watchdog.register_task("SensorProcessing", SENSOR_PROCESSING_WATCHDOG_TIMEOUT_MS);
-    watchdog.register_task("CommandLogic", COMMAND_LOGIC_WATCHDOG_TIMEOUT_MS);
-    watchdog.register_task("FaultMonitoring", FAULT_MONITORING_WATCHDOG_TIMEOUT_MS);
-    watchdog.register_task("NavigationControl",NAVIGATION_CONTROL_WATCHDOG_TIMEOUT_MS);
-    watchdog.register_task("DataCollector", DATA_COLLECTOR_WATCHDOG_TIMEOUT_MS);
+    sensor_task.set_heartbeat_handle(
+        watchdog.register_task("SensorProcessing", SENSOR_PROCESSING_WATCHDOG_TIMEOUT_MS));
+    command_task.set_heartbeat_handle(
+        watchdog.register_task("CommandLogic", COMMAND_LOGIC_WATCHDOG_TIMEOUT_MS));
+    command_task.set_idle_wakeup_ms(COMMAND_LOGIC_WATCHDOG_TIMEOUT_MS / 2);
+    fault_task.set_heartbeat_handle(
+        watchdog.register_task("FaultMonitoring", FAULT_MONITORING_WATCHDOG_TIMEOUT_MS));
+    nav_task.set_heartbeat_handle(
+        watchdog.register_task("NavigationControl", NAVIGATION_CONTROL_WATCHDOG_TIMEOUT_MS));
+    data_collector.set_telemetry_store(DATA_COLLECTOR_TELEMETRY_STORE);
+    data_collector.set_log_rotation(data_collector_log_rotation());
+    data_collector.set_heartbeat_handle(
+        watchdog.register_task("DataCollector", DATA_COLLECTOR_WATCHDOG_TIMEOUT_MS));
+
+    watchdog.set_recovery_policy("SensorProcessing", make_task_recovery_policy(sensor_task, &command_task));
+    watchdog.set_recovery_policy("CommandLogic", make_task_recovery_policy(command_task, &command_task));
+    watchdog.set_recovery_policy("FaultMonitoring", make_task_recovery_policy(fault_task, &command_task));
+    watchdog.set_recovery_policy("NavigationControl", make_task_recovery_policy(nav_task, &command_task));
+    watchdog.set_recovery_policy("DataCollector", make_task_recovery_policy(data_collector, nullptr));
 
     LOG_DEBUG(MAIN) << "event" << "watchdog_configured" << "tasks" << watchdog.get_task_count();
 
@@ -470,6 +631,7 @@ int main(int argc, char* argv[]) {
 
     LOG_DEBUG(MAIN) << "event" << "starting_tasks";
 
+    best_effort.start();
     sensor_task.start();
     command_task.start();
     fault_task.start();
@@ -487,7 +649,6 @@ int main(int argc, char* argv[]) {
 
 
     RawSensorData current_data = initial_data;
-    int bridge_read_count = 0;
 
     ActuatorOutput last_actuator_output{};
     last_actuator_output.velocity = -999;
@@ -499,42 +660,58 @@ int main(int argc, char* argv[]) {
     last_state.fault = false;
 
     int loop_counter = 0;
-    constexpr int STATE_UPDATE_INTERVAL = 4;
+    int replay_drain_cycles = 0;
 
     while (system_running) {
         loop_counter++;
+        long cycle_ms = Logger::timestamp_ms();
+
+        if (g_replay_finished && ++replay_drain_cycles > BRIDGE_REPLAY_DRAIN_CYCLES) {
+            LOG_INFO(MAIN) << "event" << "replay_shutdown";
+            break;
+        }
+
+        long source_timestamp_ms = 0;
 
         RawSensorData bridge_data;
-        if (read_sensor_data_from_bridge(bridge_data)) {
+        if (read_sensor_data_from_bridge(bridge_data, source_timestamp_ms)) {
+            input_freshness.record_arrival(InputTopic::SENSORS, source_timestamp_ms, Logger::timestamp_ms());
             current_data = bridge_data;
             sensor_task.set_raw_data(current_data);
 
 
-            if (++bridge_read_count % 250 == 0) {
-                LOG_DEBUG(MAIN) << "event" << "sensor_update"
-                                << "temp" << bridge_data.temperature
-                                << "pos_x" << bridge_data.position_x
-                                << "pos_y" << bridge_data.position_y;
-            }
+            LOGF_EVERY_N(DEBUG, MAIN, 250, "event=sensor_update,temp,pos_x,pos_y",
+                         bridge_data.temperature, bridge_data.position_x, bridge_data.position_y);
         }
 
 
-        OperatorCommand bridge_cmd;
-        if (read_commands_from_bridge(bridge_cmd)) {
-            command_task.set_command(bridge_cmd);
+        std::vector<BridgeCommand> bridge_commands;
+        if (read_commands_from_bridge(bridge_commands)) {
+            for (const BridgeCommand& bridge_cmd : bridge_commands) {
+                bool command_fresh = input_freshness.record_arrival(
+                    InputTopic::COMMANDS, bridge_cmd.source_timestamp_ms, Logger::timestamp_ms());
+                if (command_fresh) {
+                    command_task.set_command(bridge_cmd.command);
+                }
+            }
         }
 
 
         NavigationSetpoint bridge_setpoint;
-        if (read_setpoint_from_bridge(bridge_setpoint)) {
-            route_planner.set_target_waypoint(bridge_setpoint.target_position_x,
-                                              bridge_setpoint.target_position_y,
-                                              bridge_setpoint.target_speed);
+        if (read_setpoint_from_bridge(bridge_setpoint, source_timestamp_ms)) {
+            bool setpoint_fresh = input_freshness.record_arrival(
+                InputTopic::SETPOINT, source_timestamp_ms, Logger::timestamp_ms());
+            if (setpoint_fresh) {
+                route_planner.set_target_waypoint(bridge_setpoint.target_position_x,
+                                                  bridge_setpoint.target_position_y,
+                                                  bridge_setpoint.target_speed);
+            }
         }
 
         // Read obstacles
         std::vector<Obstacle> obstacles;
-        if (read_obstacles_from_bridge(obstacles)) {
+        if (read_obstacles_from_bridge(obstacles, source_timestamp_ms)) {
+            input_freshness.record_arrival(InputTopic::OBSTACLES, source_timestamp_ms, Logger::timestamp_ms());
             route_planner.update_obstacles(obstacles);
         }
 
@@ -566,23 +743,33 @@ int main(int argc, char* argv[]) {
             actuator_output.steering != last_actuator_output.steering ||
             actuator_output.arrived != last_actuator_output.arrived ||
             force_update) {
-            write_actuator_commands_to_bridge(g_truck_id, actuator_output);
+            write_bridge_actuator_output(g_truck_id, actuator_output, cycle_ms);
             last_actuator_output = actuator_output;
         }
 
         if (state.automatic != last_state.automatic ||
             state.fault != last_state.fault ||
             force_update) {
-            write_truck_state_to_bridge(g_truck_id, state);
+            write_bridge_truck_state(g_truck_id, state, cycle_ms);
             last_state = state;
         }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        std::this_thread::sleep_for(std::chrono::milliseconds(MAIN_LOOP_PERIOD_MS));
     }
 
 
     LOG_INFO(MAIN) << "event" << "shutdown_start";
 
+    bridge_replayer.stop();
+    if (g_bridge_recorder) {
+        LOG_INFO(MAIN) << "event" << "bridge_record_stop" << "records" << bridge_recorder.get_records();
+        g_bridge_recorder = nullptr;
+        bridge_recorder.close();
+    }
+    if (replaying && g_replay_finished) {
+        perf_monitor.print_report();
+    }
+
     watchdog.stop();
     local_interface.stop();
     data_collector.stop();
@@ -590,6 +777,7 @@ int main(int argc, char* argv[]) {
     fault_task.stop();
     command_task.stop();
     sensor_task.stop();
+    best_effort.stop();
 
     std::cout << "\n========================================" << std::endl;
     std::cout << "System shutdown complete." << std::endl;
@@ -597,6 +785,8 @@ int main(int argc, char* argv[]) {
     std::cout << "========================================" << std::endl;
 
     LOG_INFO(MAIN) << "event" << "shutdown_complete";
+    FlightRecorder::stop();
+    Logger::shutdown();
 
     return 0;
 }
@@ -1,6 +1,7 @@
 #include "navigation_control.h"
 #include "logger.h"
-#include "watchdog.h"
+#include "deferred_log.h"
+#include "rt_profile.h"
 #include <chrono>
 #include <cmath>
 #include <limits>
@@ -11,7 +12,13 @@ NavigationControl::NavigationControl(CircularBuffer& buffer, int period_ms, Perf
     : buffer_(buffer),
       period_ms_(period_ms),
       running_(false),
-      perf_monitor_(perf_monitor) {
+      fault_status_(nullptr),
+      observed_fault_sequence_(0),
+      perf_monitor_(perf_monitor),
+      clock_(&Clock::system()),
+      clock_thread_(0),
+      worker_pool_(nullptr),
+      pool_job_(-1) {
 
     truck_state_.fault = false;
     truck_state_.automatic = false;
@@ -32,6 +39,13 @@ void NavigationControl::start() {
     }
 
     running_ = true;
+    if (worker_pool_) {
+        pool_job_ = worker_pool_->add_periodic("NavigationControl", period_ms_, [this] { run_cycle(); });
+        LOG_INFO(NC) << "event" << "start" << "pool_job" << pool_job_;
+        return;
+    }
+
+    clock_thread_ = clock_->register_thread("NavigationControl");
     task_thread_ = std::thread(&NavigationControl::task_loop, this);
     pthread_t native_handle = task_thread_.native_handle();
     struct sched_param param;
@@ -50,6 +64,10 @@ void NavigationControl::stop() {
     }
 
     running_ = false;
+    if (worker_pool_) {
+        worker_pool_->remove(pool_job_);
+    }
+    clock_->release_thread(clock_thread_);
 
     if (task_thread_.joinable()) {
         task_thread_.join();
@@ -81,8 +99,11 @@ void NavigationControl::set_truck_state(const TruckState& state) {
     truck_state_ = state;
 }
 
-void NavigationControl::on_fault_update(FaultType type) {
-    std::lock_guard<std::mutex> lock(control_mutex_);
+void NavigationControl::set_fault_status(const FaultStatus* status) {
+    fault_status_ = status;
+}
+
+void NavigationControl::apply_fault_update(FaultType type) {
     if (type != FaultType::NONE) {
         output_.velocity = 0;
         // Keep steering as is or center it? Typically safe state is stop.
@@ -97,42 +118,75 @@ ActuatorOutput NavigationControl::get_output() const {
     return output_;
 }
 
+void NavigationControl::set_heartbeat_handle(Watchdog::HeartbeatHandle handle) {
+    heartbeat_handle_ = handle;
+}
+
+void NavigationControl::set_clock(Clock* clock) {
+    clock_ = clock;
+}
+
+void NavigationControl::set_worker_pool(RtWorkerPool* pool) {
+    worker_pool_ = pool;
+}
+
 void NavigationControl::task_loop() {
-    auto next_execution = std::chrono::steady_clock::now();
+    RtProfile::enter_thread("NavigationControl");
+    clock_->begin_thread(clock_thread_);
+    auto next_execution = clock_->now();
 
     while (running_) {
-        auto start_time = std::chrono::steady_clock::now();
+        run_cycle();
 
-        SensorData sensor_data = buffer_.peek_latest();
+        next_execution += std::chrono::milliseconds(period_ms_);
+        clock_->sleep_until(clock_thread_, next_execution);
+    }
+}
 
-        {
-            std::lock_guard<std::mutex> lock(control_mutex_);
+void NavigationControl::run_cycle() {
+    auto start_time = clock_->now();
 
-            bool controllers_enabled = truck_state_.automatic && !truck_state_.fault;
+    SensorData sensor_data = buffer_.peek_latest();
+    FaultStatus::Snapshot fault_snapshot{};
+    bool fault_changed = false;
+    if (fault_status_) {
+        fault_snapshot = fault_status_->snapshot();
+        fault_changed = fault_snapshot.sequence != observed_fault_sequence_;
+    }
 
-            if (controllers_enabled) {
-                execute_control(sensor_data);
-            } else {
-                setpoint_.target_position_x = sensor_data.position_x;
-                setpoint_.target_position_y = sensor_data.position_y;
-                setpoint_.target_angle = sensor_data.angle_x;
+    {
+        std::lock_guard<std::mutex> lock(control_mutex_);
 
-                output_.velocity = 0;
-                output_.steering = sensor_data.angle_x;
-                output_.arrived = false;
-            }
+        if (fault_changed) {
+            observed_fault_sequence_ = fault_snapshot.sequence;
+            apply_fault_update(fault_snapshot.type);
         }
 
-        if (Watchdog::get_instance()) {
-            Watchdog::get_instance()->heartbeat("NavigationControl");
-        }
+        bool controllers_enabled = truck_state_.automatic && !truck_state_.fault;
 
-        if (perf_monitor_) {
-            perf_monitor_->end_measurement("NavigationControl", start_time);
+        if (controllers_enabled) {
+            execute_control(sensor_data);
+        } else {
+            setpoint_.target_position_x = sensor_data.position_x;
+            setpoint_.target_position_y = sensor_data.position_y;
+            setpoint_.target_angle = sensor_data.angle_x;
+
+            output_.velocity = 0;
+            output_.steering = sensor_data.angle_x;
+            output_.arrived = false;
         }
+    }
 
-        next_execution += std::chrono::milliseconds(period_ms_);
-        std::this_thread::sleep_until(next_execution);
+    if (fault_changed && fault_snapshot.type != FaultType::NONE && perf_monitor_) {
+        long long now_ns = clock_->now_ns();
+        perf_monitor_->record_latency("FaultToStop.NavigationControl",
+                                      static_cast<long>((now_ns - fault_snapshot.detected_ns) / 1000));
+    }
+
+    Watchdog::heartbeat(heartbeat_handle_);
+
+    if (perf_monitor_) {
+        perf_monitor_->end_measurement("NavigationControl", start_time);
     }
 }
 
@@ -161,23 +215,18 @@ void NavigationControl::execute_control(const SensorData& sensor_data) {
     int dy = setpoint_.target_position_y - sensor_data.position_y;
     double distance = std::sqrt(dx*dx + dy*dy);
 
-    LOG_DEBUG(NC) << "event" << "nav_update"
-                  << "dist" << static_cast<int>(distance)
-                  << "cur_x" << sensor_data.position_x
-                  << "cur_y" << sensor_data.position_y
-                  << "tgt_x" << setpoint_.target_position_x
-                  << "tgt_y" << setpoint_.target_position_y;
+    LOGF_DEBUG(NC, "event=nav_update,dist,cur_x,cur_y,tgt_x,tgt_y",
+               static_cast<int>(distance), sensor_data.position_x, sensor_data.position_y,
+               setpoint_.target_position_x, setpoint_.target_position_y);
 
     if (output_.arrived) {
         if (distance > DEPARTURE_THRESHOLD_UNITS) {
             output_.arrived = false;
-            LOG_INFO(NC) << "event" << "departure"
-                         << "dist" << static_cast<int>(distance);
+            LOGF_INFO(NC, "event=departure,dist", static_cast<int>(distance));
         } else {
             output_.velocity = 0;
             output_.steering = sensor_data.angle_x;
-            LOG_DEBUG(NC) << "event" << "hold_position"
-                          << "dist" << static_cast<int>(distance);
+            LOGF_DEBUG(NC, "event=hold_position,dist", static_cast<int>(distance));
             return;
         }
     }
@@ -186,12 +235,9 @@ void NavigationControl::execute_control(const SensorData& sensor_data) {
         output_.arrived = true;
         output_.velocity = 0;
         output_.steering = sensor_data.angle_x;
-        LOG_INFO(NC) << "event" << "arrived"
-                     << "dist" << static_cast<int>(distance)
-                     << "cur_x" << sensor_data.position_x
-                     << "cur_y" << sensor_data.position_y
-                     << "tgt_x" << setpoint_.target_position_x
-                     << "tgt_y" << setpoint_.target_position_y;
+        LOGF_INFO(NC, "event=arrived,dist,cur_x,cur_y,tgt_x,tgt_y",
+                  static_cast<int>(distance), sensor_data.position_x, sensor_data.position_y,
+                  setpoint_.target_position_x, setpoint_.target_position_y);
         return;
     }
 
@@ -223,11 +269,7 @@ void NavigationControl::execute_control(const SensorData& sensor_data) {
 
     output_.velocity = desired_speed;
 
-    LOG_DEBUG(NC) << "event" << "p_control"
-                  << "dist" << static_cast<int>(distance)
-                  << "vel" << output_.velocity
-                  << "tgt_hdg" << target_heading
-                  << "cur_hdg" << sensor_data.angle_x
-                  << "hdg_err" << static_cast<int>(abs_heading_error)
-                  << "str" << output_.steering;
+    LOGF_DEBUG(NC, "event=p_control,dist,vel,tgt_hdg,cur_hdg,hdg_err,str",
+               static_cast<int>(distance), output_.velocity, target_heading,
+               sensor_data.angle_x, static_cast<int>(abs_heading_error), output_.steering);
 }
@@ -1,10 +1,17 @@
 #include "performance_monitor.h"
 #include "logger.h"
+#include "deferred_log.h"
+#include "flight_recorder.h"
+#include "rt_profile.h"
 #include <algorithm>
 #include <cmath>
 #include <sstream>
 #include <iomanip>
 
+void PerformanceMonitor::set_clock(Clock* clock) {
+    clock_ = clock;
+}
+
 void PerformanceMonitor::register_task(const std::string& task_name, int expected_period_ms) {
     std::lock_guard<std::mutex> lock(mutex_);
 
@@ -18,17 +25,19 @@ void PerformanceMonitor::register_task(const std::string& task_name, int expecte
                    << "event" << "perf_registered";
 }
 
-std::chrono::steady_clock::time_point PerformanceMonitor::start_measurement(
+Clock::time_point PerformanceMonitor::start_measurement(
     const std::string& task_name) {
-    return std::chrono::steady_clock::now();
+    return clock_->now();
 }
 
 void PerformanceMonitor::end_measurement(const std::string& task_name,
-                                        std::chrono::steady_clock::time_point start_time) {
-    auto end_time = std::chrono::steady_clock::now();
+                                        Clock::time_point start_time) {
+    auto end_time = clock_->now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
     long execution_us = duration.count();
 
+    LOGF_FLIGHT(MAIN, "event=perf_sample,task,exec_us", task_name, execution_us);
+
     std::lock_guard<std::mutex> lock(mutex_);
 
     auto it = task_stats_.find(task_name);
@@ -98,6 +107,58 @@ double PerformanceMonitor::calculate_std_dev(const std::vector<long>& samples, d
     return std::sqrt(sum_sq_diff / samples.size());
 }
 
+static size_t latency_histogram_bucket(long latency_us) {
+    size_t bucket = 0;
+    while (latency_us > 0 && bucket < LATENCY_HISTOGRAM_BUCKETS - 1) {
+        latency_us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+long PerformanceMonitor::LatencyStats::percentile_upper_bound_us(double percentile) const {
+    if (sample_count == 0) {
+        return 0;
+    }
+
+    long target_rank = static_cast<long>(std::ceil(sample_count * percentile / 100.0));
+    long cumulative = 0;
+    for (size_t bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKETS; ++bucket) {
+        cumulative += histogram[bucket];
+        if (cumulative >= target_rank) {
+            return std::min((1L << bucket) - 1, max_us);
+        }
+    }
+    return max_us;
+}
+
+void PerformanceMonitor::record_latency(const std::string& metric_name, long latency_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    LatencyStats& stats = latency_stats_[metric_name];
+    if (stats.sample_count == 0) {
+        stats.metric_name = metric_name;
+    }
+
+    stats.sample_count++;
+    stats.min_us = std::min(stats.min_us, latency_us);
+    stats.max_us = std::max(stats.max_us, latency_us);
+    stats.avg_us += (latency_us - stats.avg_us) / stats.sample_count;
+    stats.histogram[latency_histogram_bucket(latency_us)]++;
+}
+
+PerformanceMonitor::LatencyStats PerformanceMonitor::get_latency_stats(
+    const std::string& metric_name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = latency_stats_.find(metric_name);
+    if (it != latency_stats_.end()) {
+        return it->second;
+    }
+
+    return LatencyStats();
+}
+
 PerformanceMonitor::TaskStats PerformanceMonitor::get_stats(const std::string& task_name) const {
     std::lock_guard<std::mutex> lock(mutex_);
 
@@ -141,6 +202,7 @@ void PerformanceMonitor::reset_all_stats() {
         pair.second.task_name = name;
         pair.second.expected_period_ms = period;
     }
+    latency_stats_.clear();
 
     LOG_INFO(MAIN) << "event" << "perf_reset_all";
 }
@@ -150,6 +212,10 @@ void PerformanceMonitor::print_report() const {
 }
 
 std::string PerformanceMonitor::get_report_string() const {
+    // Read /proc before taking the lock the tasks record into
+    std::ostringstream threads;
+    RtProfile::append_thread_report(threads);
+
     std::lock_guard<std::mutex> lock(mutex_);
 
     std::ostringstream oss;
@@ -160,6 +226,8 @@ std::string PerformanceMonitor::get_report_string() const {
 
     if (task_stats_.empty()) {
         oss << "No performance data available.\n";
+        append_latency_report(oss);
+        oss << threads.str();
         return oss.str();
     }
 
@@ -210,12 +278,49 @@ std::string PerformanceMonitor::get_report_string() const {
     } else {
         oss << "  ✓ All tasks meeting deadlines\n";
     }
+    if (FlightRecorder::enabled()) {
+        FlightRecorder::Stats flight = FlightRecorder::get_stats();
+        oss << "  Flight Recorder: " << flight.live_rings << " live / " << flight.rings << " rings, "
+            << flight.rings_reused << " reused, " << flight.rings_refused << " threads refused\n";
+    }
+
+    append_latency_report(oss);
+    oss << threads.str();
 
     oss << "========================================\n";
 
     return oss.str();
 }
 
+void PerformanceMonitor::append_latency_report(std::ostringstream& oss) const {
+    if (latency_stats_.empty()) {
+        return;
+    }
+
+    oss << "\nEvent Latencies:\n";
+    oss << std::left
+        << std::setw(40) << "Metric"
+        << std::setw(10) << "Samples"
+        << std::setw(12) << "Min"
+        << std::setw(12) << "Avg"
+        << std::setw(12) << "P99<="
+        << std::setw(12) << "Max"
+        << "\n";
+    oss << std::string(98, '-') << "\n";
+
+    for (const auto& pair : latency_stats_) {
+        const LatencyStats& stats = pair.second;
+        oss << std::left
+            << std::setw(40) << stats.metric_name
+            << std::setw(10) << stats.sample_count
+            << std::setw(12) << (std::to_string(stats.min_us) + "μs")
+            << std::setw(12) << (std::to_string(static_cast<long>(stats.avg_us)) + "μs")
+            << std::setw(12) << (std::to_string(stats.percentile_upper_bound_us(99.0)) + "μs")
+            << std::setw(12) << (std::to_string(stats.max_us) + "μs")
+            << "\n";
+    }
+}
+
 bool PerformanceMonitor::has_deadline_violations() const {
     std::lock_guard<std::mutex> lock(mutex_);
 
@@ -0,0 +1,417 @@
+#include "rotating_log_file.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+namespace {
+
+constexpr size_t TAIL_SCAN_BYTES = 64 * 1024;
+constexpr size_t COMPRESS_CHUNK_BYTES = 256 * 1024;
+constexpr size_t ZERO_FILL_CHUNK_BYTES = 1024 * 1024;
+constexpr int MAINTENANCE_IDLE_MS = 60000;
+
+bool pwrite_all(int fd, const char* data, size_t size, size_t offset) {
+    while (size > 0) {
+        ssize_t written = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += static_cast<size_t>(written);
+    }
+    return true;
+}
+
+/**
+ * @brief End of the last complete line (0 if there is none)
+ *
+ * Skips the NUL tail of a preallocated segment and any torn last line.
+ */
+size_t find_data_end(int fd, size_t file_size) {
+    std::vector<char> chunk(TAIL_SCAN_BYTES);
+    size_t end = file_size;
+    while (end > 0) {
+        size_t begin = end > chunk.size() ? end - chunk.size() : 0;
+        ssize_t got = ::pread(fd, chunk.data(), end - begin, static_cast<off_t>(begin));
+        if (got != static_cast<ssize_t>(end - begin)) {
+            return 0;
+        }
+        for (size_t i = end - begin; i > 0; i--) {
+            if (chunk[i - 1] == '\n') {
+                return begin + i;
+            }
+        }
+        end = begin;
+    }
+    return 0;
+}
+
+long now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+enum class SegmentFile { PLAIN, COMPRESSED, PARTIAL };
+
+struct ClosedSegment {
+    long stamp;
+    std::filesystem::path path;
+    SegmentFile type;
+    size_t bytes;
+};
+
+/**
+ * @brief Closed segments of a log (<stem>.<stamp><extension>[.gz[.tmp]]), oldest first
+ */
+std::vector<ClosedSegment> list_closed_segments(const std::string& stem, const std::string& extension) {
+    std::filesystem::path stem_path(stem);
+    std::filesystem::path directory = stem_path.parent_path().empty() ? "." : stem_path.parent_path();
+    std::string prefix = stem_path.filename().string() + ".";
+    std::vector<ClosedSegment> segments;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        std::string rest = name.substr(prefix.size());
+        size_t digits = rest.find_first_not_of("0123456789");
+        if (digits == 0 || digits == std::string::npos) {
+            continue;
+        }
+        std::string suffix = rest.substr(digits);
+        SegmentFile type;
+        if (suffix == extension) {
+            type = SegmentFile::PLAIN;
+        } else if (suffix == extension + ".gz") {
+            type = SegmentFile::COMPRESSED;
+        } else if (suffix == extension + ".gz.tmp") {
+            type = SegmentFile::PARTIAL;
+        } else {
+            continue;
+        }
+        segments.push_back({std::stol(rest.substr(0, digits)), entry.path(), type,
+                            static_cast<size_t>(entry.file_size(error))});
+    }
+    std::sort(segments.begin(), segments.end(),
+              [](const ClosedSegment& a, const ClosedSegment& b) { return a.stamp < b.stamp; });
+    return segments;
+}
+
+} // namespace
+
+RotatingLogFile::RotatingLogFile()
+    : config_(),
+      fd_(-1),
+      used_(0),
+      spare_fd_(-1),
+      maintenance_running_(false),
+      rollovers_(0),
+      compressed_(0),
+      deleted_(0),
+      spare_misses_(0) {
+}
+
+RotatingLogFile::~RotatingLogFile() {
+    close();
+}
+
+bool RotatingLogFile::open(const std::string& path, const std::string& header, const RotatingLogConfig& config) {
+    if (fd_ >= 0) {
+        return false;
+    }
+    path_ = path;
+    header_ = header;
+    config_ = config;
+    std::filesystem::path file(path);
+    extension_ = file.extension().string();
+    stem_ = path.substr(0, path.size() - extension_.size());
+    spare_path_ = path + ".next";
+    ::unlink(spare_path_.c_str());
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        return false;
+    }
+    struct stat file_stat;
+    size_t file_size = ::fstat(fd_, &file_stat) == 0 ? static_cast<size_t>(file_stat.st_size) : 0;
+    used_ = find_data_end(fd_, file_size);
+    if (used_ == 0 && !pwrite_all(fd_, header_.data(), header_.size(), 0)) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    used_ = std::max(used_, header_.size());
+    if (config_.preallocate && file_size < config_.segment_bytes) {
+        // Failure (e.g. unsupported filesystem) only costs the optimization
+        ::fallocate(fd_, 0, 0, static_cast<off_t>(config_.segment_bytes));
+    }
+    opened_ = std::chrono::steady_clock::now();
+
+    queue_leftovers();
+    maintenance_running_ = true;
+    maintenance_thread_ = std::thread(&RotatingLogFile::maintenance_loop, this);
+    return true;
+}
+
+bool RotatingLogFile::append(const char* data, size_t size) {
+    if (fd_ < 0) {
+        return false;
+    }
+    if (used_ > header_.size()) {
+        bool full = used_ + size > config_.segment_bytes;
+        bool expired = config_.segment_ms > 0 &&
+                       std::chrono::steady_clock::now() - opened_ >= std::chrono::milliseconds(config_.segment_ms);
+        if ((full || expired) && !roll()) {
+            return false;
+        }
+    }
+    if (!pwrite_all(fd_, data, size, used_)) {
+        return false;
+    }
+    used_ += size;
+    return true;
+}
+
+bool RotatingLogFile::sync() {
+    return fd_ >= 0 && ::fdatasync(fd_) == 0;
+}
+
+bool RotatingLogFile::roll() {
+    ClosedSegmentFile closed{closed_name(), fd_, used_};
+    ::rename(path_.c_str(), closed.path.c_str());
+    fd_ = -1;
+
+    {
+        // Renamed under the lock so the background thread never recreates
+        // the spare path while it is being moved
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (spare_fd_ >= 0 && ::rename(spare_path_.c_str(), path_.c_str()) == 0) {
+            fd_ = spare_fd_;
+        } else if (spare_fd_ >= 0) {
+            ::close(spare_fd_);
+        }
+        spare_fd_ = -1;
+        pending_.push_back(closed);
+    }
+    if (fd_ < 0) {
+        if (config_.preallocate) {
+            spare_misses_++;
+        }
+        fd_ = create_segment(path_, false);
+    }
+    used_ = header_.size();
+    opened_ = std::chrono::steady_clock::now();
+    rollovers_++;
+    maintenance_signal_.notify();
+    return fd_ >= 0;
+}
+
+int RotatingLogFile::create_segment(const std::string& path, bool zero_fill) const {
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    if (config_.preallocate) {
+        ::fallocate(fd, 0, 0, static_cast<off_t>(config_.segment_bytes));
+    }
+    if (config_.preallocate && zero_fill) {
+        // Written back chunk by chunk so the device never sees one burst of
+        // segment_bytes competing with the writer's fdatasync()
+        std::vector<char> zeros(ZERO_FILL_CHUNK_BYTES);
+        for (size_t offset = 0; offset < config_.segment_bytes; offset += zeros.size()) {
+            size_t length = std::min(zeros.size(), config_.segment_bytes - offset);
+            pwrite_all(fd, zeros.data(), length, offset);
+            ::sync_file_range(fd, static_cast<off_t>(offset), static_cast<off_t>(length),
+                              SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        }
+    }
+    if (!pwrite_all(fd, header_.data(), header_.size(), 0)) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+std::string RotatingLogFile::closed_name() const {
+    for (long stamp = now_ms();; stamp++) {
+        std::string name = stem_ + "." + std::to_string(stamp) + extension_;
+        std::error_code error;
+        if (!std::filesystem::exists(name, error) && !std::filesystem::exists(name + ".gz", error)) {
+            return name;
+        }
+    }
+}
+
+void RotatingLogFile::close() {
+    if (fd_ >= 0) {
+        ::ftruncate(fd_, static_cast<off_t>(used_));
+        ::fdatasync(fd_);
+        ::close(fd_);
+        fd_ = -1;
+    }
+    maintenance_running_ = false;
+    maintenance_signal_.notify();
+    if (maintenance_thread_.joinable()) {
+        maintenance_thread_.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (spare_fd_ >= 0) {
+        ::close(spare_fd_);
+        ::unlink(spare_path_.c_str());
+        spare_fd_ = -1;
+    }
+    for (auto& segment : pending_) {
+        if (segment.fd >= 0) {
+            finish_segment(segment);
+        }
+    }
+    pending_.clear();
+}
+
+void RotatingLogFile::maintenance_loop() {
+    while (true) {
+        bool running = maintenance_running_.load();
+        uint32_t seen = maintenance_signal_.version();
+
+        if (running && config_.preallocate) {
+            bool need_spare;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                need_spare = spare_fd_ < 0;
+            }
+            if (need_spare) {
+                // Sync the new file's size and extents now so the writer's
+                // first fdatasync() after the switch has only data to flush
+                int fd = create_segment(spare_path_, true);
+                if (fd >= 0) {
+                    ::fsync(fd);
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    spare_fd_ = fd;
+                }
+            }
+        }
+
+        bool removed = false;
+        while (maintenance_running_) {
+            ClosedSegmentFile closed;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (pending_.empty()) {
+                    break;
+                }
+                closed = pending_.front();
+                pending_.pop_front();
+            }
+            finish_segment(closed);
+            if (config_.compress) {
+                compress_segment(closed.path);
+            }
+            removed = true;
+        }
+        if (removed || !running) {
+            apply_retention();
+        }
+
+        if (!running) {
+            break;
+        }
+        maintenance_signal_.wait_until(seen, std::chrono::steady_clock::now() +
+                                             std::chrono::milliseconds(MAINTENANCE_IDLE_MS));
+    }
+}
+
+void RotatingLogFile::queue_leftovers() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& segment : list_closed_segments(stem_, extension_)) {
+        std::error_code error;
+        if (segment.type == SegmentFile::PARTIAL) {
+            std::filesystem::remove(segment.path, error);
+        } else if (segment.type == SegmentFile::PLAIN) {
+            pending_.push_back({segment.path.string(), -1, 0});
+        }
+    }
+}
+
+void RotatingLogFile::finish_segment(ClosedSegmentFile& segment) {
+    if (segment.fd < 0) {
+        segment.fd = ::open(segment.path.c_str(), O_RDWR | O_CLOEXEC);
+        if (segment.fd < 0) {
+            return;
+        }
+        struct stat file_stat;
+        size_t file_size = ::fstat(segment.fd, &file_stat) == 0 ? static_cast<size_t>(file_stat.st_size) : 0;
+        segment.used = find_data_end(segment.fd, file_size);
+    }
+    ::ftruncate(segment.fd, static_cast<off_t>(segment.used));
+    ::close(segment.fd);
+    segment.fd = -1;
+}
+
+bool RotatingLogFile::compress_segment(const std::string& path) {
+    int input = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (input < 0) {
+        return false;
+    }
+    std::string temporary = path + ".gz.tmp";
+    gzFile output = gzopen(temporary.c_str(), "wb1");
+    bool ok = output != nullptr;
+    std::vector<char> chunk(COMPRESS_CHUNK_BYTES);
+    while (ok) {
+        ssize_t got = ::read(input, chunk.data(), chunk.size());
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            ok = got == 0;
+            break;
+        }
+        ok = gzwrite(output, chunk.data(), static_cast<unsigned>(got)) == got;
+    }
+    ::close(input);
+    if (output && gzclose(output) != Z_OK) {
+        ok = false;
+    }
+    if (!ok || ::rename(temporary.c_str(), (path + ".gz").c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        return false;
+    }
+    ::unlink(path.c_str());
+    compressed_++;
+    return true;
+}
+
+void RotatingLogFile::apply_retention() {
+    if (config_.retain_segments == 0 && config_.retain_bytes == 0) {
+        return;
+    }
+    std::vector<ClosedSegment> segments = list_closed_segments(stem_, extension_);
+    size_t total = 0;
+    for (const auto& segment : segments) {
+        total += segment.bytes;
+    }
+    size_t count = segments.size();
+    for (const auto& segment : segments) {
+        bool over_count = config_.retain_segments > 0 && count > config_.retain_segments;
+        bool over_bytes = config_.retain_bytes > 0 && total > config_.retain_bytes;
+        if (!over_count && !over_bytes) {
+            break;
+        }
+        std::error_code error;
+        if (std::filesystem::remove(segment.path, error)) {
+            deleted_++;
+        }
+        count--;
+        total -= segment.bytes;
+    }
+}
@@ -0,0 +1,586 @@
+#include "rt_profile.h"
+#include "logger.h"
+#include "json.hpp"
+#include <alloca.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <iomanip>
+#include <malloc.h>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t STACK_PREFAULT_MARGIN = 64 * 1024;     // Left untouched below the caller's frames
+
+struct Role {
+    const char* name;
+    bool rt;                // SCHED_FIFO thread(s)
+};
+
+const Role ROLES[] = {
+    {"SensorProcessing", true},
+    {"CommandLogic", true},
+    {"FaultMonitoring", true},
+    {"NavigationControl", true},
+    {"Watchdog", true},
+    {"RtWorkerPool", true},
+    {"Main", false},
+    {"BestEffort", false},
+    {"DataCollector", false},
+    {"DataCollectorWriter", false},
+    {"FaultDispatcher", false},
+    {"LocalInterface", false},
+    {"WatchdogRecovery", false},
+};
+
+struct ThreadEntry {
+    pid_t tid;
+    std::string role;
+    std::vector<int> cpus;      // Affinity at enter_thread(), empty if every CPU
+    long minflt;                // Baselines at enter_thread()
+    long majflt;
+    long migrations;            // -1: /proc/<tid>/sched not available
+    long nivcsw;
+};
+
+struct ProcCounters {
+    long minflt = 0;
+    long majflt = 0;
+    int cpu = -1;
+    long migrations = -1;
+    long nivcsw = -1;
+};
+
+std::mutex g_mutex;
+RtProfile::Config g_config;
+bool g_loaded = false;
+std::map<std::string, ThreadEntry> g_threads;   // By thread name, a restarted thread replaces its entry
+
+const Role* find_role(const std::string& name) {
+    for (const Role& role : ROLES) {
+        if (name == role.name) {
+            return &role;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<int> missing_cpus(const std::vector<int>& cpus, const std::vector<int>& available) {
+    std::vector<int> missing;
+    std::set_difference(cpus.begin(), cpus.end(), available.begin(), available.end(), std::back_inserter(missing));
+    return missing;
+}
+
+/**
+ * @brief Read a /sys CPU list; a missing or empty file is an empty list
+ */
+std::vector<int> read_cpu_list_file(const char* path, bool& present) {
+    std::vector<int> cpus;
+    std::ifstream file(path);
+    present = file.is_open();
+    std::string text;
+    if (present && std::getline(file, text)) {
+        text.erase(std::remove_if(text.begin(), text.end(), ::isspace), text.end());
+        RtProfile::parse_cpu_list(text, cpus);
+    }
+    return cpus;
+}
+
+cpu_set_t make_cpu_set(const std::vector<int>& cpus) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &cpu_set);
+    }
+    return cpu_set;
+}
+
+void touch_pages(volatile unsigned char* memory, size_t bytes) {
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    for (size_t offset = 0; offset < bytes; offset += page) {
+        memory[offset] = 0;
+    }
+}
+
+/**
+ * @brief Fault in bytes of the calling thread's heap arena and keep them mapped
+ *
+ * Freed chunks stay in the arena because apply() disabled trimming and
+ * mmap'ed allocations.
+ */
+void prefault_heap(size_t bytes) {
+    if (bytes == 0) {
+        return;
+    }
+    void* memory = std::malloc(bytes);
+    if (memory) {
+        touch_pages(static_cast<volatile unsigned char*>(memory), bytes);
+        std::free(memory);
+    }
+}
+
+/**
+ * @brief Fault in bytes of the calling thread's stack below this frame
+ */
+__attribute__((noinline)) void prefault_stack(size_t bytes) {
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        size_t stack_size = 0;
+        pthread_attr_getstacksize(&attr, &stack_size);
+        pthread_attr_destroy(&attr);
+        if (stack_size > 2 * STACK_PREFAULT_MARGIN) {
+            bytes = std::min(bytes, stack_size - 2 * STACK_PREFAULT_MARGIN);
+        }
+    }
+    if (bytes == 0) {
+        return;
+    }
+    volatile unsigned char* memory = static_cast<volatile unsigned char*>(alloca(bytes));
+    touch_pages(memory, bytes);
+}
+
+/**
+ * @brief Affinity of the calling thread, empty if it may run on every online CPU
+ */
+std::vector<int> current_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t cpu_set;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+        return cpus;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &cpu_set)) {
+            cpus.push_back(cpu);
+        }
+    }
+    if (static_cast<long>(cpus.size()) >= sysconf(_SC_NPROCESSORS_ONLN)) {
+        cpus.clear();
+    }
+    return cpus;
+}
+
+pid_t current_tid() {
+    return static_cast<pid_t>(syscall(SYS_gettid));
+}
+
+/**
+ * @brief Migrations and involuntary switches from /proc/self/task/<tid>/sched
+ *
+ * Both stay -1 if the kernel has no sched debug file.
+ */
+void read_sched_counters(pid_t tid, ProcCounters& counters) {
+    std::ifstream file("/proc/self/task/" + std::to_string(tid) + "/sched");
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, colon);
+        key.erase(std::remove_if(key.begin(), key.end(), ::isspace), key.end());
+        if (key == "se.nr_migrations") {
+            counters.migrations = std::atol(line.c_str() + colon + 1);
+        } else if (key == "nr_involuntary_switches") {
+            counters.nivcsw = std::atol(line.c_str() + colon + 1);
+        }
+    }
+}
+
+/**
+ * @brief Current counters of a thread of this process
+ *
+ * @return false if the thread has exited
+ */
+bool read_thread_counters(pid_t tid, ProcCounters& counters) {
+    std::ifstream file("/proc/self/task/" + std::to_string(tid) + "/stat");
+    std::string stat;
+    if (!std::getline(file, stat)) {
+        return false;
+    }
+    size_t name_end = stat.rfind(')');
+    if (name_end == std::string::npos) {
+        return false;
+    }
+
+    // Fields after the command name, numbered as in proc(5): state is field 3
+    std::istringstream fields(stat.substr(name_end + 2));
+    std::string field;
+    for (int number = 3; fields >> field; number++) {
+        if (number == 10) {
+            counters.minflt = std::atol(field.c_str());
+        } else if (number == 12) {
+            counters.majflt = std::atol(field.c_str());
+        } else if (number == 39) {
+            counters.cpu = std::atoi(field.c_str());
+            break;
+        }
+    }
+    read_sched_counters(tid, counters);
+    return true;
+}
+
+void pin_running_threads(const std::vector<int>& cpus) {
+    cpu_set_t cpu_set = make_cpu_set(cpus);
+    int pinned = 0;
+    int failed = 0;
+    DIR* tasks = opendir("/proc/self/task");
+    if (tasks) {
+        while (struct dirent* entry = readdir(tasks)) {
+            pid_t tid = static_cast<pid_t>(std::atoi(entry->d_name));
+            if (tid <= 0) {
+                continue;
+            }
+            if (sched_setaffinity(tid, sizeof(cpu_set), &cpu_set) == 0) {
+                pinned++;
+            } else {
+                failed++;
+            }
+        }
+        closedir(tasks);
+    }
+    LOG_INFO(MAIN) << "event" << "rt_pin_running" << "cpus" << RtProfile::format_cpu_list(cpus)
+                   << "threads" << pinned << "failed" << failed;
+}
+
+bool lock_memory() {
+    int flags = MCL_CURRENT | MCL_FUTURE;
+#ifdef MCL_ONFAULT
+    // Populate what is mapped now, then lock later mappings (8 MiB thread
+    // stacks, new heap arenas) only as their pages fault in.
+    if (mlockall(MCL_CURRENT) == 0) {
+        flags |= MCL_ONFAULT;
+    }
+#endif
+    if (mlockall(flags) == 0) {
+        LOG_INFO(MAIN) << "event" << "rt_mlock" << "onfault" << ((flags & ~(MCL_CURRENT | MCL_FUTURE)) != 0);
+        return true;
+    }
+
+    int error = errno;
+    munlockall();
+    struct rlimit limit;
+    std::string memlock = "unknown";
+    if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0) {
+        memlock = limit.rlim_cur == RLIM_INFINITY ? "unlimited" : std::to_string(limit.rlim_cur / 1024) + "KiB";
+    }
+    LOG_WARN(MAIN) << "event" << "rt_mlock_failed" << "errno" << error << "memlock_limit" << memlock;
+    return false;
+}
+
+/**
+ * @brief Check the RT roles' CPUs against isolcpus, nohz_full and the soft roles
+ *
+ * @return false if an RT CPU is not isolated or not tickless, or shared
+ */
+bool check_isolation(const RtProfile::Config& config) {
+    std::vector<int> rt_cpus;
+    for (const auto& pair : config.cpus) {
+        const Role* role = find_role(pair.first);
+        if (role && role->rt) {
+            rt_cpus.insert(rt_cpus.end(), pair.second.begin(), pair.second.end());
+        }
+    }
+    std::sort(rt_cpus.begin(), rt_cpus.end());
+    rt_cpus.erase(std::unique(rt_cpus.begin(), rt_cpus.end()), rt_cpus.end());
+    if (rt_cpus.empty()) {
+        LOG_INFO(MAIN) << "event" << "rt_isolation" << "rt_cpus" << "none";
+        return true;
+    }
+
+    bool isolated_present = false;
+    bool nohz_present = false;
+    std::vector<int> isolated = read_cpu_list_file("/sys/devices/system/cpu/isolated", isolated_present);
+    std::vector<int> nohz = read_cpu_list_file("/sys/devices/system/cpu/nohz_full", nohz_present);
+    std::vector<int> not_isolated = missing_cpus(rt_cpus, isolated);
+    std::vector<int> not_nohz = missing_cpus(rt_cpus, nohz);
+    bool ok = not_isolated.empty() && not_nohz.empty();
+
+    if (ok) {
+        LOG_INFO(MAIN) << "event" << "rt_isolation" << "rt_cpus" << RtProfile::format_cpu_list(rt_cpus)
+                       << "isolated" << RtProfile::format_cpu_list(isolated) << "nohz_full" << RtProfile::format_cpu_list(nohz);
+    } else {
+        LOG_WARN(MAIN) << "event" << "rt_isolation" << "rt_cpus" << RtProfile::format_cpu_list(rt_cpus)
+                       << "not_isolated" << (not_isolated.empty() ? "none" : RtProfile::format_cpu_list(not_isolated))
+                       << "not_nohz_full" << (not_nohz.empty() ? "none" : RtProfile::format_cpu_list(not_nohz))
+                       << "nohz_full_supported" << nohz_present;
+    }
+
+    // Unpinned soft roles run wherever Main does
+    auto main_cpus = config.cpus.find("Main");
+    if (main_cpus == config.cpus.end()) {
+        LOG_WARN(MAIN) << "event" << "rt_cpu_shared" << "role" << "Main" << "cpus" << "all";
+        ok = false;
+    }
+    for (const auto& pair : config.cpus) {
+        const Role* role = find_role(pair.first);
+        if (role && role->rt) {
+            continue;
+        }
+        std::vector<int> shared;
+        std::set_intersection(pair.second.begin(), pair.second.end(), rt_cpus.begin(), rt_cpus.end(),
+                              std::back_inserter(shared));
+        if (!shared.empty()) {
+            LOG_WARN(MAIN) << "event" << "rt_cpu_shared" << "role" << pair.first << "cpus" << RtProfile::format_cpu_list(shared);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+} // namespace
+
+bool RtProfile::load(const std::string& path, Config& config, std::string& error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    config = Config();
+    try {
+        nlohmann::json profile = nlohmann::json::parse(file);
+        if (!profile.is_object()) {
+            error = "profile is not an object";
+            return false;
+        }
+        for (auto it = profile.begin(); it != profile.end(); ++it) {
+            const std::string& key = it.key();
+            const nlohmann::json& value = it.value();
+            if (key == "cpus") {
+                for (auto role = value.begin(); role != value.end(); ++role) {
+                    if (!find_role(role.key())) {
+                        error = "unknown role " + role.key();
+                        return false;
+                    }
+                    std::string text = role.value().is_number_integer()
+                        ? std::to_string(role.value().get<int>()) : role.value().get<std::string>();
+                    if (!parse_cpu_list(text, config.cpus[role.key()])) {
+                        error = "invalid CPU list for " + role.key() + ": " + text;
+                        return false;
+                    }
+                }
+            } else if (key == "lock_memory") {
+                config.lock_memory = value.get<bool>();
+            } else if (key == "prefault_stack_kb") {
+                config.prefault_stack_bytes = value.get<size_t>() * 1024;
+            } else if (key == "prefault_heap_kb") {
+                config.prefault_heap_bytes = value.get<size_t>() * 1024;
+            } else if (key == "prefault_thread_heap_kb") {
+                config.prefault_thread_heap_bytes = value.get<size_t>() * 1024;
+            } else if (key == "heap_arenas") {
+                config.heap_arenas = value.get<int>();
+            } else if (key == "strict") {
+                config.strict = value.get<bool>();
+            } else {
+                error = "unknown key " + key;
+                return false;
+            }
+        }
+    } catch (const nlohmann::json::exception& e) {
+        error = e.what();
+        return false;
+    }
+    return true;
+}
+
+bool RtProfile::apply(const Config& config) {
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_config = config;
+        g_loaded = true;
+    }
+
+    if (config.heap_arenas > 0) {
+        mallopt(M_ARENA_MAX, config.heap_arenas);
+    }
+    if (config.lock_memory || config.prefault_heap_bytes > 0 || config.prefault_thread_heap_bytes > 0) {
+        // Keep prefaulted heap mapped: no trimming, no per-allocation mmap
+        mallopt(M_TRIM_THRESHOLD, -1);
+        mallopt(M_MMAP_MAX, 0);
+    }
+
+    bool locked = !config.lock_memory || lock_memory();
+    prefault_heap(config.prefault_heap_bytes);
+
+    auto main_cpus = config.cpus.find("Main");
+    if (main_cpus != config.cpus.end()) {
+        pin_running_threads(main_cpus->second);
+    }
+
+    bool isolated = check_isolation(config);
+
+    LOG_INFO(MAIN) << "event" << "rt_profile" << "roles" << config.cpus.size()
+                   << "mlock" << (config.lock_memory ? (locked ? "ok" : "failed") : "off")
+                   << "stack_kb" << config.prefault_stack_bytes / 1024
+                   << "heap_kb" << config.prefault_heap_bytes / 1024
+                   << "thread_heap_kb" << config.prefault_thread_heap_bytes / 1024
+                   << "heap_arenas" << config.heap_arenas
+                   << "strict" << config.strict;
+
+    return !config.strict || (locked && isolated);
+}
+
+std::vector<int> RtProfile::role_cpus(const std::string& role) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    auto it = g_config.cpus.find(role);
+    return it == g_config.cpus.end() ? std::vector<int>() : it->second;
+}
+
+void RtProfile::enter_thread(const std::string& role, const std::string& thread_name) {
+    Config config;
+    bool loaded;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        config = g_config;
+        loaded = g_loaded;
+    }
+
+    std::vector<int> cpus;
+    auto it = config.cpus.find(role);
+    int pin_error = 0;
+    if (it != config.cpus.end()) {
+        cpus = it->second;
+        cpu_set_t cpu_set = make_cpu_set(cpus);
+        pin_error = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    }
+    prefault_stack(config.prefault_stack_bytes);
+    prefault_heap(config.prefault_thread_heap_bytes);
+
+    ThreadEntry entry;
+    entry.tid = current_tid();
+    entry.role = role;
+    entry.cpus = current_cpus();
+
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    ProcCounters sched;
+    read_sched_counters(entry.tid, sched);
+    entry.minflt = usage.ru_minflt;
+    entry.majflt = usage.ru_majflt;
+    entry.nivcsw = usage.ru_nivcsw;
+    entry.migrations = sched.migrations;
+
+    const std::string& name = thread_name.empty() ? role : thread_name;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_threads[name] = entry;
+    }
+
+    if (pin_error != 0) {
+        LOG_WARN(MAIN) << "event" << "thread_pin_failed" << "thread" << name
+                       << "cpus" << RtProfile::format_cpu_list(cpus) << "errno" << pin_error;
+    } else if (loaded) {
+        LOG_INFO(MAIN) << "event" << "thread_profile" << "thread" << name << "tid" << entry.tid
+                       << "cpus" << RtProfile::format_cpu_list(entry.cpus) << "minflt" << entry.minflt;
+    } else {
+        LOG_DEBUG(MAIN) << "event" << "thread_profile" << "thread" << name << "tid" << entry.tid;
+    }
+}
+
+void RtProfile::append_thread_report(std::ostringstream& oss) {
+    std::map<std::string, ThreadEntry> threads;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        threads = g_threads;
+    }
+    if (threads.empty()) {
+        return;
+    }
+
+    oss << "\nThread Faults & Migrations (since warm-up):\n";
+    oss << std::left
+        << std::setw(24) << "Thread"
+        << std::setw(9) << "TID"
+        << std::setw(10) << "CPUs"
+        << std::setw(10) << "Last CPU"
+        << std::setw(11) << "Minor PF"
+        << std::setw(11) << "Major PF"
+        << std::setw(12) << "Migrations"
+        << std::setw(11) << "Invol CS"
+        << "\n";
+    oss << std::string(98, '-') << "\n";
+
+    for (const auto& pair : threads) {
+        const ThreadEntry& entry = pair.second;
+        oss << std::left
+            << std::setw(24) << pair.first
+            << std::setw(9) << entry.tid
+            << std::setw(10) << RtProfile::format_cpu_list(entry.cpus);
+
+        ProcCounters counters;
+        if (!read_thread_counters(entry.tid, counters)) {
+            oss << "exited\n";
+            continue;
+        }
+        auto delta = [](long now, long base) {
+            return now < 0 || base < 0 ? std::string("-") : std::to_string(now - base);
+        };
+        oss << std::setw(10) << counters.cpu
+            << std::setw(11) << counters.minflt - entry.minflt
+            << std::setw(11) << counters.majflt - entry.majflt
+            << std::setw(12) << delta(counters.migrations, entry.migrations)
+            << std::setw(11) << delta(counters.nivcsw, entry.nivcsw)
+            << "\n";
+    }
+}
+
+bool RtProfile::parse_cpu_list(const std::string& text, std::vector<int>& cpus) {
+    cpus.clear();
+    std::istringstream input(text);
+    std::string range;
+    while (std::getline(input, range, ',')) {
+        int first = 0;
+        int last = 0;
+        char extra = 0;
+        int fields = std::sscanf(range.c_str(), "%d-%d%c", &first, &last, &extra);
+        if (fields == 1) {
+            last = first;
+        } else if (fields != 2) {
+            return false;
+        }
+        if (first < 0 || last < first || last >= CPU_SETSIZE) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return !cpus.empty();
+}
+
+std::string RtProfile::format_cpu_list(const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return "all";
+    }
+    std::string text;
+    size_t i = 0;
+    while (i < cpus.size()) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            j++;
+        }
+        if (!text.empty()) {
+            text += ',';
+        }
+        text += std::to_string(cpus[i]);
+        if (j > i) {
+            text += '-' + std::to_string(cpus[j]);
+        }
+        i = j + 1;
+    }
+    return text;
+}
@@ -0,0 +1,174 @@
+#include "rt_worker_pool.h"
+#include "logger.h"
+#include "rt_profile.h"
+#include <algorithm>
+#include <pthread.h>
+
+RtWorkerPool::RtWorkerPool(size_t workers, int rt_priority, PerformanceMonitor* perf_monitor)
+    : worker_count_(std::max<size_t>(workers, 1)),
+      rt_priority_(rt_priority),
+      perf_monitor_(perf_monitor),
+      running_(false),
+      overruns_(0),
+      runs_(0),
+      max_lateness_us_(0) {
+}
+
+RtWorkerPool::~RtWorkerPool() {
+    stop();
+}
+
+void RtWorkerPool::start() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) {
+            return;
+        }
+        running_ = true;
+    }
+
+    int failed = 0;
+    int last_error = 0;
+    for (size_t i = 0; i < worker_count_; i++) {
+        workers_.emplace_back(&RtWorkerPool::worker_loop, this, i);
+
+        struct sched_param param;
+        param.sched_priority = rt_priority_;
+        int result = pthread_setschedparam(workers_.back().native_handle(), SCHED_FIFO, &param);
+        if (result != 0) {
+            failed++;
+            last_error = result;
+        }
+    }
+
+    if (failed == 0) {
+        LOG_INFO(MAIN) << "event" << "rt_pool_start" << "workers" << worker_count_
+                       << "rt_priority" << rt_priority_ << "sched" << "FIFO";
+    } else {
+        LOG_WARN(MAIN) << "event" << "rt_pool_start" << "workers" << worker_count_
+                       << "rt_priority" << "failed" << "failed_workers" << failed << "errno" << last_error;
+    }
+}
+
+void RtWorkerPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    release_changed_.notify_all();
+
+    for (std::thread& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+
+    Stats stats = get_stats();
+    LOG_INFO(MAIN) << "event" << "rt_pool_stop" << "jobs" << stats.jobs << "runs" << stats.runs
+                   << "overruns" << stats.overruns << "max_lateness_us" << stats.max_lateness_us;
+}
+
+RtWorkerPool::JobId RtWorkerPool::add_periodic(const std::string& name, int period_ms,
+                                               std::function<void()> cycle) {
+    auto job = std::make_unique<Job>();
+    job->name = name;
+    job->period = std::chrono::milliseconds(period_ms);
+    job->cycle = std::move(cycle);
+    job->release = std::chrono::steady_clock::now();
+
+    JobId id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = static_cast<JobId>(jobs_.size());
+        releases_.push(Release{job->release, id});
+        jobs_.push_back(std::move(job));
+    }
+    release_changed_.notify_one();
+    return id;
+}
+
+void RtWorkerPool::remove(JobId id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (id < 0 || static_cast<size_t>(id) >= jobs_.size() || !jobs_[id]) {
+        return;
+    }
+
+    // The job's pending release stays queued; a worker drops it
+    cycle_done_.wait(lock, [&] { return !jobs_[id]->running; });
+    LOG_DEBUG(MAIN) << "event" << "rt_pool_remove" << "job" << jobs_[id]->name
+                    << "runs" << jobs_[id]->runs << "overruns" << jobs_[id]->overruns;
+    jobs_[id].reset();
+}
+
+RtWorkerPool::Stats RtWorkerPool::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.workers = worker_count_;
+    stats.jobs = static_cast<size_t>(std::count_if(jobs_.begin(), jobs_.end(),
+                                                   [](const std::unique_ptr<Job>& job) { return job != nullptr; }));
+    stats.runs = runs_;
+    stats.overruns = overruns_;
+    stats.max_lateness_us = max_lateness_us_;
+    return stats;
+}
+
+void RtWorkerPool::worker_loop(size_t index) {
+    RtProfile::enter_thread("RtWorkerPool", "RtWorkerPool#" + std::to_string(index));
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (running_) {
+        if (releases_.empty()) {
+            release_changed_.wait(lock);
+            continue;
+        }
+
+        Release next = releases_.top();
+        if (!jobs_[next.id]) {
+            releases_.pop();
+            continue;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (next.time > now) {
+            release_changed_.wait_until(lock, next.time);
+            continue;
+        }
+
+        releases_.pop();
+        Job& job = *jobs_[next.id];
+        job.running = true;
+        long lateness_us = static_cast<long>(
+            std::chrono::duration_cast<std::chrono::microseconds>(now - job.release).count());
+        max_lateness_us_ = std::max(max_lateness_us_, lateness_us);
+
+        // Another worker takes the next release while this one runs the cycle
+        if (!releases_.empty()) {
+            release_changed_.notify_one();
+        }
+
+        lock.unlock();
+        if (perf_monitor_) {
+            perf_monitor_->record_latency("RtPoolRelease", lateness_us);
+        }
+        job.cycle();
+        auto end = std::chrono::steady_clock::now();
+        lock.lock();
+
+        job.running = false;
+        job.runs++;
+        runs_++;
+        job.release += job.period;
+        if (job.release < end) {
+            job.overruns++;
+            overruns_++;
+            job.release = end;
+        }
+        releases_.push(Release{job.release, next.id});
+        cycle_done_.notify_all();
+        release_changed_.notify_one();
+    }
+}
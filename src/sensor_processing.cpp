@@ -1,6 +1,7 @@
 #include "sensor_processing.h"
 #include "logger.h"
-#include "watchdog.h"
+#include "deferred_log.h"
+#include "rt_profile.h"
 #include <pthread.h>
 #include <cstring>
 #include <numeric>
@@ -11,8 +12,14 @@ SensorProcessing::SensorProcessing(CircularBuffer& buffer, size_t filter_order,
       filter_order_(filter_order),
       period_ms_(period_ms),
       running_(false),
+      capture_(nullptr),
       perf_monitor_(perf_monitor),
-      current_raw_data_{0, 0, 0, 20, false, false} {
+      clock_(&Clock::system()),
+      clock_thread_(0),
+      worker_pool_(nullptr),
+      pool_job_(-1),
+      current_raw_data_{0, 0, 0, 20, false, false},
+      raw_arrival_ns_(0) {
 }
 
 SensorProcessing::~SensorProcessing() {
@@ -25,6 +32,13 @@ void SensorProcessing::start() {
     }
 
     running_ = true;
+    if (worker_pool_) {
+        pool_job_ = worker_pool_->add_periodic("SensorProcessing", period_ms_, [this] { run_cycle(); });
+        LOG_INFO(SP) << "event" << "start" << "period_ms" << period_ms_ << "filter_order" << filter_order_ << "pool_job" << pool_job_;
+        return;
+    }
+
+    clock_thread_ = clock_->register_thread("SensorProcessing");
     task_thread_ = std::thread(&SensorProcessing::task_loop, this);
     pthread_t native_handle = task_thread_.native_handle();
     struct sched_param param;
@@ -44,6 +58,10 @@ void SensorProcessing::stop() {
     }
 
     running_ = false;
+    if (worker_pool_) {
+        worker_pool_->remove(pool_job_);
+    }
+    clock_->release_thread(clock_thread_);
 
     if (task_thread_.joinable()) {
         task_thread_.join();
@@ -53,64 +71,93 @@ void SensorProcessing::stop() {
 }
 
 void SensorProcessing::set_raw_data(const RawSensorData& data) {
+    long long arrival_ns = clock_->now_ns();
     std::lock_guard<std::mutex> lock(raw_data_mutex_);
     current_raw_data_ = data;
+    raw_arrival_ns_ = arrival_ns;
+}
+
+void SensorProcessing::set_heartbeat_handle(Watchdog::HeartbeatHandle handle) {
+    heartbeat_handle_ = handle;
+}
+
+void SensorProcessing::set_sample_hook(SensorSampleHook hook) {
+    sample_hook_ = hook;
+}
+
+void SensorProcessing::set_telemetry_capture(TelemetryCapture* capture) {
+    capture_ = capture;
+}
+
+void SensorProcessing::set_clock(Clock* clock) {
+    clock_ = clock;
+}
+
+void SensorProcessing::set_worker_pool(RtWorkerPool* pool) {
+    worker_pool_ = pool;
 }
 
 void SensorProcessing::task_loop() {
-    auto next_execution = std::chrono::steady_clock::now();
+    RtProfile::enter_thread("SensorProcessing");
+    clock_->begin_thread(clock_thread_);
+    auto next_execution = clock_->now();
 
     while (running_) {
-        auto start_time = std::chrono::steady_clock::now();
+        run_cycle();
+
+        next_execution += std::chrono::milliseconds(period_ms_);
+        clock_->sleep_until(clock_thread_, next_execution);
+    }
+}
 
-        RawSensorData raw_data;
-        {
-            std::lock_guard<std::mutex> lock(raw_data_mutex_);
-            raw_data = current_raw_data_;
-        }
+void SensorProcessing::run_cycle() {
+    auto start_time = clock_->now();
 
+    RawSensorData raw_data;
+    long long raw_arrival_ns;
+    {
+        std::lock_guard<std::mutex> lock(raw_data_mutex_);
+        raw_data = current_raw_data_;
+        raw_arrival_ns = raw_arrival_ns_;
+    }
+
+
+    int filtered_x = apply_moving_average(raw_data.position_x, position_x_history_);
+    int filtered_y = apply_moving_average(raw_data.position_y, position_y_history_);
+    int filtered_angle = apply_moving_average(raw_data.angle_x, angle_x_history_);
+    int filtered_temp = apply_moving_average(raw_data.temperature, temperature_history_);
 
-        int filtered_x = apply_moving_average(raw_data.position_x, position_x_history_);
-        int filtered_y = apply_moving_average(raw_data.position_y, position_y_history_);
-        int filtered_angle = apply_moving_average(raw_data.angle_x, angle_x_history_);
-        int filtered_temp = apply_moving_average(raw_data.temperature, temperature_history_);
 
+    SensorData processed_data;
+    processed_data.position_x = filtered_x;
+    processed_data.position_y = filtered_y;
+    processed_data.angle_x = filtered_angle;
+    processed_data.temperature = filtered_temp;
+    processed_data.fault_electrical = raw_data.fault_electrical;
+    processed_data.fault_hydraulic = raw_data.fault_hydraulic;
 
-        SensorData processed_data;
-        processed_data.position_x = filtered_x;
-        processed_data.position_y = filtered_y;
-        processed_data.angle_x = filtered_angle;
-        processed_data.temperature = filtered_temp;
-        processed_data.fault_electrical = raw_data.fault_electrical;
-        processed_data.fault_hydraulic = raw_data.fault_hydraulic;
 
+    processed_data.timestamp = clock_->wall_ms();
 
-        auto now = std::chrono::system_clock::now();
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch());
-        processed_data.timestamp = ms.count();
 
+    buffer_.write(processed_data);
 
-        buffer_.write(processed_data);
+    if (capture_) {
+        capture_->record_sensor(processed_data);
+    }
 
+    if (sample_hook_) {
+        sample_hook_(raw_data, processed_data, raw_arrival_ns);
+    }
 
-        static int write_count = 0;
-        if (++write_count % 50 == 0) {
-            LOG_DEBUG(SP) << "event" << "write"
-                          << "temp" << processed_data.temperature
-                          << "pos_x" << processed_data.position_x
-                          << "pos_y" << processed_data.position_y;
-        }
 
-        if (Watchdog::get_instance()) {
-            Watchdog::get_instance()->heartbeat("SensorProcessing");
-        }
+    LOGF_LIMITED_BY(write_log_sampler_, DEBUG, SP, "event=write,temp,pos_x,pos_y",
+                    processed_data.temperature, processed_data.position_x, processed_data.position_y);
 
-        if (perf_monitor_) {
-            perf_monitor_->end_measurement("SensorProcessing", start_time);
-        }
+    Watchdog::heartbeat(heartbeat_handle_);
 
-        next_execution += std::chrono::milliseconds(period_ms_);
-        std::this_thread::sleep_until(next_execution);
+    if (perf_monitor_) {
+        perf_monitor_->end_measurement("SensorProcessing", start_time);
     }
 }
 
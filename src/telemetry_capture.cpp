@@ -0,0 +1,62 @@
+#include "telemetry_capture.h"
+#include "deferred_log.h"
+#include <chrono>
+
+TelemetryCapture::TelemetryCapture() : drain_signal_(nullptr), clock_(&Clock::system()), drop_log_limiter_(1, 1) {
+    for (size_t i = 0; i < CAPTURE_KIND_COUNT; i++) {
+        recorded_[i].store(0, std::memory_order_relaxed);
+        dropped_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void TelemetryCapture::record_sensor(const SensorData& data) {
+    CaptureRecord record{};
+    record.kind = CaptureKind::SENSOR;
+    record.sensor = data;
+    push(record);
+}
+
+void TelemetryCapture::record_actuator(const ActuatorOutput& output) {
+    CaptureRecord record{};
+    record.kind = CaptureKind::ACTUATOR;
+    record.actuator = output;
+    push(record);
+}
+
+void TelemetryCapture::record_state(const TruckState& state) {
+    CaptureRecord record{};
+    record.kind = CaptureKind::STATE;
+    record.state = state;
+    push(record);
+}
+
+void TelemetryCapture::push(CaptureRecord& record) {
+    record.timestamp_us = clock_->wall_us();
+    size_t kind = static_cast<size_t>(record.kind);
+    if (ring_.try_push(record)) {
+        recorded_[kind].fetch_add(1, std::memory_order_relaxed);
+        if (drain_signal_ && ring_.size() >= TELEMETRY_CAPTURE_CAPACITY / 2) {
+            drain_signal_->notify();
+        }
+        return;
+    }
+    long dropped = dropped_[kind].fetch_add(1, std::memory_order_relaxed) + 1;
+    LOGF_LIMITED_BY(drop_log_limiter_, WARN, DC, "event=capture_drop,kind,dropped", kind_name(record.kind), dropped);
+}
+
+long TelemetryCapture::get_dropped_total() const {
+    long total = 0;
+    for (const auto& dropped : dropped_) {
+        total += dropped.load();
+    }
+    return total;
+}
+
+const char* TelemetryCapture::kind_name(CaptureKind kind) {
+    switch (kind) {
+        case CaptureKind::SENSOR: return "SENSOR";
+        case CaptureKind::ACTUATOR: return "ACTUATOR";
+        case CaptureKind::STATE: return "STATE";
+        default: return "UNKNOWN";
+    }
+}
@@ -0,0 +1,362 @@
+#include "telemetry_store.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <initializer_list>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Worst case of one row without new dictionary entries: four 64-bit
+// varints and two 32-bit ids.
+constexpr size_t MAX_ROW_BYTES = 4 * 10 + 2 * 5;
+
+bool write_all_at(int fd, const char* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t written = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+std::string_view truncated(std::string_view text) {
+    return text.substr(0, TELEMETRY_MAX_STRING_BYTES);
+}
+
+} // namespace
+
+bool TelemetrySegmentView::load(const char* segment, size_t size) {
+    segment_ = segment;
+    dictionary_.clear();
+    if (size < sizeof(TelemetrySegmentHeader)) {
+        return false;
+    }
+    std::memcpy(&header_, segment, sizeof(header_));
+    if (std::memcmp(header_.magic, TELEMETRY_SEGMENT_MAGIC, sizeof(header_.magic)) != 0 ||
+        header_.used_bytes > size || header_.used_bytes < sizeof(TelemetrySegmentHeader)) {
+        return false;
+    }
+    for (uint32_t column = 0; column < TELEMETRY_COLUMN_COUNT; column++) {
+        if (header_.column_offset[column] < sizeof(TelemetrySegmentHeader) ||
+            header_.column_offset[column] > header_.used_bytes ||
+            header_.column_bytes[column] > header_.used_bytes - header_.column_offset[column]) {
+            return false;
+        }
+    }
+
+    const uint8_t* cursor = reinterpret_cast<const uint8_t*>(segment + header_.column_offset[TELEMETRY_COLUMN_DICTIONARY]);
+    const uint8_t* end = cursor + header_.column_bytes[TELEMETRY_COLUMN_DICTIONARY];
+    dictionary_.reserve(header_.dictionary_entries);
+    for (uint32_t i = 0; i < header_.dictionary_entries; i++) {
+        uint64_t length;
+        if (!telemetry_detail::read_varint(cursor, end, length) || length > static_cast<uint64_t>(end - cursor)) {
+            return false;
+        }
+        dictionary_.emplace_back(reinterpret_cast<const char*>(cursor), static_cast<size_t>(length));
+        cursor += length;
+    }
+    return true;
+}
+
+TelemetryStoreWriter::TelemetryStoreWriter()
+    : fd_(-1),
+      segment_bytes_(TELEMETRY_SEGMENT_BYTES),
+      footer_offset_(0),
+      row_count_(0),
+      previous_{},
+      min_timestamp_(0),
+      max_timestamp_(0),
+      rows_written_(0) {
+}
+
+TelemetryStoreWriter::~TelemetryStoreWriter() {
+    close();
+}
+
+bool TelemetryStoreWriter::open(const std::string& path, size_t segment_bytes) {
+    close();
+    long page = ::sysconf(_SC_PAGESIZE);
+    if (page <= 0 || segment_bytes == 0 || segment_bytes % static_cast<size_t>(page) != 0 ||
+        TELEMETRY_FILE_HEADER_BYTES % static_cast<size_t>(page) != 0) {
+        return false;
+    }
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        return false;
+    }
+    segment_bytes_ = segment_bytes;
+    index_.clear();
+    rows_written_ = 0;
+    reset_segment();
+
+    char header[TELEMETRY_FILE_HEADER_BYTES] = {};
+    TelemetryFileHeader file_header;
+    std::memcpy(file_header.magic, TELEMETRY_FILE_MAGIC, sizeof(file_header.magic));
+    file_header.header_bytes = static_cast<uint32_t>(TELEMETRY_FILE_HEADER_BYTES);
+    file_header.segment_bytes = static_cast<uint32_t>(segment_bytes_);
+    file_header.created_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::memcpy(header, &file_header, sizeof(file_header));
+    if (!write_all_at(fd_, header, sizeof(header), 0)) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    footer_offset_ = TELEMETRY_FILE_HEADER_BYTES;
+    return true;
+}
+
+bool TelemetryStoreWriter::append(int64_t timestamp, int truck_id, std::string_view state,
+                                  int position_x, int position_y, std::string_view description) {
+    if (fd_ < 0) {
+        return false;
+    }
+    state = truncated(state);
+    description = truncated(description);
+
+    size_t worst = MAX_ROW_BYTES;
+    for (std::string_view text : {state, description}) {
+        if (dictionary_.find(text) == dictionary_.end()) {
+            worst += 5 + text.size();
+        }
+    }
+    if (used_bytes() + worst > segment_bytes_ && !seal()) {
+        return false;
+    }
+
+    const int64_t values[] = {timestamp, truck_id, position_x, position_y};
+    const TelemetryColumn numeric[] = {TELEMETRY_COLUMN_TIMESTAMP, TELEMETRY_COLUMN_TRUCK_ID,
+                                       TELEMETRY_COLUMN_POSITION_X, TELEMETRY_COLUMN_POSITION_Y};
+    for (size_t i = 0; i < 4; i++) {
+        telemetry_detail::append_varint(columns_[numeric[i]],
+                                        telemetry_detail::zigzag_encode(values[i] - previous_[numeric[i]]));
+        previous_[numeric[i]] = values[i];
+    }
+    telemetry_detail::append_varint(columns_[TELEMETRY_COLUMN_STATE], dictionary_id(state));
+    telemetry_detail::append_varint(columns_[TELEMETRY_COLUMN_DESCRIPTION], dictionary_id(description));
+
+    if (row_count_ == 0 || timestamp < min_timestamp_) {
+        min_timestamp_ = timestamp;
+    }
+    if (row_count_ == 0 || timestamp > max_timestamp_) {
+        max_timestamp_ = timestamp;
+    }
+    row_count_++;
+    return true;
+}
+
+uint32_t TelemetryStoreWriter::dictionary_id(std::string_view text) {
+    auto found = dictionary_.find(text);
+    if (found != dictionary_.end()) {
+        return found->second;
+    }
+    uint32_t id = static_cast<uint32_t>(dictionary_.size());
+    dictionary_.emplace(std::string(text), id);
+    telemetry_detail::append_varint(columns_[TELEMETRY_COLUMN_DICTIONARY], text.size());
+    columns_[TELEMETRY_COLUMN_DICTIONARY].append(text.data(), text.size());
+    return id;
+}
+
+size_t TelemetryStoreWriter::used_bytes() const {
+    size_t used = sizeof(TelemetrySegmentHeader);
+    for (const auto& column : columns_) {
+        used += column.size();
+    }
+    return used;
+}
+
+bool TelemetryStoreWriter::flush() {
+    return fd_ >= 0 && (row_count_ == 0 || seal());
+}
+
+bool TelemetryStoreWriter::seal() {
+    uint64_t offset = footer_offset_;
+    size_t used = used_bytes();
+
+    // The file grows by a whole segment; only the used pages get blocks,
+    // so running out of space fails here instead of as SIGBUS on the map.
+    if (::ftruncate(fd_, static_cast<off_t>(offset + segment_bytes_)) != 0 ||
+        ::posix_fallocate(fd_, static_cast<off_t>(offset), static_cast<off_t>(used)) != 0) {
+        return false;
+    }
+    void* mapping = ::mmap(nullptr, segment_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+                           static_cast<off_t>(offset));
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    char* segment = static_cast<char*>(mapping);
+
+    TelemetrySegmentHeader header = {};
+    std::memcpy(header.magic, TELEMETRY_SEGMENT_MAGIC, sizeof(header.magic));
+    header.used_bytes = static_cast<uint32_t>(used);
+    header.row_count = row_count_;
+    header.dictionary_entries = static_cast<uint32_t>(dictionary_.size());
+    header.min_timestamp = min_timestamp_;
+    header.max_timestamp = max_timestamp_;
+    uint32_t position = sizeof(TelemetrySegmentHeader);
+    for (uint32_t column = 0; column < TELEMETRY_COLUMN_COUNT; column++) {
+        header.column_offset[column] = position;
+        header.column_bytes[column] = static_cast<uint32_t>(columns_[column].size());
+        std::memcpy(segment + position, columns_[column].data(), columns_[column].size());
+        position += header.column_bytes[column];
+    }
+    std::memcpy(segment, &header, sizeof(header));
+
+    bool synced = ::msync(mapping, segment_bytes_, MS_SYNC) == 0;
+    ::munmap(mapping, segment_bytes_);
+    if (!synced) {
+        return false;
+    }
+
+    index_.push_back({offset, min_timestamp_, max_timestamp_, row_count_, header.used_bytes});
+    rows_written_ += row_count_;
+    footer_offset_ = offset + segment_bytes_;
+    reset_segment();
+    return true;
+}
+
+void TelemetryStoreWriter::reset_segment() {
+    for (auto& column : columns_) {
+        column.clear();
+    }
+    dictionary_.clear();
+    row_count_ = 0;
+    for (auto& previous : previous_) {
+        previous = 0;
+    }
+    min_timestamp_ = 0;
+    max_timestamp_ = 0;
+}
+
+bool TelemetryStoreWriter::close() {
+    if (fd_ < 0) {
+        return true;
+    }
+    bool ok = flush();
+
+    std::string footer(reinterpret_cast<const char*>(index_.data()), index_.size() * sizeof(TelemetrySegmentIndex));
+    TelemetryFooterTail tail;
+    tail.segment_count = static_cast<uint32_t>(index_.size());
+    std::memcpy(tail.magic, TELEMETRY_FOOTER_MAGIC, sizeof(tail.magic));
+    footer.append(reinterpret_cast<const char*>(&tail), sizeof(tail));
+    ok = ok && write_all_at(fd_, footer.data(), footer.size(), footer_offset_) &&
+         ::ftruncate(fd_, static_cast<off_t>(footer_offset_ + footer.size())) == 0 &&
+         ::fdatasync(fd_) == 0;
+
+    ::close(fd_);
+    fd_ = -1;
+    reset_segment();
+    return ok;
+}
+
+uint64_t TelemetryStoreWriter::file_bytes() const {
+    return fd_ >= 0 ? footer_offset_ : 0;
+}
+
+TelemetryStoreReader::TelemetryStoreReader()
+    : data_(nullptr),
+      size_(0),
+      segment_bytes_(0),
+      header_bytes_(0),
+      has_footer_(false) {
+}
+
+TelemetryStoreReader::~TelemetryStoreReader() {
+    close();
+}
+
+bool TelemetryStoreReader::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(TelemetryFileHeader)) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(file_stat.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    data_ = static_cast<const char*>(mapping);
+    size_ = size;
+
+    TelemetryFileHeader header;
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, TELEMETRY_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.segment_bytes == 0 || header.header_bytes < sizeof(TelemetryFileHeader)) {
+        close();
+        return false;
+    }
+    segment_bytes_ = header.segment_bytes;
+    header_bytes_ = header.header_bytes;
+
+    has_footer_ = load_footer();
+    if (!has_footer_) {
+        walk_segments();
+    }
+    ::madvise(const_cast<char*>(data_), size_, MADV_SEQUENTIAL);
+    return true;
+}
+
+bool TelemetryStoreReader::load_footer() {
+    if (size_ < header_bytes_ + sizeof(TelemetryFooterTail)) {
+        return false;
+    }
+    TelemetryFooterTail tail;
+    std::memcpy(&tail, data_ + size_ - sizeof(tail), sizeof(tail));
+    uint64_t segments_end = header_bytes_ + static_cast<uint64_t>(tail.segment_count) * segment_bytes_;
+    if (std::memcmp(tail.magic, TELEMETRY_FOOTER_MAGIC, sizeof(tail.magic)) != 0 ||
+        segments_end + static_cast<uint64_t>(tail.segment_count) * sizeof(TelemetrySegmentIndex) +
+            sizeof(tail) != size_) {
+        return false;
+    }
+    index_.resize(tail.segment_count);
+    std::memcpy(index_.data(), data_ + segments_end, index_.size() * sizeof(TelemetrySegmentIndex));
+    return true;
+}
+
+void TelemetryStoreReader::walk_segments() {
+    index_.clear();
+    TelemetrySegmentView view;
+    for (uint64_t offset = header_bytes_; offset + segment_bytes_ <= size_; offset += segment_bytes_) {
+        if (!view.load(data_ + offset, segment_bytes_)) {
+            break;
+        }
+        const TelemetrySegmentHeader& header = view.header();
+        index_.push_back({offset, header.min_timestamp, header.max_timestamp, header.row_count, header.used_bytes});
+    }
+}
+
+bool TelemetryStoreReader::segment(size_t index, TelemetrySegmentView& view) const {
+    if (index >= index_.size() || index_[index].offset + segment_bytes_ > size_) {
+        return false;
+    }
+    return view.load(data_ + index_[index].offset, segment_bytes_);
+}
+
+void TelemetryStoreReader::close() {
+    if (data_ != nullptr) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    index_.clear();
+    has_footer_ = false;
+}
@@ -0,0 +1,111 @@
+#include "temperature_trend_estimator.h"
+#include <algorithm>
+
+constexpr double MILLISECONDS_PER_SECOND = 1000.0;
+constexpr size_t MIN_TREND_WINDOW_SAMPLES = 2;
+
+TemperatureTrendEstimator::TemperatureTrendEstimator(size_t window_samples)
+    : window_(std::max(window_samples, MIN_TREND_WINDOW_SAMPLES)),
+      next_(0),
+      count_(0),
+      origin_ms_(0),
+      sum_t_(0.0),
+      sum_v_(0.0),
+      sum_tt_(0.0),
+      sum_tv_(0.0) {
+}
+
+void TemperatureTrendEstimator::add_sample(long timestamp_ms, double value) {
+    if (count_ > 0) {
+        double shift = (timestamp_ms - origin_ms_) / MILLISECONDS_PER_SECOND;
+        double n = static_cast<double>(count_);
+        sum_tt_ += -2.0 * shift * sum_t_ + n * shift * shift;
+        sum_tv_ -= shift * sum_v_;
+        sum_t_ -= n * shift;
+    }
+    origin_ms_ = timestamp_ms;
+
+    if (count_ == window_.size()) {
+        const Sample& oldest = window_[next_];
+        double t = (oldest.timestamp_ms - origin_ms_) / MILLISECONDS_PER_SECOND;
+        sum_t_ -= t;
+        sum_v_ -= oldest.value;
+        sum_tt_ -= t * t;
+        sum_tv_ -= t * oldest.value;
+    } else {
+        count_++;
+    }
+
+    window_[next_] = Sample{timestamp_ms, value};
+    sum_v_ += value;
+    next_ = (next_ + 1) % window_.size();
+
+    if (next_ == 0) {
+        resum();
+    }
+}
+
+void TemperatureTrendEstimator::reset() {
+    next_ = 0;
+    count_ = 0;
+    origin_ms_ = 0;
+    sum_t_ = 0.0;
+    sum_v_ = 0.0;
+    sum_tt_ = 0.0;
+    sum_tv_ = 0.0;
+}
+
+void TemperatureTrendEstimator::resum() {
+    sum_t_ = 0.0;
+    sum_v_ = 0.0;
+    sum_tt_ = 0.0;
+    sum_tv_ = 0.0;
+
+    for (size_t i = 0; i < count_; i++) {
+        double t = (window_[i].timestamp_ms - origin_ms_) / MILLISECONDS_PER_SECOND;
+        sum_t_ += t;
+        sum_v_ += window_[i].value;
+        sum_tt_ += t * t;
+        sum_tv_ += t * window_[i].value;
+    }
+}
+
+double TemperatureTrendEstimator::slope_per_second() const {
+    if (count_ < MIN_TREND_WINDOW_SAMPLES) {
+        return 0.0;
+    }
+
+    double n = static_cast<double>(count_);
+    double denominator = n * sum_tt_ - sum_t_ * sum_t_;
+    if (denominator <= 0.0) {
+        return 0.0;
+    }
+
+    return (n * sum_tv_ - sum_t_ * sum_v_) / denominator;
+}
+
+double TemperatureTrendEstimator::fitted_value() const {
+    if (count_ == 0) {
+        return 0.0;
+    }
+
+    return (sum_v_ - slope_per_second() * sum_t_) / static_cast<double>(count_);
+}
+
+long TemperatureTrendEstimator::predict_ms_to_reach(double threshold, double min_slope_per_second) const {
+    if (!is_ready()) {
+        return -1;
+    }
+
+    double current = fitted_value();
+    if (current >= threshold) {
+        return 0;
+    }
+
+    double slope = slope_per_second();
+    if (slope < min_slope_per_second || slope <= 0.0) {
+        return -1;
+    }
+
+    return static_cast<long>((threshold - current) / slope * MILLISECONDS_PER_SECOND);
+}
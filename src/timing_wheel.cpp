@@ -0,0 +1,149 @@
+#include "timing_wheel.h"
+
+constexpr size_t NO_ENTRY = static_cast<size_t>(-1);
+constexpr unsigned FINE_LEVEL_BITS = 8;
+constexpr unsigned COARSE_LEVEL_BITS = 6;
+constexpr unsigned COARSE_LEVEL_COUNT = 3;
+constexpr size_t FINE_LEVEL_BUCKETS = size_t{1} << FINE_LEVEL_BITS;
+constexpr size_t COARSE_LEVEL_BUCKETS = size_t{1} << COARSE_LEVEL_BITS;
+constexpr uint64_t FINE_LEVEL_MASK = FINE_LEVEL_BUCKETS - 1;
+constexpr uint64_t COARSE_LEVEL_MASK = COARSE_LEVEL_BUCKETS - 1;
+constexpr size_t TOTAL_BUCKETS = FINE_LEVEL_BUCKETS + COARSE_LEVEL_BUCKETS * COARSE_LEVEL_COUNT;
+constexpr uint64_t WHEEL_HORIZON_TICKS =
+    uint64_t{1} << (FINE_LEVEL_BITS + COARSE_LEVEL_BITS * COARSE_LEVEL_COUNT);
+
+static unsigned coarse_level_shift(unsigned level) {
+    return FINE_LEVEL_BITS + COARSE_LEVEL_BITS * (level - 1);
+}
+
+static size_t coarse_level_offset(unsigned level) {
+    return FINE_LEVEL_BUCKETS + COARSE_LEVEL_BUCKETS * (level - 1);
+}
+
+TimingWheel::TimingWheel(size_t capacity)
+    : entries_(capacity, WheelEntry{NO_ENTRY, NO_ENTRY, NO_ENTRY, 0}),
+      bucket_heads_(TOTAL_BUCKETS, NO_ENTRY),
+      current_tick_(0),
+      scheduled_count_(0) {
+}
+
+void TimingWheel::schedule(size_t entry_id, uint64_t deadline_tick) {
+    if (entry_id >= entries_.size()) {
+        return;
+    }
+
+    if (is_scheduled(entry_id)) {
+        unlink(entry_id);
+    }
+
+    if (deadline_tick <= current_tick_) {
+        deadline_tick = current_tick_ + 1;
+    }
+    if (deadline_tick - current_tick_ >= WHEEL_HORIZON_TICKS) {
+        deadline_tick = current_tick_ + WHEEL_HORIZON_TICKS - 1;
+    }
+
+    entries_[entry_id].deadline_tick = deadline_tick;
+    link(entry_id, select_bucket(deadline_tick));
+}
+
+void TimingWheel::cancel(size_t entry_id) {
+    if (entry_id < entries_.size() && is_scheduled(entry_id)) {
+        unlink(entry_id);
+    }
+}
+
+bool TimingWheel::is_scheduled(size_t entry_id) const {
+    return entries_[entry_id].bucket != NO_ENTRY;
+}
+
+void TimingWheel::advance(std::vector<size_t>& expired_entry_ids) {
+    current_tick_++;
+
+    for (unsigned level = COARSE_LEVEL_COUNT; level >= 1; --level) {
+        uint64_t lower_bits_mask = (uint64_t{1} << coarse_level_shift(level)) - 1;
+        if ((current_tick_ & lower_bits_mask) == 0) {
+            size_t index = (current_tick_ >> coarse_level_shift(level)) & COARSE_LEVEL_MASK;
+            cascade(coarse_level_offset(level) + index);
+        }
+    }
+
+    size_t bucket = current_tick_ & FINE_LEVEL_MASK;
+    size_t entry_id = bucket_heads_[bucket];
+    bucket_heads_[bucket] = NO_ENTRY;
+
+    while (entry_id != NO_ENTRY) {
+        size_t next_id = entries_[entry_id].next;
+        entries_[entry_id].bucket = NO_ENTRY;
+        scheduled_count_--;
+
+        if (entries_[entry_id].deadline_tick <= current_tick_) {
+            expired_entry_ids.push_back(entry_id);
+        } else {
+            schedule(entry_id, entries_[entry_id].deadline_tick);
+        }
+        entry_id = next_id;
+    }
+}
+
+void TimingWheel::link(size_t entry_id, size_t bucket) {
+    WheelEntry& entry = entries_[entry_id];
+    entry.bucket = bucket;
+    entry.prev = NO_ENTRY;
+    entry.next = bucket_heads_[bucket];
+    if (entry.next != NO_ENTRY) {
+        entries_[entry.next].prev = entry_id;
+    }
+    bucket_heads_[bucket] = entry_id;
+    scheduled_count_++;
+}
+
+void TimingWheel::unlink(size_t entry_id) {
+    WheelEntry& entry = entries_[entry_id];
+    if (entry.prev != NO_ENTRY) {
+        entries_[entry.prev].next = entry.next;
+    } else {
+        bucket_heads_[entry.bucket] = entry.next;
+    }
+    if (entry.next != NO_ENTRY) {
+        entries_[entry.next].prev = entry.prev;
+    }
+    entry.next = NO_ENTRY;
+    entry.prev = NO_ENTRY;
+    entry.bucket = NO_ENTRY;
+    scheduled_count_--;
+}
+
+size_t TimingWheel::select_bucket(uint64_t deadline_tick) const {
+    uint64_t delta = deadline_tick - current_tick_;
+    if (delta < FINE_LEVEL_BUCKETS) {
+        return deadline_tick & FINE_LEVEL_MASK;
+    }
+
+    for (unsigned level = 1; level < COARSE_LEVEL_COUNT; ++level) {
+        if (delta < (uint64_t{1} << (coarse_level_shift(level) + COARSE_LEVEL_BITS))) {
+            return coarse_level_offset(level) +
+                   ((deadline_tick >> coarse_level_shift(level)) & COARSE_LEVEL_MASK);
+        }
+    }
+
+    return coarse_level_offset(COARSE_LEVEL_COUNT) +
+           ((deadline_tick >> coarse_level_shift(COARSE_LEVEL_COUNT)) & COARSE_LEVEL_MASK);
+}
+
+void TimingWheel::cascade(size_t bucket) {
+    size_t entry_id = bucket_heads_[bucket];
+    bucket_heads_[bucket] = NO_ENTRY;
+
+    while (entry_id != NO_ENTRY) {
+        size_t next_id = entries_[entry_id].next;
+        entries_[entry_id].bucket = NO_ENTRY;
+        scheduled_count_--;
+        if (entries_[entry_id].deadline_tick <= current_tick_) {
+            link(entry_id, current_tick_ & FINE_LEVEL_MASK);
+        } else {
+            schedule(entry_id, entries_[entry_id].deadline_tick);
+        }
+        entry_id = next_id;
+    }
+}
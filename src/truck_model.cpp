@@ -0,0 +1,60 @@
+#include "truck_model.h"
+#include <algorithm>
+#include <cmath>
+
+TruckModel::TruckModel(double start_x, double start_y, uint64_t noise_seed)
+    : x(start_x),
+      y(start_y),
+      angle(0.0),
+      velocity(0.0),
+      temperature(TRUCK_MODEL_TEMPERATURE_BASE),
+      fault_electrical(false),
+      fault_hydraulic(false),
+      noise_state(noise_seed != 0 ? noise_seed : TRUCK_MODEL_DEFAULT_NOISE_SEED) {
+}
+
+void TruckModel::frame(const ActuatorOutput& output) {
+    if (output.velocity != 0) {
+        velocity += TRUCK_MODEL_ACCELERATION_RATE * (output.velocity / 100.0);
+    } else {
+        velocity = 0.0;
+    }
+    velocity = std::max(-TRUCK_MODEL_MAX_SPEED, std::min(TRUCK_MODEL_MAX_SPEED, velocity));
+
+    double angle_diff = output.steering - angle;
+    while (angle_diff > 180.0) angle_diff -= 360.0;
+    while (angle_diff < -180.0) angle_diff += 360.0;
+    if (std::abs(angle_diff) > TRUCK_MODEL_MAX_TURN_RATE_DEGREES) {
+        angle += angle_diff > 0 ? TRUCK_MODEL_MAX_TURN_RATE_DEGREES : -TRUCK_MODEL_MAX_TURN_RATE_DEGREES;
+    } else {
+        angle = output.steering;
+    }
+    angle = std::fmod(angle + 360.0, 360.0);
+
+    double rad = angle * M_PI / 180.0;
+    x = std::max(0.0, std::min(TRUCK_MODEL_MAP_WIDTH, x + velocity * std::cos(rad)));
+    y = std::max(0.0, std::min(TRUCK_MODEL_MAP_HEIGHT, y + velocity * std::sin(rad)));
+
+    temperature += std::abs(velocity) > TRUCK_MODEL_VELOCITY_HEATING_THRESHOLD
+                       ? TRUCK_MODEL_TEMPERATURE_INCREASE_RATE
+                       : -TRUCK_MODEL_TEMPERATURE_DECREASE_RATE;
+    temperature = std::max(TRUCK_MODEL_TEMPERATURE_MIN, std::min(TRUCK_MODEL_TEMPERATURE_MAX, temperature));
+}
+
+int TruckModel::noise(int amplitude) {
+    noise_state ^= noise_state << 13;
+    noise_state ^= noise_state >> 7;
+    noise_state ^= noise_state << 17;
+    return static_cast<int>(noise_state % (2 * amplitude + 1)) - amplitude;
+}
+
+RawSensorData TruckModel::sample() {
+    RawSensorData data;
+    data.position_x = static_cast<int>(x) + noise(TRUCK_MODEL_NOISE_POSITION);
+    data.position_y = static_cast<int>(y) + noise(TRUCK_MODEL_NOISE_POSITION);
+    data.angle_x = (static_cast<int>(angle) + noise(TRUCK_MODEL_NOISE_ANGLE) + 360) % 360;
+    data.temperature = static_cast<int>(temperature) + noise(TRUCK_MODEL_NOISE_TEMPERATURE);
+    data.fault_electrical = fault_electrical;
+    data.fault_hydraulic = fault_hydraulic;
+    return data;
+}
@@ -1,13 +1,40 @@
 #include "watchdog.h"
 #include "logger.h"
+#include "flight_recorder.h"
+#include "rt_profile.h"
 #include <algorithm>
+#include <pthread.h>
+#include <cstdlib>
 
 static Watchdog* g_watchdog_instance = nullptr;
 
-Watchdog::Watchdog(int check_period_ms)
-    : check_period_ms_(check_period_ms),
+constexpr long long NANOSECONDS_PER_MILLISECOND = 1000000;
+
+constexpr long long NANOSECONDS_PER_MICROSECOND = 1000;
+
+Watchdog::Watchdog(int tick_period_ms, size_t max_monitored_tasks, PerformanceMonitor* perf_monitor)
+    : tick_period_ms_(std::max(tick_period_ms, 1)),
+      tick_period_ns_(static_cast<long long>(tick_period_ms_) * NANOSECONDS_PER_MILLISECOND),
+      max_monitored_tasks_(max_monitored_tasks),
       running_(false),
+      slots_(std::make_unique<HeartbeatSlot[]>(max_monitored_tasks)),
+      slot_names_(max_monitored_tasks),
+      slot_monitor_states_(max_monitored_tasks, SlotMonitorState{0, 0, 0, 0}),
+      registered_slot_count_(0),
+      timing_wheel_(max_monitored_tasks),
+      wheel_epoch_ns_(0),
+      armed_slot_count_(0),
+      perf_monitor_(perf_monitor),
+      clock_(&Clock::system()),
+      clock_thread_(0),
+      recovery_policies_(max_monitored_tasks),
+      policies_in_use_(false),
+      restart_pending_(std::make_unique<std::atomic<bool>[]>(max_monitored_tasks)),
       fault_count_(0) {
+    expired_slot_ids_.reserve(max_monitored_tasks);
+    for (size_t i = 0; i < max_monitored_tasks; ++i) {
+        restart_pending_[i].store(false, std::memory_order_relaxed);
+    }
     fault_handler_ = std::bind(&Watchdog::default_fault_handler, this,
                                std::placeholders::_1, std::placeholders::_2);
 }
@@ -21,10 +48,29 @@ void Watchdog::start() {
         return;
     }
 
+    {
+        // Orders the recovery policies before the threads that read them
+        std::lock_guard<std::mutex> lock(registration_mutex_);
+        policies_in_use_ = true;
+    }
     running_ = true;
+    recovery_thread_ = std::thread(&Watchdog::recovery_loop, this);
+    clock_thread_ = clock_->register_thread("Watchdog");
     watchdog_thread_ = std::thread(&Watchdog::watchdog_loop, this);
 
-    LOG_INFO(MAIN) << "event" << "watchdog_start" << "check_period_ms" << check_period_ms_;
+    pthread_t native_handle = watchdog_thread_.native_handle();
+    struct sched_param param;
+    param.sched_priority = WATCHDOG_THREAD_PRIORITY;
+
+    int result = pthread_setschedparam(native_handle, SCHED_FIFO, &param);
+    if (result == 0) {
+        LOG_INFO(MAIN) << "event" << "watchdog_start" << "tick_ms" << tick_period_ms_
+                       << "capacity" << max_monitored_tasks_
+                       << "rt_priority" << WATCHDOG_THREAD_PRIORITY << "sched" << "FIFO";
+    } else {
+        LOG_WARN(MAIN) << "event" << "watchdog_start" << "tick_ms" << tick_period_ms_
+                       << "rt_priority" << "failed" << "errno" << result;
+    }
 }
 
 void Watchdog::stop() {
@@ -33,102 +79,324 @@ void Watchdog::stop() {
     }
 
     running_ = false;
+    clock_->release_thread(clock_thread_);
 
     if (watchdog_thread_.joinable()) {
         watchdog_thread_.join();
     }
 
+    {
+        std::lock_guard<std::mutex> lock(recovery_mutex_);
+    }
+    recovery_requested_.notify_all();
+    if (recovery_thread_.joinable()) {
+        recovery_thread_.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(registration_mutex_);
+        policies_in_use_ = false;
+    }
+
     LOG_INFO(MAIN) << "event" << "watchdog_stop" << "faults_detected" << fault_count_.load();
 }
 
-void Watchdog::register_task(const std::string& task_name, int timeout_ms) {
-    std::lock_guard<std::mutex> lock(tasks_mutex_);
+void Watchdog::set_clock(Clock* clock) {
+    clock_ = clock;
+}
+
+Watchdog::HeartbeatHandle Watchdog::register_task(const std::string& task_name, int timeout_ms) {
+    std::lock_guard<std::mutex> lock(registration_mutex_);
+
+    size_t slot_count = registered_slot_count_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < slot_count; ++i) {
+        if (slots_[i].active.load(std::memory_order_relaxed) && slot_names_[i] == task_name) {
+            LOG_WARN(MAIN) << "event" << "watchdog_register_duplicate" << "task" << task_name;
+            return HeartbeatHandle(&slots_[i], clock_);
+        }
+    }
 
-    TaskInfo info;
-    info.timeout_ms = timeout_ms;
-    info.last_heartbeat = std::chrono::steady_clock::now();
-    info.ever_reported = false;
-    info.consecutive_failures = 0;
+    if (slot_count == max_monitored_tasks_) {
+        LOG_ERR(MAIN) << "event" << "watchdog_register_full" << "task" << task_name
+                      << "capacity" << max_monitored_tasks_;
+        return HeartbeatHandle();
+    }
 
-    monitored_tasks_[task_name] = info;
+    HeartbeatSlot& slot = slots_[slot_count];
+    slot.timeout_ms = timeout_ms;
+    slot.last_heartbeat_ns.store(0, std::memory_order_relaxed);
+    slot.active.store(true, std::memory_order_relaxed);
+    slot_names_[slot_count] = task_name;
+    slot_monitor_states_[slot_count] = SlotMonitorState{0, 0, 0, 0};
 
-    LOG_INFO(MAIN) << "event" << "watchdog_register" << "task" << task_name << "timeout_ms" << timeout_ms;
+    registered_slot_count_.store(slot_count + 1, std::memory_order_release);
+
+    LOG_INFO(MAIN) << "event" << "watchdog_register" << "task" << task_name
+                   << "timeout_ms" << timeout_ms << "slot" << slot_count;
+
+    return HeartbeatHandle(&slot, clock_);
 }
 
 void Watchdog::unregister_task(const std::string& task_name) {
-    std::lock_guard<std::mutex> lock(tasks_mutex_);
-    monitored_tasks_.erase(task_name);
+    std::lock_guard<std::mutex> lock(registration_mutex_);
+
+    size_t slot_count = registered_slot_count_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < slot_count; ++i) {
+        if (slot_names_[i] == task_name) {
+            slots_[i].active.store(false, std::memory_order_release);
+        }
+    }
 
     LOG_INFO(MAIN) << "event" << "watchdog_unregister" << "task" << task_name;
 }
 
-void Watchdog::heartbeat(const std::string& task_name) {
-    std::lock_guard<std::mutex> lock(tasks_mutex_);
+void Watchdog::set_fault_handler(FaultHandler handler) {
+    fault_handler_ = handler;
+}
 
-    auto it = monitored_tasks_.find(task_name);
-    if (it != monitored_tasks_.end()) {
-        it->second.last_heartbeat = std::chrono::steady_clock::now();
-        it->second.ever_reported = true;
-        it->second.consecutive_failures = 0;
+bool Watchdog::set_recovery_policy(const std::string& task_name, const RecoveryPolicy& policy) {
+    std::lock_guard<std::mutex> lock(registration_mutex_);
+
+    if (policies_in_use_) {
+        LOG_ERR(MAIN) << "event" << "watchdog_policy_rejected" << "task" << task_name
+                      << "reason" << "running";
+        return false;
+    }
 
-        static int heartbeat_count = 0;
-        if (++heartbeat_count % 100 == 0) {
-            LOG_DEBUG(MAIN) << "event" << "watchdog_heartbeat" << "task" << task_name << "count" << heartbeat_count;
+    size_t slot_count = registered_slot_count_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < slot_count; ++i) {
+        if (slots_[i].active.load(std::memory_order_relaxed) && slot_names_[i] == task_name) {
+            recovery_policies_[i] = policy;
+            LOG_INFO(MAIN) << "event" << "watchdog_policy" << "task" << task_name
+                           << "safe_state" << static_cast<bool>(policy.enter_safe_state)
+                           << "restart_after" << policy.restart_after_failures
+                           << "max_restarts" << policy.max_restarts_per_outage
+                           << "fail_fast_after" << policy.fail_fast_after_failures;
+            return true;
         }
-    } else {
-        LOG_WARN(MAIN) << "event" << "watchdog_heartbeat_unknown" << "task" << task_name;
     }
-}
 
-void Watchdog::set_fault_handler(FaultHandler handler) {
-    fault_handler_ = handler;
+    LOG_WARN(MAIN) << "event" << "watchdog_policy_unknown" << "task" << task_name;
+    return false;
 }
 
 size_t Watchdog::get_task_count() const {
-    std::lock_guard<std::mutex> lock(tasks_mutex_);
-    return monitored_tasks_.size();
+    size_t slot_count = registered_slot_count_.load(std::memory_order_acquire);
+    size_t active_count = 0;
+    for (size_t i = 0; i < slot_count; ++i) {
+        if (slots_[i].active.load(std::memory_order_acquire)) {
+            active_count++;
+        }
+    }
+    return active_count;
 }
 
 void Watchdog::watchdog_loop() {
-    auto next_check = std::chrono::steady_clock::now();
+    RtProfile::enter_thread("Watchdog");
+    clock_->begin_thread(clock_thread_);
+    wheel_epoch_ns_ = clock_->now_ns();
+    auto next_tick = clock_->now();
 
     while (running_) {
-        {
-            std::lock_guard<std::mutex> lock(tasks_mutex_);
+        long long now_ns = clock_->now_ns();
+        arm_new_slots(now_ns);
+
+        uint64_t target_tick = static_cast<uint64_t>((now_ns - wheel_epoch_ns_) / tick_period_ns_);
+        while (timing_wheel_.current_tick() < target_tick) {
+            expired_slot_ids_.clear();
+            timing_wheel_.advance(expired_slot_ids_);
+            for (size_t slot_index : expired_slot_ids_) {
+                handle_expired_slot(slot_index, now_ns);
+            }
+        }
 
-            for (auto& [task_name, info] : monitored_tasks_) {
-                if (is_timed_out(task_name, info)) {
-                auto now = std::chrono::steady_clock::now();
-                    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                        now - info.last_heartbeat).count();
+        next_tick += std::chrono::milliseconds(tick_period_ms_);
+        clock_->sleep_until(clock_thread_, next_tick);
+    }
+}
 
-                    info.consecutive_failures++;
-                    fault_count_++;
+void Watchdog::arm_new_slots(long long now_ns) {
+    size_t slot_count = registered_slot_count_.load(std::memory_order_acquire);
 
-                    if (fault_handler_) {
-                        fault_handler_(task_name, elapsed);
-                    }
+    while (armed_slot_count_ < slot_count) {
+        const HeartbeatSlot& slot = slots_[armed_slot_count_];
+        long long timeout_ns = static_cast<long long>(slot.timeout_ms) * NANOSECONDS_PER_MILLISECOND;
+        timing_wheel_.schedule(armed_slot_count_, tick_for_time(now_ns + timeout_ns));
+        armed_slot_count_++;
+    }
+}
 
-                    info.last_heartbeat = now;
-                }
-            }
+void Watchdog::handle_expired_slot(size_t slot_index, long long now_ns) {
+    const HeartbeatSlot& slot = slots_[slot_index];
+    if (!slot.active.load(std::memory_order_acquire)) {
+        // A slot in outage is checked every tick, so this runs right after unregister_task()
+        if (slot_monitor_states_[slot_index].consecutive_failures > 0) {
+            LOG_WARN(MAIN) << "event" << "watchdog_outage_released" << "task" << slot_names_[slot_index]
+                           << "reason" << "unregistered";
+            end_outage(slot_index);
         }
+        return;
+    }
 
-        next_check += std::chrono::milliseconds(check_period_ms_);
-        std::this_thread::sleep_until(next_check);
+    long long timeout_ns = static_cast<long long>(slot.timeout_ms) * NANOSECONDS_PER_MILLISECOND;
+    long long last_heartbeat_ns = slot.last_heartbeat_ns.load(std::memory_order_relaxed);
+    if (last_heartbeat_ns == 0) {
+        timing_wheel_.schedule(slot_index, tick_for_time(now_ns + timeout_ns));
+        return;
+    }
+
+    SlotMonitorState& state = slot_monitor_states_[slot_index];
+    bool in_outage = state.consecutive_failures > 0;
+
+    if (in_outage && last_heartbeat_ns > state.last_fault_ns) {
+        complete_recovery(slot_index, last_heartbeat_ns);
+        in_outage = false;
     }
+
+    long long deadline_ns = std::max(last_heartbeat_ns, state.last_fault_ns) + timeout_ns;
+    if (now_ns < deadline_ns) {
+        uint64_t next_check_tick = in_outage ? timing_wheel_.current_tick() + 1
+                                             : tick_for_time(deadline_ns);
+        timing_wheel_.schedule(slot_index, next_check_tick);
+        return;
+    }
+
+    raise_timeout(slot_index, now_ns, last_heartbeat_ns);
+    timing_wheel_.schedule(slot_index, timing_wheel_.current_tick() + 1);
 }
 
-bool Watchdog::is_timed_out(const std::string& task_name, const TaskInfo& info) {
-    if (!info.ever_reported) {
-        return false;
+void Watchdog::raise_timeout(size_t slot_index, long long now_ns, long long last_heartbeat_ns) {
+    const HeartbeatSlot& slot = slots_[slot_index];
+    SlotMonitorState& state = slot_monitor_states_[slot_index];
+    long long timeout_ns = static_cast<long long>(slot.timeout_ms) * NANOSECONDS_PER_MILLISECOND;
+
+    if (state.consecutive_failures == 0) {
+        state.outage_deadline_ns = last_heartbeat_ns + timeout_ns;
+        state.restarts_this_outage = 0;
+        if (perf_monitor_) {
+            long detection_latency_us = static_cast<long>(
+                (now_ns - state.outage_deadline_ns) / NANOSECONDS_PER_MICROSECOND);
+            perf_monitor_->record_latency("WatchdogDetect." + slot_names_[slot_index] + "(" +
+                                          std::to_string(slot.timeout_ms) + "ms)",
+                                          detection_latency_us);
+        }
+    }
+
+    long elapsed_ms = static_cast<long>((now_ns - last_heartbeat_ns) / NANOSECONDS_PER_MILLISECOND);
+    state.consecutive_failures++;
+    state.last_fault_ns = now_ns;
+    fault_count_++;
+
+    // Before the handler so the dump is labelled with the real cause
+    // rather than the CRIT log it emits
+    FlightRecorder::trigger("watchdog_fault");
+
+    if (fault_handler_) {
+        fault_handler_(slot_names_[slot_index], elapsed_ms);
+    }
+
+    escalate_recovery(slot_index, now_ns);
+}
+
+void Watchdog::escalate_recovery(size_t slot_index, long long now_ns) {
+    const RecoveryPolicy& policy = recovery_policies_[slot_index];
+    SlotMonitorState& state = slot_monitor_states_[slot_index];
+    const std::string& task_name = slot_names_[slot_index];
+
+    if (state.consecutive_failures == 1 && policy.enter_safe_state) {
+        policy.enter_safe_state();
+        long safe_state_latency_us = static_cast<long>(
+            (clock_->now_ns() - state.outage_deadline_ns) / NANOSECONDS_PER_MICROSECOND);
+        if (perf_monitor_) {
+            perf_monitor_->record_latency("WatchdogSafeState." + task_name, safe_state_latency_us);
+        }
+        LOG_CRIT(MAIN) << "event" << "watchdog_safe_state" << "task" << task_name
+                       << "latency_us" << safe_state_latency_us;
+    }
+
+    bool restart_due = policy.restart_task &&
+                       policy.restart_after_failures > 0 &&
+                       state.consecutive_failures >= policy.restart_after_failures &&
+                       state.restarts_this_outage < policy.max_restarts_per_outage;
+    if (restart_due && !restart_pending_[slot_index].exchange(true, std::memory_order_acq_rel)) {
+        state.restarts_this_outage++;
+        {
+            std::lock_guard<std::mutex> lock(recovery_mutex_);
+            pending_restart_slots_.push_back(slot_index);
+        }
+        recovery_requested_.notify_one();
+        LOG_CRIT(MAIN) << "event" << "watchdog_restart_request" << "task" << task_name
+                       << "attempt" << state.restarts_this_outage
+                       << "failures" << state.consecutive_failures;
+    }
+
+    if (policy.fail_fast_after_failures > 0 &&
+        state.consecutive_failures >= policy.fail_fast_after_failures) {
+        LOG_CRIT(MAIN) << "event" << "watchdog_fail_fast" << "task" << task_name
+                       << "failures" << state.consecutive_failures
+                       << "outage_ms" << (now_ns - state.outage_deadline_ns) / NANOSECONDS_PER_MILLISECOND;
+        std::abort();
+    }
+}
+
+void Watchdog::complete_recovery(size_t slot_index, long long last_heartbeat_ns) {
+    SlotMonitorState& state = slot_monitor_states_[slot_index];
+    const std::string& task_name = slot_names_[slot_index];
+
+    long recovery_latency_us = static_cast<long>(
+        (last_heartbeat_ns - state.outage_deadline_ns) / NANOSECONDS_PER_MICROSECOND);
+    if (perf_monitor_) {
+        perf_monitor_->record_latency("WatchdogRecovery." + task_name, recovery_latency_us);
+    }
+
+    LOG_INFO(MAIN) << "event" << "watchdog_recovered" << "task" << task_name
+                   << "failures" << state.consecutive_failures
+                   << "restarts" << state.restarts_this_outage
+                   << "latency_us" << recovery_latency_us;
+
+    end_outage(slot_index);
+}
+
+void Watchdog::end_outage(size_t slot_index) {
+    SlotMonitorState& state = slot_monitor_states_[slot_index];
+    state.consecutive_failures = 0;
+    state.restarts_this_outage = 0;
+
+    const RecoveryPolicy& policy = recovery_policies_[slot_index];
+    if (policy.on_recovered) {
+        policy.on_recovered();
     }
+}
 
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now - info.last_heartbeat).count();
+void Watchdog::recovery_loop() {
+    RtProfile::enter_thread("WatchdogRecovery");
+    while (true) {
+        size_t slot_index;
+        {
+            std::unique_lock<std::mutex> lock(recovery_mutex_);
+            recovery_requested_.wait(lock, [this]() {
+                return !running_ || !pending_restart_slots_.empty();
+            });
+            if (pending_restart_slots_.empty()) {
+                return;
+            }
+            slot_index = pending_restart_slots_.front();
+            pending_restart_slots_.pop_front();
+        }
+
+        const std::string& task_name = slot_names_[slot_index];
+        LOG_WARN(MAIN) << "event" << "watchdog_restart_begin" << "task" << task_name;
+
+        recovery_policies_[slot_index].restart_task();
+
+        LOG_WARN(MAIN) << "event" << "watchdog_restart_done" << "task" << task_name;
+        restart_pending_[slot_index].store(false, std::memory_order_release);
+    }
+}
 
-    return elapsed > info.timeout_ms;
+uint64_t Watchdog::tick_for_time(long long time_ns) const {
+    long long offset_ns = std::max(time_ns - wheel_epoch_ns_, 0LL);
+    return static_cast<uint64_t>((offset_ns + tick_period_ns_ - 1) / tick_period_ns_);
 }
 
 void Watchdog::default_fault_handler(const std::string& task_name, long elapsed_ms) {
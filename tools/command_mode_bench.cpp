@@ -0,0 +1,115 @@
+/**
+ * @brief Microbenchmark for the Command Logic mode state machine
+ *
+ * Feeds a pseudo-random event stream through command_mode_step() (one
+ * COMMAND_MODE_TABLE lookup per event) and through a nested-if
+ * implementation of the same rules, as CommandLogic used before the table,
+ * and reports transitions per second for both. Both paths are also
+ * cross-checked step by step so the benchmark fails if they disagree.
+ *
+ * Usage:
+ *   command_mode_bench [events] [rounds]
+ */
+#include "command_mode_machine.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+constexpr size_t DEFAULT_EVENT_COUNT = 1 << 20;
+constexpr int DEFAULT_ROUNDS = 50;
+
+/**
+ * @brief Nested-if reference of the mode rules (pre-table CommandLogic)
+ */
+static CommandModeTransition reference_step(CommandMode mode, CommandModeEvent event) {
+    bool fault = mode == CommandMode::FAULT;
+    bool automatic = mode == CommandMode::AUTOMATIC;
+    uint8_t actions = MODE_ACTION_NONE;
+
+    if (event == CommandModeEvent::FAULT_DETECTED || event == CommandModeEvent::FAULT_LATCHED) {
+        if (!fault && event == CommandModeEvent::FAULT_DETECTED) {
+            actions |= MODE_ACTION_REPORT_FAULT;
+        }
+        fault = true;
+        automatic = false;
+    } else if (event == CommandModeEvent::AUTO_REQUEST) {
+        if (!automatic) {
+            if (!fault) {
+                automatic = true;
+            } else {
+                actions |= MODE_ACTION_REJECT_AUTO;
+            }
+        }
+    } else if (event == CommandModeEvent::MANUAL_REQUEST) {
+        if (automatic) {
+            automatic = false;
+        }
+    } else if (fault) {
+        if (event == CommandModeEvent::REARM_FAULT_CLEARED) {
+            fault = false;
+        } else {
+            actions |= MODE_ACTION_REARM_FAILED;
+        }
+    }
+
+    CommandMode next = fault ? CommandMode::FAULT : (automatic ? CommandMode::AUTOMATIC : CommandMode::MANUAL);
+    return {next, actions};
+}
+
+template <typename Step>
+static double run(const std::vector<CommandModeEvent>& events, int rounds, Step step, unsigned long& changes) {
+    CommandMode mode = CommandMode::MANUAL;
+    unsigned long checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (CommandModeEvent event : events) {
+            CommandModeTransition transition = step(mode, event);
+            checksum += (transition.next != mode) + transition.actions;
+            mode = transition.next;
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    changes = checksum;
+    return std::chrono::duration<double>(elapsed).count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t event_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : DEFAULT_EVENT_COUNT;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : DEFAULT_ROUNDS;
+
+    // Weighted like a live session: mostly mode requests, occasional faults
+    std::mt19937 rng(42);
+    std::discrete_distribution<int> pick({30, 30, 15, 10, 10, 5});
+    std::vector<CommandModeEvent> events(event_count);
+    for (auto& event : events) {
+        event = static_cast<CommandModeEvent>(pick(rng));
+    }
+
+    CommandMode table_mode = CommandMode::MANUAL;
+    CommandMode reference_mode = CommandMode::MANUAL;
+    for (CommandModeEvent event : events) {
+        CommandModeTransition a = command_mode_step(table_mode, event);
+        CommandModeTransition b = reference_step(reference_mode, event);
+        if (a.next != b.next || a.actions != b.actions) {
+            std::fprintf(stderr, "mismatch: mode=%s event=%s\n",
+                         command_mode_name(table_mode), command_mode_event_name(event));
+            return 1;
+        }
+        table_mode = a.next;
+        reference_mode = b.next;
+    }
+
+    unsigned long table_changes = 0;
+    unsigned long reference_changes = 0;
+    double table_s = run(events, rounds, command_mode_step, table_changes);
+    double reference_s = run(events, rounds, reference_step, reference_changes);
+    double steps = static_cast<double>(event_count) * rounds;
+
+    std::printf("events=%zu rounds=%d checksum=%lu/%lu\n", event_count, rounds, table_changes, reference_changes);
+    std::printf("%-10s %14s %10s\n", "impl", "transitions/s", "ns/step");
+    std::printf("%-10s %14.3e %10.2f\n", "table", steps / table_s, table_s * 1e9 / steps);
+    std::printf("%-10s %14.3e %10.2f\n", "nested_if", steps / reference_s, reference_s * 1e9 / steps);
+    return 0;
+}
@@ -0,0 +1,227 @@
+/**
+ * @brief Throughput and caller latency of the DataCollector CSV log
+ *
+ * Several producer threads log records as fast as they can, in two ways:
+ * - "ofstream": the previous implementation, an std::ofstream write
+ *   ending in std::endl under a mutex, so one write() per record;
+ * - "group": DataCollector::log_event(), which queues the record for the
+ *   group-commit writer.
+ * A run of DURABLE calls (one at a time, like fault events) follows. For
+ * each mode the tool reports records/s and caller latency percentiles.
+ *
+ * Then the same threads feed a TelemetryCapture ring drained by the
+ * collector, first paced at capture_rate records/s in total for
+ * CAPTURE_SECONDS ("capture"), then flat out ("capture_max"). Each run
+ * reports the records/s offered and committed and the records dropped on
+ * a full staging ring.
+ *
+ * Usage:
+ *   data_collector_bench [threads] [records_per_thread] [work_dir] [capture_rate]
+ *
+ * The CSV files are written under <work_dir>/logs (default /tmp).
+ */
+#include "circular_buffer.h"
+#include "data_collector.h"
+#include "logger.h"
+#include "telemetry_capture.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using BenchClock = std::chrono::steady_clock;
+
+constexpr int BENCH_TRUCK_ID = 900;
+constexpr int DURABLE_RECORDS = 200;
+constexpr double CAPTURE_SECONDS = 2.0;
+
+/**
+ * @brief Pre-group-commit DataCollector::log_event (reference)
+ */
+class OfstreamLog {
+public:
+    explicit OfstreamLog(const std::string& path) : file_(path, std::ios::out | std::ios::trunc) {}
+
+    void log_event(const EventLog& event) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        file_ << event.timestamp << ","
+              << event.truck_id << ","
+              << event.state << ","
+              << event.position_x << ","
+              << event.position_y << ","
+              << event.description << std::endl;
+    }
+
+private:
+    std::mutex mutex_;
+    std::ofstream file_;
+};
+
+struct RunResult {
+    double seconds;
+    std::vector<long> latencies_ns;
+};
+
+template <typename Log>
+static RunResult run(Log log, int threads, int records_per_thread) {
+    std::vector<std::vector<long>> per_thread(threads);
+    std::vector<std::thread> workers;
+    auto start = BenchClock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            EventLog event{Logger::timestamp_ms(), BENCH_TRUCK_ID, "AUTO", 0, 0, "Periodic status update"};
+            per_thread[t].reserve(records_per_thread);
+            for (int i = 0; i < records_per_thread; i++) {
+                event.position_x = i;
+                event.position_y = t;
+                auto before = BenchClock::now();
+                log(event);
+                per_thread[t].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    BenchClock::now() - before).count());
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    RunResult result;
+    result.seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+    for (auto& samples : per_thread) {
+        result.latencies_ns.insert(result.latencies_ns.end(), samples.begin(), samples.end());
+    }
+    std::sort(result.latencies_ns.begin(), result.latencies_ns.end());
+    return result;
+}
+
+static void report(const char* name, const RunResult& result, long records) {
+    auto percentile = [&](double p) {
+        if (result.latencies_ns.empty()) {
+            return 0L;
+        }
+        size_t index = static_cast<size_t>(p / 100.0 * static_cast<double>(result.latencies_ns.size() - 1));
+        return result.latencies_ns[index];
+    };
+    std::printf("%-10s %10ld %12.0f %10.2f %10.2f %10.2f\n", name, records,
+                static_cast<double>(records) / result.seconds, percentile(50) / 1000.0,
+                percentile(99) / 1000.0, result.latencies_ns.empty() ? 0.0 : result.latencies_ns.back() / 1000.0);
+}
+
+struct CaptureResult {
+    long offered;
+    long written;
+    long dropped;
+    double seconds;
+};
+
+/**
+ * @brief Feed the capture ring from several threads for CAPTURE_SECONDS
+ *
+ * @param rate Total records/s offered, or 0 for as fast as possible
+ */
+static CaptureResult run_capture(TelemetryCapture& capture, DataCollector& collector, int threads, double rate) {
+    long written_before = collector.get_capture_written();
+    long dropped_before = capture.get_dropped_total();
+    std::vector<long> offered(threads, 0);
+    std::vector<std::thread> workers;
+    auto start = BenchClock::now();
+    auto end = start + std::chrono::duration_cast<BenchClock::duration>(std::chrono::duration<double>(CAPTURE_SECONDS));
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            SensorData sample{0, t, 0, 75, false, false, 0};
+            auto period = rate > 0.0 ? std::chrono::duration_cast<BenchClock::duration>(
+                                           std::chrono::duration<double>(threads / rate))
+                                     : BenchClock::duration::zero();
+            auto next = BenchClock::now();
+            while (BenchClock::now() < end) {
+                sample.position_x++;
+                capture.record_sensor(sample);
+                offered[t]++;
+                if (rate > 0.0) {
+                    next += period;
+                    std::this_thread::sleep_until(next);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    CaptureResult result;
+    result.seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+    result.offered = 0;
+    for (long count : offered) {
+        result.offered += count;
+    }
+    // Let the writer drain and commit what the ring still holds
+    while (capture.pending() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    result.written = collector.get_capture_written() - written_before;
+    result.dropped = capture.get_dropped_total() - dropped_before;
+    return result;
+}
+
+static void report_capture(const char* name, const CaptureResult& result) {
+    std::printf("%-12s %10ld %12.0f %10ld %12.0f %10ld\n", name, result.offered,
+                static_cast<double>(result.offered) / result.seconds, result.written,
+                static_cast<double>(result.written) / result.seconds, result.dropped);
+}
+
+int main(int argc, char* argv[]) {
+    int threads = argc > 1 ? std::atoi(argv[1]) : 4;
+    int records_per_thread = argc > 2 ? std::atoi(argv[2]) : 50000;
+    std::filesystem::path work_dir = argc > 3 ? argv[3] : "/tmp";
+    double capture_rate = argc > 4 ? std::atof(argv[4]) : 20000.0;
+
+    Logger::init(Logger::Level::WARN);
+    std::filesystem::create_directories(work_dir / "logs");
+    std::filesystem::current_path(work_dir);
+    std::filesystem::remove("logs/truck_" + std::to_string(BENCH_TRUCK_ID) + "_log.csv");
+    std::filesystem::remove("logs/truck_" + std::to_string(BENCH_TRUCK_ID) + "_capture.csv");
+
+    long records = static_cast<long>(threads) * records_per_thread;
+    std::printf("threads=%d records=%ld\n", threads, records);
+    std::printf("%-10s %10s %12s %10s %10s %10s\n", "mode", "records", "records/s", "p50_us", "p99_us", "max_us");
+
+    {
+        OfstreamLog reference("logs/ofstream_bench.csv");
+        RunResult result = run([&](const EventLog& event) { reference.log_event(event); },
+                               threads, records_per_thread);
+        report("ofstream", result, records);
+    }
+
+    CircularBuffer buffer;
+    TelemetryCapture capture;
+    DataCollector collector(buffer, BENCH_TRUCK_ID, 1000);
+    collector.set_telemetry_capture(&capture);
+    collector.start();
+    // The queue holds DATA_COLLECTOR_QUEUE_CAPACITY records; retry on a full
+    // queue so every record is measured end to end, as the ofstream path is.
+    RunResult group = run([&](const EventLog& event) {
+        while (!collector.log_event(event)) {
+            std::this_thread::yield();
+        }
+    }, threads, records_per_thread);
+    report("group", group, records);
+
+    RunResult durable = run([&](const EventLog& event) {
+        collector.log_event(event, LogDurability::DURABLE);
+    }, 1, DURABLE_RECORDS);
+    report("durable", durable, DURABLE_RECORDS);
+
+    std::printf("\n%-12s %10s %12s %10s %12s %10s\n", "mode", "offered", "offered/s", "written",
+                "written/s", "dropped");
+    report_capture("capture", run_capture(capture, collector, threads, capture_rate));
+    report_capture("capture_max", run_capture(capture, collector, threads, 0.0));
+    collector.stop();
+
+    std::printf("commits=%ld written=%ld dropped_on_full_queue=%ld\n", collector.get_commit_count(),
+                collector.get_records_written(), collector.get_dropped_records());
+    return 0;
+}
@@ -0,0 +1,168 @@
+/**
+ * @brief Offline decoder for deferred (binary) log files
+ *
+ * Reads a file written with LOG_DEFERRED_FILE=<path> and prints the same
+ * "ts|LVL|MOD|k=v" lines the text logger would have printed, merged across
+ * threads in timestamp order.
+ *
+ * Usage:
+ *   deferred_log_decode <file.dlog> [--stats]
+ *
+ * --stats prints the record count per call site instead of the log.
+ */
+#include "deferred_log.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct SiteInfo {
+    Logger::Level level;
+    Logger::Module module;
+    std::string format;
+    long record_count = 0;
+};
+
+struct DecodedRecord {
+    int64_t ticks;
+    int64_t timestamp_ns;
+    uint32_t site_id;
+    std::string body;
+};
+
+template <typename T>
+bool read_value(const std::string& data, size_t& offset, T& value) {
+    if (data.size() - offset < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <file.dlog> [--stats]" << std::endl;
+        return 2;
+    }
+    bool stats_only = argc > 2 && std::strcmp(argv[2], "--stats") == 0;
+
+    std::ifstream file(argv[1], std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < sizeof(Logger::DEFERRED_LOG_MAGIC) ||
+        std::memcmp(data.data(), Logger::DEFERRED_LOG_MAGIC, sizeof(Logger::DEFERRED_LOG_MAGIC)) != 0) {
+        std::cerr << "not a deferred log file: " << argv[1] << std::endl;
+        return 1;
+    }
+
+    // Sites and records are collected first: a record may precede the
+    // definition of its site when the writer was stopped mid-flush.
+    std::map<uint32_t, SiteInfo> sites;
+    std::vector<std::pair<size_t, uint16_t>> record_spans;
+    std::vector<std::pair<int64_t, int64_t>> calibration;
+    size_t offset = sizeof(Logger::DEFERRED_LOG_MAGIC);
+    bool truncated = false;
+
+    while (offset < data.size()) {
+        uint8_t type = static_cast<uint8_t>(data[offset++]);
+        if (type == Logger::DEFERRED_ENTRY_SITE) {
+            uint32_t id;
+            uint8_t level;
+            uint8_t module;
+            uint16_t format_length;
+            if (!read_value(data, offset, id) || !read_value(data, offset, level) ||
+                !read_value(data, offset, module) || !read_value(data, offset, format_length) ||
+                data.size() - offset < format_length) {
+                truncated = true;
+                break;
+            }
+            SiteInfo& site = sites[id];
+            site.level = static_cast<Logger::Level>(level);
+            site.module = static_cast<Logger::Module>(module);
+            site.format.assign(data, offset, format_length);
+            offset += format_length;
+        } else if (type == Logger::DEFERRED_ENTRY_CALIBRATION) {
+            int64_t ticks;
+            int64_t wall_ns;
+            if (!read_value(data, offset, ticks) || !read_value(data, offset, wall_ns)) {
+                truncated = true;
+                break;
+            }
+            calibration.emplace_back(ticks, wall_ns);
+        } else if (type == Logger::DEFERRED_ENTRY_RECORD) {
+            uint16_t length;
+            if (!read_value(data, offset, length) || data.size() - offset < length ||
+                length < Logger::DEFERRED_RECORD_HEADER_BYTES) {
+                truncated = true;
+                break;
+            }
+            record_spans.emplace_back(offset, length);
+            offset += length;
+        } else {
+            truncated = true;
+            break;
+        }
+    }
+
+    std::sort(calibration.begin(), calibration.end());
+
+    std::vector<DecodedRecord> records;
+    records.reserve(record_spans.size());
+    long malformed = 0;
+    for (const auto& span : record_spans) {
+        DecodedRecord record;
+        size_t position = span.first;
+        read_value(data, position, record.site_id);
+        read_value(data, position, record.ticks);
+        record.timestamp_ns = Logger::deferred_ticks_to_ns(calibration, record.ticks);
+
+        auto site = sites.find(record.site_id);
+        if (site == sites.end()) {
+            malformed++;
+            continue;
+        }
+        site->second.record_count++;
+        if (stats_only) {
+            continue;
+        }
+        if (!Logger::format_deferred_body(site->second.format.c_str(), data.data() + position,
+                                          span.first + span.second - position, record.body)) {
+            malformed++;
+        }
+        records.push_back(std::move(record));
+    }
+
+    if (stats_only) {
+        std::cout << "site  level  module  records  format" << std::endl;
+        for (const auto& entry : sites) {
+            std::cout << entry.first << "  " << Logger::level_str(entry.second.level) << "  "
+                      << Logger::module_str(entry.second.module) << "  " << entry.second.record_count
+                      << "  " << entry.second.format << std::endl;
+        }
+    } else {
+        std::stable_sort(records.begin(), records.end(), [](const DecodedRecord& a, const DecodedRecord& b) {
+            return a.ticks < b.ticks;
+        });
+        for (const auto& record : records) {
+            const SiteInfo& site = sites[record.site_id];
+            std::cout << record.timestamp_ns / 1000000 << "|"
+                      << Logger::level_str(site.level) << "|"
+                      << Logger::module_str(site.module) << "|"
+                      << record.body << "\n";
+        }
+    }
+
+    if (truncated || malformed > 0) {
+        std::cerr << "warning: truncated=" << (truncated ? 1 : 0) << " malformed=" << malformed << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,247 @@
+/**
+ * @brief Merge a flight recorder dump into one timeline
+ *
+ * Reads the sites.bin and ring_<tid>.bin files of a dump directory and
+ * prints every record still in the rings in timestamp order. The format is
+ * that of the text logger, with the thread id as the first key:
+ *
+ *   1731283456789|DBG|NC|tid=4242,event=nav_update,dist=12,cur_x=40
+ *
+ * A per-thread summary (records, time span covered) goes to stderr.
+ *
+ * Usage:
+ *   flight_recorder_merge <dump_dir> [--tid <tid>]
+ */
+#include "deferred_log.h"
+#include "flight_recorder.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct SiteInfo {
+    Logger::Level level;
+    Logger::Module module;
+    std::string format;
+};
+
+struct TimelineRecord {
+    int64_t ticks;
+    int tid;
+    uint32_t site_id;
+    std::string body;
+};
+
+std::string read_file(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+template <typename T>
+bool read_value(const std::string& data, size_t& offset, T& value) {
+    if (data.size() < offset || data.size() - offset < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+/**
+ * @brief Load the site table and calibration entries of sites.bin
+ */
+bool load_sites(const std::string& data, std::map<uint32_t, SiteInfo>& sites,
+                std::vector<std::pair<int64_t, int64_t>>& calibration) {
+    if (data.size() < sizeof(Logger::DEFERRED_LOG_MAGIC) ||
+        std::memcmp(data.data(), Logger::DEFERRED_LOG_MAGIC, sizeof(Logger::DEFERRED_LOG_MAGIC)) != 0) {
+        return false;
+    }
+    size_t offset = sizeof(Logger::DEFERRED_LOG_MAGIC);
+    while (offset < data.size()) {
+        uint8_t type = static_cast<uint8_t>(data[offset++]);
+        if (type == Logger::DEFERRED_ENTRY_SITE) {
+            uint32_t id;
+            uint8_t level;
+            uint8_t module;
+            uint16_t format_length;
+            if (!read_value(data, offset, id) || !read_value(data, offset, level) ||
+                !read_value(data, offset, module) || !read_value(data, offset, format_length) ||
+                data.size() - offset < format_length) {
+                return false;
+            }
+            SiteInfo& site = sites[id];
+            site.level = static_cast<Logger::Level>(level);
+            site.module = static_cast<Logger::Module>(module);
+            site.format.assign(data, offset, format_length);
+            offset += format_length;
+        } else if (type == Logger::DEFERRED_ENTRY_CALIBRATION) {
+            int64_t ticks;
+            int64_t wall_ns;
+            if (!read_value(data, offset, ticks) || !read_value(data, offset, wall_ns)) {
+                return false;
+            }
+            calibration.emplace_back(ticks, wall_ns);
+        } else {
+            return false;
+        }
+    }
+    std::sort(calibration.begin(), calibration.end());
+    return true;
+}
+
+/**
+ * @brief Decode the complete records of one ring file
+ *
+ * @return Records read, or -1 if the file is not a flight ring
+ */
+long load_ring(const std::string& data, const std::map<uint32_t, SiteInfo>& sites,
+               std::vector<TimelineRecord>& out, long& malformed, int& tid) {
+    char magic[sizeof(FLIGHT_RING_MAGIC)];
+    uint32_t header_bytes;
+    uint32_t data_bytes;
+    int32_t stored_tid;
+    uint64_t oldest;
+    uint64_t write_pos;
+    size_t offset = offsetof(FlightRingHeader, magic);
+    if (data.size() < FLIGHT_RING_HEADER_BYTES || !read_value(data, offset, magic) ||
+        std::memcmp(magic, FLIGHT_RING_MAGIC, sizeof(magic)) != 0) {
+        return -1;
+    }
+    offset = offsetof(FlightRingHeader, header_bytes);
+    read_value(data, offset, header_bytes);
+    offset = offsetof(FlightRingHeader, data_bytes);
+    read_value(data, offset, data_bytes);
+    offset = offsetof(FlightRingHeader, tid);
+    read_value(data, offset, stored_tid);
+    offset = offsetof(FlightRingHeader, oldest);
+    read_value(data, offset, oldest);
+    offset = offsetof(FlightRingHeader, write_pos);
+    read_value(data, offset, write_pos);
+    tid = stored_tid;
+    if (data_bytes == 0 || data.size() < static_cast<size_t>(header_bytes) + data_bytes ||
+        write_pos < oldest || write_pos - oldest > data_bytes) {
+        return -1;
+    }
+
+    const char* ring = data.data() + header_bytes;
+    auto copy_out = [&](uint64_t position, char* dest, size_t size) {
+        size_t start = static_cast<size_t>(position % data_bytes);
+        size_t first = std::min<size_t>(size, data_bytes - start);
+        std::memcpy(dest, ring + start, first);
+        std::memcpy(dest + first, ring, size - first);
+    };
+
+    long count = 0;
+    char record[Logger::DEFERRED_LOG_MAX_RECORD_BYTES];
+    uint64_t position = oldest;
+    while (write_pos - position >= sizeof(uint16_t)) {
+        uint16_t length;
+        copy_out(position, reinterpret_cast<char*>(&length), sizeof(length));
+        if (length < Logger::DEFERRED_RECORD_HEADER_BYTES || length > sizeof(record) ||
+            write_pos - position - sizeof(length) < length) {
+            malformed++;
+            break;
+        }
+        copy_out(position + sizeof(length), record, length);
+        position += sizeof(length) + length;
+
+        TimelineRecord entry;
+        entry.tid = stored_tid;
+        std::memcpy(&entry.site_id, record, sizeof(entry.site_id));
+        std::memcpy(&entry.ticks, record + sizeof(entry.site_id), sizeof(entry.ticks));
+        auto site = sites.find(entry.site_id);
+        if (site == sites.end() ||
+            !Logger::format_deferred_body(site->second.format.c_str(),
+                                          record + Logger::DEFERRED_RECORD_HEADER_BYTES,
+                                          length - Logger::DEFERRED_RECORD_HEADER_BYTES, entry.body)) {
+            malformed++;
+            continue;
+        }
+        out.push_back(std::move(entry));
+        count++;
+    }
+    return count;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <dump_dir> [--tid <tid>]" << std::endl;
+        return 2;
+    }
+    std::filesystem::path directory = argv[1];
+    int only_tid = 0;
+    if (argc > 3 && std::strcmp(argv[2], "--tid") == 0) {
+        only_tid = std::atoi(argv[3]);
+    }
+
+    std::map<uint32_t, SiteInfo> sites;
+    std::vector<std::pair<int64_t, int64_t>> calibration;
+    if (!load_sites(read_file(directory / FLIGHT_DUMP_SITES_FILE), sites, calibration)) {
+        std::cerr << "missing or malformed " << (directory / FLIGHT_DUMP_SITES_FILE).string() << std::endl;
+        return 1;
+    }
+
+    std::vector<std::filesystem::path> ring_files;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("ring_", 0) == 0) {
+            ring_files.push_back(entry.path());
+        }
+    }
+    std::sort(ring_files.begin(), ring_files.end());
+
+    std::vector<TimelineRecord> records;
+    long malformed = 0;
+    std::cerr << "tid  records  span_s" << std::endl;
+    for (const auto& path : ring_files) {
+        size_t first = records.size();
+        int tid = 0;
+        long count = load_ring(read_file(path), sites, records, malformed, tid);
+        if (count < 0) {
+            std::cerr << "skipping " << path.string() << ": not a flight ring" << std::endl;
+            continue;
+        }
+        double span_s = 0.0;
+        if (count > 0) {
+            auto bounds = std::minmax_element(records.begin() + static_cast<std::ptrdiff_t>(first), records.end(),
+                                              [](const TimelineRecord& a, const TimelineRecord& b) {
+                                                  return a.ticks < b.ticks;
+                                              });
+            span_s = static_cast<double>(Logger::deferred_ticks_to_ns(calibration, bounds.second->ticks) -
+                                         Logger::deferred_ticks_to_ns(calibration, bounds.first->ticks)) / 1e9;
+        }
+        std::cerr << tid << "  " << count << "  " << span_s << std::endl;
+    }
+
+    if (only_tid != 0) {
+        records.erase(std::remove_if(records.begin(), records.end(),
+                                     [only_tid](const TimelineRecord& r) { return r.tid != only_tid; }),
+                      records.end());
+    }
+    std::stable_sort(records.begin(), records.end(), [](const TimelineRecord& a, const TimelineRecord& b) {
+        return a.ticks < b.ticks;
+    });
+    for (const auto& record : records) {
+        const SiteInfo& site = sites[record.site_id];
+        std::cout << Logger::deferred_ticks_to_ns(calibration, record.ticks) / 1000000 << "|"
+                  << Logger::level_str(site.level) << "|"
+                  << Logger::module_str(site.module) << "|"
+                  << "tid=" << record.tid << "," << record.body << "\n";
+    }
+
+    if (malformed > 0) {
+        std::cerr << "warning: malformed=" << malformed << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,658 @@
+/**
+ * @brief Headless mine simulator: N trucks on the bridge file interface
+ *
+ * Stands in for python_gui/mine_simulation.py and the MQTT bridge when
+ * load testing truck_control. Each truck is a TruckModel stepped at 60 Hz.
+ * Its sensors are published into bridge/from_mqtt as the bridge writes
+ * them (<ms>_truck_<id>_sensors.json), and the actuator and state files
+ * truck_control writes into bridge/to_mqtt are consumed and applied to the
+ * model. The simulator also plays dispatcher and operator: it selects
+ * automatic mode, sends setpoints between a loading and a dumping point
+ * per truck, and rearms a faulted truck once the fault has cleared.
+ *
+ * Faults are injected every fault_every seconds per truck, staggered across
+ * the fleet, cycling hydraulic, electrical and overheat, each held for
+ * FAULT_HOLD_MS. The end-to-end control latency of a fault is the time from
+ * the first published sensor file carrying it to the state file in which
+ * truck_control reports it (file name timestamps, one host clock). The age
+ * of each actuator file when the simulator reads it is reported as well.
+ *
+ * With --spawn, one truck_control per truck is started in the work
+ * directory and stopped with SIGINT at the end; otherwise running
+ * truck_control processes are found by their command line. With --fleet,
+ * all trucks are served by one "truck_control --fleet <first-id> <n>
+ * [workers]" process instead. The measured window starts once every truck
+ * has reported its state (at least WARMUP_MS after start, at most
+ * STARTUP_TIMEOUT_MS). CPU is read from /proc/<pid>/stat over the window,
+ * and threads and resident memory from
+ * /proc/<pid>/status at its end; the summary divides them by the number of
+ * trucks.
+ *
+ * Usage:
+ *   headless_mine_sim [--trucks n] [--first-id id] [--seconds s] [--rate hz]
+ *                     [--fault-every s] [--spawn truck_control] [--fleet [workers]]
+ *                     [--dir work_dir]
+ *
+ * truck_control's output is written to logs/sim_truck_<id>.out (fleet:
+ * logs/sim_fleet_<first-id>.out).
+ */
+#include "json.hpp"
+#include "truck_model.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+constexpr int DEFAULT_TRUCKS = 10;
+constexpr int DEFAULT_FIRST_TRUCK_ID = 1;
+constexpr int DEFAULT_SECONDS = 60;
+constexpr int DEFAULT_SENSOR_RATE_HZ = 20;
+constexpr int DEFAULT_FAULT_EVERY_S = 20;
+constexpr long WARMUP_MS = 2000;                    // truck_control start-up
+constexpr long STARTUP_TIMEOUT_MS = 120000;         // Measure even if some trucks never reported
+constexpr long FAULT_HOLD_MS = 3000;
+constexpr long REACTION_TIMEOUT_MS = FAULT_HOLD_MS;
+constexpr double OVERHEAT_TEMPERATURE = 125.0;      // Above CRITICAL_TEMPERATURE_THRESHOLD_FM
+constexpr long OPERATOR_COMMAND_GAP_MS = 500;       // Several main loop cycles: one command file each
+constexpr long REARM_DELAY_MS = 2000;
+constexpr long DWELL_MS = 5000;
+constexpr long FRAME_OVERRUN_RESET_MS = 100;
+constexpr int LANE_COUNT = 9;
+constexpr int LANE_SPACING = 100;
+constexpr int LOAD_Y = 150;
+constexpr int DUMP_Y = 550;
+constexpr int WAYPOINT_SPEED = 50;
+constexpr int START_X = 100;                        // truck_control's initial position: 100 + 50*id, 200
+constexpr int START_X_PER_ID = 50;
+constexpr int START_Y = 200;
+
+enum class InjectedFault { HYDRAULIC, ELECTRICAL, OVERHEAT, COUNT };
+
+struct SimTruck {
+    int id;
+    TruckModel model;
+    ActuatorOutput output;
+
+    bool state_seen = false;
+    bool automatic = false;
+    bool fault = false;
+    long fault_since_ms = 0;
+    long last_command_ms = 0;
+
+    bool heading_to_dump = false;
+    bool leaving = false;               // Setpoint sent; ignore arrived until it drops
+    long dwell_until_ms = 0;
+    int trips = 0;
+
+    long next_fault_ms = 0;
+    int next_fault_kind = 0;
+    long inject_until_ms = 0;
+    bool awaiting_reaction = false;
+    bool inject_pending_publish = false;
+    long injected_ms = 0;
+
+    long sensors_out = 0;
+    long outputs_in = 0;
+    long states_in = 0;
+    long faults_injected = 0;
+    long reactions_missed = 0;
+    std::vector<long> react_ms;
+    std::vector<long> output_age_ms;
+    size_t process = 0;                 // Index in the truck_control processes
+
+    SimTruck(int truck_id, uint64_t seed)
+        : id(truck_id), model(START_X + START_X_PER_ID * truck_id, START_Y, seed) {}
+};
+
+/**
+ * @brief One truck_control process and its resource use over the window
+ */
+struct TruckControlProcess {
+    std::vector<std::string> arguments;
+    std::string output;
+    pid_t pid = 0;
+    long cpu_ticks_start = -1;
+    long cpu_ticks_end = -1;
+    long threads = -1;
+    long rss_kb = -1;
+};
+
+std::atomic<bool> g_running(true);
+
+void signal_handler(int) {
+    g_running = false;
+}
+
+long wall_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Write a bridge message atomically (the reader only lists *.json)
+ */
+bool publish(const std::string& topic_name, int truck_id, const json& payload, long timestamp_ms) {
+    std::string name = std::to_string(timestamp_ms) + "_truck_" + std::to_string(truck_id) + "_" + topic_name;
+    std::string target = "bridge/from_mqtt/" + name + ".json";
+    std::string temporary = target + ".tmp";
+    json message = {
+        {"topic", "truck/" + std::to_string(truck_id) + "/" + topic_name},
+        {"payload", payload},
+        {"timestamp", timestamp_ms}
+    };
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << message.dump();
+    }
+    std::error_code error;
+    fs::rename(temporary, target, error);
+    return !error;
+}
+
+void send_command(SimTruck& truck, const char* field, long now_ms) {
+    publish("commands", truck.id, {{field, true}}, now_ms);
+    truck.last_command_ms = now_ms;
+}
+
+void send_setpoint(SimTruck& truck, int index, long now_ms) {
+    int target_x = START_X + (index % LANE_COUNT) * LANE_SPACING;
+    int target_y = truck.heading_to_dump ? DUMP_Y : LOAD_Y;
+    publish("setpoint", truck.id,
+            {{"target_x", target_x}, {"target_y", target_y}, {"target_speed", WAYPOINT_SPEED}}, now_ms);
+    truck.leaving = true;
+    truck.dwell_until_ms = 0;
+}
+
+long read_cpu_ticks(pid_t pid) {
+    std::ifstream file("/proc/" + std::to_string(pid) + "/stat");
+    std::string stat;
+    if (!pid || !std::getline(file, stat)) {
+        return -1;
+    }
+    // Fields after the parenthesised command name; utime and stime are 14 and 15
+    size_t close = stat.rfind(')');
+    if (close == std::string::npos) {
+        return -1;
+    }
+    std::istringstream fields(stat.substr(close + 2));
+    std::string field;
+    long utime = 0;
+    long stime = 0;
+    for (int number = 3; number <= 15 && fields >> field; number++) {
+        if (number == 14) {
+            utime = std::atol(field.c_str());
+        } else if (number == 15) {
+            stime = std::atol(field.c_str());
+        }
+    }
+    return utime + stime;
+}
+
+/**
+ * @brief Threads and VmRSS from /proc/<pid>/status
+ */
+void read_process_status(TruckControlProcess& process) {
+    std::ifstream file("/proc/" + std::to_string(process.pid) + "/status");
+    std::string line;
+    while (process.pid && std::getline(file, line)) {
+        if (line.rfind("Threads:", 0) == 0) {
+            process.threads = std::atol(line.c_str() + 8);
+        } else if (line.rfind("VmRSS:", 0) == 0) {
+            process.rss_kb = std::atol(line.c_str() + 6);
+        }
+    }
+}
+
+/**
+ * @brief Find a running "truck_control <arguments...>" by its command line
+ */
+pid_t find_truck_control(const std::vector<std::string>& arguments) {
+    for (const auto& entry : fs::directory_iterator("/proc")) {
+        std::string pid_name = entry.path().filename().string();
+        if (pid_name.empty() || !std::all_of(pid_name.begin(), pid_name.end(), ::isdigit)) {
+            continue;
+        }
+        std::ifstream file(entry.path() / "cmdline", std::ios::binary);
+        std::string program;
+        if (!std::getline(file, program, '\0') || fs::path(program).filename() != "truck_control") {
+            continue;
+        }
+        bool matches = true;
+        std::string argument;
+        for (const auto& expected : arguments) {
+            if (!std::getline(file, argument, '\0') || argument != expected) {
+                matches = false;
+                break;
+            }
+        }
+        if (matches) {
+            return static_cast<pid_t>(std::atoi(pid_name.c_str()));
+        }
+    }
+    return 0;
+}
+
+pid_t spawn_truck_control(const std::string& program, const TruckControlProcess& process) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        setpgid(0, 0);      // The simulator alone decides when the trucks stop
+        int fd = ::open(process.output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            ::close(fd);
+        }
+        std::vector<char*> argv{const_cast<char*>(program.c_str())};
+        for (const auto& argument : process.arguments) {
+            argv.push_back(const_cast<char*>(argument.c_str()));
+        }
+        argv.push_back(nullptr);
+        execv(program.c_str(), argv.data());
+        _exit(127);
+    }
+    return pid > 0 ? pid : 0;
+}
+
+void apply_state(SimTruck& truck, const json& payload, long file_ms, long now_ms) {
+    bool fault = payload.value("fault", false);
+    truck.automatic = payload.value("automatic", false);
+    truck.states_in++;
+    if (fault && !truck.fault) {
+        truck.fault_since_ms = now_ms;
+    }
+    truck.fault = fault;
+    if (fault && truck.awaiting_reaction && !truck.inject_pending_publish && file_ms >= truck.injected_ms) {
+        truck.react_ms.push_back(file_ms - truck.injected_ms);
+        truck.awaiting_reaction = false;
+    }
+}
+
+/**
+ * @brief Consume truck_control's files in bridge/to_mqtt, oldest first
+ */
+void poll_outputs(std::vector<SimTruck>& trucks, int first_id, long now_ms, bool measuring) {
+    std::vector<fs::path> files;
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator("bridge/to_mqtt", error)) {
+        if (entry.path().extension() == ".json") {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    for (const auto& path : files) {
+        long file_ms = 0;
+        int truck_id = 0;
+        char kind[16] = {};
+        std::string name = path.filename().string();
+        if (std::sscanf(name.c_str(), "%ld_truck_%d_%15[a-z]", &file_ms, &truck_id, kind) != 3 ||
+            truck_id < first_id || truck_id >= first_id + static_cast<int>(trucks.size())) {
+            continue;       // Another consumer's file
+        }
+        SimTruck& truck = trucks[truck_id - first_id];
+        try {
+            std::ifstream file(path);
+            json message = json::parse(file);
+            const json& payload = message.at("payload");
+            if (std::string_view(kind) == "commands") {
+                truck.output.velocity = payload.value("acceleration", 0);
+                truck.output.steering = payload.value("steering", 0);
+                truck.output.arrived = payload.value("arrived", false);
+                truck.outputs_in++;
+                if (measuring) {
+                    truck.output_age_ms.push_back(now_ms - file_ms);
+                }
+            } else if (std::string_view(kind) == "state") {
+                truck.state_seen = true;
+                apply_state(truck, payload, file_ms, now_ms);
+            }
+        } catch (const std::exception&) {
+        }
+        fs::remove(path, error);
+    }
+}
+
+/**
+ * @brief Dispatcher, operator and fault injection for one truck
+ */
+void operate(SimTruck& truck, int index, long now_ms, long fault_every_ms) {
+    if (!truck.state_seen) {
+        return;             // truck_control not up yet
+    }
+
+    if (truck.inject_until_ms && now_ms >= truck.inject_until_ms) {
+        truck.model.fault_hydraulic = false;
+        truck.model.fault_electrical = false;
+        truck.inject_until_ms = 0;
+    }
+    if (truck.awaiting_reaction && !truck.inject_pending_publish &&
+        now_ms - truck.injected_ms > REACTION_TIMEOUT_MS) {
+        truck.reactions_missed++;
+        truck.awaiting_reaction = false;
+    }
+
+    if (fault_every_ms > 0 && now_ms >= truck.next_fault_ms) {
+        if (truck.automatic && !truck.fault && !truck.inject_until_ms) {
+            auto kind = static_cast<InjectedFault>(truck.next_fault_kind);
+            truck.next_fault_kind = (truck.next_fault_kind + 1) % static_cast<int>(InjectedFault::COUNT);
+            if (kind == InjectedFault::HYDRAULIC) {
+                truck.model.fault_hydraulic = true;
+            } else if (kind == InjectedFault::ELECTRICAL) {
+                truck.model.fault_electrical = true;
+            } else {
+                truck.model.temperature = OVERHEAT_TEMPERATURE;
+            }
+            truck.inject_until_ms = now_ms + FAULT_HOLD_MS;
+            truck.awaiting_reaction = true;
+            truck.inject_pending_publish = true;
+            truck.faults_injected++;
+            truck.next_fault_ms += fault_every_ms;
+        } else {
+            truck.next_fault_ms = now_ms + OPERATOR_COMMAND_GAP_MS;
+        }
+    }
+
+    if (now_ms - truck.last_command_ms >= OPERATOR_COMMAND_GAP_MS) {
+        if (truck.fault) {
+            if (!truck.inject_until_ms && now_ms - truck.fault_since_ms >= REARM_DELAY_MS) {
+                send_command(truck, "rearm", now_ms);
+            }
+        } else if (!truck.automatic) {
+            send_command(truck, "auto_mode", now_ms);
+            send_setpoint(truck, index, now_ms);
+        }
+    }
+
+    if (!truck.output.arrived) {
+        truck.leaving = false;
+    } else if (truck.automatic && !truck.fault && !truck.leaving) {
+        if (!truck.dwell_until_ms) {
+            truck.dwell_until_ms = now_ms + DWELL_MS;
+        } else if (now_ms >= truck.dwell_until_ms) {
+            truck.trips += truck.heading_to_dump ? 1 : 0;
+            truck.heading_to_dump = !truck.heading_to_dump;
+            send_setpoint(truck, index, now_ms);
+        }
+    }
+}
+
+long percentile(std::vector<long> samples, double p) {
+    if (samples.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(p / 100.0 * static_cast<double>(samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + static_cast<long>(index), samples.end());
+    return samples[index];
+}
+
+void report_row(const char* label, long sensors, long outputs, const std::vector<long>& ages, long injected,
+                long missed, const std::vector<long>& reactions, int trips, double cpu_pct) {
+    std::printf("%-6s %8ld %8ld %8ld %8ld %8ld %8ld %8ld %8ld %8ld %6d ", label, sensors, outputs,
+                percentile(ages, 99), injected, static_cast<long>(reactions.size()), missed,
+                percentile(reactions, 50), percentile(reactions, 99),
+                reactions.empty() ? 0L : *std::max_element(reactions.begin(), reactions.end()), trips);
+    if (cpu_pct < 0.0) {
+        std::printf("%8s\n", "-");
+    } else {
+        std::printf("%8.2f\n", cpu_pct);
+    }
+}
+
+int usage(const char* program) {
+    std::fprintf(stderr,
+                 "usage: %s [--trucks n] [--first-id id] [--seconds s] [--rate hz] [--fault-every s]\n"
+                 "          [--spawn truck_control] [--fleet [workers]] [--dir work_dir]\n",
+                 program);
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int truck_count = DEFAULT_TRUCKS;
+    int first_id = DEFAULT_FIRST_TRUCK_ID;
+    int seconds = DEFAULT_SECONDS;
+    int rate_hz = DEFAULT_SENSOR_RATE_HZ;
+    int fault_every_s = DEFAULT_FAULT_EVERY_S;
+    std::string spawn_program;
+    bool fleet = false;
+    std::string fleet_workers;
+    fs::path work_dir = ".";
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--trucks" && has_value) {
+            truck_count = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--first-id" && has_value) {
+            first_id = std::atoi(argv[++i]);
+        } else if (arg == "--seconds" && has_value) {
+            seconds = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--rate" && has_value) {
+            rate_hz = std::max(1, std::min(TRUCK_MODEL_FRAMES_PER_SECOND, std::atoi(argv[++i])));
+        } else if (arg == "--fault-every" && has_value) {
+            fault_every_s = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--spawn" && has_value) {
+            spawn_program = fs::absolute(argv[++i]).string();
+        } else if (arg == "--fleet") {
+            fleet = true;
+            if (has_value && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                fleet_workers = argv[++i];
+            }
+        } else if (arg == "--dir" && has_value) {
+            work_dir = argv[++i];
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    fs::create_directories(work_dir / "logs");
+    fs::create_directories(work_dir / "bridge" / "from_mqtt");
+    fs::create_directories(work_dir / "bridge" / "to_mqtt");
+    fs::current_path(work_dir);
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
+    std::vector<SimTruck> trucks;
+    trucks.reserve(truck_count);
+    for (int i = 0; i < truck_count; i++) {
+        trucks.emplace_back(first_id + i, TRUCK_MODEL_DEFAULT_NOISE_SEED + static_cast<uint64_t>(first_id + i));
+    }
+    std::vector<TruckControlProcess> processes;
+    if (fleet) {
+        TruckControlProcess process;
+        process.arguments = {"--fleet", std::to_string(first_id), std::to_string(truck_count)};
+        if (!fleet_workers.empty()) {
+            process.arguments.push_back(fleet_workers);
+        }
+        process.output = "logs/sim_fleet_" + std::to_string(first_id) + ".out";
+        processes.push_back(process);
+    } else {
+        for (auto& truck : trucks) {
+            TruckControlProcess process;
+            process.arguments = {std::to_string(truck.id)};
+            process.output = "logs/sim_truck_" + std::to_string(truck.id) + ".out";
+            truck.process = processes.size();
+            processes.push_back(process);
+        }
+    }
+    for (auto& process : processes) {
+        process.pid = spawn_program.empty() ? 0 : spawn_truck_control(spawn_program, process);
+    }
+
+    const auto frame_period = std::chrono::microseconds(1000000 / TRUCK_MODEL_FRAMES_PER_SECOND);
+    const int frames_per_sample = TRUCK_MODEL_FRAMES_PER_SECOND / rate_hz;
+    const long fault_every_ms = fault_every_s * 1000L;
+    long start_ms = wall_ms();
+    long measure_start_ms = start_ms + WARMUP_MS;
+    long end_ms = start_ms + STARTUP_TIMEOUT_MS + seconds * 1000L;
+
+    bool measuring = false;
+    long frames = 0;
+    long frame_overruns = 0;
+    rusage usage_start{};
+    auto next_frame = std::chrono::steady_clock::now();
+    while (g_running) {
+        long now_ms = wall_ms();
+        if (now_ms >= end_ms) {
+            break;
+        }
+        bool started = std::all_of(trucks.begin(), trucks.end(), [](const SimTruck& truck) { return truck.state_seen; });
+        if (!measuring && now_ms >= measure_start_ms && (started || now_ms >= start_ms + STARTUP_TIMEOUT_MS)) {
+            measuring = true;
+            measure_start_ms = now_ms;
+            end_ms = now_ms + seconds * 1000L;
+            for (int i = 0; i < truck_count; i++) {
+                trucks[i].next_fault_ms = now_ms + fault_every_ms * (i + 1) / (truck_count + 1);
+            }
+            getrusage(RUSAGE_SELF, &usage_start);
+            for (auto& process : processes) {
+                if (!process.pid) {
+                    process.pid = find_truck_control(process.arguments);
+                }
+                process.cpu_ticks_start = read_cpu_ticks(process.pid);
+            }
+        }
+
+        poll_outputs(trucks, first_id, now_ms, measuring);
+        bool publish_frame = frames % frames_per_sample == 0;
+        for (int i = 0; i < truck_count; i++) {
+            SimTruck& truck = trucks[i];
+            operate(truck, i, now_ms, measuring ? fault_every_ms : 0);
+            truck.model.frame(truck.output);
+            if (publish_frame) {
+                RawSensorData data = truck.model.sample();
+                long sample_ms = wall_ms();
+                publish("sensors", truck.id,
+                        {{"truck_id", truck.id},
+                         {"position_x", data.position_x},
+                         {"position_y", data.position_y},
+                         {"angle_x", data.angle_x},
+                         {"temperature", data.temperature},
+                         {"fault_electrical", data.fault_electrical},
+                         {"fault_hydraulic", data.fault_hydraulic},
+                         {"timestamp", sample_ms}},
+                        sample_ms);
+                truck.sensors_out += measuring ? 1 : 0;
+                if (truck.inject_pending_publish) {
+                    truck.injected_ms = sample_ms;
+                    truck.inject_pending_publish = false;
+                }
+            }
+        }
+        frames++;
+
+        next_frame += frame_period;
+        auto now = std::chrono::steady_clock::now();
+        if (now - next_frame > std::chrono::milliseconds(FRAME_OVERRUN_RESET_MS)) {
+            frame_overruns++;
+            next_frame = now;
+        }
+        std::this_thread::sleep_until(next_frame);
+    }
+
+    double window_s = std::max(1e-3, static_cast<double>(wall_ms() - measure_start_ms) / 1000.0);
+    rusage usage_end{};
+    getrusage(RUSAGE_SELF, &usage_end);
+    long ticks_per_second = sysconf(_SC_CLK_TCK);
+    for (auto& process : processes) {
+        process.cpu_ticks_end = read_cpu_ticks(process.pid);
+        read_process_status(process);
+    }
+    for (auto& process : processes) {
+        if (process.pid && !spawn_program.empty()) {
+            kill(process.pid, SIGINT);
+        }
+    }
+    for (auto& process : processes) {
+        if (process.pid && !spawn_program.empty()) {
+            waitpid(process.pid, nullptr, 0);
+        }
+    }
+
+    auto cpu_pct_of = [&](const TruckControlProcess& process) {
+        if (process.cpu_ticks_start < 0 || process.cpu_ticks_end < process.cpu_ticks_start) {
+            return -1.0;
+        }
+        return 100.0 * static_cast<double>(process.cpu_ticks_end - process.cpu_ticks_start) /
+               static_cast<double>(ticks_per_second) / window_s;
+    };
+
+    std::printf("trucks=%d mode=%s startup_s=%.1f window_s=%.1f rate_hz=%d fault_every_s=%d frames=%ld "
+                "frame_overruns=%ld\n",
+                truck_count, fleet ? "fleet" : "process", static_cast<double>(measure_start_ms - start_ms) / 1000.0,
+                window_s, rate_hz, fault_every_s, frames, frame_overruns);
+    std::printf("%-6s %8s %8s %8s %8s %8s %8s %8s %8s %8s %6s %8s\n", "truck", "sensors", "outputs",
+                "age_p99", "faults", "reacted", "missed", "re_p50", "re_p99", "re_max", "trips", "cpu_pct");
+    long sensors = 0;
+    long outputs = 0;
+    long injected = 0;
+    long missed = 0;
+    int trips = 0;
+    std::vector<long> ages;
+    std::vector<long> reactions;
+    for (const auto& truck : trucks) {
+        double cpu_pct = fleet ? -1.0 : cpu_pct_of(processes[truck.process]);
+        report_row(std::to_string(truck.id).c_str(), truck.sensors_out, truck.outputs_in, truck.output_age_ms,
+                   truck.faults_injected, truck.reactions_missed, truck.react_ms, truck.trips, cpu_pct);
+        sensors += truck.sensors_out;
+        outputs += truck.outputs_in;
+        injected += truck.faults_injected;
+        missed += truck.reactions_missed;
+        trips += truck.trips;
+        ages.insert(ages.end(), truck.output_age_ms.begin(), truck.output_age_ms.end());
+        reactions.insert(reactions.end(), truck.react_ms.begin(), truck.react_ms.end());
+    }
+
+    double cpu_total = 0.0;
+    long threads = 0;
+    long rss_kb = 0;
+    int measured = 0;
+    for (const auto& process : processes) {
+        double cpu_pct = cpu_pct_of(process);
+        if (cpu_pct >= 0.0) {
+            cpu_total += cpu_pct;
+            threads += std::max(0L, process.threads);
+            rss_kb += std::max(0L, process.rss_kb);
+            measured++;
+        }
+    }
+    report_row("all", sensors, outputs, ages, injected, missed, reactions, trips, measured ? cpu_total : -1.0);
+
+    auto cpu_seconds = [](const rusage& usage) {
+        return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+               static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    };
+    double sim_cpu_pct = 100.0 * (cpu_seconds(usage_end) - cpu_seconds(usage_start)) / window_s;
+    // Per truck over the trucks whose process was measured
+    int measured_trucks = fleet ? (measured ? truck_count : 0) : measured;
+    double per_truck = measured_trucks ? 1.0 / measured_trucks : 0.0;
+    std::printf("truck_control processes=%d threads=%ld rss_mb=%.1f cpu_pct=%.2f "
+                "per_truck: threads=%.2f rss_mb=%.2f cpu_pct=%.3f\n",
+                measured, threads, static_cast<double>(rss_kb) / 1024.0, cpu_total,
+                static_cast<double>(threads) * per_truck, static_cast<double>(rss_kb) / 1024.0 * per_truck,
+                cpu_total * per_truck);
+    std::printf("simulator cpu_pct=%.2f per_truck=%.3f\n", sim_cpu_pct, sim_cpu_pct / truck_count);
+    return 0;
+}
@@ -0,0 +1,151 @@
+/**
+ * @brief Write latency of a group-committed log across segment rollovers
+ *
+ * Writes batches of CSV lines, each committed with write + fdatasync()
+ * like a DataCollector group commit, in three ways:
+ * - "append": the previous log file, one O_APPEND file growing forever;
+ * - "rotate": RotatingLogFile without preallocation, so every write grows
+ *   the file and each rollover creates the next segment inline;
+ * - "prealloc": RotatingLogFile with fallocate()d segments and a spare
+ *   segment prepared by its background thread.
+ * The segment size is small so a run crosses many rollovers. For each
+ * mode the tool reports commit latency percentiles over all batches and
+ * the worst commit that rolled a segment. Closed segments are compressed
+ * and pruned in the background while the run goes on.
+ *
+ * Usage:
+ *   rotating_log_bench [batches] [batch_bytes] [segment_kb] [work_dir]
+ */
+#include "rotating_log_file.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr size_t BENCH_RETAIN_SEGMENTS = 8;
+
+struct Result {
+    std::vector<long> latency_us;
+    long rollovers = 0;
+    long rollover_max_us = 0;
+    long spare_misses = 0;
+    long compressed = 0;
+    long deleted = 0;
+};
+
+std::string make_batch(size_t bytes) {
+    std::string batch;
+    long timestamp = 1792000000000;
+    while (batch.size() < bytes) {
+        batch += std::to_string(timestamp) + ",900,AUTO,350,200,Periodic status update\n";
+        timestamp += 100;
+    }
+    return batch;
+}
+
+long elapsed_us(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+}
+
+Result run_append(const std::string& path, const std::string& batch, long batches) {
+    Result result;
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::perror(path.c_str());
+        return result;
+    }
+    for (long i = 0; i < batches; i++) {
+        auto start = Clock::now();
+        if (::write(fd, batch.data(), batch.size()) != static_cast<ssize_t>(batch.size()) || ::fdatasync(fd) != 0) {
+            std::perror("append");
+            break;
+        }
+        result.latency_us.push_back(elapsed_us(start));
+    }
+    ::close(fd);
+    return result;
+}
+
+Result run_rotating(const std::string& path, const std::string& batch, long batches, size_t segment_bytes,
+                    bool preallocate) {
+    Result result;
+    RotatingLogConfig config;
+    config.segment_bytes = segment_bytes;
+    config.segment_ms = 0;
+    config.preallocate = preallocate;
+    config.retain_segments = BENCH_RETAIN_SEGMENTS;
+    RotatingLogFile file;
+    if (!file.open(path, "Timestamp,TruckID,State,PositionX,PositionY,Description\n", config)) {
+        std::perror(path.c_str());
+        return result;
+    }
+    for (long i = 0; i < batches; i++) {
+        long rollovers = file.get_rollovers();
+        auto start = Clock::now();
+        if (!file.append(batch.data(), batch.size()) || !file.sync()) {
+            std::perror("rotating");
+            break;
+        }
+        long latency = elapsed_us(start);
+        result.latency_us.push_back(latency);
+        if (file.get_rollovers() != rollovers) {
+            result.rollover_max_us = std::max(result.rollover_max_us, latency);
+        }
+    }
+    file.close();
+    result.rollovers = file.get_rollovers();
+    result.spare_misses = file.get_spare_misses();
+    result.compressed = file.get_compressed();
+    result.deleted = file.get_deleted();
+    return result;
+}
+
+double percentile(std::vector<long> values, double fraction) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return static_cast<double>(values[index]);
+}
+
+void report(const char* name, const Result& result) {
+    long max_us = result.latency_us.empty() ? 0 : *std::max_element(result.latency_us.begin(), result.latency_us.end());
+    std::printf("%-9s %8zu %9.0f %9.0f %9.0f %9ld %9ld %10ld %7ld %10ld %7ld\n", name, result.latency_us.size(),
+                percentile(result.latency_us, 0.50), percentile(result.latency_us, 0.99),
+                percentile(result.latency_us, 0.999), max_us, result.rollovers, result.rollover_max_us,
+                result.spare_misses, result.compressed, result.deleted);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    long batches = argc > 1 ? std::atol(argv[1]) : 20000;
+    size_t batch_bytes = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4096;
+    size_t segment_bytes = (argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 4096) * 1024;
+    std::filesystem::path work_dir = std::filesystem::path(argc > 4 ? argv[4] : "/tmp") / "rotating_log_bench";
+
+    std::filesystem::remove_all(work_dir);
+    std::filesystem::create_directories(work_dir);
+    std::string batch = make_batch(batch_bytes);
+
+    std::printf("batches=%ld batch_bytes=%zu segment_kb=%zu\n", batches, batch.size(), segment_bytes / 1024);
+    std::printf("%-9s %8s %9s %9s %9s %9s %9s %10s %7s %10s %7s\n", "mode", "commits", "p50_us", "p99_us",
+                "p999_us", "max_us", "rollovers", "roll_max_us", "misses", "compressed", "deleted");
+    report("append", run_append((work_dir / "append_log.csv").string(), batch, batches));
+    report("rotate", run_rotating((work_dir / "rotate_log.csv").string(), batch, batches, segment_bytes, false));
+    report("prealloc", run_rotating((work_dir / "prealloc_log.csv").string(), batch, batches, segment_bytes, true));
+
+    std::filesystem::remove_all(work_dir);
+    return 0;
+}
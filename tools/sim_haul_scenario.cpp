@@ -0,0 +1,267 @@
+/**
+ * @brief A haul scenario on a SimulatedClock, faster than real time
+ *
+ * Runs the control tasks (Sensor Processing, Command Logic, Fault
+ * Monitoring, Navigation Control, Data Collector and the Watchdog) on one
+ * SimulatedClock against a truck model with the mine simulator's
+ * kinematics and heating. The tool's main thread plays the main loop:
+ * every 50 ms of virtual time it steps the model (60 Hz frames), feeds the
+ * sample to Sensor Processing and passes state, setpoint and navigation
+ * output between the tasks.
+ *
+ * The truck hauls in automatic mode between a loading and a dumping point,
+ * waiting at each. An operator rearms and re-selects automatic mode once
+ * a fault has cleared. A hydraulic fault is injected at two thirds of the
+ * run. Sensor noise comes from a fixed-seed generator.
+ *
+ * Each run reports virtual and real time, the speedup, clock turns, trips,
+ * faults and an FNV-1a digest of the actuator output, state and filtered
+ * position at every step. The scenario is run `runs` times; equal digests
+ * show the result is reproducible.
+ *
+ * Usage:
+ *   sim_haul_scenario [virtual_seconds] [runs] [work_dir]
+ *
+ * The DataCollector logs are written under <work_dir>/logs (default /tmp).
+ */
+#include "circular_buffer.h"
+#include "clock.h"
+#include "command_logic.h"
+#include "data_collector.h"
+#include "fault_monitoring.h"
+#include "logger.h"
+#include "navigation_control.h"
+#include "performance_monitor.h"
+#include "route_planning.h"
+#include "sensor_processing.h"
+#include "truck_model.h"
+#include "watchdog.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+
+namespace {
+
+constexpr int SCENARIO_TRUCK_ID = 901;
+constexpr int SENSOR_PROCESSING_PERIOD_MS = 20;
+constexpr int COMMAND_LOGIC_PERIOD_MS = 10;
+constexpr int FAULT_MONITORING_PERIOD_MS = 20;
+constexpr int NAVIGATION_CONTROL_PERIOD_MS = 10;
+constexpr int DATA_COLLECTOR_PERIOD_MS = 100;
+constexpr int WATCHDOG_TICK_PERIOD_MS = 5;
+constexpr int COMMAND_LOGIC_IDLE_WAKEUP_MS = 15;
+constexpr int MAIN_LOOP_PERIOD_MS = 50;
+constexpr int MODEL_FRAMES_PER_STEP = 3;            // 60 Hz model
+constexpr long PREDICTIVE_ALERT_HORIZON_MS = 5000;
+
+constexpr int LOAD_X = 100;
+constexpr int LOAD_Y = 200;
+constexpr int DUMP_X = 850;
+constexpr int DUMP_Y = 550;
+constexpr int WAYPOINT_SPEED = 50;
+constexpr int LOAD_DWELL_STEPS = 400;               // 20 s
+constexpr int DUMP_DWELL_STEPS = 200;               // 10 s
+constexpr int REARM_DELAY_STEPS = 40;               // Operator reacts after 2 s
+constexpr int HYDRAULIC_FAULT_STEPS = 100;          // 5 s
+
+struct ScenarioResult {
+    double virtual_s = 0.0;
+    double real_s = 0.0;
+    long turns = 0;
+    long steps = 0;
+    int trips = 0;
+    int faults = 0;
+    uint64_t digest = 0;
+};
+
+void digest_value(uint64_t& digest, long value) {
+    for (int i = 0; i < 8; i++) {
+        digest ^= static_cast<uint64_t>(value >> (8 * i)) & 0xFF;
+        digest *= 0x100000001B3ULL;
+    }
+}
+
+ScenarioResult run_scenario(long virtual_seconds) {
+    std::filesystem::remove("logs/truck_" + std::to_string(SCENARIO_TRUCK_ID) + "_log.csv");
+
+    SimulatedClock clock;
+    PerformanceMonitor perf_monitor;
+    perf_monitor.set_clock(&clock);
+
+    CircularBuffer buffer;
+    SensorProcessing sensor_task(buffer, 5, SENSOR_PROCESSING_PERIOD_MS, &perf_monitor);
+    CommandLogic command_task(buffer, COMMAND_LOGIC_PERIOD_MS, &perf_monitor);
+    FaultMonitoring fault_task(buffer, FAULT_MONITORING_PERIOD_MS, &perf_monitor);
+    NavigationControl nav_task(buffer, NAVIGATION_CONTROL_PERIOD_MS, &perf_monitor);
+    DataCollector data_collector(buffer, SCENARIO_TRUCK_ID, DATA_COLLECTOR_PERIOD_MS, &perf_monitor);
+    Watchdog watchdog(WATCHDOG_TICK_PERIOD_MS, DEFAULT_MAX_MONITORED_TASKS, &perf_monitor);
+    RoutePlanning route_planner;
+
+    sensor_task.set_clock(&clock);
+    command_task.set_clock(&clock);
+    fault_task.set_clock(&clock);
+    nav_task.set_clock(&clock);
+    data_collector.set_clock(&clock);
+    watchdog.set_clock(&clock);
+
+    command_task.set_fault_status(&fault_task.get_fault_status());
+    command_task.set_idle_wakeup_ms(COMMAND_LOGIC_IDLE_WAKEUP_MS);
+    fault_task.add_fault_listener(&command_task.get_input_signal());
+    nav_task.set_fault_status(&fault_task.get_fault_status());
+    fault_task.set_evaluation_mode(FaultEvaluationMode::WRITE_TRIGGERED);
+    fault_task.set_predictive_alert_horizon(PREDICTIVE_ALERT_HORIZON_MS);
+    sensor_task.set_sample_hook(
+        [&fault_task](const RawSensorData& raw, const SensorData& filtered, long long raw_arrival_ns) {
+            fault_task.on_sensor_sample(raw, filtered, raw_arrival_ns);
+        });
+    fault_task.register_fault_callback([&](FaultType type, const SensorData& data) {
+        data_collector.log_event(type == FaultType::NONE ? "OK" : "FAULT", data.position_x, data.position_y,
+                                 type == FaultType::NONE ? "Fault cleared" : "Fault detected",
+                                 LogDurability::DURABLE);
+    });
+    fault_task.register_advisory_callback([&](bool active, const SensorData& data) {
+        data_collector.log_event("ADVISORY", data.position_x, data.position_y,
+                                 active ? "Temperature trend alert" : "Temperature trend cleared");
+    });
+
+    sensor_task.set_heartbeat_handle(watchdog.register_task("SensorProcessing", 3 * SENSOR_PROCESSING_PERIOD_MS));
+    command_task.set_heartbeat_handle(watchdog.register_task("CommandLogic", 2 * COMMAND_LOGIC_IDLE_WAKEUP_MS));
+    fault_task.set_heartbeat_handle(watchdog.register_task("FaultMonitoring", 3 * FAULT_MONITORING_PERIOD_MS));
+    nav_task.set_heartbeat_handle(watchdog.register_task("NavigationControl", 3 * NAVIGATION_CONTROL_PERIOD_MS));
+    data_collector.set_heartbeat_handle(watchdog.register_task("DataCollector", 3 * DATA_COLLECTOR_PERIOD_MS));
+
+    TruckModel truck(LOAD_X, LOAD_Y);
+    sensor_task.set_raw_data(truck.sample());
+    route_planner.set_target_waypoint(DUMP_X, DUMP_Y, WAYPOINT_SPEED);
+
+    sensor_task.start();
+    command_task.start();
+    fault_task.start();
+    nav_task.start();
+    data_collector.start();
+    watchdog.start();
+
+    ScenarioResult result;
+    result.digest = 0xCBF29CE484222325ULL;
+    auto real_start = std::chrono::steady_clock::now();
+
+    long total_steps = virtual_seconds * 1000 / MAIN_LOOP_PERIOD_MS;
+    long fault_start = total_steps * 2 / 3;
+    bool heading_to_dump = true;
+    int dwell_steps = 0;
+    int fault_clear_steps = 0;
+    bool was_fault = false;
+
+    OperatorCommand auto_command;
+    auto_command.auto_mode = true;
+    command_task.set_command(auto_command);
+
+    for (long step = 0; step < total_steps; step++) {
+        clock.run_for(std::chrono::milliseconds(MAIN_LOOP_PERIOD_MS));
+
+        TruckState state = command_task.get_state();
+        nav_task.set_truck_state(state);
+        data_collector.set_truck_state(state);
+
+        truck.fault_hydraulic = step >= fault_start && step < fault_start + HYDRAULIC_FAULT_STEPS;
+        if (state.fault && !was_fault) {
+            result.faults++;
+        }
+        was_fault = state.fault;
+        fault_clear_steps = state.fault && fault_task.get_current_fault() == FaultType::NONE
+                                ? fault_clear_steps + 1 : 0;
+        if (fault_clear_steps == REARM_DELAY_STEPS) {
+            OperatorCommand rearm;
+            rearm.rearm = true;
+            command_task.set_command(rearm);
+            command_task.set_command(auto_command);
+        }
+
+        SensorData current_sensor = buffer.peek_latest();
+        NavigationSetpoint setpoint = route_planner.calculate_adjusted_setpoint(
+            current_sensor.position_x, current_sensor.position_y);
+        setpoint.target_angle = static_cast<int>(
+            std::atan2(setpoint.target_position_y - current_sensor.position_y,
+                       setpoint.target_position_x - current_sensor.position_x) * 180.0 / M_PI);
+        nav_task.set_setpoint(setpoint);
+
+        ActuatorOutput nav_output = nav_task.get_output();
+        command_task.set_navigation_output(nav_output);
+        ActuatorOutput output = command_task.get_actuator_output();
+
+        if (nav_output.arrived && state.automatic && !state.fault) {
+            dwell_steps++;
+            if (dwell_steps >= (heading_to_dump ? DUMP_DWELL_STEPS : LOAD_DWELL_STEPS)) {
+                if (heading_to_dump) {
+                    result.trips++;
+                }
+                heading_to_dump = !heading_to_dump;
+                route_planner.set_target_waypoint(heading_to_dump ? DUMP_X : LOAD_X,
+                                                  heading_to_dump ? DUMP_Y : LOAD_Y, WAYPOINT_SPEED);
+                dwell_steps = 0;
+            }
+        }
+
+        for (int frame = 0; frame < MODEL_FRAMES_PER_STEP; frame++) {
+            truck.frame(output);
+        }
+        sensor_task.set_raw_data(truck.sample());
+
+        for (long value : {static_cast<long>(output.velocity), static_cast<long>(output.steering),
+                           static_cast<long>(output.arrived), static_cast<long>(state.automatic),
+                           static_cast<long>(state.fault), static_cast<long>(current_sensor.position_x),
+                           static_cast<long>(current_sensor.position_y),
+                           static_cast<long>(current_sensor.temperature)}) {
+            digest_value(result.digest, value);
+        }
+        result.steps++;
+    }
+
+    result.real_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - real_start).count();
+    result.virtual_s = static_cast<double>(result.steps * MAIN_LOOP_PERIOD_MS) / 1000.0;
+    result.turns = clock.get_turns();
+
+    watchdog.stop();
+    data_collector.stop();
+    nav_task.stop();
+    fault_task.stop();
+    command_task.stop();
+    sensor_task.stop();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    long virtual_seconds = argc > 1 ? std::atol(argv[1]) : 3600;
+    int runs = argc > 2 ? std::atoi(argv[2]) : 2;
+    std::filesystem::path work_dir = argc > 3 ? argv[3] : "/tmp";
+
+    Logger::init(Logger::Level::ERR);
+    std::filesystem::create_directories(work_dir / "logs");
+    std::filesystem::current_path(work_dir);
+
+    std::printf("%-4s %10s %8s %8s %10s %6s %6s %18s\n", "run", "virtual_s", "real_s", "speedup", "turns",
+                "trips", "faults", "digest");
+    uint64_t first_digest = 0;
+    bool reproducible = true;
+    for (int run = 0; run < runs; run++) {
+        ScenarioResult result = run_scenario(virtual_seconds);
+        std::printf("%-4d %10.0f %8.2f %8.0f %10ld %6d %6d %018llx\n", run, result.virtual_s, result.real_s,
+                    result.virtual_s / std::max(result.real_s, 1e-6), result.turns, result.trips,
+                    result.faults, static_cast<unsigned long long>(result.digest));
+        if (run == 0) {
+            first_digest = result.digest;
+        } else if (result.digest != first_digest) {
+            reproducible = false;
+        }
+    }
+    std::printf("reproducible=%s\n", reproducible ? "yes" : "no");
+
+    Logger::shutdown();
+    return reproducible ? 0 : 1;
+}
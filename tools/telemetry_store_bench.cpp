@@ -0,0 +1,344 @@
+/**
+ * @brief Size and throughput of the columnar telemetry store against CSV
+ *
+ * Writes the same DataCollector records both as the CSV log (the
+ * DataCollector line format, one write() + fdatasync() per 64 KiB batch)
+ * and as a telemetry store file, then reads them back:
+ * - full scan: every row decoded (CSV lines parsed with from_chars),
+ * - range: the rows of the last 1% of the time span; the CSV has to be
+ *   scanned in full, the store only opens the segments the index selects.
+ * Both files are mmap'd for reading. Checksums of the decoded rows must
+ * match, which also checks the store round trip.
+ *
+ * Records are synthetic 10 Hz DataCollector output unless --csv names an
+ * existing DataCollector log to convert.
+ *
+ * Usage:
+ *   telemetry_store_bench [records] [work_dir]
+ *   telemetry_store_bench --csv <logs/truck_1_log.csv> [work_dir]
+ */
+#include "telemetry_store.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr size_t CSV_COMMIT_BYTES = 64 * 1024;
+constexpr const char* CSV_HEADER = "Timestamp,TruckID,State,PositionX,PositionY,Description\n";
+
+struct Record {
+    int64_t timestamp;
+    int truck_id;
+    std::string state;
+    int position_x;
+    int position_y;
+    std::string description;
+};
+
+struct Checksum {
+    long rows = 0;
+    int64_t sum = 0;
+
+    void add(int64_t timestamp, int truck_id, std::string_view state, int x, int y, std::string_view description) {
+        rows++;
+        sum += timestamp + truck_id + x * 3 + y * 7 +
+               static_cast<int64_t>(state.size()) * 11 + static_cast<int64_t>(description.size()) * 13;
+    }
+};
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::vector<Record> synthetic_records(long count) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> step(-3, 3);
+    std::uniform_int_distribution<int> percent(0, 999);
+    std::vector<Record> records;
+    records.reserve(static_cast<size_t>(count));
+    Record record{1731283456789, 1, "MANUAL", 150, 200, "Periodic status update"};
+    int fault_rows = 0;
+    for (long i = 0; i < count; i++) {
+        record.timestamp += 100 + (i % 7 == 0 ? 1 : 0);
+        record.position_x += step(rng);
+        record.position_y += step(rng);
+        record.description = "Periodic status update";
+        if (fault_rows > 0 && --fault_rows == 0) {
+            record.state = "AUTO";
+            record.description = "Fault cleared";
+        } else if (fault_rows == 0 && percent(rng) < 2) {
+            fault_rows = 50;
+            record.state = "FAULT";
+            record.description = "Fault detected: " + std::to_string(1 + percent(rng) % 3);
+        } else if (fault_rows == 0 && i > count / 20) {
+            record.state = "AUTO";
+        }
+        records.push_back(record);
+    }
+    return records;
+}
+
+bool parse_csv_line(std::string_view line, Record& record) {
+    std::string_view fields[6];
+    for (int i = 0; i < 5; i++) {
+        size_t comma = line.find(',');
+        if (comma == std::string_view::npos) {
+            return false;
+        }
+        fields[i] = line.substr(0, comma);
+        line.remove_prefix(comma + 1);
+    }
+    fields[5] = line;
+    auto number = [](std::string_view text, auto& value) {
+        return std::from_chars(text.data(), text.data() + text.size(), value).ec == std::errc();
+    };
+    record.state.assign(fields[2]);
+    record.description.assign(fields[5]);
+    return number(fields[0], record.timestamp) && number(fields[1], record.truck_id) &&
+           number(fields[3], record.position_x) && number(fields[4], record.position_y);
+}
+
+std::vector<Record> load_csv(const std::string& path) {
+    std::ifstream file(path);
+    std::vector<Record> records;
+    std::string line;
+    Record record;
+    while (std::getline(file, line)) {
+        if (parse_csv_line(line, record)) {
+            records.push_back(record);
+        }
+    }
+    return records;
+}
+
+void append_number(std::string& out, int64_t value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+bool write_csv(const std::string& path, const std::vector<Record>& records) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    std::string batch(CSV_HEADER);
+    bool ok = true;
+    auto commit = [&]() {
+        ok = ok && ::write(fd, batch.data(), batch.size()) == static_cast<ssize_t>(batch.size()) &&
+             ::fdatasync(fd) == 0;
+        batch.clear();
+    };
+    for (const Record& record : records) {
+        append_number(batch, record.timestamp);
+        batch.push_back(',');
+        append_number(batch, record.truck_id);
+        batch.push_back(',');
+        batch.append(record.state);
+        batch.push_back(',');
+        append_number(batch, record.position_x);
+        batch.push_back(',');
+        append_number(batch, record.position_y);
+        batch.push_back(',');
+        batch.append(record.description);
+        batch.push_back('\n');
+        if (batch.size() >= CSV_COMMIT_BYTES) {
+            commit();
+        }
+    }
+    commit();
+    ::close(fd);
+    return ok;
+}
+
+bool write_store(const std::string& path, const std::vector<Record>& records) {
+    TelemetryStoreWriter writer;
+    if (!writer.open(path)) {
+        return false;
+    }
+    for (const Record& record : records) {
+        if (!writer.append(record.timestamp, record.truck_id, record.state,
+                           record.position_x, record.position_y, record.description)) {
+            return false;
+        }
+    }
+    return writer.close();
+}
+
+/**
+ * @brief Parse the mmap'd CSV, keeping rows with min_ts <= timestamp <= max_ts
+ */
+Checksum scan_csv(const std::string& path, int64_t min_ts, int64_t max_ts) {
+    Checksum checksum;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat file_stat;
+    if (fd < 0 || ::fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return checksum;
+    }
+    size_t size = static_cast<size_t>(file_stat.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return checksum;
+    }
+    std::string_view data(static_cast<const char*>(mapping), size);
+    data.remove_prefix(std::min(data.size(), std::strlen(CSV_HEADER)));
+
+    std::string_view fields[6];
+    while (!data.empty()) {
+        size_t newline = data.find('\n');
+        std::string_view line = data.substr(0, newline);
+        data.remove_prefix(newline == std::string_view::npos ? data.size() : newline + 1);
+        int field = 0;
+        while (field < 5) {
+            size_t comma = line.find(',');
+            if (comma == std::string_view::npos) {
+                break;
+            }
+            fields[field++] = line.substr(0, comma);
+            line.remove_prefix(comma + 1);
+        }
+        if (field < 5) {
+            continue;
+        }
+        fields[5] = line;
+        int64_t timestamp = 0;
+        int truck_id = 0;
+        int x = 0;
+        int y = 0;
+        std::from_chars(fields[0].data(), fields[0].data() + fields[0].size(), timestamp);
+        if (timestamp < min_ts || timestamp > max_ts) {
+            continue;
+        }
+        std::from_chars(fields[1].data(), fields[1].data() + fields[1].size(), truck_id);
+        std::from_chars(fields[3].data(), fields[3].data() + fields[3].size(), x);
+        std::from_chars(fields[4].data(), fields[4].data() + fields[4].size(), y);
+        checksum.add(timestamp, truck_id, fields[2], x, y, fields[5]);
+    }
+    ::munmap(mapping, size);
+    return checksum;
+}
+
+Checksum scan_store(const std::string& path, int64_t min_ts, int64_t max_ts) {
+    Checksum checksum;
+    TelemetryStoreReader reader;
+    if (!reader.open(path)) {
+        return checksum;
+    }
+    reader.scan(min_ts, max_ts, [&](const TelemetryRow& row) {
+        checksum.add(row.timestamp, row.truck_id, row.state, row.position_x, row.position_y, row.description);
+    });
+    return checksum;
+}
+
+void report_size(const char* name, const std::string& path, long records) {
+    struct stat file_stat;
+    if (::stat(path.c_str(), &file_stat) != 0) {
+        return;
+    }
+    long allocated = static_cast<long>(file_stat.st_blocks) * 512;
+    std::printf("%-8s %12ld %12ld %10.2f\n", name, static_cast<long>(file_stat.st_size), allocated,
+                static_cast<double>(file_stat.st_size) / static_cast<double>(records));
+}
+
+template <typename Scan>
+void report_scan(const char* name, const char* query, Scan scan, const Checksum& expected) {
+    auto start = Clock::now();
+    Checksum checksum = scan();
+    double elapsed = seconds_since(start);
+    std::printf("%-8s %-6s %10ld %10.2f %14.0f %s\n", name, query, checksum.rows, elapsed * 1000.0,
+                static_cast<double>(checksum.rows) / elapsed,
+                checksum.rows == expected.rows && checksum.sum == expected.sum ? "ok" : "MISMATCH");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<Record> records;
+    std::filesystem::path work_dir = "/tmp";
+    if (argc > 2 && std::strcmp(argv[1], "--csv") == 0) {
+        records = load_csv(argv[2]);
+        if (argc > 3) {
+            work_dir = argv[3];
+        }
+    } else {
+        records = synthetic_records(argc > 1 ? std::atol(argv[1]) : 1000000);
+        if (argc > 2) {
+            work_dir = argv[2];
+        }
+    }
+    if (records.empty()) {
+        std::fprintf(stderr, "no records\n");
+        return 1;
+    }
+    long count = static_cast<long>(records.size());
+    std::filesystem::create_directories(work_dir);
+    std::string csv_path = (work_dir / "telemetry_bench.csv").string();
+    std::string store_path = (work_dir / "telemetry_bench.tlm").string();
+
+    // Each write phase starts with no dirty pages left by the previous one
+    ::sync();
+    auto start = Clock::now();
+    bool csv_ok = write_csv(csv_path, records);
+    double csv_seconds = seconds_since(start);
+    ::sync();
+    start = Clock::now();
+    bool store_ok = write_store(store_path, records);
+    double store_seconds = seconds_since(start);
+    if (!csv_ok || !store_ok) {
+        std::fprintf(stderr, "write failed: csv=%d store=%d\n", csv_ok, store_ok);
+        return 1;
+    }
+
+    std::printf("records=%ld\n\n", count);
+    std::printf("%-8s %12s %12s %10s\n", "format", "bytes", "allocated", "bytes/rec");
+    report_size("csv", csv_path, count);
+    report_size("store", store_path, count);
+
+    std::printf("\n%-8s %10s %14s\n", "format", "write_ms", "write_rec/s");
+    std::printf("%-8s %10.2f %14.0f\n", "csv", csv_seconds * 1000.0, static_cast<double>(count) / csv_seconds);
+    std::printf("%-8s %10.2f %14.0f\n", "store", store_seconds * 1000.0, static_cast<double>(count) / store_seconds);
+
+    int64_t first = records.front().timestamp;
+    int64_t last = records.back().timestamp;
+    int64_t range_start = last - (last - first) / 100;
+    Checksum all;
+    Checksum range;
+    for (const Record& record : records) {
+        all.add(record.timestamp, record.truck_id, record.state, record.position_x, record.position_y,
+                record.description);
+        if (record.timestamp >= range_start) {
+            range.add(record.timestamp, record.truck_id, record.state, record.position_x, record.position_y,
+                      record.description);
+        }
+    }
+    int64_t min_ts = std::numeric_limits<int64_t>::min();
+    int64_t max_ts = std::numeric_limits<int64_t>::max();
+
+    std::printf("\n%-8s %-6s %10s %10s %14s %s\n", "format", "query", "rows", "ms", "rows/s", "check");
+    report_scan("csv", "full", [&]() { return scan_csv(csv_path, min_ts, max_ts); }, all);
+    report_scan("store", "full", [&]() { return scan_store(store_path, min_ts, max_ts); }, all);
+    report_scan("csv", "range", [&]() { return scan_csv(csv_path, range_start, max_ts); }, range);
+    report_scan("store", "range", [&]() { return scan_store(store_path, range_start, max_ts); }, range);
+    return 0;
+}
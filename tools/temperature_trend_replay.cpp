@@ -0,0 +1,229 @@
+/**
+ * @brief Replay benchmark for predictive temperature advisories
+ *
+ * Replays temperature ramps through the same moving-average filter and
+ * rolling least-squares trend used by SensorProcessing/FaultMonitoring, and
+ * reports how much earlier the trend advisory fires than TEMPERATURE_ALERT,
+ * which only follows the fixed 95°C threshold.
+ *
+ * Usage:
+ *   temperature_trend_replay [horizon_ms] [samples.csv]
+ *
+ * samples.csv holds raw readings as "timestamp_ms,temperature" lines
+ * (non-numeric lines are skipped). Without a file, ramps modeled on
+ * mine_simulation.py (±2°C noise, 6°C/s heating while driving) are replayed:
+ * "ramp" scenarios heat to 150°C, "plateau" scenarios level off at 90°C and
+ * never cross the threshold, so every advisory there is a false advisory
+ * and the Faults column must stay 0.
+ */
+#include "fault_monitoring.h"
+#include "fault_state_machine.h"
+#include "temperature_trend_estimator.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+constexpr long DEFAULT_HORIZON_MS = 5000;
+constexpr size_t SENSOR_FILTER_ORDER = 5;
+constexpr long SAMPLE_PERIOD_MS = 20;
+constexpr double SIM_BASE_TEMPERATURE = 75.0;
+constexpr double SIM_MAX_TEMPERATURE = 150.0;
+constexpr double SIM_COOLING_RATE_C_PER_S = 3.0;
+constexpr long SIM_HOLD_MS = 8000;
+constexpr int SIM_NOISE_C = 2;
+constexpr int SIM_CYCLES_PER_RAMP = 5;
+constexpr double SIM_PLATEAU_TEMPERATURE = 90.0;
+constexpr int REARM_MARGIN_C = 10;
+
+struct RawSample {
+    long timestamp_ms;
+    int temperature;
+};
+
+struct Ramp {
+    std::string name;
+    std::vector<RawSample> samples;
+};
+
+struct ReplayResult {
+    std::vector<long> lead_ms;      // Per crossing: threshold time - advisory start time
+    int crossings;                  // Threshold crossings
+    int faults;                     // TEMPERATURE_ALERT activations (measured temperature only)
+    int false_advisories;           // Advisories that ended before a crossing
+};
+
+static std::vector<RawSample> load_csv(const std::string& path) {
+    std::vector<RawSample> samples;
+    std::ifstream file(path);
+    std::string line;
+
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string ts_field;
+        std::string temp_field;
+        if (!std::getline(fields, ts_field, ',') || !std::getline(fields, temp_field, ',')) {
+            continue;
+        }
+        char* ts_end = nullptr;
+        char* temp_end = nullptr;
+        long ts = std::strtol(ts_field.c_str(), &ts_end, 10);
+        double temp = std::strtod(temp_field.c_str(), &temp_end);
+        if (ts_end == ts_field.c_str() || temp_end == temp_field.c_str()) {
+            continue;
+        }
+        samples.push_back(RawSample{ts, static_cast<int>(temp)});
+    }
+
+    return samples;
+}
+
+static Ramp make_simulated_ramp(const char* label, double heating_rate_c_per_s, double peak_temperature,
+                                unsigned seed) {
+    Ramp ramp;
+    char name[32];
+    std::snprintf(name, sizeof(name), "%s %.2f C/s", label, heating_rate_c_per_s);
+    ramp.name = name;
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> noise(-SIM_NOISE_C, SIM_NOISE_C);
+
+    double temperature = SIM_BASE_TEMPERATURE;
+    long t = 0;
+    auto emit = [&]() {
+        ramp.samples.push_back(RawSample{t, static_cast<int>(temperature) + noise(rng)});
+        t += SAMPLE_PERIOD_MS;
+    };
+
+    for (int cycle = 0; cycle < SIM_CYCLES_PER_RAMP; cycle++) {
+        for (long held = 0; held < SIM_HOLD_MS; held += SAMPLE_PERIOD_MS) {
+            emit();
+        }
+        while (temperature < peak_temperature) {
+            temperature += heating_rate_c_per_s * SAMPLE_PERIOD_MS / 1000.0;
+            emit();
+        }
+        for (long held = 0; held < SIM_HOLD_MS; held += SAMPLE_PERIOD_MS) {
+            emit();
+        }
+        while (temperature > SIM_BASE_TEMPERATURE) {
+            temperature -= SIM_COOLING_RATE_C_PER_S * SAMPLE_PERIOD_MS / 1000.0;
+            emit();
+        }
+    }
+
+    return ramp;
+}
+
+/**
+ * A crossing is the first sample above the threshold after the filtered
+ * value fell REARM_MARGIN_C below it. Lead time is measured from the start
+ * of the uninterrupted advisory-or-alert that was active at the crossing;
+ * advisories that end before any crossing are counted as false advisories.
+ */
+static ReplayResult replay(const std::vector<RawSample>& samples, long horizon_ms) {
+    ReplayResult result{{}, 0, 0, 0};
+    TemperatureTrendEstimator trend(PREDICTIVE_ALERT_WINDOW_SAMPLES);
+    FaultStateMachine fault_states;
+    fault_states.configure(FaultType::TEMPERATURE_ALERT,
+                           FaultHysteresis{ALERT_TEMPERATURE_THRESHOLD_FM, ALERT_TEMPERATURE_CLEAR_BELOW_FM,
+                                           TEMPERATURE_ALERT_SET_SAMPLES, DEFAULT_FAULT_CLEAR_SAMPLES});
+    std::deque<int> history;
+
+    bool armed = true;
+    bool predicted = false;
+    bool warning_active = false;
+    long warning_start_ms = 0;
+
+    for (const RawSample& sample : samples) {
+        history.push_back(sample.temperature);
+        if (history.size() > SENSOR_FILTER_ORDER) {
+            history.pop_front();
+        }
+        int filtered = std::accumulate(history.begin(), history.end(), 0) / static_cast<int>(history.size());
+
+        // Same decision as FaultMonitoring::update_temperature_trend()
+        if (horizon_ms > 0) {
+            trend.add_sample(sample.timestamp_ms, filtered);
+            long eta_ms = trend.predict_ms_to_reach(ALERT_TEMPERATURE_THRESHOLD_FM,
+                                                    PREDICTIVE_ALERT_MIN_SLOPE_C_PER_S);
+            long effective_horizon_ms = predicted ? horizon_ms * PREDICTIVE_ALERT_CLEAR_HORIZON_FACTOR
+                                                  : horizon_ms;
+            predicted = eta_ms >= 0 && eta_ms <= effective_horizon_ms;
+        }
+
+        bool threshold = filtered > ALERT_TEMPERATURE_THRESHOLD_FM;
+        bool warning = threshold || predicted;
+
+        // Same fault latch as FaultMonitoring::observe_sensor_faults(): the prediction is not fed in
+        fault_states.observe_level(FaultType::TEMPERATURE_ALERT, filtered);
+
+        if (warning && !warning_active) {
+            warning_start_ms = sample.timestamp_ms;
+        }
+        if (!warning && warning_active && armed) {
+            result.false_advisories++;
+        }
+        warning_active = warning;
+
+        if (armed && threshold) {
+            result.crossings++;
+            result.lead_ms.push_back(sample.timestamp_ms - warning_start_ms);
+            armed = false;
+        } else if (!armed && filtered < ALERT_TEMPERATURE_THRESHOLD_FM - REARM_MARGIN_C) {
+            armed = true;
+        }
+    }
+
+    result.faults = static_cast<int>(fault_states.get_counters(FaultType::TEMPERATURE_ALERT).activations);
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    long horizon_ms = argc > 1 ? std::atol(argv[1]) : DEFAULT_HORIZON_MS;
+
+    std::vector<Ramp> ramps;
+    if (argc > 2) {
+        Ramp recorded;
+        recorded.name = argv[2];
+        recorded.samples = load_csv(argv[2]);
+        if (recorded.samples.empty()) {
+            std::cerr << "No samples read from " << argv[2] << std::endl;
+            return 1;
+        }
+        ramps.push_back(recorded);
+    } else {
+        const double heating_rates[] = {6.0, 3.0, 1.5, 0.75};
+        unsigned seed = 1;
+        for (double rate : heating_rates) {
+            ramps.push_back(make_simulated_ramp("ramp", rate, SIM_MAX_TEMPERATURE, seed++));
+        }
+        for (double rate : heating_rates) {
+            ramps.push_back(make_simulated_ramp("plateau", rate, SIM_PLATEAU_TEMPERATURE, seed++));
+        }
+    }
+
+    std::cout << "Predictive advisory replay (threshold " << ALERT_TEMPERATURE_THRESHOLD_FM
+              << "C, horizon " << horizon_ms << "ms, window " << PREDICTIVE_ALERT_WINDOW_SAMPLES
+              << " samples)\n\n";
+    std::printf("%-20s %10s %8s %12s %12s %16s\n", "Ramp", "Crossings", "Faults", "Avg lead ms", "Min lead ms",
+                "False advisories");
+
+    for (const Ramp& ramp : ramps) {
+        ReplayResult result = replay(ramp.samples, horizon_ms);
+        long total = std::accumulate(result.lead_ms.begin(), result.lead_ms.end(), 0L);
+        long min_lead = result.lead_ms.empty() ? 0 : *std::min_element(result.lead_ms.begin(), result.lead_ms.end());
+        long avg_lead = result.lead_ms.empty() ? 0 : total / static_cast<long>(result.lead_ms.size());
+        std::printf("%-20s %10d %8d %12ld %12ld %16d\n", ramp.name.c_str(), result.crossings, result.faults,
+                    avg_lead, min_lead, result.false_advisories);
+    }
+
+    return 0;
+}
@@ -0,0 +1,829 @@
+/**
+ * @brief Time-range query and aggregation over DataCollector logs
+ *
+ * Reads the per-truck event logs (truck_<id>_log.csv) and full-rate
+ * capture logs (truck_<id>_capture.csv), filters rows by time range,
+ * truck and truck state, and reports per truck:
+ * - rows matched,
+ * - max temperature (capture logs only),
+ * - distance travelled (sum of position steps),
+ * - time spent in FAULT, AUTO and MANUAL.
+ * Event and capture logs are reported on separate lines: they cover the
+ * same truck at different rates (10 Hz rows vs every sample and state
+ * transition), so their figures are not added together.
+ *
+ * Each file gets a sparse timestamp index: one entry per ~1 MiB block with
+ * the block's offset, min/max timestamp and the truck state in effect at
+ * its first line. The index is cached next to the file as <file>.idx and
+ * extended incrementally as the log grows. A query only reads the blocks
+ * whose time range overlaps it.
+ *
+ * Rotated segments compressed by the DataCollector (<stem>.<ms>.csv.gz)
+ * are decompressed into memory. They never change, so their cached index
+ * is validated by the compressed file's size and mtime, and a segment
+ * with no block in the range is skipped without decompressing it. When
+ * a directory is searched, .idx files whose log no longer exists are
+ * deleted: a plain segment's index is orphaned once the segment is
+ * compressed. The selected blocks are split into work
+ * units scanned by a thread pool; every unit reduces to a partial
+ * aggregate that is merged in time order, so results do not depend on the
+ * number of threads.
+ *
+ * Time is attributed to the state in effect between two consecutive rows,
+ * and a position step is added to the distance, only when the rows are at
+ * most --max-gap-ms apart (so restarts and missing data count as nothing).
+ *
+ * Usage:
+ *   truck_log_query [options] <file|dir>...
+ *     --from <t>         Start of the range (ms since epoch or YYYY-MM-DDTHH:MM:SS UTC)
+ *     --to <t>           End of the range (inclusive)
+ *     --truck <id>       Only this truck (repeatable)
+ *     --state <s>        Only rows/time while in MANUAL, AUTO or FAULT
+ *     --threads <n>      Scanning threads (default: hardware concurrency)
+ *     --max-gap-ms <ms>  Longest gap still counted as continuous (default 1000)
+ *     --print            Print the matching rows (file order, then time order)
+ *     --no-index-cache   Do not read or write <file>.idx
+ *
+ * Directories are searched recursively for *_log*.csv[.gz] and *_capture*.csv[.gz].
+ */
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+namespace {
+
+constexpr size_t INDEX_BLOCK_BYTES = 1024 * 1024;
+constexpr size_t UNIT_MAX_BYTES = 8 * 1024 * 1024;
+constexpr size_t GZIP_READ_BYTES = 1024 * 1024;
+constexpr char INDEX_MAGIC[8] = {'T', 'R', 'K', 'Q', 'I', 'D', 'X', '2'};
+constexpr const char* EVENT_HEADER = "Timestamp,TruckID,State,";
+constexpr const char* CAPTURE_HEADER = "TimestampUs,TruckID,Kind,";
+constexpr int64_t NO_TIME_LIMIT = std::numeric_limits<int64_t>::max();
+
+enum TruckStateCode : uint8_t { STATE_UNKNOWN, STATE_MANUAL, STATE_AUTO, STATE_FAULT, STATE_CODE_COUNT };
+const char* const STATE_NAMES[STATE_CODE_COUNT] = {"UNKNOWN", "MANUAL", "AUTO", "FAULT"};
+
+enum class LogKind : uint8_t { EVENT, CAPTURE };
+
+struct Options {
+    int64_t from_us = std::numeric_limits<int64_t>::min();
+    int64_t to_us = NO_TIME_LIMIT;
+    std::set<int> trucks;
+    int state = -1;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    int64_t max_gap_us = 1000 * 1000;
+    bool print = false;
+    bool index_cache = true;
+};
+
+struct IndexEntry {
+    uint64_t offset;        // First byte of the block (a line start)
+    int64_t min_us;
+    int64_t max_us;
+    uint32_t start_state;   // TruckStateCode in effect before the block's first line
+    uint32_t reserved;
+};
+
+struct IndexFileHeader {
+    char magic[8];
+    uint64_t indexed_bytes;     // Log bytes covered (whole lines)
+    int64_t first_us;           // Timestamp of the first row, detects a replaced file
+    int32_t truck_id;
+    uint32_t end_state;         // State in effect at indexed_bytes
+    uint32_t kind;
+    uint32_t entry_count;
+    uint64_t source_bytes;      // Compressed segments: size and mtime of the .gz file
+    int64_t source_mtime_ns;
+};
+
+/**
+ * @brief One parsed log line
+ */
+struct Row {
+    int64_t timestamp_us = 0;
+    int truck_id = 0;
+    int state = -1;             // TruckStateCode set by this row, or -1
+    bool has_position = false;
+    int position_x = 0;
+    int position_y = 0;
+    bool has_temperature = false;
+    int temperature = 0;
+};
+
+/**
+ * @brief Aggregate of a run of consecutive rows, mergeable in time order
+ */
+struct Partial {
+    long rows = 0;
+    bool has_rows = false;
+    int64_t first_us = 0;
+    int64_t last_us = 0;
+    int last_state = STATE_UNKNOWN;         // State in effect at the last row
+    int64_t state_us[STATE_CODE_COUNT] = {};
+    bool has_position = false;
+    int64_t first_position_us = 0;
+    int first_x = 0;
+    int first_y = 0;
+    int64_t last_position_us = 0;
+    int last_x = 0;
+    int last_y = 0;
+    int last_position_state = STATE_UNKNOWN;
+    double distance = 0.0;
+    bool has_temperature = false;
+    int max_temperature = 0;
+    int64_t max_temperature_us = 0;
+};
+
+struct LogFile {
+    std::string path;
+    LogKind kind = LogKind::EVENT;
+    int truck_id = 0;
+    bool compressed = false;        // .csv.gz segment, read into buffer
+    uint64_t source_bytes = 0;      // Compressed segments: .gz size and mtime
+    int64_t source_mtime_ns = 0;
+    std::string buffer;
+    const char* data = nullptr;
+    size_t size = 0;                // Mapped or decompressed bytes
+    size_t data_start = 0;          // First byte after the header line
+    size_t complete_bytes = 0;      // End of the last complete line
+    int64_t first_us = 0;
+    std::vector<IndexEntry> index;
+    int end_state = STATE_UNKNOWN;
+    bool index_reused = false;
+};
+
+struct WorkUnit {
+    size_t file;
+    size_t begin;
+    size_t end;
+    int start_state;
+    Partial result;
+    std::string printed;
+};
+
+template <typename T>
+bool parse_number(std::string_view text, T& value) {
+    return !text.empty() && std::from_chars(text.data(), text.data() + text.size(), value).ec == std::errc();
+}
+
+int state_code(std::string_view text) {
+    for (int code = STATE_MANUAL; code < STATE_CODE_COUNT; code++) {
+        if (text == STATE_NAMES[code]) {
+            return code;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Split a line into at most max_fields comma-separated fields
+ */
+size_t split_fields(std::string_view line, std::string_view* fields, size_t max_fields) {
+    size_t count = 0;
+    while (count + 1 < max_fields) {
+        size_t comma = line.find(',');
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        fields[count++] = line.substr(0, comma);
+        line.remove_prefix(comma + 1);
+    }
+    fields[count++] = line;
+    return count;
+}
+
+/**
+ * @brief Parse one data line of either log kind
+ *
+ * @param full false to parse only the timestamp, truck and state
+ */
+bool parse_row(LogKind kind, std::string_view line, Row& row, bool full) {
+    std::string_view fields[14];
+    row.state = -1;
+    row.has_position = false;
+    row.has_temperature = false;
+    if (kind == LogKind::EVENT) {
+        if (split_fields(line, fields, 6) < 6 || !parse_number(fields[0], row.timestamp_us) ||
+            !parse_number(fields[1], row.truck_id)) {
+            return false;
+        }
+        row.timestamp_us *= 1000;
+        row.state = state_code(fields[2]);
+        if (full) {
+            row.has_position = parse_number(fields[3], row.position_x) && parse_number(fields[4], row.position_y);
+        }
+        return true;
+    }
+
+    if (split_fields(line, fields, 14) < 14 || !parse_number(fields[0], row.timestamp_us) ||
+        !parse_number(fields[1], row.truck_id)) {
+        return false;
+    }
+    if (fields[2] == "STATE") {
+        int fault = 0;
+        int automatic = 0;
+        parse_number(fields[12], fault);
+        parse_number(fields[13], automatic);
+        row.state = fault ? STATE_FAULT : (automatic ? STATE_AUTO : STATE_MANUAL);
+    } else if (full && fields[2] == "SENSOR") {
+        row.has_position = parse_number(fields[3], row.position_x) && parse_number(fields[4], row.position_y);
+        row.has_temperature = parse_number(fields[6], row.temperature);
+    }
+    return true;
+}
+
+/**
+ * @brief Walk the complete lines of [begin, end), calling fn(line, line_start)
+ */
+template <typename Fn>
+void for_each_line(const char* data, size_t begin, size_t end, Fn&& fn) {
+    size_t position = begin;
+    while (position < end) {
+        const void* newline = std::memchr(data + position, '\n', end - position);
+        size_t line_end = newline ? static_cast<size_t>(static_cast<const char*>(newline) - data) : end;
+        fn(std::string_view(data + position, line_end - position), position);
+        position = line_end + 1;
+    }
+}
+
+bool is_compressed_name(const std::string& path) {
+    return path.size() > 3 && path.compare(path.size() - 3, 3, ".gz") == 0;
+}
+
+/**
+ * @brief Find the log kind, first row and complete lines of file.data
+ */
+bool parse_file_header(LogFile& file) {
+    std::string_view text(file.data, file.size);
+    if (text.compare(0, std::strlen(CAPTURE_HEADER), CAPTURE_HEADER) == 0) {
+        file.kind = LogKind::CAPTURE;
+    } else if (text.compare(0, std::strlen(EVENT_HEADER), EVENT_HEADER) == 0) {
+        file.kind = LogKind::EVENT;
+    } else {
+        return false;
+    }
+    size_t header_end = text.find('\n');
+    size_t last_newline = text.rfind('\n');
+    if (header_end == std::string_view::npos) {
+        return false;
+    }
+    file.data_start = header_end + 1;
+    file.complete_bytes = last_newline + 1;
+
+    Row row;
+    for (size_t position = file.data_start; position < file.complete_bytes;) {
+        size_t line_end = text.find('\n', position);
+        if (parse_row(file.kind, text.substr(position, line_end - position), row, false)) {
+            file.first_us = row.timestamp_us;
+            file.truck_id = row.truck_id;
+            return true;
+        }
+        position = line_end + 1;
+    }
+    return false;
+}
+
+bool map_file(LogFile& file) {
+    int fd = ::open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    file.size = static_cast<size_t>(file_stat.st_size);
+    void* mapping = ::mmap(nullptr, file.size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    file.data = static_cast<const char*>(mapping);
+    return parse_file_header(file);
+}
+
+/**
+ * @brief Size and mtime of a compressed segment, which identify its cached index
+ */
+bool stat_compressed(LogFile& file) {
+    struct stat file_stat;
+    if (::stat(file.path.c_str(), &file_stat) != 0 || file_stat.st_size == 0) {
+        return false;
+    }
+    file.source_bytes = static_cast<uint64_t>(file_stat.st_size);
+    file.source_mtime_ns = static_cast<int64_t>(file_stat.st_mtim.tv_sec) * 1000000000 + file_stat.st_mtim.tv_nsec;
+    return true;
+}
+
+bool read_compressed(LogFile& file) {
+    gzFile input = gzopen(file.path.c_str(), "rb");
+    if (!input) {
+        return false;
+    }
+    gzbuffer(input, GZIP_READ_BYTES);
+    bool ok = true;
+    while (true) {
+        size_t used = file.buffer.size();
+        file.buffer.resize(used + GZIP_READ_BYTES);
+        int got = gzread(input, &file.buffer[used], GZIP_READ_BYTES);
+        if (got <= 0) {
+            file.buffer.resize(used);
+            ok = got == 0;
+            break;
+        }
+        file.buffer.resize(used + static_cast<size_t>(got));
+    }
+    gzclose(input);
+    if (!ok || file.buffer.empty()) {
+        return false;
+    }
+    file.data = file.buffer.data();
+    file.size = file.buffer.size();
+    return parse_file_header(file);
+}
+
+/**
+ * @brief Extend file.index over [from, complete_bytes)
+ */
+void build_index(LogFile& file, size_t from, int state) {
+    IndexEntry entry{};
+    bool open_entry = false;
+    size_t block_end = 0;
+    Row row;
+    for_each_line(file.data, from, file.complete_bytes, [&](std::string_view line, size_t start) {
+        if (!parse_row(file.kind, line, row, false)) {
+            return;
+        }
+        if (!open_entry || start >= block_end) {
+            if (open_entry) {
+                file.index.push_back(entry);
+            }
+            entry = IndexEntry{start, row.timestamp_us, row.timestamp_us, static_cast<uint32_t>(state), 0};
+            open_entry = true;
+            block_end = start + INDEX_BLOCK_BYTES;
+        }
+        entry.min_us = std::min(entry.min_us, row.timestamp_us);
+        entry.max_us = std::max(entry.max_us, row.timestamp_us);
+        if (row.state >= 0) {
+            state = row.state;
+        }
+    });
+    if (open_entry) {
+        file.index.push_back(entry);
+    }
+    file.end_state = state;
+}
+
+/**
+ * @brief Read the cached index of a mapped file and index what was appended since
+ *
+ * A compressed segment is not read yet: its index is taken whole, with the
+ * header fields the file would have given.
+ */
+bool load_index_cache(LogFile& file) {
+    std::string path = file.path + ".idx";
+    FILE* cache = std::fopen(path.c_str(), "rb");
+    if (!cache) {
+        return false;
+    }
+    IndexFileHeader header;
+    bool ok = std::fread(&header, sizeof(header), 1, cache) == 1 &&
+              std::memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) == 0 && header.entry_count > 0;
+    if (ok && file.compressed) {
+        ok = header.source_bytes == file.source_bytes && header.source_mtime_ns == file.source_mtime_ns;
+        file.kind = static_cast<LogKind>(header.kind);
+        file.truck_id = header.truck_id;
+        file.first_us = header.first_us;
+        file.complete_bytes = header.indexed_bytes;
+        file.end_state = static_cast<int>(header.end_state);
+    } else if (ok) {
+        ok = header.kind == static_cast<uint32_t>(file.kind) && header.truck_id == file.truck_id &&
+             header.first_us == file.first_us && header.indexed_bytes <= file.complete_bytes;
+    }
+    if (ok) {
+        file.index.resize(header.entry_count);
+        ok = std::fread(file.index.data(), sizeof(IndexEntry), file.index.size(), cache) == file.index.size();
+    }
+    std::fclose(cache);
+    if (!ok) {
+        file.index.clear();
+        return false;
+    }
+    file.index_reused = true;
+    if (file.compressed) {
+        return true;
+    }
+    // Reopen the last block and index whatever was appended since
+    IndexEntry last = file.index.back();
+    file.index.pop_back();
+    build_index(file, last.offset, static_cast<int>(last.start_state));
+    return true;
+}
+
+void save_index_cache(const LogFile& file) {
+    std::string path = file.path + ".idx";
+    std::string temporary = path + ".tmp";
+    FILE* cache = std::fopen(temporary.c_str(), "wb");
+    if (!cache) {
+        return;
+    }
+    IndexFileHeader header{};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.indexed_bytes = file.complete_bytes;
+    header.first_us = file.first_us;
+    header.truck_id = file.truck_id;
+    header.end_state = static_cast<uint32_t>(file.end_state);
+    header.kind = static_cast<uint32_t>(file.kind);
+    header.entry_count = static_cast<uint32_t>(file.index.size());
+    header.source_bytes = file.source_bytes;
+    header.source_mtime_ns = file.source_mtime_ns;
+    bool ok = std::fwrite(&header, sizeof(header), 1, cache) == 1 &&
+              std::fwrite(file.index.data(), sizeof(IndexEntry), file.index.size(), cache) == file.index.size();
+    ok = std::fclose(cache) == 0 && ok;
+    if (ok) {
+        std::rename(temporary.c_str(), path.c_str());
+    } else {
+        std::remove(temporary.c_str());
+    }
+}
+
+/**
+ * @brief Reduce one work unit to a Partial
+ */
+void scan_unit(const LogFile& file, WorkUnit& unit, const Options& options) {
+    Partial& result = unit.result;
+    int state = unit.start_state;
+    Row row;
+    for_each_line(file.data, unit.begin, unit.end, [&](std::string_view line, size_t) {
+        if (!parse_row(file.kind, line, row, true)) {
+            return;
+        }
+        int previous_state = state;
+        if (row.state >= 0) {
+            state = row.state;
+        }
+        if (row.timestamp_us < options.from_us || row.timestamp_us > options.to_us) {
+            return;
+        }
+
+        if (result.has_rows) {
+            int64_t gap = row.timestamp_us - result.last_us;
+            if (gap >= 0 && gap <= options.max_gap_us && (options.state < 0 || previous_state == options.state)) {
+                result.state_us[previous_state] += gap;
+            }
+        } else {
+            result.has_rows = true;
+            result.first_us = row.timestamp_us;
+        }
+        result.last_us = row.timestamp_us;
+        result.last_state = state;
+
+        bool matches = options.state < 0 || state == options.state;
+        if (row.has_position) {
+            if (!result.has_position) {
+                result.has_position = true;
+                result.first_position_us = row.timestamp_us;
+                result.first_x = row.position_x;
+                result.first_y = row.position_y;
+            } else {
+                int64_t gap = row.timestamp_us - result.last_position_us;
+                if (gap >= 0 && gap <= options.max_gap_us &&
+                    (options.state < 0 || result.last_position_state == options.state)) {
+                    result.distance += std::hypot(row.position_x - result.last_x, row.position_y - result.last_y);
+                }
+            }
+            result.last_position_us = row.timestamp_us;
+            result.last_x = row.position_x;
+            result.last_y = row.position_y;
+            result.last_position_state = state;
+        }
+        if (!matches) {
+            return;
+        }
+        if (row.has_temperature && (!result.has_temperature || row.temperature > result.max_temperature)) {
+            result.has_temperature = true;
+            result.max_temperature = row.temperature;
+            result.max_temperature_us = row.timestamp_us;
+        }
+        result.rows++;
+        if (options.print) {
+            unit.printed.append(line);
+            unit.printed.push_back('\n');
+        }
+    });
+}
+
+/**
+ * @brief Append b (later in time) to a
+ */
+void merge(Partial& a, const Partial& b, const Options& options) {
+    if (!b.has_rows) {
+        return;
+    }
+    if (!a.has_rows) {
+        a = b;
+        return;
+    }
+    int64_t gap = b.first_us - a.last_us;
+    if (gap >= 0 && gap <= options.max_gap_us && (options.state < 0 || a.last_state == options.state)) {
+        a.state_us[a.last_state] += gap;
+    }
+    if (a.has_position && b.has_position) {
+        int64_t position_gap = b.first_position_us - a.last_position_us;
+        if (position_gap >= 0 && position_gap <= options.max_gap_us &&
+            (options.state < 0 || a.last_position_state == options.state)) {
+            a.distance += std::hypot(b.first_x - a.last_x, b.first_y - a.last_y);
+        }
+    }
+    if (b.has_position) {
+        if (!a.has_position) {
+            a.first_position_us = b.first_position_us;
+            a.first_x = b.first_x;
+            a.first_y = b.first_y;
+        }
+        a.has_position = true;
+        a.last_position_us = b.last_position_us;
+        a.last_x = b.last_x;
+        a.last_y = b.last_y;
+        a.last_position_state = b.last_position_state;
+    }
+    if (b.has_temperature && (!a.has_temperature || b.max_temperature > a.max_temperature)) {
+        a.has_temperature = true;
+        a.max_temperature = b.max_temperature;
+        a.max_temperature_us = b.max_temperature_us;
+    }
+    a.rows += b.rows;
+    for (int code = 0; code < STATE_CODE_COUNT; code++) {
+        a.state_us[code] += b.state_us[code];
+    }
+    a.distance += b.distance;
+    a.last_us = b.last_us;
+    a.last_state = b.last_state;
+}
+
+bool parse_time(const char* text, int64_t& us) {
+    int64_t ms = 0;
+    std::string_view view(text);
+    if (std::from_chars(view.data(), view.data() + view.size(), ms).ptr == view.data() + view.size()) {
+        us = ms * 1000;
+        return true;
+    }
+    std::tm parts{};
+    if (std::sscanf(text, "%d-%d-%dT%d:%d:%d", &parts.tm_year, &parts.tm_mon, &parts.tm_mday,
+                    &parts.tm_hour, &parts.tm_min, &parts.tm_sec) != 6) {
+        return false;
+    }
+    parts.tm_year -= 1900;
+    parts.tm_mon -= 1;
+    us = static_cast<int64_t>(::timegm(&parts)) * 1000000;
+    return true;
+}
+
+bool is_log_name(const std::filesystem::path& path) {
+    std::string name = path.filename().string();
+    std::filesystem::path csv = path.extension() == ".gz" ? path.stem() : path;
+    return csv.extension() == ".csv" &&
+           (name.find("_log") != std::string::npos || name.find("_capture") != std::string::npos);
+}
+
+/**
+ * @brief Whether any indexed block of the file overlaps the queried range
+ */
+bool overlaps_range(const LogFile& file, const Options& options) {
+    return std::any_of(file.index.begin(), file.index.end(), [&](const IndexEntry& entry) {
+        return entry.max_us >= options.from_us && entry.min_us <= options.to_us;
+    });
+}
+
+int usage(const char* program) {
+    std::fprintf(stderr,
+                 "usage: %s [--from t] [--to t] [--truck id]... [--state MANUAL|AUTO|FAULT]\n"
+                 "          [--threads n] [--max-gap-ms ms] [--print] [--no-index-cache] <file|dir>...\n",
+                 program);
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    std::vector<std::filesystem::path> inputs;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--from" && has_value) {
+            if (!parse_time(argv[++i], options.from_us)) {
+                return usage(argv[0]);
+            }
+        } else if (arg == "--to" && has_value) {
+            if (!parse_time(argv[++i], options.to_us)) {
+                return usage(argv[0]);
+            }
+        } else if (arg == "--truck" && has_value) {
+            options.trucks.insert(std::atoi(argv[++i]));
+        } else if (arg == "--state" && has_value) {
+            options.state = state_code(argv[++i]);
+            if (options.state < 0) {
+                return usage(argv[0]);
+            }
+        } else if (arg == "--threads" && has_value) {
+            options.threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--max-gap-ms" && has_value) {
+            options.max_gap_us = std::atoll(argv[++i]) * 1000;
+        } else if (arg == "--print") {
+            options.print = true;
+        } else if (arg == "--no-index-cache") {
+            options.index_cache = false;
+        } else if (!arg.empty() && arg[0] == '-') {
+            return usage(argv[0]);
+        } else {
+            inputs.emplace_back(argv[i]);
+        }
+    }
+    if (inputs.empty()) {
+        return usage(argv[0]);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> paths;
+    for (const auto& input : inputs) {
+        if (std::filesystem::is_directory(input)) {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(input)) {
+                if (!entry.is_regular_file()) {
+                    continue;
+                }
+                const std::filesystem::path& path = entry.path();
+                if (is_log_name(path)) {
+                    paths.push_back(path.string());
+                } else if (options.index_cache && path.extension() == ".idx" && is_log_name(path.stem()) &&
+                           !std::filesystem::exists(path.parent_path() / path.stem())) {
+                    std::error_code error;
+                    std::filesystem::remove(path, error);
+                }
+            }
+        } else {
+            paths.push_back(input.string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    // Map and index the files in parallel; each thread takes whole files
+    std::vector<LogFile> files(paths.size());
+    std::vector<char> usable(paths.size(), 0);
+    std::atomic<size_t> next_file{0};
+    auto index_worker = [&]() {
+        for (size_t i = next_file++; i < files.size(); i = next_file++) {
+            LogFile& file = files[i];
+            file.path = paths[i];
+            file.compressed = is_compressed_name(file.path);
+            if (file.compressed) {
+                // Decompress only if the cached index is stale or overlaps the range
+                if (!stat_compressed(file)) {
+                    continue;
+                }
+                bool cached = options.index_cache && load_index_cache(file);
+                if (cached && (!options.trucks.empty() && !options.trucks.count(file.truck_id))) {
+                    continue;
+                }
+                if ((!cached || overlaps_range(file, options)) && !read_compressed(file)) {
+                    continue;
+                }
+            } else if (!map_file(file)) {
+                continue;
+            }
+            if (!options.trucks.empty() && !options.trucks.count(file.truck_id)) {
+                continue;
+            }
+            if (file.data && file.index.empty()) {
+                if (!options.index_cache || file.compressed || !load_index_cache(file)) {
+                    build_index(file, file.data_start, STATE_UNKNOWN);
+                }
+                if (options.index_cache) {
+                    save_index_cache(file);
+                }
+            }
+            usable[i] = 1;
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < options.threads; t++) {
+        workers.emplace_back(index_worker);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    double index_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Work units: runs of consecutive blocks overlapping the range
+    std::vector<WorkUnit> units;
+    size_t scanned_bytes = 0;
+    size_t indexed_files = 0;
+    size_t reused_indexes = 0;
+    for (size_t i = 0; i < files.size(); i++) {
+        if (!usable[i]) {
+            continue;
+        }
+        const LogFile& file = files[i];
+        indexed_files++;
+        reused_indexes += file.index_reused ? 1 : 0;
+        for (size_t b = 0; b < file.index.size(); b++) {
+            const IndexEntry& entry = file.index[b];
+            if (entry.max_us < options.from_us || entry.min_us > options.to_us) {
+                continue;
+            }
+            size_t end = b + 1 < file.index.size() ? file.index[b + 1].offset : file.complete_bytes;
+            if (!units.empty() && units.back().file == i && units.back().end == entry.offset &&
+                end - units.back().begin <= UNIT_MAX_BYTES) {
+                units.back().end = end;
+            } else {
+                units.push_back(WorkUnit{i, entry.offset, end, static_cast<int>(entry.start_state), {}, {}});
+            }
+            scanned_bytes += end - entry.offset;
+        }
+    }
+
+    std::atomic<size_t> next_unit{0};
+    for (unsigned t = 0; t < options.threads; t++) {
+        workers.emplace_back([&]() {
+            for (size_t u = next_unit++; u < units.size(); u = next_unit++) {
+                scan_unit(files[units[u].file], units[u], options);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Units are in file order and, within a file, in offset order
+    std::map<size_t, Partial> per_file;
+    for (const WorkUnit& unit : units) {
+        merge(per_file[unit.file], unit.result, options);
+        if (options.print) {
+            std::fwrite(unit.printed.data(), 1, unit.printed.size(), stdout);
+        }
+    }
+
+    // Per truck and log kind, files merged in time order
+    std::map<std::pair<int, LogKind>, std::vector<const Partial*>> per_truck;
+    for (const auto& [index, partial] : per_file) {
+        if (partial.has_rows) {
+            per_truck[{files[index].truck_id, files[index].kind}].push_back(&partial);
+        }
+    }
+    std::map<std::pair<int, LogKind>, Partial> results;
+    for (auto& [key, partials] : per_truck) {
+        std::sort(partials.begin(), partials.end(),
+                  [](const Partial* a, const Partial* b) { return a->first_us < b->first_us; });
+        for (const Partial* partial : partials) {
+            merge(results[key], *partial, options);
+        }
+    }
+
+    std::FILE* out = options.print ? stderr : stdout;
+    std::fprintf(out, "%-6s %-8s %10s %9s %12s %10s %10s %10s\n", "truck", "source", "rows", "max_temp",
+                 "distance", "fault_s", "auto_s", "manual_s");
+    for (const auto& [key, total] : results) {
+        char temperature[16] = "-";
+        if (total.has_temperature) {
+            std::snprintf(temperature, sizeof(temperature), "%d", total.max_temperature);
+        }
+        std::fprintf(out, "%-6d %-8s %10ld %9s %12.1f %10.1f %10.1f %10.1f\n", key.first,
+                     key.second == LogKind::CAPTURE ? "capture" : "log", total.rows, temperature,
+                     total.distance, total.state_us[STATE_FAULT] / 1e6, total.state_us[STATE_AUTO] / 1e6,
+                     total.state_us[STATE_MANUAL] / 1e6);
+    }
+
+    double total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "files=%zu index_reused=%zu units=%zu scanned_mb=%.1f threads=%u index_s=%.2f total_s=%.2f\n",
+                 indexed_files, reused_indexes, units.size(), scanned_bytes / 1048576.0, options.threads,
+                 index_seconds, total_seconds);
+
+    for (const LogFile& file : files) {
+        if (file.data && !file.compressed) {
+            ::munmap(const_cast<char*>(file.data), file.size);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,200 @@
+/**
+ * @brief Cost of a watchdog heartbeat from several SCHED_FIFO task threads
+ *
+ * Each thread reports heartbeats for its own task as fast as it can, in
+ * two ways:
+ * - "name_map": the previous implementation, Watchdog::heartbeat(name),
+ *   which built the std::string key, took the watchdog mutex, looked the
+ *   task up in a std::map and counted heartbeats for a DEBUG log line;
+ * - "slot": Watchdog::heartbeat(handle), one relaxed store into the task's
+ *   padded slot, with the watchdog thread running and scanning the slots.
+ * The threads start together and run at SCHED_FIFO priority 80 when the
+ * process may use it (otherwise SCHED_OTHER, shown in the output). For
+ * each mode the tool reports ns per call (mean of the threads' own CPU
+ * time, so time slicing on a small box does not inflate it) and
+ * heartbeats/s over all threads in wall time, which includes lock waits.
+ *
+ * Usage:
+ *   watchdog_heartbeat_bench [threads] [heartbeats_per_thread]
+ */
+#include "logger.h"
+#include "watchdog.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <pthread.h>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+constexpr int DEFAULT_THREADS = 6;
+constexpr long DEFAULT_HEARTBEATS = 2000000;
+constexpr int BENCH_THREAD_PRIORITY = 80;
+constexpr int BENCH_TIMEOUT_MS = 60000;     // No fault while the threads are busy with the other mode
+
+static const char* const TASK_NAMES[] = {"SensorProcessing", "NavigationControl", "CommandLogic",
+                                         "FaultMonitoring", "DataCollector", "RoutePlanning"};
+
+/**
+ * @brief Heartbeat path before HeartbeatHandle (string-keyed map under a mutex)
+ */
+class NameMapHeartbeats {
+public:
+    void register_task(const std::string& name, int timeout_ms) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_[name] = TaskInfo{timeout_ms, std::chrono::steady_clock::now(), false, 0};
+    }
+
+    void heartbeat(const std::string& task_name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = tasks_.find(task_name);
+        if (it != tasks_.end()) {
+            it->second.last_heartbeat = std::chrono::steady_clock::now();
+            it->second.ever_reported = true;
+            it->second.consecutive_failures = 0;
+            if (++heartbeat_count_ % 100 == 0) {
+                LOG_DEBUG(MAIN) << "event" << "watchdog_heartbeat" << "task" << task_name
+                                << "count" << heartbeat_count_;
+            }
+        }
+    }
+
+private:
+    struct TaskInfo {
+        int timeout_ms;
+        std::chrono::steady_clock::time_point last_heartbeat;
+        bool ever_reported;
+        int consecutive_failures;
+    };
+
+    std::mutex mutex_;
+    std::map<std::string, TaskInfo> tasks_;
+    int heartbeat_count_ = 0;
+};
+
+static double thread_cpu_seconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) * 1e-9;
+}
+
+struct RunResult {
+    double ns_per_call;
+    double calls_per_s;
+    int fifo_threads;
+};
+
+/**
+ * @brief Run body(thread_index) on every thread, released together
+ *
+ * body returns the CPU seconds the thread spent in its loop.
+ */
+template <typename Body>
+static RunResult run_threads(int threads, long heartbeats, Body body) {
+    std::mutex gate_mutex;
+    std::condition_variable gate;
+    int ready = 0;
+    bool go = false;
+    std::vector<double> seconds(threads, 0.0);
+    std::vector<int> fifo(threads, 0);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            struct sched_param param;
+            param.sched_priority = BENCH_THREAD_PRIORITY;
+            fifo[t] = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+            // Block rather than spin: on one CPU a spinning SCHED_FIFO
+            // thread would starve the others
+            {
+                std::unique_lock<std::mutex> lock(gate_mutex);
+                ready++;
+                gate.notify_all();
+                gate.wait(lock, [&] { return go; });
+            }
+            seconds[t] = body(t);
+        });
+    }
+
+    std::chrono::steady_clock::time_point start;
+    {
+        std::unique_lock<std::mutex> lock(gate_mutex);
+        gate.wait(lock, [&] { return ready == threads; });
+        go = true;
+        start = std::chrono::steady_clock::now();
+    }
+    gate.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    RunResult result{0.0, 0.0, 0};
+    for (int t = 0; t < threads; t++) {
+        result.ns_per_call += seconds[t] * 1e9 / static_cast<double>(heartbeats);
+        result.fifo_threads += fifo[t];
+    }
+    result.ns_per_call /= threads;
+    result.calls_per_s = static_cast<double>(heartbeats) * threads / wall_s;
+    return result;
+}
+
+static std::string task_name(int index) {
+    return index < static_cast<int>(sizeof(TASK_NAMES) / sizeof(TASK_NAMES[0]))
+               ? TASK_NAMES[index] : "Task" + std::to_string(index);
+}
+
+int main(int argc, char* argv[]) {
+    int threads = argc > 1 ? std::max(1, std::atoi(argv[1])) : DEFAULT_THREADS;
+    long heartbeats = argc > 2 ? std::max(1L, std::atol(argv[2])) : DEFAULT_HEARTBEATS;
+    Logger::set_level(Logger::Level::WARN);
+
+    std::vector<std::string> names;
+    for (int t = 0; t < threads; t++) {
+        names.push_back(task_name(t));
+    }
+
+    NameMapHeartbeats name_map;
+    for (const auto& name : names) {
+        name_map.register_task(name, BENCH_TIMEOUT_MS);
+    }
+    RunResult map_result = run_threads(threads, heartbeats, [&](int t) {
+        // Tasks passed a literal, so every call built the key
+        const char* name = names[t].c_str();
+        double start = thread_cpu_seconds();
+        for (long i = 0; i < heartbeats; i++) {
+            name_map.heartbeat(name);
+        }
+        return thread_cpu_seconds() - start;
+    });
+
+    Watchdog watchdog(DEFAULT_WATCHDOG_TICK_PERIOD_MS, static_cast<size_t>(threads));
+    std::vector<Watchdog::HeartbeatHandle> handles;
+    for (const auto& name : names) {
+        handles.push_back(watchdog.register_task(name, BENCH_TIMEOUT_MS));
+    }
+    watchdog.start();
+    RunResult slot_result = run_threads(threads, heartbeats, [&](int t) {
+        Watchdog::HeartbeatHandle handle = handles[t];
+        double start = thread_cpu_seconds();
+        for (long i = 0; i < heartbeats; i++) {
+            Watchdog::heartbeat(handle);
+        }
+        return thread_cpu_seconds() - start;
+    });
+    watchdog.stop();
+
+    std::printf("threads=%d heartbeats_per_thread=%ld cpus=%u sched=%s faults=%d\n", threads, heartbeats,
+                std::thread::hardware_concurrency(),
+                std::min(map_result.fifo_threads, slot_result.fifo_threads) == threads ? "FIFO" : "OTHER",
+                watchdog.get_fault_count());
+    std::printf("%-10s %10s %16s\n", "impl", "ns/call", "heartbeats/s");
+    std::printf("%-10s %10.1f %16.3e\n", "name_map", map_result.ns_per_call, map_result.calls_per_s);
+    std::printf("%-10s %10.1f %16.3e\n", "slot", slot_result.ns_per_call, slot_result.calls_per_s);
+    return 0;
+}